@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <float.h>
+#include <inttypes.h>
 
 static void format_double(char* buf, size_t buf_size, double x) {
     if (isnan(x)) {
@@ -101,6 +102,13 @@ char* hl_tostring_number(double x) {
     return buf;
 }
 
+char* hl_tostring_int(int64_t x) {
+    char* buf = (char*)malloc(24);
+    if (!buf) return NULL;
+    snprintf(buf, 24, "%" PRId64, x);
+    return buf;
+}
+
 char* hl_tostring_bool(int b) {
     char* buf = (char*)malloc(6);
     if (!buf) return NULL;
@@ -134,8 +142,198 @@ char* hl_concat_strings(const char* a, const char* b) {
     return result;
 }
 
-void hl_free_string(char* str) {
-    if (str) free(str);
+/* numbers, ints and bools are written straight into the result, which is
+   sized once from the string lengths plus the widest formatting of every
+   other part */
+static size_t concat_size(int count, hl_part* parts) {
+    size_t size = 1;
+    for (int i = 0; i < count; i++) {
+        switch (parts[i].kind) {
+        case HL_PART_STRING:
+            if (!parts[i].as.s) parts[i].as.s = "nil";
+            parts[i].len = strlen(parts[i].as.s);
+            size += parts[i].len;
+            break;
+        case HL_PART_NUMBER:
+            size += 64;
+            break;
+        case HL_PART_INT:
+            size += 24;
+            break;
+        case HL_PART_BOOL:
+            size += 6;
+            break;
+        }
+    }
+    return size;
+}
+
+/* returns the length written, without the terminator */
+static size_t concat_write(char* result, int count, hl_part* parts) {
+    char* out = result;
+    for (int i = 0; i < count; i++) {
+        switch (parts[i].kind) {
+        case HL_PART_STRING:
+            memcpy(out, parts[i].as.s, parts[i].len);
+            out += parts[i].len;
+            break;
+        case HL_PART_NUMBER:
+            format_double(out, 64, parts[i].as.n);
+            out += strlen(out);
+            break;
+        case HL_PART_INT:
+            out += snprintf(out, 24, "%" PRId64, parts[i].as.i);
+            break;
+        case HL_PART_BOOL:
+            memcpy(out, parts[i].as.b ? "true" : "false", parts[i].as.b ? 4 : 5);
+            out += parts[i].as.b ? 4 : 5;
+            break;
+        }
+    }
+    *out = '\0';
+    return (size_t)(out - result);
+}
+
+char* hl_concat_n(int count, hl_part* parts) {
+    char* result = (char*)malloc(concat_size(count, parts));
+    if (!result) return NULL;
+    concat_write(result, count, parts);
+    return result;
+}
+
+/* the scratch region is a stack of chunks, each twice the size of the one
+   before. chunks stay allocated once the region shrinks back, so a program
+   that keeps building temporaries in a loop settles on a fixed footprint */
+#define HL_SCRATCH_CHUNKS 24
+#define HL_SCRATCH_FIRST_CHUNK ((size_t)64 * 1024)
+
+static struct {
+    char* base[HL_SCRATCH_CHUNKS];
+    size_t size[HL_SCRATCH_CHUNKS];
+    int chunk; /* chunk allocations currently come from */
+    size_t used; /* bytes in use in that chunk */
+    struct adopted_string* adopted; /* latest adopted string */
+} scratch;
+
+/* list nodes live in the region, so releasing them costs nothing extra */
+struct adopted_string {
+    char* s;
+    struct adopted_string* next;
+};
+
+static char* scratch_alloc(size_t size) {
+    while (scratch.chunk < HL_SCRATCH_CHUNKS) {
+        int c = scratch.chunk;
+        if (!scratch.base[c]) {
+            size_t chunk_size = HL_SCRATCH_FIRST_CHUNK << c;
+            while (chunk_size < size) chunk_size *= 2;
+            scratch.base[c] = (char*)malloc(chunk_size);
+            if (!scratch.base[c]) break;
+            scratch.size[c] = chunk_size;
+        }
+        if (scratch.size[c] - scratch.used >= size) {
+            char* p = scratch.base[c] + scratch.used;
+            scratch.used += size;
+            return p;
+        }
+        scratch.chunk++;
+        scratch.used = 0;
+    }
+    /* out of chunks: the string outlives the region and is never freed */
+    return (char*)malloc(size);
+}
+
+/* gives back the unused tail of the latest allocation */
+static void scratch_shrink(char* p, size_t reserved, size_t needed) {
+    if (scratch.chunk < HL_SCRATCH_CHUNKS && scratch.base[scratch.chunk] &&
+        p + reserved == scratch.base[scratch.chunk] + scratch.used) {
+        scratch.used -= reserved - needed;
+    }
+}
+
+hl_scratch_mark hl_scratch_save(void) {
+    hl_scratch_mark mark;
+    mark.chunk = scratch.chunk;
+    mark.used = scratch.used;
+    mark.adopted = scratch.adopted;
+    return mark;
+}
+
+void hl_scratch_restore(hl_scratch_mark mark) {
+    while (scratch.adopted != (struct adopted_string*)mark.adopted) {
+        free(scratch.adopted->s);
+        scratch.adopted = scratch.adopted->next;
+    }
+    scratch.chunk = mark.chunk;
+    scratch.used = mark.used;
+}
+
+char* hl_scratch_tostring_number(double x) {
+    if (isnan(x)) return "nil";
+    char* buf = scratch_alloc(64);
+    if (!buf) return NULL;
+    format_double(buf, 64, x);
+    scratch_shrink(buf, 64, strlen(buf) + 1);
+    return buf;
+}
+
+char* hl_scratch_tostring_int(int64_t x) {
+    char* buf = scratch_alloc(24);
+    if (!buf) return NULL;
+    int len = snprintf(buf, 24, "%" PRId64, x);
+    scratch_shrink(buf, 24, (size_t)len + 1);
+    return buf;
+}
+
+char* hl_scratch_tostring_bool(int b) {
+    return (char*)(b ? "true" : "false");
+}
+
+char* hl_scratch_tostring_string(const char* s) {
+    return (char*)(s ? s : "nil");
+}
+
+char* hl_scratch_concat_n(int count, hl_part* parts) {
+    size_t size = concat_size(count, parts);
+    char* result = scratch_alloc(size);
+    if (!result) return NULL;
+    scratch_shrink(result, size, concat_write(result, count, parts) + 1);
+    return result;
+}
+
+char* hl_scratch_adopt(char* s) {
+    /* strings end anywhere, the node needs pointer alignment */
+    size_t align = sizeof(void*);
+    scratch.used = (scratch.used + align - 1) & ~(align - 1);
+    if (scratch.chunk < HL_SCRATCH_CHUNKS && scratch.base[scratch.chunk] &&
+        scratch.used > scratch.size[scratch.chunk]) {
+        scratch.used = scratch.size[scratch.chunk];
+    }
+    struct adopted_string* node =
+        (struct adopted_string*)scratch_alloc(sizeof(struct adopted_string));
+    if (!node) return s;
+    node->s = s;
+    node->next = scratch.adopted;
+    scratch.adopted = node;
+    return s;
+}
+
+char* hl_string_copy(const char* s) {
+    if (!s) return NULL;
+    size_t size = strlen(s) + 1;
+    char* copy = (char*)malloc(size);
+    if (copy) memcpy(copy, s, size);
+    return copy;
+}
+
+void hl_string_set(char** slot, char* value) {
+    char* old = *slot;
+    *slot = value;
+    free(old);
+}
+
+void hl_free_string(const char* str) {
+    free((void*)str);
 }
 
 void hl_print_no_newline(const char* s) {
@@ -152,6 +350,10 @@ void hl_print_number_no_newline(double x) {
     }
 }
 
+void hl_print_int_no_newline(int64_t x) {
+    printf("%" PRId64, x);
+}
+
 void hl_print_bool_no_newline(int b) {
     printf("%s", b ? "true" : "false");
 }
@@ -178,6 +380,10 @@ void hl_print_number(double x) {
     }
 }
 
+void hl_print_int(int64_t x) {
+    printf("%" PRId64 "\n", x);
+}
+
 void hl_print_bool(int b) {
     printf("%s\n", b ? "true" : "false");
 }
@@ -219,6 +425,16 @@ double hl_floor_div_float(double a, double b) {
     return floor(a / b);
 }
 
+void hl_error_int_division_by_zero(void) {
+    fprintf(stderr, "Error: attempt to perform 'n//0' or 'n%%0' on int\n");
+    exit(1);
+}
+
+void hl_error_for_step_zero(void) {
+    fprintf(stderr, "Error: 'for' step is zero\n");
+    exit(1);
+}
+
 const char* hl_type(double x) {
     return isnan(x) ? "nil" : "number";
 }
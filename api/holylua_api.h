@@ -2,24 +2,86 @@
 #define HOLYLUA_API_H
 
 #include <math.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define HL_NIL_NUMBER (0.0/0.0)
 
 char* hl_tostring_number(double x);
+char* hl_tostring_int(int64_t x);
 char* hl_tostring_bool(int b);
 char* hl_tostring_string(const char* s);
 char* hl_concat_strings(const char* a, const char* b);
 
-void hl_free_string(char* str);
+/* one operand of a concatenation chain, formatted by hl_concat_n itself so
+   the chain builds a single string instead of one per operand */
+typedef enum {
+    HL_PART_STRING,
+    HL_PART_NUMBER,
+    HL_PART_INT,
+    HL_PART_BOOL
+} hl_part_kind;
+
+typedef struct {
+    hl_part_kind kind;
+    size_t len; /* scratch for hl_concat_n */
+    union {
+        const char* s;
+        double n;
+        int64_t i;
+        int b;
+    } as;
+} hl_part;
+
+/* variadic so a compound literal inside the operand keeps its commas */
+#define HL_STR_PART(...) {HL_PART_STRING, 0, {.s = (__VA_ARGS__)}}
+#define HL_NUM_PART(...) {HL_PART_NUMBER, 0, {.n = (__VA_ARGS__)}}
+#define HL_INT_PART(...) {HL_PART_INT, 0, {.i = (__VA_ARGS__)}}
+#define HL_BOOL_PART(...) {HL_PART_BOOL, 0, {.b = (__VA_ARGS__)}}
+
+char* hl_concat_n(int count, hl_part* parts);
+
+/* scratch region for strings that die with the statement building them
+   (printed, compared or concatenated, never stored). allocation is a
+   pointer bump, hl_scratch_restore releases everything allocated since the
+   matching hl_scratch_save. the strings are never freed one by one */
+typedef struct {
+    int chunk;
+    size_t used;
+    void* adopted; /* heap strings handed to the region, see hl_scratch_adopt */
+} hl_scratch_mark;
+
+hl_scratch_mark hl_scratch_save(void);
+void hl_scratch_restore(hl_scratch_mark mark);
+
+char* hl_scratch_tostring_number(double x);
+char* hl_scratch_tostring_int(int64_t x);
+char* hl_scratch_tostring_bool(int b);
+char* hl_scratch_tostring_string(const char* s);
+char* hl_scratch_concat_n(int count, hl_part* parts);
+
+/* a heap string used as a temporary, such as the result of a call that is
+   only printed or compared. it is freed by the restore releasing the
+   statement, like the region's own strings */
+char* hl_scratch_adopt(char* s);
+
+/* variables and fields own their strings: each holds its own heap copy or
+   NULL, freed when it is overwritten or goes out of scope */
+char* hl_string_copy(const char* s);
+void hl_string_set(char** slot, char* value);
+
+void hl_free_string(const char* str);
 
 void hl_print_no_newline(const char* s);
 void hl_print_number_no_newline(double x);
+void hl_print_int_no_newline(int64_t x);
 void hl_print_bool_no_newline(int b);
 void hl_print_string_no_newline(const char* s);
 void hl_print_enum_no_newline(int e);
 
 void hl_print(const char* s);
 void hl_print_number(double x);
+void hl_print_int(int64_t x);
 void hl_print_bool(int b);
 void hl_print_string(const char* s);
 void hl_print_enum(int e);
@@ -35,6 +97,51 @@ double hl_tonumber(const char* s);
 
 double hl_floor_div_float(double a, double b);
 
+void hl_error_int_division_by_zero(void);
+
+/* lua semantics: the quotient rounds towards negative infinity and the
+   remainder takes the sign of the divisor */
+static inline int64_t hl_idiv(int64_t a, int64_t b) {
+    if (b == 0) {
+        hl_error_int_division_by_zero();
+        return 0;
+    }
+    if (b == -1) {
+        /* INT64_MIN / -1 overflows, wrap like lua does */
+        return (int64_t)(0 - (uint64_t)a);
+    }
+    int64_t q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+    return q;
+}
+
+static inline int64_t hl_imod(int64_t a, int64_t b) {
+    if (b == 0) {
+        hl_error_int_division_by_zero();
+        return 0;
+    }
+    if (b == -1) return 0;
+    int64_t r = a % b;
+    if (r != 0 && ((r < 0) != (b < 0))) r += b;
+    return r;
+}
+
+static inline double hl_mod_float(double a, double b) {
+    return a - floor(a / b) * b;
+}
+
+void hl_error_for_step_zero(void);
+
+/* the limit of an integer for loop when it is given as a float: floored
+   when counting up, ceiled when counting down, and clamped to int64 */
+static inline int64_t hl_for_limit(double limit, int64_t step) {
+    if (isnan(limit)) return step > 0 ? INT64_MIN : INT64_MAX;
+    limit = step > 0 ? floor(limit) : ceil(limit);
+    if (limit >= 9223372036854775807.0) return INT64_MAX;
+    if (limit <= -9223372036854775808.0) return INT64_MIN;
+    return (int64_t)limit;
+}
+
 const char* hl_type(double x);
 const char* hl_type_str(const char* s);
 const char* hl_type_bool(int b);
@@ -0,0 +1,284 @@
+#include "../include/compiler/compiler.h"
+#include "../include/lexer.h"
+#include "../include/optimizer/constant_folder.h"
+#include "../include/parser.h"
+#include "../include/utils/pass_timer.h"
+#include "../include/utils/source_manager.h"
+#include "../include/validation/type_checker.h"
+#include "program_generator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct StageResult {
+  std::string name;
+  HolyLua::PassSample sample;
+};
+
+struct ShapeResult {
+  HolyLua::ProgramShape shape;
+  size_t bytes = 0;
+  size_t lines = 0;
+  size_t tokens = 0;
+  std::vector<StageResult> stages;
+};
+
+struct BenchOptions {
+  std::vector<HolyLua::ProgramShape> shapes;
+  HolyLua::GeneratorOptions generator;
+  unsigned repeat = 3;
+  unsigned jobs = 1;
+  std::string jsonPath = "holylua_bench.json";
+  std::string emitDir;
+};
+
+void printUsage() {
+  std::cout << "Usage: holylua_bench [options]\n\n";
+  std::cout << "Generates synthetic programs and times the lexer, parser, type checker\n";
+  std::cout << "and code generator on them in-process.\n\n";
+  std::cout << "Options:\n";
+  std::cout << "  --shape <name>  functions, expressions, types, branches, script or all\n";
+  std::cout << "  --size <n>      functions, locals, types, arms or statements (default 2000)\n";
+  std::cout << "  --depth <n>     expression nesting (default 8)\n";
+  std::cout << "  --seed <n>      generator seed (default 1)\n";
+  std::cout << "  --repeat <n>    runs per shape, the fastest is kept (default 3)\n";
+  std::cout << "  -j <n>          threads for type checking and codegen\n";
+  std::cout << "  --json <file>   where to store results (default holylua_bench.json)\n";
+  std::cout << "  --emit <dir>    only write the generated programs to <dir>\n\n";
+  std::cout << "Peak RSS is the process high-water mark, so run one shape per process\n";
+  std::cout << "to compare memory between shapes.\n";
+}
+
+// one lex/parse/check/codegen run over the file. returns false if a stage
+// reported errors, which means the generator produced an invalid program
+bool runOnce(const std::string &path, unsigned jobs, ShapeResult &result) {
+  HolyLua::PassTimer timer;
+  HolyLua::SourceManager sources;
+  if (!sources.open(path)) {
+    std::cerr << "Could not open file: " << path << "\n";
+    return false;
+  }
+
+  std::vector<HolyLua::Token> tokens;
+  {
+    HolyLua::PassTimer::Scope scope(&timer, "lex");
+    HolyLua::Lexer lexer(sources.text());
+    tokens = lexer.scanTokens();
+    if (lexer.hasErrors()) {
+      return false;
+    }
+  }
+  size_t tokenCount = tokens.size();
+
+  HolyLua::Parser parser(std::move(tokens), sources);
+  HolyLua::Program program;
+  {
+    HolyLua::PassTimer::Scope scope(&timer, "parse");
+    program = parser.parse();
+  }
+
+  {
+    HolyLua::PassTimer::Scope scope(&timer, "typecheck");
+    HolyLua::TypeChecker typeChecker(sources);
+    typeChecker.setJobs(jobs);
+    if (!typeChecker.check(program)) {
+      return false;
+    }
+  }
+
+  {
+    HolyLua::PassTimer::Scope scope(&timer, "fold constants");
+    HolyLua::ConstantFolder().fold(program);
+  }
+
+  {
+    HolyLua::PassTimer::Scope scope(&timer, "codegen");
+    HolyLua::Compiler compiler(sources);
+    compiler.setJobs(jobs);
+    if (compiler.compile(program).empty()) {
+      return false;
+    }
+  }
+
+  result.bytes = sources.size();
+  result.lines = sources.lineCount();
+  result.tokens = tokenCount;
+
+  // keep the fastest run of each stage
+  const auto &phases = timer.recorded();
+  for (size_t i = 0; i < phases.size(); i++) {
+    if (i >= result.stages.size()) {
+      result.stages.push_back({phases[i].name, phases[i].sample});
+    } else if (phases[i].sample.wallMs < result.stages[i].sample.wallMs) {
+      result.stages[i].sample = phases[i].sample;
+    }
+  }
+  return true;
+}
+
+double perSecond(size_t count, double ms) {
+  return ms > 0 ? count * 1000.0 / ms : 0;
+}
+
+void printResult(const ShapeResult &result) {
+  std::cout << HolyLua::shapeName(result.shape) << ": " << result.lines
+            << " lines, " << result.tokens << " tokens, " << result.bytes
+            << " bytes\n";
+  std::cout << std::setw(12) << "stage" << std::setw(11) << "wall ms"
+            << std::setw(14) << "lines/s" << std::setw(14) << "tokens/s"
+            << std::setw(12) << "alloc KB" << std::setw(13) << "peak RSS KB"
+            << "\n";
+  for (const auto &stage : result.stages) {
+    const auto &sample = stage.sample;
+    std::cout << std::setw(12) << stage.name << std::setw(11) << sample.wallMs
+              << std::setw(14) << perSecond(result.lines, sample.wallMs)
+              << std::setw(14) << perSecond(result.tokens, sample.wallMs)
+              << std::setw(12) << sample.allocatedBytes / 1024
+              << std::setw(13) << sample.peakRssKb << "\n";
+  }
+  std::cout << "\n";
+}
+
+void writeJson(std::ostream &out, const BenchOptions &options,
+               const std::vector<ShapeResult> &results) {
+  out << std::fixed << std::setprecision(3);
+  out << "{\n  \"size\": " << options.generator.size
+      << ",\n  \"depth\": " << options.generator.depth
+      << ",\n  \"seed\": " << options.generator.seed
+      << ",\n  \"repeat\": " << options.repeat
+      << ",\n  \"jobs\": " << options.jobs << ",\n  \"shapes\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto &result = results[i];
+    out << (i ? "," : "") << "\n    {\"shape\": \""
+        << HolyLua::shapeName(result.shape) << "\", \"bytes\": "
+        << result.bytes << ", \"lines\": " << result.lines
+        << ", \"tokens\": " << result.tokens << ", \"stages\": [";
+    for (size_t j = 0; j < result.stages.size(); j++) {
+      const auto &stage = result.stages[j];
+      const auto &sample = stage.sample;
+      out << (j ? "," : "") << "\n      {\"stage\": \"" << stage.name
+          << "\", \"wall_ms\": " << sample.wallMs
+          << ", \"cpu_ms\": " << sample.cpuMs
+          << ", \"lines_per_sec\": " << perSecond(result.lines, sample.wallMs)
+          << ", \"tokens_per_sec\": " << perSecond(result.tokens, sample.wallMs)
+          << ", \"allocations\": " << sample.allocations
+          << ", \"allocated_bytes\": " << sample.allocatedBytes
+          << ", \"peak_rss_kb\": " << sample.peakRssKb << "}";
+    }
+    out << "\n    ]}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+bool parseArgs(int argc, char *argv[], BenchOptions &options) {
+  std::string shape = "all";
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--help" || arg == "-h") {
+      return false;
+    } else if (arg == "--shape" && hasValue) {
+      shape = argv[++i];
+    } else if (arg == "--size" && hasValue) {
+      options.generator.size = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--depth" && hasValue) {
+      options.generator.depth = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--seed" && hasValue) {
+      options.generator.seed = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--repeat" && hasValue) {
+      options.repeat = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+    } else if (arg == "-j" && hasValue) {
+      options.jobs = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--json" && hasValue) {
+      options.jsonPath = argv[++i];
+    } else if (arg == "--emit" && hasValue) {
+      options.emitDir = argv[++i];
+    } else {
+      std::cerr << "Unknown option: " << arg << "\n";
+      return false;
+    }
+  }
+
+  if (shape == "all") {
+    options.shapes = {HolyLua::ProgramShape::FUNCTIONS,
+                      HolyLua::ProgramShape::EXPRESSIONS,
+                      HolyLua::ProgramShape::TYPES,
+                      HolyLua::ProgramShape::BRANCHES,
+                      HolyLua::ProgramShape::SCRIPT};
+  } else {
+    HolyLua::ProgramShape parsed;
+    if (!HolyLua::parseShape(shape, parsed)) {
+      std::cerr << "Unknown shape: " << shape << "\n";
+      return false;
+    }
+    options.shapes = {parsed};
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  BenchOptions options;
+  options.generator.size = 2000;
+  if (!parseArgs(argc, argv, options)) {
+    printUsage();
+    return 1;
+  }
+
+  fs::path dir = options.emitDir.empty() ? fs::temp_directory_path()
+                                         : fs::path(options.emitDir);
+  if (!options.emitDir.empty()) {
+    fs::create_directories(dir);
+  }
+
+  std::vector<ShapeResult> results;
+  std::cout << std::fixed << std::setprecision(1);
+  for (HolyLua::ProgramShape shape : options.shapes) {
+    HolyLua::GeneratorOptions generator = options.generator;
+    generator.shape = shape;
+
+    fs::path path =
+        dir / (std::string("holylua_bench_") + HolyLua::shapeName(shape) + ".hlua");
+    {
+      std::ofstream file(path, std::ios::binary);
+      file << HolyLua::generateProgram(generator);
+    }
+    if (!options.emitDir.empty()) {
+      std::cout << "Wrote " << path.string() << "\n";
+      continue;
+    }
+
+    ShapeResult result;
+    result.shape = shape;
+    for (unsigned run = 0; run < options.repeat; run++) {
+      if (!runOnce(path.string(), options.jobs, result)) {
+        std::cerr << "Generated '" << HolyLua::shapeName(shape)
+                  << "' program failed to compile: " << path.string() << "\n";
+        return 1;
+      }
+    }
+    fs::remove(path);
+
+    printResult(result);
+    results.push_back(std::move(result));
+  }
+
+  if (!options.emitDir.empty()) {
+    return 0;
+  }
+
+  std::ofstream json(options.jsonPath);
+  writeJson(json, options, results);
+  std::cout << "Results written to " << options.jsonPath << "\n";
+  return 0;
+}
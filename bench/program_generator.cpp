@@ -0,0 +1,265 @@
+#include "program_generator.h"
+#include <algorithm>
+#include <random>
+
+namespace HolyLua {
+
+namespace {
+
+class Generator {
+public:
+  explicit Generator(const GeneratorOptions &options)
+      : options(options), random(options.seed) {}
+
+  std::string run() {
+    switch (options.shape) {
+    case ProgramShape::FUNCTIONS:
+      functions();
+      break;
+    case ProgramShape::EXPRESSIONS:
+      expressions();
+      break;
+    case ProgramShape::TYPES:
+      types();
+      break;
+    case ProgramShape::BRANCHES:
+      branches();
+      break;
+    case ProgramShape::SCRIPT:
+      script();
+      break;
+    }
+    return std::move(out);
+  }
+
+private:
+  const GeneratorOptions &options;
+  // raw engine output is specified by the standard, distributions are not,
+  // so programs are identical across standard libraries
+  std::mt19937 random;
+  std::string out;
+
+  size_t pick(size_t bound) { return bound ? random() % bound : 0; }
+
+  void line(int indent, const std::string &text) {
+    out.append(indent * 4, ' ');
+    out += text;
+    out += '\n';
+  }
+
+  // arithmetic over `names`, nested `depth` levels on its left spine with
+  // occasional balanced subtrees
+  std::string expr(size_t depth, const std::string &names0,
+                   const std::string &names1) {
+    if (depth == 0) {
+      switch (pick(3)) {
+      case 0:
+        return names0;
+      case 1:
+        return names1;
+      default:
+        return std::to_string(pick(97) + 1);
+      }
+    }
+    static const char *ops[] = {" + ", " - ", " * "};
+    std::string op = ops[pick(3)];
+    if (pick(4) == 0) {
+      return "(" + expr(depth - 1, names0, names1) + op +
+             expr(depth / 2, names0, names1) + ")";
+    }
+    return expr(depth - 1, names0, names1) + op + expr(0, names0, names1);
+  }
+
+  void functions() {
+    for (size_t i = 0; i < options.size; i++) {
+      std::string name = "f" + std::to_string(i);
+      line(0, "function " + name + "(a: number, b: number): number");
+      line(1, "local t = " + expr(options.depth / 2, "a", "b"));
+      line(1, "if t > " + std::to_string(pick(50)) + " then");
+      line(2, "t = t - b");
+      line(1, "else");
+      line(2, "t = t + a");
+      line(1, "end");
+      line(1, "local i = 0");
+      line(1, "while i < 3 do");
+      line(2, "t += i");
+      line(2, "i += 1");
+      line(1, "end");
+      line(1, "return t");
+      line(0, "end");
+      line(0, "");
+    }
+    line(0, "function main()");
+    line(1, "local total = 0");
+    for (size_t i = 0; i < options.size; i += 1 + options.size / 64) {
+      line(1, "total = total + f" + std::to_string(i) + "(" +
+                  std::to_string(i) + ", 2)");
+    }
+    line(1, "print(total)");
+    line(0, "end");
+  }
+
+  void expressions() {
+    line(0, "function main()");
+    line(1, "local a = 3");
+    line(1, "local b = 7");
+    std::string previous = "a";
+    for (size_t i = 0; i < options.size; i++) {
+      std::string name = "e" + std::to_string(i);
+      line(1, "local " + name + " = " + expr(options.depth, previous, "b"));
+      if (i % 8 == 7) {
+        line(1, "local s" + std::to_string(i) + " = \"v\" .. " + name +
+                    " .. \"-\" .. a .. \"+\" .. b");
+      }
+      previous = name;
+    }
+    line(1, "print(" + previous + ")");
+    line(0, "end");
+  }
+
+  void types() {
+    for (size_t i = 0; i < options.size; i++) {
+      std::string n = std::to_string(i);
+      line(0, "struct S" + n);
+      line(1, "x: number");
+      line(1, "y: number");
+      line(1, "label: string");
+      line(0, "end");
+      line(0, "");
+      line(0, "enum E" + n);
+      line(1, "Idle");
+      line(1, "Busy");
+      line(1, "Done");
+      line(0, "end");
+      line(0, "");
+      line(0, "class C" + n);
+      line(1, "public value: number");
+      line(1, "private step: number");
+      line(1, "public static created: number = 0");
+      line(0, "");
+      line(1, "function __init(start: number)");
+      line(2, "self.value = start");
+      line(2, "self.step = " + std::to_string(pick(9) + 1));
+      line(1, "end");
+      line(0, "");
+      line(1, "function bump()");
+      line(2, "self.value += self.step");
+      line(1, "end");
+      line(0, "");
+      line(1, "function get(): number");
+      line(2, "return self.value");
+      line(1, "end");
+      line(0, "end");
+      line(0, "");
+    }
+    line(0, "function main()");
+    for (size_t i = 0; i < options.size; i += 1 + options.size / 64) {
+      std::string n = std::to_string(i);
+      line(1, "local p" + n + " = S" + n + " { " + n + ", 2, \"p\" }");
+      line(1, "local c" + n + ": C" + n + " = C" + n + "(" + n + ")");
+      line(1, "c" + n + ".bump()");
+      line(1, "local k" + n + ": E" + n + " = E" + n + ".Busy");
+      line(1, "print(p" + n + ".x + c" + n + ".get())");
+    }
+    line(0, "end");
+  }
+
+  void branches() {
+    // chains of up to 256 arms, one per function
+    const size_t armsPerChain = 256;
+    size_t chains = (options.size + armsPerChain - 1) / armsPerChain;
+    for (size_t c = 0; c < chains; c++) {
+      size_t arms = std::min(armsPerChain, options.size - c * armsPerChain);
+      line(0, "function classify" + std::to_string(c) + "(n: number): number");
+      line(1, "local r = 0");
+      for (size_t i = 0; i < arms; i++) {
+        std::string test = "n == " + std::to_string(i);
+        line(1, (i == 0 ? "if " : "elseif ") + test + " then");
+        line(2, "r = " + expr(2, "n", "r"));
+      }
+      line(1, "else");
+      line(2, "r = -1");
+      line(1, "end");
+      line(1, "return r");
+      line(0, "end");
+      line(0, "");
+    }
+    line(0, "function main()");
+    for (size_t c = 0; c < chains; c++) {
+      line(1, "print(classify" + std::to_string(c) + "(" +
+                  std::to_string(pick(armsPerChain)) + "))");
+    }
+    line(0, "end");
+  }
+
+  void script() {
+    line(0, "local v0 = 1");
+    for (size_t i = 1; i < options.size; i++) {
+      std::string v = "v" + std::to_string(i);
+      std::string prev = "v" + std::to_string(i - 1);
+      switch (i % 5) {
+      case 0:
+        line(0, "local " + v + " = " + expr(options.depth / 2, prev, "v0"));
+        break;
+      case 1:
+        line(0, "local " + v + " = " + prev + " + 1");
+        line(0, "if " + v + " > 100 then");
+        line(1, v + " = " + v + " - 100");
+        line(0, "end");
+        break;
+      case 2:
+        line(0, "local " + v + " = 0");
+        line(0, "while " + v + " < 3 do");
+        line(1, v + " += 1");
+        line(0, "end");
+        break;
+      case 3:
+        line(0, "local " + v + " = " + prev);
+        line(0, "for local k = 1, 3 do");
+        line(1, v + " = " + v + " + k");
+        line(0, "end");
+        break;
+      default:
+        line(0, "local " + v + " = " + prev + " * 2");
+        line(0, "print(\"step " + std::to_string(i) + ": \" .. " + v + ")");
+        break;
+      }
+    }
+  }
+};
+
+} // namespace
+
+const char *shapeName(ProgramShape shape) {
+  switch (shape) {
+  case ProgramShape::FUNCTIONS:
+    return "functions";
+  case ProgramShape::EXPRESSIONS:
+    return "expressions";
+  case ProgramShape::TYPES:
+    return "types";
+  case ProgramShape::BRANCHES:
+    return "branches";
+  case ProgramShape::SCRIPT:
+    return "script";
+  }
+  return "unknown";
+}
+
+bool parseShape(const std::string &name, ProgramShape &shape) {
+  for (ProgramShape candidate :
+       {ProgramShape::FUNCTIONS, ProgramShape::EXPRESSIONS,
+        ProgramShape::TYPES, ProgramShape::BRANCHES, ProgramShape::SCRIPT}) {
+    if (name == shapeName(candidate)) {
+      shape = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string generateProgram(const GeneratorOptions &options) {
+  return Generator(options).run();
+}
+
+} // namespace HolyLua
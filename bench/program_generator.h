@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace HolyLua {
+
+// kinds of synthetic program, each stressing a different part of the
+// frontend
+enum class ProgramShape {
+  FUNCTIONS,   // many small functions calling each other
+  EXPRESSIONS, // locals initialised by deep arithmetic and concat trees
+  TYPES,       // many structs, enums and classes with methods
+  BRANCHES,    // long if/elseif chains
+  SCRIPT       // large scripting-mode top level, no main()
+};
+
+struct GeneratorOptions {
+  ProgramShape shape = ProgramShape::FUNCTIONS;
+  size_t size = 1000;  // functions, locals, types, arms or statements
+  size_t depth = 8;    // expression nesting
+  uint32_t seed = 1;
+};
+
+const char *shapeName(ProgramShape shape);
+bool parseShape(const std::string &name, ProgramShape &shape);
+
+// deterministic for a given set of options, and always type checks
+std::string generateProgram(const GeneratorOptions &options);
+
+} // namespace HolyLua
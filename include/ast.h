@@ -1,7 +1,11 @@
 #pragma once
+#include "ast_arena.h"
+#include "type_name.h"
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -9,7 +13,7 @@ namespace HolyLua {
 
 struct StructDecl;
 
-enum class ValueType { NUMBER, STRING, BOOL, INFERRED, FUNCTION, STRUCT, ENUM };
+enum class ValueType { NUMBER, STRING, BOOL, INFERRED, FUNCTION, STRUCT, ENUM, INT };
 
 std::string valueTypeToString(ValueType type);
 
@@ -40,108 +44,201 @@ enum class BinaryOp {
 
 enum class UnaryOp { NEGATE, NOT };
 
+// one tag per concrete node type, expressions first so isExpr() is a range
+// check. passes switch on the tag instead of probing with dynamic_cast.
+enum class NodeKind {
+  LITERAL,
+  VAR,
+  FUNCTION_CALL,
+  BINARY,
+  UNARY,
+  FORCE_UNWRAP,
+  NIL,
+  LAMBDA,
+  STRUCT_CONSTRUCTOR,
+  FIELD_ACCESS,
+  CLASS_INSTANTIATION,
+  METHOD_CALL,
+  SELF,
+  ENUM_ACCESS,
+  VAR_DECL,
+  FUNCTION_DECL,
+  RETURN,
+  ASSIGNMENT,
+  PRINT,
+  IF,
+  INLINE_C,
+  WHILE,
+  FOR,
+  REPEAT,
+  STRUCT_DECL,
+  CLASS_DECL,
+  FIELD_ASSIGNMENT,
+  ENUM_DECL
+};
+
+// nodes live in the program's AstArena: allocate them with
+// `new (arena) Node(...)`. deleting a node only runs its destructor, the
+// memory itself is released with the arena. a program that lives until the
+// process exits can skip the destructors, see Program::abandon().
 struct ASTNode {
+  const NodeKind kind;
   int line = 0;
+
+  explicit ASTNode(NodeKind k) : kind(k) {}
   virtual ~ASTNode() = default;
+
+  bool isExpr() const { return kind <= NodeKind::ENUM_ACCESS; }
+
+  static void *operator new(std::size_t size, AstArena &arena) {
+    return arena.allocate(size);
+  }
+  static void operator delete(void *, AstArena &) noexcept {}
+  static void operator delete(void *) noexcept {}
+  static void *operator new(std::size_t) = delete;
+};
+
+// type pinned down for an expression by an earlier pass. the type checker
+// records what it resolves (literals, operators, constructors, calls and
+// field accesses), codegen fills in the rest the first time it asks and
+// reads the annotation from then on.
+struct TypeAnnotation {
+  ValueType type = ValueType::INFERRED;
+  std::string typeName; // struct, class or enum name when the type has one
+  bool resolved = false;
 };
 
 struct Expr : public ASTNode {
+  // passes walk `const Expr *`, the annotation is a cache on top of the tree
+  mutable TypeAnnotation resolvedType;
+
+  explicit Expr(NodeKind k) : ASTNode(k) {}
   virtual ~Expr() = default;
+
+  void annotate(ValueType type, const std::string &typeName = "") const {
+    resolvedType.type = type;
+    resolvedType.typeName = typeName;
+    resolvedType.resolved = true;
+  }
 };
 
 struct LiteralExpr : public Expr {
+  static constexpr NodeKind KIND = NodeKind::LITERAL;
+
   std::variant<int64_t, double, std::string, bool> value;
-  LiteralExpr(std::variant<int64_t, double, std::string, bool> v) : value(v) {}
+  LiteralExpr(std::variant<int64_t, double, std::string, bool> v) : Expr(KIND), value(v) {}
 };
 
 struct VarExpr : public Expr {
-  std::string name;
-  VarExpr(std::string n) : name(n) {}
+  static constexpr NodeKind KIND = NodeKind::VAR;
+
+  const std::string &name;
+  VarExpr(const std::string &n) : Expr(KIND), name(n) {}
 };
 
 struct FunctionCall : public Expr {
-  std::string name;
+  static constexpr NodeKind KIND = NodeKind::FUNCTION_CALL;
+
+  const std::string &name;
   std::vector<std::unique_ptr<Expr>> arguments;
 
-  FunctionCall(std::string n, std::vector<std::unique_ptr<Expr>> args)
-      : name(n), arguments(std::move(args)) {}
+  FunctionCall(const std::string &n, std::vector<std::unique_ptr<Expr>> args)
+      : Expr(KIND), name(n), arguments(std::move(args)) {}
 };
 
 struct BinaryExpr : public Expr {
+  static constexpr NodeKind KIND = NodeKind::BINARY;
+
   std::unique_ptr<Expr> left;
   BinaryOp op;
   std::unique_ptr<Expr> right;
   BinaryExpr(std::unique_ptr<Expr> l, BinaryOp o, std::unique_ptr<Expr> r)
-      : left(std::move(l)), op(o), right(std::move(r)) {}
+      : Expr(KIND), left(std::move(l)), op(o), right(std::move(r)) {}
+  // unlinks a left-leaning chain one operator at a time instead of recursing
+  ~BinaryExpr() override;
 };
 
 struct UnaryExpr : public Expr {
+  static constexpr NodeKind KIND = NodeKind::UNARY;
+
   UnaryOp op;
   std::unique_ptr<Expr> operand;
   UnaryExpr(UnaryOp o, std::unique_ptr<Expr> operand)
-      : op(o), operand(std::move(operand)) {}
+      : Expr(KIND), op(o), operand(std::move(operand)) {}
 };
 
 struct ForceUnwrapExpr : public Expr {
+  static constexpr NodeKind KIND = NodeKind::FORCE_UNWRAP;
+
   std::unique_ptr<Expr> operand;
   ForceUnwrapExpr(std::unique_ptr<Expr> operand)
-      : operand(std::move(operand)) {}
+      : Expr(KIND), operand(std::move(operand)) {}
 };
 
 struct NilExpr : public Expr {
-  NilExpr() = default;
+  static constexpr NodeKind KIND = NodeKind::NIL;
+
+  NilExpr() : Expr(KIND) {}
 };
 
 struct VarDecl : public ASTNode {
+  static constexpr NodeKind KIND = NodeKind::VAR_DECL;
+
   bool isGlobal;
   bool isConst;
-  std::string name;
+  const std::string &name;
   ValueType type;
   bool isOptional;
   std::unique_ptr<Expr> value;
   bool hasValue;
-  std::string typeName;
+  TypeName typeName; // the annotation as written, empty when there is none
 
-  VarDecl(bool global, bool cnst, std::string n, ValueType t,
+  VarDecl(bool global, bool cnst, const std::string &n, ValueType t,
           bool optional = false)
-      : isGlobal(global), isConst(cnst), name(n), type(t), isOptional(optional),
-        hasValue(false), typeName("") {}
+      : ASTNode(KIND), isGlobal(global), isConst(cnst), name(n), type(t), isOptional(optional),
+        hasValue(false) {}
 };
 
 struct FunctionDecl : public ASTNode {
-  std::string name;
+  static constexpr NodeKind KIND = NodeKind::FUNCTION_DECL;
+
+  const std::string &name;
   std::vector<std::pair<std::string, ValueType>> parameters;
   std::vector<bool> parameterOptionals;
   ValueType returnType;
   std::vector<std::unique_ptr<ASTNode>> body;
   bool isGlobal;
 
-  FunctionDecl(std::string n,
+  FunctionDecl(const std::string &n,
                std::vector<std::pair<std::string, ValueType>> params,
                ValueType retType, bool global = false)
-      : name(n), parameters(std::move(params)), returnType(retType),
+      : ASTNode(KIND), name(n), parameters(std::move(params)), returnType(retType),
         isGlobal(global) {
     parameterOptionals.resize(parameters.size(), false);
   }
 };
 
 struct ReturnStmt : public ASTNode {
+  static constexpr NodeKind KIND = NodeKind::RETURN;
+
   std::unique_ptr<Expr> value;
 
-  ReturnStmt(std::unique_ptr<Expr> v = nullptr) : value(std::move(v)) {}
+  ReturnStmt(std::unique_ptr<Expr> v = nullptr) : ASTNode(KIND), value(std::move(v)) {}
 };
 
 struct Assignment : public ASTNode {
-  std::string name;
+  static constexpr NodeKind KIND = NodeKind::ASSIGNMENT;
+
+  const std::string &name;
   std::unique_ptr<Expr> value;
   bool isCompound;
   BinaryOp compoundOp;
 
-  Assignment(std::string n, std::unique_ptr<Expr> v)
-      : name(n), value(std::move(v)), isCompound(false) {}
+  Assignment(const std::string &n, std::unique_ptr<Expr> v)
+      : ASTNode(KIND), name(n), value(std::move(v)), isCompound(false) {}
 
-  Assignment(std::string n, std::unique_ptr<Expr> v, BinaryOp op)
-      : name(n), value(std::move(v)), isCompound(true), compoundOp(op) {}
+  Assignment(const std::string &n, std::unique_ptr<Expr> v, BinaryOp op)
+      : ASTNode(KIND), name(n), value(std::move(v)), isCompound(true), compoundOp(op) {}
 };
 
 struct PrintArg {
@@ -155,57 +252,101 @@ struct PrintArg {
 };
 
 struct PrintStmt : public ASTNode {
+  static constexpr NodeKind KIND = NodeKind::PRINT;
+
   std::vector<PrintArg> arguments;
-  PrintStmt(std::vector<PrintArg> args) : arguments(std::move(args)) {}
+  PrintStmt(std::vector<PrintArg> args) : ASTNode(KIND), arguments(std::move(args)) {}
 };
 
 struct IfStmt : public ASTNode {
+  static constexpr NodeKind KIND = NodeKind::IF;
+
   std::unique_ptr<Expr> condition;
   std::vector<std::unique_ptr<ASTNode>> thenBlock;
   std::vector<std::pair<std::unique_ptr<Expr>, std::vector<std::unique_ptr<ASTNode>>>> elseifBranches;
   std::vector<std::unique_ptr<ASTNode>> elseBlock;
 
-  IfStmt(std::unique_ptr<Expr> cond) : condition(std::move(cond)) {}
+  IfStmt(std::unique_ptr<Expr> cond) : ASTNode(KIND), condition(std::move(cond)) {}
+};
+
+struct VarDecl;
+struct FunctionDecl;
+struct StructDecl;
+struct ClassDecl;
+struct EnumDecl;
+
+// top-level statements bucketed by kind while parsing, so each pass walks
+// only the declarations it needs. nodes are owned by Program::statements and
+// every bucket keeps source order.
+struct DeclarationIndex {
+  std::vector<EnumDecl *> enums;
+  std::vector<StructDecl *> structs;
+  std::vector<ClassDecl *> classes;
+  std::vector<FunctionDecl *> functions;
+  // every top-level variable, local or global
+  std::vector<VarDecl *> globals;
+  // what runs in main(): variables and plain statements
+  std::vector<ASTNode *> statements;
+
+  void add(ASTNode *node);
 };
 
 struct Program {
+  // declared first so the nodes are destroyed before their storage
+  std::unique_ptr<AstArena> arena;
   std::vector<std::unique_ptr<ASTNode>> statements;
+  DeclarationIndex declarations;
+
+  // lets go of the tree without tearing it down: neither the node
+  // destructors nor the arena's are run and the memory is left to the OS, so
+  // only call this when the process is about to exit
+  void abandon();
 };
 
 struct InlineCStmt : public ASTNode {
+  static constexpr NodeKind KIND = NodeKind::INLINE_C;
+
   std::string cCode;
 
-  InlineCStmt(std::string code) : cCode(code) {}
+  InlineCStmt(std::string code) : ASTNode(KIND), cCode(code) {}
 };
 
 struct WhileStmt : public ASTNode {
+  static constexpr NodeKind KIND = NodeKind::WHILE;
+
   std::unique_ptr<Expr> condition;
   std::vector<std::unique_ptr<ASTNode>> body;
 
-  WhileStmt(std::unique_ptr<Expr> cond) : condition(std::move(cond)) {}
+  WhileStmt(std::unique_ptr<Expr> cond) : ASTNode(KIND), condition(std::move(cond)) {}
 };
 
 struct ForStmt : public ASTNode {
-  std::string varName;
+  static constexpr NodeKind KIND = NodeKind::FOR;
+
+  const std::string &varName;
   std::unique_ptr<Expr> start;
   std::unique_ptr<Expr> end;
   std::unique_ptr<Expr> step;
   std::vector<std::unique_ptr<ASTNode>> body;
 
-  ForStmt(std::string var, std::unique_ptr<Expr> s, std::unique_ptr<Expr> e,
+  ForStmt(const std::string &var, std::unique_ptr<Expr> s, std::unique_ptr<Expr> e,
           std::unique_ptr<Expr> st = nullptr)
-      : varName(var), start(std::move(s)), end(std::move(e)),
+      : ASTNode(KIND), varName(var), start(std::move(s)), end(std::move(e)),
         step(std::move(st)) {}
 };
 
 struct RepeatStmt : public ASTNode {
+  static constexpr NodeKind KIND = NodeKind::REPEAT;
+
   std::unique_ptr<Expr> condition;
   std::vector<std::unique_ptr<ASTNode>> body;
 
-  RepeatStmt(std::unique_ptr<Expr> cond) : condition(std::move(cond)) {}
+  RepeatStmt(std::unique_ptr<Expr> cond) : ASTNode(KIND), condition(std::move(cond)) {}
 };
 
 struct LambdaExpr : public Expr {
+  static constexpr NodeKind KIND = NodeKind::LAMBDA;
+
   std::vector<std::pair<std::string, ValueType>> parameters;
   std::vector<bool> parameterOptionals;
   ValueType returnType;
@@ -213,7 +354,7 @@ struct LambdaExpr : public Expr {
 
   LambdaExpr(std::vector<std::pair<std::string, ValueType>> params,
              ValueType retType = ValueType::INFERRED)
-      : parameters(std::move(params)), returnType(retType) {
+      : Expr(KIND), parameters(std::move(params)), returnType(retType) {
     parameterOptionals.resize(parameters.size(), false);
   }
 };
@@ -224,57 +365,63 @@ struct StructField {
   bool isOptional;
   bool hasDefault;
   std::variant<int64_t, double, std::string, bool, std::nullptr_t> defaultValue;
-  std::string structTypeName;
+  TypeName structTypeName;
 
   StructField(std::string n, ValueType t, bool optional = false,
               bool hasDef = false)
       : name(n), type(t), isOptional(optional), hasDefault(hasDef),
-        defaultValue(nullptr), structTypeName("") {}
+        defaultValue(nullptr) {}
 
-  StructField(std::string n, ValueType t, std::string structType,
+  StructField(std::string n, ValueType t, TypeName structType,
               bool optional = false)
       : name(n), type(t), isOptional(optional), hasDefault(false),
         defaultValue(nullptr), structTypeName(structType) {}
 
   StructField(std::string n, ValueType t, int64_t defaultVal)
       : name(n), type(t), isOptional(false), hasDefault(true),
-        defaultValue(defaultVal), structTypeName("") {}
+        defaultValue(defaultVal) {}
 
   StructField(std::string n, ValueType t, double defaultVal)
       : name(n), type(t), isOptional(false), hasDefault(true),
-        defaultValue(defaultVal), structTypeName("") {}
+        defaultValue(defaultVal) {}
 
   StructField(std::string n, ValueType t, const std::string &defaultVal)
       : name(n), type(t), isOptional(false), hasDefault(true),
-        defaultValue(defaultVal), structTypeName("") {}
+        defaultValue(defaultVal) {}
 
   StructField(std::string n, ValueType t, bool defaultVal)
       : name(n), type(t), isOptional(false), hasDefault(true),
-        defaultValue(defaultVal), structTypeName("") {}
+        defaultValue(defaultVal) {}
 };
 
 struct StructDecl : public ASTNode {
-  std::string name;
+  static constexpr NodeKind KIND = NodeKind::STRUCT_DECL;
+
+  const std::string &name;
   std::vector<StructField> fields;
 
-  StructDecl(std::string n) : name(n) {}
+  StructDecl(const std::string &n) : ASTNode(KIND), name(n) {}
 };
 
 struct StructConstructor : public Expr {
-  std::string structName;
+  static constexpr NodeKind KIND = NodeKind::STRUCT_CONSTRUCTOR;
+
+  const std::string &structName;
   std::vector<std::pair<std::string, std::unique_ptr<Expr>>> namedArgs;
   std::vector<std::unique_ptr<Expr>> positionalArgs;
   bool useDefaults;
 
-  StructConstructor(std::string name) : structName(name), useDefaults(false) {}
+  StructConstructor(const std::string &name) : Expr(KIND), structName(name), useDefaults(false) {}
 };
 
 struct FieldAccessExpr : public Expr {
+  static constexpr NodeKind KIND = NodeKind::FIELD_ACCESS;
+
   std::unique_ptr<Expr> object;
-  std::string fieldName;
+  const std::string &fieldName;
 
-  FieldAccessExpr(std::unique_ptr<Expr> obj, std::string field)
-      : object(std::move(obj)), fieldName(field) {}
+  FieldAccessExpr(std::unique_ptr<Expr> obj, const std::string &field)
+      : Expr(KIND), object(std::move(obj)), fieldName(field) {}
 };
 
 struct ClassField {
@@ -286,13 +433,12 @@ struct ClassField {
   bool hasDefault;
   bool isConst;
   std::variant<int64_t, double, std::string, bool, std::nullptr_t> defaultValue;
-  std::string structTypeName;
+  TypeName structTypeName;
   
   ClassField(Visibility vis, bool staticMember, std::string n, ValueType t, 
              bool optional = false, bool hasDef = false)
       : visibility(vis), isStatic(staticMember), name(n), type(t), 
-        isOptional(optional), hasDefault(hasDef), isConst(false), defaultValue(nullptr), 
-        structTypeName("") {}
+        isOptional(optional), hasDefault(hasDef), isConst(false), defaultValue(nullptr) {}
 };
 
 struct ClassMethod {
@@ -301,7 +447,7 @@ struct ClassMethod {
   std::string name;
   std::vector<std::pair<std::string, ValueType>> parameters;
   std::vector<bool> parameterOptionals;
-  std::vector<std::string> parameterTypeNames;
+  std::vector<TypeName> parameterTypeNames;
   ValueType returnType;
   std::vector<std::unique_ptr<ASTNode>> body;
   int line;
@@ -314,75 +460,122 @@ struct ClassMethod {
 };
 
 struct ClassDecl : public ASTNode {
-  std::string name;
+  static constexpr NodeKind KIND = NodeKind::CLASS_DECL;
+
+  const std::string &name;
   std::vector<ClassField> fields;
   std::vector<ClassMethod> methods;
   std::unique_ptr<ClassMethod> constructor;
   
-  ClassDecl(std::string n) : name(n), constructor(nullptr) {}
+  ClassDecl(const std::string &n) : ASTNode(KIND), name(n), constructor(nullptr) {}
   
   ClassDecl(const ClassDecl&) = delete;
   ClassDecl& operator=(const ClassDecl&) = delete;
-
-  ClassDecl(ClassDecl&&) = default;
-  ClassDecl& operator=(ClassDecl&&) = default;
 };
 
 struct FieldAssignment : public ASTNode {
+  static constexpr NodeKind KIND = NodeKind::FIELD_ASSIGNMENT;
+
   std::unique_ptr<Expr> object;
-  std::string fieldName;
+  const std::string &fieldName;
   std::unique_ptr<Expr> value;
   bool isCompound;
   BinaryOp compoundOp;
   
-  FieldAssignment(std::unique_ptr<Expr> obj, std::string field, 
+  FieldAssignment(std::unique_ptr<Expr> obj, const std::string &field,
                   std::unique_ptr<Expr> val)
-      : object(std::move(obj)), fieldName(field), value(std::move(val)),
+      : ASTNode(KIND), object(std::move(obj)), fieldName(field), value(std::move(val)),
         isCompound(false) {}
   
-  FieldAssignment(std::unique_ptr<Expr> obj, std::string field,
+  FieldAssignment(std::unique_ptr<Expr> obj, const std::string &field,
                   std::unique_ptr<Expr> val, BinaryOp op)
-      : object(std::move(obj)), fieldName(field), value(std::move(val)),
+      : ASTNode(KIND), object(std::move(obj)), fieldName(field), value(std::move(val)),
         isCompound(true), compoundOp(op) {}
 };
 
 struct ClassInstantiation : public Expr {
-  std::string className;
+  static constexpr NodeKind KIND = NodeKind::CLASS_INSTANTIATION;
+
+  const std::string &className;
   std::vector<std::unique_ptr<Expr>> arguments;
   
-  ClassInstantiation(std::string name, std::vector<std::unique_ptr<Expr>> args)
-      : className(name), arguments(std::move(args)) {}
+  ClassInstantiation(const std::string &name, std::vector<std::unique_ptr<Expr>> args)
+      : Expr(KIND), className(name), arguments(std::move(args)) {}
 };
 
 struct MethodCall : public Expr {
+  static constexpr NodeKind KIND = NodeKind::METHOD_CALL;
+
   std::unique_ptr<Expr> object;
-  std::string methodName;
+  const std::string &methodName;
   std::vector<std::unique_ptr<Expr>> arguments;
   
-  MethodCall(std::unique_ptr<Expr> obj, std::string method,
+  MethodCall(std::unique_ptr<Expr> obj, const std::string &method,
              std::vector<std::unique_ptr<Expr>> args)
-      : object(std::move(obj)), methodName(method), arguments(std::move(args)) {}
+      : Expr(KIND), object(std::move(obj)), methodName(method), arguments(std::move(args)) {}
 };
 
 struct SelfExpr : public Expr {
-  SelfExpr() = default;
+  static constexpr NodeKind KIND = NodeKind::SELF;
+
+  SelfExpr() : Expr(KIND) {}
 };
 
 struct EnumDecl : public ASTNode {
-  std::string name;
+  static constexpr NodeKind KIND = NodeKind::ENUM_DECL;
+
+  const std::string &name;
   std::vector<std::string> values;
   
-  EnumDecl(std::string n) : name(n) {}
+  EnumDecl(const std::string &n) : ASTNode(KIND), name(n) {}
 };
 
 struct EnumAccessExpr : public Expr {
-  std::string enumName;
-  std::string valueName;
+  static constexpr NodeKind KIND = NodeKind::ENUM_ACCESS;
+
+  const std::string &enumName;
+  const std::string &valueName;
   
-  EnumAccessExpr(std::string enumN, std::string valN)
-      : enumName(enumN), valueName(valN) {}
+  EnumAccessExpr(const std::string &enumN, const std::string &valN)
+      : Expr(KIND), enumName(enumN), valueName(valN) {}
 };
 
+// tag-checked downcast, returns nullptr when the node is of another kind
+template <typename T> bool isNode(const ASTNode *node) {
+  if constexpr (std::is_same_v<T, Expr>) {
+    return node && node->isExpr();
+  } else {
+    return node && node->kind == T::KIND;
+  }
+}
+
+template <typename T> T *nodeCast(ASTNode *node) {
+  return isNode<T>(node) ? static_cast<T *>(node) : nullptr;
+}
+
+template <typename T> const T *nodeCast(const ASTNode *node) {
+  return isNode<T>(node) ? static_cast<const T *>(node) : nullptr;
+}
+
+// operators of a chain like a + b + c, outermost first. parsed chains lean
+// left as deep as they are long, so passes walk this spine in a loop and
+// recurse only into the right operands. the innermost left operand is
+// spine.back()->left
+std::vector<const BinaryExpr *> leftSpine(const BinaryExpr *bin);
+
+// integer literals, negated or combined with + - * % //. they have no type
+// of their own and stay integral next to an int operand
+bool isIntegerConstant(const Expr *expr);
+
+// + - * % // stay int when both operands are int or integer constants and
+// at least one of them is int, any other arithmetic yields a number
+ValueType arithmeticResultType(BinaryOp op, const Expr *left, ValueType leftType,
+                               const Expr *right, ValueType rightType);
+
+// type of a declaration without an annotation: its initializer's, except
+// that a bare integer constant declares a number. an int expression (int
+// variables, int arithmetic, int calls) stays int
+ValueType declarationType(const Expr *value, ValueType valueType);
 
 struct ASTPrinter {
   int indentLevel = 0;
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace HolyLua {
+
+// bump allocator that owns every node of a parsed program. nodes are carved
+// out of large blocks and released together when the arena is destroyed;
+// identifier names are interned so each distinct name is stored once.
+class AstArena {
+public:
+  AstArena() = default;
+  AstArena(const AstArena &) = delete;
+  AstArena &operator=(const AstArena &) = delete;
+
+  void *allocate(std::size_t size,
+                 std::size_t align = alignof(std::max_align_t));
+
+  // returns a reference that stays valid for the lifetime of the arena
+  const std::string &intern(std::string_view name);
+
+  std::size_t bytesUsed() const { return used; }
+  std::size_t bytesReserved() const { return reserved; }
+
+private:
+  static constexpr std::size_t MIN_BLOCK_SIZE = 64 * 1024;
+  static constexpr std::size_t MAX_BLOCK_SIZE = 4 * 1024 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char *cursor = nullptr;
+  char *limit = nullptr;
+  std::size_t nextBlockSize = MIN_BLOCK_SIZE;
+  std::size_t used = 0;
+  std::size_t reserved = 0;
+  std::unordered_set<std::string> names;
+
+  void grow(std::size_t minSize);
+};
+
+} // namespace HolyLua
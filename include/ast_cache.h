@@ -0,0 +1,27 @@
+#pragma once
+#include "ast.h"
+#include <string>
+#include <string_view>
+
+namespace HolyLua {
+
+// parsed programs stored as a compact binary file, one per source content.
+// the key hashes the source text together with the compiler binary and the
+// format version, so an edit or a rebuilt compiler simply misses. entries are
+// mmapped and decoded straight into a fresh arena; a missing, truncated or
+// foreign file is a miss, never an error.
+class AstCache {
+public:
+  explicit AstCache(std::string directory);
+
+  // file the program parsed from `source` is stored in
+  std::string pathFor(std::string_view source) const;
+
+  bool load(std::string_view source, Program &program) const;
+  bool store(std::string_view source, const Program &program) const;
+
+private:
+  std::string directory;
+};
+
+} // namespace HolyLua
@@ -2,6 +2,7 @@
 #include "ast.h"
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace HolyLua {
@@ -13,37 +14,49 @@ struct TypeInfo {
     bool isOptional;
     bool isFunction;
     bool isStruct;
-    std::string structTypeName;
+    TypeName structTypeName;
 };
 
+enum class MemberKind { FIELD, METHOD };
+
+// one entry of a class or struct member index
+struct MemberInfo {
+  MemberKind kind;
+  ValueType type; // field type, or method return type
+  Visibility visibility;
+  bool isStatic;
+  bool isOptional;
+  TypeName structTypeName;
+  std::string cName; // symbol the member is emitted as
+  size_t slot;       // declaration order, which is also the struct layout order
+};
+
+using MemberIndex = std::unordered_map<std::string, MemberInfo>;
+
 struct ClassInfo {
   std::string name;
   std::vector<ClassField> fields;
-  std::map<std::string, std::pair<ValueType, Visibility>> fieldInfo;
-  std::map<std::string, std::pair<ValueType, Visibility>> methodInfo;
-  std::map<std::string, bool> methodIsStatic;
-  std::map<std::string, bool> fieldIsStatic;
+  // fields, methods and __init by name, built once per class
+  MemberIndex members;
   
   bool hasConstructor = false;
   std::vector<std::pair<std::string, ValueType>> constructorParams;
   std::vector<bool> constructorParamOptionals;
-  std::vector<std::string> constructorParamTypeNames;
-  
-  ClassInfo() = default;
+  std::vector<TypeName> constructorParamTypeNames;
   
-  ClassInfo(ClassInfo&& other) = default;
-  ClassInfo& operator=(ClassInfo&& other) = default;
-  
-  ClassInfo(const ClassInfo&) = delete;
-  ClassInfo& operator=(const ClassInfo&) = delete;
+  void indexMembers(const ClassDecl &decl);
+  const MemberInfo *findField(const std::string &member) const;
+  const MemberInfo *findMethod(const std::string &member) const;
 };
 
 
 struct StructInfo {
   std::string name;
   std::vector<StructField> fields;
-  std::map<std::string, std::pair<ValueType, bool>>
-      fieldTypes;
+  MemberIndex members;
+
+  void indexMembers(const StructDecl &decl);
+  const MemberInfo *findField(const std::string &member) const;
 };
 
 struct Variable {
@@ -53,10 +66,10 @@ struct Variable {
   bool isOptional;
   bool isFunction;
   bool isStruct;
-  std::string structTypeName;
+  TypeName structTypeName;
 
   Variable() = default;
-  Variable(ValueType t, bool c, bool d, bool o, bool f, bool s = false, std::string stn = "")
+  Variable(ValueType t, bool c, bool d, bool o, bool f, bool s = false, TypeName stn = TypeName())
       : type(t), isConst(c), isDefined(d), isOptional(o), isFunction(f), isStruct(s), structTypeName(stn) {}
 };
 
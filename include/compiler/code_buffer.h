@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace HolyLua {
+
+// generated C kept as a list of chunks. a statement compiles into its own
+// section which is spliced onto the enclosing one by moving chunks, so text
+// that was already emitted is never copied again.
+class CodeBuffer {
+public:
+  CodeBuffer() = default;
+  CodeBuffer(CodeBuffer &&) = default;
+  CodeBuffer &operator=(CodeBuffer &&) = default;
+  CodeBuffer(const CodeBuffer &) = delete;
+  CodeBuffer &operator=(const CodeBuffer &) = delete;
+
+  CodeBuffer &operator+=(const std::string &text);
+  CodeBuffer &operator+=(CodeBuffer &&other);
+
+  // replaces the contents of the current section
+  CodeBuffer &operator=(const std::string &text);
+
+  bool empty() const { return length == 0; }
+  std::size_t size() const { return length; }
+  void clear();
+
+  // start a nested section, then either splice it back onto the enclosing
+  // one or detach it (e.g. for hoisted nested function bodies)
+  void openSection();
+  void closeSection();
+  CodeBuffer takeSection();
+
+  std::string str() const;
+  void writeTo(std::ostream &out) const;
+
+private:
+  struct Section {
+    std::vector<std::string> chunks;
+    std::size_t length = 0;
+  };
+
+  std::vector<std::string> chunks;
+  std::size_t length = 0;
+  std::vector<Section> enclosing;
+
+  void restoreEnclosing();
+};
+
+} // namespace HolyLua
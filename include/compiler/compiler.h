@@ -1,8 +1,14 @@
 #pragma once
 #include "../ast.h"
 #include "../common.h"
+#include "../utils/source_manager.h"
+#include "code_buffer.h"
+#include "symbol_table.h"
 #include <cstdint>
 #include <map>
+#include <optional>
+#include <ostream>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -12,28 +18,95 @@ namespace HolyLua {
 
 class Compiler {
 public:
-  Compiler(const std::string &source);
-  std::string compile(const Program &program);
+  Compiler(const SourceManager &sources);
+  // compile classes and functions on up to `jobs` threads. the generated C
+  // does not depend on the job count
+  void setJobs(unsigned jobs);
+  CodeBuffer compile(const Program &program);
 
 private:
-  std::unordered_map<std::string, Variable> symbolTable;
+  // a class or top-level function compiled into its own buffers
+  struct CodegenUnit {
+    const ClassDecl *classDecl = nullptr;
+    const FunctionDecl *function = nullptr;
+    CodeBuffer code;
+    CodeBuffer nestedDecls;
+    std::string diagnostics;
+    bool failed = false;
+  };
+
+  SymbolTable symbolTable;
   std::unordered_map<std::string, FunctionInfo> functionTable;
-  std::string output;
-  std::string source;
-  std::vector<std::string> sourceLines;
+  CodeBuffer output;
+  const SourceManager &sources;
   int indentLevel = 1;
   std::string currentFunction;
   std::unordered_set<std::string> nonNilVars;
   std::vector<std::unordered_set<std::string>> nonNilVarStack;
-  std::string nestedFunctionDecls;
+  CodeBuffer nestedFunctionDecls;
   std::vector<std::pair<std::string, ValueType>> currentFunctionParams;
   std::vector<std::pair<std::string, std::string>> structDefs;
   std::map<std::string, StructInfo> structTable;
   std::map<std::string, ClassInfo> classTable;
   std::string currentClass;
   std::map<std::string, std::vector<std::string>> enumTable;
+  std::map<std::string, std::set<std::string>> constFieldAssignments;
+  // signatures resolved before any body is compiled
+  std::unordered_map<const FunctionDecl *, ValueType> declaredReturnTypes;
+  // previous entries of functionTable names written since a mark
+  std::vector<std::pair<std::string, std::optional<FunctionInfo>>> functionUndo;
+  std::ostream *diagnostics;
+  // errors reported so far, any of them fails the whole compilation
+  int errorCount = 0;
+  unsigned jobs = 1;
+  size_t uniqueNameSpace = 0;
+  int uniqueNameCounter = 0;
+  // strings built by the expression being compiled die with its statement
+  // (printed, compared, concatenated) and may come from the scratch region
+  bool scratchStrings = false;
+  // the current statement / function body built scratch strings
+  bool statementScratch = false;
+  bool functionScratch = false;
+  // a statement enclosing the current one still holds scratch strings
+  bool enclosingScratch = false;
+
+  // sets scratchStrings while an operand is compiled. operands that can be
+  // stored (call arguments, constructor fields) always use the heap
+  class StringLifetime {
+  public:
+    StringLifetime(Compiler &compiler, bool scratch)
+        : compiler(compiler), enclosing(compiler.scratchStrings) {
+      compiler.scratchStrings = scratch;
+    }
+    ~StringLifetime() { compiler.scratchStrings = enclosing; }
+
+  private:
+    Compiler &compiler;
+    bool enclosing;
+  };
+
+  // a local that owns heap strings: a string, or a struct whose fields
+  // hold some. it is released when its block ends and before a return
+  struct OwnedLocal {
+    std::string name;
+    std::string structType; // empty for a string
+  };
+  // owned locals of the current function, one list per open block
+  std::vector<std::vector<OwnedLocal>> ownedLocals;
+  // the statement just compiled was a return, so its block ends there
+  bool returned = false;
+
+  struct ScratchState {
+    bool strings;
+    bool statement;
+    bool function;
+    bool enclosing;
+    std::vector<std::vector<OwnedLocal>> owned;
+  };
+
+  // worker copy: shares the declaration tables, starts with empty buffers
+  Compiler(const Compiler &parent);
 
-  void initSourceLines();
   std::string indent();
 
   void error(const std::string &msg, int line);
@@ -45,10 +118,15 @@ private:
   bool isProvenNonNil(const std::string &varName);
   bool checkVariable(const std::string &name);
   bool checkFunction(const std::string &name);
+  bool checkIntValue(ValueType target, ValueType valueType, const Expr *value,
+                     const std::string &name, int line);
   bool validateExpr(const Expr *expr);
   bool isOptionalExpr(const Expr *expr);
   std::string generateUniqueName(const std::string &base);
 
+  void compileUnits(std::vector<CodegenUnit> &units);
+  void compileUnit(CodegenUnit &unit, size_t index);
+
   std::string getCTypeForStruct(const std::string &structName);
   std::string getCType(ValueType type, const std::string &structTypeName = "");
   std::string getCTypeWithOptional(ValueType type, bool isOptional);
@@ -65,8 +143,35 @@ private:
   std::string generateNilCheck(const std::string &varName, ValueType type);
 
   void compileStatement(const ASTNode *node);
+  void releaseStatementScratch();
+  ScratchState beginFunctionBody();
+  void endFunctionBody(ScratchState &enclosing);
   void compileInlineCStmt(const InlineCStmt *stmt);
 
+  void ownedFields(const std::string &typeName,
+                   std::vector<std::pair<std::string, std::string>> &fields);
+  bool ownsStrings(const std::string &typeName);
+  std::string ownershipHelpers(const std::string &typeName);
+  std::string ownedStructType(const Expr *expr);
+  bool isFreshString(const Expr *expr);
+  bool isFreshStruct(const Expr *expr);
+  std::string compileOwned(const Expr *expr, ValueType slotType,
+                           const std::string &structType = "");
+  std::string adoptTemporary(const Expr *expr, const std::string &value);
+  std::string storeOwned(const std::string &slot, const std::string &value,
+                         ValueType slotType, const std::string &structType);
+  std::string releaseCode(const OwnedLocal &local);
+  void ownLocal(const std::string &name, const std::string &structType = "");
+  const OwnedLocal *findOwnedLocal(const std::string &name);
+  void openOwnedBlock();
+  void closeOwnedBlock();
+  std::string releaseOwnedLocals(const std::string &lineIndent,
+                                 const OwnedLocal *keep = nullptr);
+  std::string discardResult(const Expr *expr, const std::string &value);
+  void ownAssignedParameters(
+      const std::vector<std::unique_ptr<ASTNode>> &body,
+      const std::vector<std::pair<std::string, ValueType>> &params);
+
   void compileIfStmt(const IfStmt *ifStmt);
   void compileWhileStmt(const WhileStmt *whileStmt);
   void compileForStmt(const ForStmt *forStmt);
@@ -81,6 +186,12 @@ private:
   void compileAssignment(const Assignment *assign);
   void compileReturnStmt(const ReturnStmt *ret);
 
+  void defineFunction(const FunctionInfo &info);
+  void rollbackFunctions(size_t mark);
+  void bindFunctionParameters(const FunctionDecl *func);
+  void registerNestedFunction(const FunctionDecl *func, const FunctionDecl *nestedFunc);
+  ValueType inferFunctionReturnType(const FunctionDecl *func);
+  void declareFunction(const FunctionDecl *func);
   void compileFunctionDecl(const FunctionDecl *func);
   void compileNestedFunction(const FunctionDecl *func,
                              const std::vector<std::pair<std::string, ValueType>> &parentParams);
@@ -92,6 +203,8 @@ private:
   std::string compileStructInitializer(const StructConstructor *expr);
 
   void compileClassDecl(const ClassDecl *decl);
+  void declareClass(const ClassDecl *decl);
+  void compileClassBody(const ClassDecl *decl);
   std::string compileClassInstantiation(const ClassInstantiation *expr);
   std::string compileSelfExpr(const SelfExpr *expr);
   
@@ -105,13 +218,27 @@ private:
   std::string compileExpr(const Expr *expr,
                           ValueType expectedType = ValueType::INFERRED,
                           bool forGlobalInit = false);
+  std::string compileBinaryExpr(const BinaryExpr *bin, ValueType expectedType,
+                                bool forGlobalInit);
+  ValueType binaryOperandType(const BinaryExpr *bin, ValueType expectedType);
+  std::string joinBinaryOperands(const BinaryExpr *bin, std::string left,
+                                 const std::string &right);
+  std::string compileUnaryExpr(const UnaryExpr *un, ValueType expectedType,
+                               bool forGlobalInit);
+  std::string compileArithmetic(BinaryOp op, const std::string &left,
+                                const std::string &right, ValueType resultType);
+  std::string compileIntConstant(const Expr *expr);
   std::string compileExprForConcat(const Expr *expr);
+  void collectConcatOperands(const Expr *expr,
+                             std::vector<const Expr *> &operands);
   bool containsVariables(const Expr *expr);
 
   void compileEnumDecl(const EnumDecl *decl);
   std::string compileEnumAccess(const EnumAccessExpr *expr);
   
   ValueType inferExprType(const Expr *expr);
+  ValueType inferVarType(const Expr *value);
+  ValueType resolveExprType(const Expr *expr, std::string &typeName);
   std::string getStructTypeNameFromFieldAccess(const FieldAccessExpr *fieldAccess);
   ValueType inferFieldAccessType(const FieldAccessExpr *fieldAccess);
 };
@@ -0,0 +1,53 @@
+#pragma once
+#include "../common.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace HolyLua {
+
+// variables visible to codegen. function, method and main bodies run in
+// their own scope: the first write to a name inside a scope records the
+// previous entry in an undo log, and leaving the scope replays the log.
+// entering and leaving therefore cost O(names changed), not a table copy.
+class SymbolTable {
+public:
+  std::size_t count(const std::string &name) const {
+    return entries.count(name);
+  }
+
+  // same contract as unordered_map::operator[]: missing names are inserted
+  Variable &operator[](const std::string &name);
+  void erase(const std::string &name);
+
+  // hide every name until the current scope is left
+  void clear();
+
+  void enterScope();
+  void exitScope();
+
+private:
+  struct Entry {
+    Variable var;
+    uint64_t scope = 0; // scope that last logged this entry
+  };
+
+  struct UndoRecord {
+    std::string name;
+    bool existed;
+    Entry previous;
+  };
+
+  std::unordered_map<std::string, Entry> entries;
+  std::vector<UndoRecord> undoLog;
+  // undo log size and scope id of each enclosing scope
+  std::vector<std::pair<std::size_t, uint64_t>> scopes;
+  uint64_t currentScope = 0;
+  uint64_t nextScope = 1;
+
+  void record(const std::string &name, const Entry *previous);
+};
+
+} // namespace HolyLua
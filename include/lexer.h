@@ -1,23 +1,27 @@
 #pragma once
 #include "token.h"
-#include <unordered_map>
+#include <cstddef>
+#include <string_view>
 #include <vector>
 
 namespace HolyLua {
 
+// the lexer reads `source` in place (e.g. a MappedFile) and tokens point
+// into it, so the buffer must stay alive for as long as the tokens do.
 class Lexer {
 public:
-  explicit Lexer(const std::string &source);
+  explicit Lexer(std::string_view source);
   std::vector<Token> scanTokens();
+  // pull interface: one token per call, END_OF_FILE once the input is done
+  Token nextToken();
   bool hasErrors() const { return errorCount > 0; }
 
 private:
-  std::string source;
+  std::string_view source;
   std::vector<Token> tokens;
-  std::unordered_map<std::string, TokenType> keywords;
 
-  int current = 0;
-  int start = 0;
+  size_t current = 0;
+  size_t start = 0;
   int line = 1;
   int errorCount = 0;
 
@@ -0,0 +1,50 @@
+#pragma once
+#include "../ast.h"
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace HolyLua {
+
+// rewrites a type checked program before codegen: arithmetic, comparisons
+// and boolean logic on literals, concatenation of string literals and reads
+// of const variables initialized with a literal are replaced by their value,
+// and `if` branches whose condition became constant are dropped. every
+// rewrite keeps the type the checker saw, so the pass never reports errors.
+class ConstantFolder {
+public:
+  void fold(Program &program);
+
+private:
+  using Value = std::variant<int64_t, double, std::string, bool>;
+
+  AstArena *arena = nullptr;
+  // value of each visible const, nullopt for a name that shadows one
+  std::vector<std::unordered_map<std::string, std::optional<Value>>> scopes;
+
+  void pushScope() { scopes.emplace_back(); }
+  void popScope() { scopes.pop_back(); }
+  void declare(const std::string &name) { scopes.back()[name] = std::nullopt; }
+  void declareVar(const VarDecl *decl);
+  const Value *lookup(const std::string &name) const;
+
+  void foldFunction(FunctionDecl *func);
+  void foldMethod(ClassMethod &method);
+  void foldBlock(std::vector<std::unique_ptr<ASTNode>> &block);
+  void foldStatements(std::vector<std::unique_ptr<ASTNode>> &block);
+  // returns false when nothing of the statement is left to run
+  bool foldStatement(ASTNode *stmt);
+  bool foldIf(IfStmt *ifStmt);
+
+  void foldExpr(std::unique_ptr<Expr> &expr);
+  void foldBinaryChain(std::unique_ptr<Expr> &expr);
+  void foldOperands(Expr *expr);
+  // the folded replacement of `expr`, nullptr when it stays as it is
+  std::unique_ptr<Expr> evaluate(Expr *expr);
+  std::unique_ptr<Expr> evaluateBinary(BinaryExpr *bin);
+  std::unique_ptr<Expr> evaluateUnary(const UnaryExpr *un);
+  std::unique_ptr<Expr> makeLiteral(Value value, int line);
+};
+
+} // namespace HolyLua
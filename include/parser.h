@@ -1,10 +1,13 @@
 #pragma once
 #include "ast.h"
 #include "token.h"
+#include "utils/source_manager.h"
 #include <cstdint>
 #include <initializer_list>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <unordered_set>
 #include <vector>
 #include <map>
@@ -12,28 +15,44 @@
 namespace HolyLua {
 class Parser {
 public:
-  explicit Parser(const std::vector<Token> &tokens, const std::string &source);
+  explicit Parser(std::vector<Token> tokens, const SourceManager &sources);
   Program parse();
   void error(const std::string &msg, int line);
+  bool hasErrors() const { return errorCount > 0; }
 
 private:
   std::vector<Token> tokens;
-  std::string source;
-  std::vector<std::string> sourceLines;
+  std::unique_ptr<AstArena> arena;
+  const SourceManager &sources;
   size_t current = 0;
+  int errorCount = 0;
   int functionDepth = 0;
-  std::unordered_set<std::string> declaredStructs;
-  std::unordered_set<std::string> declaredClasses;
-  std::unordered_set<std::string> declaredEnums;
+  int expressionDepth = 0;
+  bool expressionTooDeep = false;
+  static constexpr int MAX_EXPRESSION_DEPTH = 1000;
+  // names are views into the source, like the tokens they come from
+  std::unordered_set<std::string_view> declaredStructs;
+  std::unordered_set<std::string_view> declaredClasses;
+  std::unordered_set<std::string_view> declaredEnums;
   std::map<std::string, std::vector<std::string>> enumValues;
 
-  void initSourceLines();
+  template <typename T, typename... Args>
+  std::unique_ptr<T> make(Args &&...args) {
+    return std::unique_ptr<T>(new (*arena) T(std::forward<Args>(args)...));
+  }
+  const std::string &intern(std::string_view name) {
+    return arena->intern(name);
+  }
+
   void showErrorContext(int line);
-  bool isAtEnd();
-  Token peek();
-  Token previous();
-  Token advance();
-  bool check(TokenType type);
+  // lookahead hands out references into `tokens`, which is never resized
+  // while parsing
+  bool isAtEnd() const;
+  const Token &peek() const;
+  const Token &previous() const;
+  const Token &advance();
+  bool check(TokenType type) const;
+  bool match(TokenType type);
   bool match(std::initializer_list<TokenType> types);
   void skipNewlines();
   std::unique_ptr<ASTNode> statement();
@@ -60,21 +79,15 @@ private:
   ValueType parseType();
 
   std::unique_ptr<Expr> expression();
-  std::unique_ptr<Expr> logicalOr();
-  std::unique_ptr<Expr> logicalAnd();
-  std::unique_ptr<Expr> nilCoalescing();
-  std::unique_ptr<Expr> comparison();
-  std::unique_ptr<Expr> concat();
-  std::unique_ptr<Expr> additive();
-  std::unique_ptr<Expr> multiplicative();
-  std::unique_ptr<Expr> power();
+  std::unique_ptr<Expr> binary(int minPrecedence);
+  std::unique_ptr<Expr> powerChain(std::unique_ptr<Expr> base, int line);
   std::unique_ptr<Expr> unary();
   std::unique_ptr<Expr> postfix();
   std::unique_ptr<Expr> primary();
   std::unique_ptr<LambdaExpr> lambdaExpression(int line);
   std::unique_ptr<FieldAccessExpr> fieldAccess();
   void synchronize();
-  bool peekNextIs(TokenType type);
+  bool peekNextIs(TokenType type) const;
 };
 
 } // namespace HolyLua
\ No newline at end of file
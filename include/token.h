@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <variant>
 
 namespace HolyLua {
@@ -40,6 +41,7 @@ enum class TokenType {
   TYPE_NUMBER,
   TYPE_STRING,
   TYPE_BOOL,
+  TYPE_INT,
 
   // literals
   NUMBER,
@@ -93,16 +95,18 @@ enum class TokenType {
   END_OF_FILE
 };
 
+// tokens don't own text: lexeme and string literals are views into the
+// source buffer, which has to outlive every token (and the parser).
 struct Token {
   TokenType type;
-  std::string lexeme;
-  std::variant<int64_t, double, std::string> literal;
   int line;
+  std::string_view lexeme;
+  std::variant<int64_t, double, std::string_view> literal;
 
-  Token(TokenType t, std::string lex, int l);
-  Token(TokenType t, std::string lex, int64_t num, int l);
-  Token(TokenType t, std::string lex, double num, int l);
-  Token(TokenType t, std::string lex, std::string str, int l);
+  Token(TokenType t, std::string_view lex, int l);
+  Token(TokenType t, std::string_view lex, int64_t num, int l);
+  Token(TokenType t, std::string_view lex, double num, int l);
+  Token(TokenType t, std::string_view lex, std::string_view str, int l);
 };
 
 std::string tokenTypeToString(TokenType type);
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace HolyLua {
+
+// name of a struct, class or enum type, interned in a process-wide table.
+// each distinct name is stored once, so copying is a pointer copy and two
+// names are equal exactly when they share the same entry. the empty name
+// (no nominal type) is the null entry.
+//
+// names enter the table while parsing (or loading a cached tree) through
+// intern(), which is the only writer and takes the table's lock. later
+// passes carry TypeName values along and use find() for text that only
+// names a type, which reads the table without locking.
+class TypeName {
+public:
+  TypeName() = default;
+
+  static TypeName intern(std::string_view name);
+  // the interned name, or the empty name when no type was ever called that
+  static TypeName find(std::string_view name);
+
+  bool empty() const { return entry == nullptr; }
+  const std::string &str() const { return entry ? *entry : emptyName(); }
+  operator const std::string &() const { return str(); }
+
+  bool operator==(const TypeName &other) const { return entry == other.entry; }
+  bool operator!=(const TypeName &other) const { return entry != other.entry; }
+
+  // comparing against text reads the entry, the table is not consulted
+  bool operator==(std::string_view name) const { return str() == name; }
+  bool operator!=(std::string_view name) const { return str() != name; }
+  bool operator==(const char *name) const { return str() == name; }
+  bool operator!=(const char *name) const { return str() != name; }
+  bool operator==(const std::string &name) const { return str() == name; }
+  bool operator!=(const std::string &name) const { return str() != name; }
+
+  std::size_t hash() const { return std::hash<const std::string *>()(entry); }
+
+private:
+  const std::string *entry = nullptr;
+
+  explicit TypeName(const std::string *entry) : entry(entry) {}
+
+  static const std::string &emptyName();
+};
+
+} // namespace HolyLua
+
+namespace std {
+template <> struct hash<HolyLua::TypeName> {
+  size_t operator()(const HolyLua::TypeName &name) const { return name.hash(); }
+};
+} // namespace std
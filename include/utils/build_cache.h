@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace HolyLua {
+
+// build outputs stored flat in one directory under a content key. each key
+// is derived from everything that went into the artifact, so an entry is
+// exactly what a rebuild would produce; nothing is ever invalidated, stale
+// entries are just no longer asked for.
+class BuildCache {
+public:
+  enum class Artifact { EXECUTABLE, C_SOURCE, OBJECT };
+
+  explicit BuildCache(std::string directory);
+
+  std::string pathFor(Artifact artifact, uint64_t key) const;
+
+  // every lookup is counted as a hit or a miss for the report
+  bool contains(Artifact artifact, uint64_t key);
+
+  // copies an entry out to `destination`, replacing it atomically
+  bool fetch(Artifact artifact, uint64_t key,
+             const std::string &destination) const;
+
+  // entries are produced at their staging path and renamed into place, so
+  // an interrupted build never leaves a partial entry behind
+  std::string stagingPathFor(Artifact artifact, uint64_t key) const;
+  bool commit(Artifact artifact, uint64_t key) const;
+
+  // hash of a file's contents, 0 when it cannot be read
+  static uint64_t hashFile(const std::string &path);
+
+  void report(std::ostream &out) const;
+
+private:
+  static constexpr int ARTIFACT_COUNT = 3;
+
+  std::string directory;
+  int hits[ARTIFACT_COUNT] = {};
+  int misses[ARTIFACT_COUNT] = {};
+};
+
+} // namespace HolyLua
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+namespace HolyLua {
+
+// hash of the running compiler executable (plus HOLYLUA_VERSION). every
+// cache keyed on it misses after any rebuild of the compiler, so a codegen
+// or parser change never reuses output of an older binary. computed once.
+uint64_t compilerIdentity();
+
+} // namespace HolyLua
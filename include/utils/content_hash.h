@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+namespace HolyLua {
+
+// fast 64-bit hash for cache keys. not cryptographic: it only has to spread
+// edits well, every cache re-checks what it loads.
+uint64_t contentHash(std::string_view data, uint64_t seed = 0);
+
+// folds another hash or value into a key, order-sensitive
+uint64_t hashCombine(uint64_t seed, uint64_t value);
+
+} // namespace HolyLua
@@ -1,24 +1,25 @@
 #pragma once
+#include "source_manager.h"
 #include <iostream>
 #include <string>
-#include <vector>
 
 namespace HolyLua {
 
 class ErrorReporter {
 public:
-    ErrorReporter(const std::string &source);
+    ErrorReporter(const SourceManager &sources, std::ostream &out = std::cerr);
     void reportError(const std::string &msg, int line);
     void showErrorContext(int line);
+    // emit diagnostics another reporter buffered, e.g. for a parallel task
+    void replay(const std::string &diagnostics, int errors);
     bool hasErrors() const { return errorCount > 0; }
     int getErrorCount() const { return errorCount; }
+    const SourceManager &getSources() const { return sources; }
     
 private:
-    std::string source;
-    std::vector<std::string> sourceLines;
+    const SourceManager &sources;
+    std::ostream &out;
     int errorCount = 0;
-    
-    void initSourceLines();
 };
 
-} // namespace HolyLua
\ No newline at end of file
+} // namespace HolyLua
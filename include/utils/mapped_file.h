@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace HolyLua {
+
+// read-only contents of a source file. mapped with mmap where available so
+// lexing works on the page cache directly, read into memory otherwise.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool open(const std::string &path);
+  void close();
+
+  std::string_view view() const { return std::string_view(data, length); }
+  size_t size() const { return length; }
+
+private:
+  const char *data = nullptr;
+  size_t length = 0;
+  bool mapped = false;
+  std::string buffer;
+};
+
+} // namespace HolyLua
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+namespace HolyLua {
+
+// runs task(worker, index) for every index in [0, count) on up to `jobs`
+// threads, the calling thread being worker 0. indices are handed out in
+// increasing order, worker ids are below `jobs`. the first exception thrown
+// by a task stops the remaining work and is rethrown once every thread has
+// joined
+void parallelFor(size_t count, unsigned jobs,
+                 const std::function<void(unsigned worker, size_t index)> &task);
+
+} // namespace HolyLua
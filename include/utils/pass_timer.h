@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace HolyLua {
+
+// resources used by one compiler phase. allocations are counted by the
+// global operator new, peak RSS is the process high-water mark when the
+// phase ended (for external phases, that of the child processes)
+struct PassSample {
+  double wallMs = 0;
+  double cpuMs = 0;
+  uint64_t allocations = 0;
+  uint64_t allocatedBytes = 0;
+  long peakRssKb = 0;
+};
+
+// collects the --time-passes report. phases nest: a scope opened while
+// another is active is reported indented under it
+class PassTimer {
+public:
+  PassTimer();
+
+  // times the enclosing block. a null timer makes the scope a no-op, so
+  // stages can take an optional timer without branching
+  class Scope {
+  public:
+    Scope(PassTimer *timer, const std::string &name, bool external = false);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    PassTimer *timer;
+    size_t index = 0;
+    bool external = false;
+    PassSample start;
+    std::chrono::steady_clock::time_point wallStart;
+  };
+
+  struct Phase {
+    std::string name;
+    int depth;
+    PassSample sample;
+  };
+
+  // phases in the order they were opened
+  const std::vector<Phase> &recorded() const { return phases; }
+
+  void report(std::ostream &out) const;
+  void reportJson(std::ostream &out) const;
+
+private:
+  std::vector<Phase> phases;
+  int depth = 0;
+  PassSample start;
+  PassSample childrenStart;
+  std::chrono::steady_clock::time_point wallStart;
+
+  PassSample total() const;
+};
+
+} // namespace HolyLua
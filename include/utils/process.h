@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace HolyLua {
+
+// starts `args[0]` (looked up on PATH) with `args` as its argv, no shell
+// in between, and waits for it. its stderr goes to our stdout, like `2>&1`.
+// when `input` is given it is written to the child's stdin, which is then
+// closed. returns the exit status, or -1 when the process could not run.
+int runProcess(const std::vector<std::string> &args,
+               const std::string_view *input = nullptr);
+
+// replaces the current process with the program at `path`. only returns,
+// with -1, when it could not be started; on Windows it runs the program,
+// waits and returns its exit status.
+int execProgram(const std::string &path);
+
+} // namespace HolyLua
@@ -0,0 +1,45 @@
+#pragma once
+#include "mapped_file.h"
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace HolyLua {
+
+// the program text, loaded once and shared by every stage. the line index
+// is only built when a diagnostic first needs it, so clean compiles never
+// split the source into lines.
+class SourceManager {
+public:
+  SourceManager() = default;
+  SourceManager(const SourceManager &) = delete;
+  SourceManager &operator=(const SourceManager &) = delete;
+
+  bool open(const std::string &path);
+
+  const std::string &path() const { return filePath; }
+  std::string_view text() const { return file.view(); }
+  size_t size() const { return file.size(); }
+
+  // lines are 1-based and split like std::getline: no trailing '\n', and
+  // no empty line after a final newline
+  size_t lineCount() const;
+  std::string_view line(size_t number) const;
+
+  // the offending line with one line of context either side
+  void printContext(std::ostream &out, int line) const;
+
+private:
+  MappedFile file;
+  std::string filePath;
+
+  mutable std::once_flag indexed;
+  mutable std::vector<size_t> lineStarts;
+
+  void buildLineIndex() const;
+};
+
+} // namespace HolyLua
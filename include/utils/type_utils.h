@@ -17,6 +17,7 @@ struct UsageConstraint {
 struct ReturnAnalysis {
     std::vector<ValueType> returnTypes;
     std::vector<int> returnLines;
+    std::vector<bool> returnsIntegerConstant;
     bool hasConflict;
     ValueType inferredType;
 
@@ -27,8 +28,11 @@ class TypeUtils {
 public:
     static std::string typeToString(ValueType type);
     static bool isCompatible(ValueType expected, ValueType actual);
+    static bool isNumeric(ValueType type);
+    static ValueType valueTypeFor(ValueType target, const Expr *value, ValueType valueType);
     static std::string binaryOpToString(BinaryOp op);
     static bool operatorRequiresType(BinaryOp op, ValueType &requiredType);
+    static ValueType binaryResultType(BinaryOp op);
     static ValueType resolveTypeName(const std::string &typeName);
 };
 
@@ -31,7 +31,8 @@ private:
     ValueType validateLiteral(const LiteralExpr *lit);
     ValueType validateVariable(const VarExpr *var,
                               const std::unordered_map<std::string, TypeInfo> &symbolTable);
-    ValueType validateBinaryExpr(const BinaryExpr *bin,
+    // types `bin` given the already validated type of its left operand
+    ValueType validateBinaryExpr(const BinaryExpr *bin, ValueType leftType,
                                 const std::unordered_map<std::string, TypeInfo> &symbolTable,
                                 const std::unordered_map<std::string, FunctionInfo> &functionTable,
                                 const std::map<std::string, StructInfo> &structTable,
@@ -29,6 +29,7 @@ private:
     
     bool validateVarDecl(const VarDecl *decl,
                         std::unordered_map<std::string, TypeInfo> &symbolTable,
+                        const std::unordered_map<std::string, FunctionInfo> &functionTable,
                         const std::map<std::string, StructInfo> &structTable,
                         const std::map<std::string, ClassInfo> &classTable);
     
@@ -26,7 +26,7 @@ public:
                             bool isConstructor,
                             std::unordered_map<std::string, TypeInfo> &symbolTable,
                             const std::map<std::string, StructInfo> &structTable,
-                            std::map<std::string, ClassInfo> &classTable,
+                            const std::map<std::string, ClassInfo> &classTable,
                             std::unordered_set<std::string> &nonNilVars,
                             std::string &currentClass,
                             std::string &currentFunction);
@@ -20,6 +20,7 @@ public:
     
     void collectLocalVariables(const std::vector<std::unique_ptr<ASTNode>> &stmts,
                               std::unordered_map<std::string, TypeInfo> &symbolTable,
+                              const std::unordered_map<std::string, FunctionInfo> &functionTable,
                               const std::map<std::string, StructInfo> &structTable,
                               const std::map<std::string, ClassInfo> &classTable);
     
@@ -2,6 +2,7 @@
 #include "../ast.h"
 #include "../common.h"
 #include "../utils/error_reporter.h"
+#include "../utils/pass_timer.h"
 #include "semantics/function_validator.h"
 #include "semantics/struct_validator.h"
 #include "semantics/class_validator.h"
@@ -9,6 +10,7 @@
 #include "ast_validation/stmt_validator.h"
 #include <map>
 #include <string>
+#include <vector>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -16,12 +18,32 @@ namespace HolyLua {
 
 class TypeChecker {
 public:
-    TypeChecker(const std::string &source);
+    TypeChecker(const SourceManager &sources);
+    // validate function and method bodies on up to `jobs` threads
+    void setJobs(unsigned jobs);
+    // time each pass into `timer` when it is not null
+    void setTimer(PassTimer *timer) { this->timer = timer; }
     bool check(const Program &program);
     bool hasErrors() const { return reporter.hasErrors(); }
     
 private:
+    // one independent piece of the third pass, checked against scratch
+    // tables and reported later in source order
+    struct BodyCheck {
+        FunctionDecl *function = nullptr;
+        const ClassDecl *classDecl = nullptr;
+        const ClassMethod *method = nullptr;
+        bool isConstructor = false;
+        bool done = false;
+        bool passed = true;
+        std::string diagnostics;
+        int errorCount = 0;
+    };
+
+    const SourceManager &sources;
     ErrorReporter reporter;
+    unsigned jobs = 1;
+    PassTimer *timer = nullptr;
 
     FunctionValidator functionValidator;
     StructValidator structValidator;
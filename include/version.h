@@ -0,0 +1,6 @@
+#pragma once
+
+// compiler version, mixed into compilerIdentity(); the build may override it
+#ifndef HOLYLUA_VERSION
+#define HOLYLUA_VERSION "1.0.0"
+#endif
@@ -21,11 +21,72 @@ std::string valueTypeToString(ValueType type) {
     return "struct";
   case ValueType::ENUM:
     return "enum";
+  case ValueType::INT:
+    return "int";
   default:
     return "unknown";
   }
 }
 
+static bool isIntegerOp(BinaryOp op) {
+  return op == BinaryOp::ADD || op == BinaryOp::SUBTRACT ||
+         op == BinaryOp::MULTIPLY || op == BinaryOp::MODULO ||
+         op == BinaryOp::FLOOR_DIVIDE;
+}
+
+BinaryExpr::~BinaryExpr() {
+  std::unique_ptr<Expr> next = std::move(left);
+  while (auto *bin = nodeCast<BinaryExpr>(next.get())) {
+    std::unique_ptr<Expr> inner = std::move(bin->left);
+    next = std::move(inner);
+  }
+}
+
+std::vector<const BinaryExpr *> leftSpine(const BinaryExpr *bin) {
+  std::vector<const BinaryExpr *> spine;
+  for (; bin; bin = nodeCast<BinaryExpr>(bin->left.get())) {
+    spine.push_back(bin);
+  }
+  return spine;
+}
+
+bool isIntegerConstant(const Expr *expr) {
+  while (auto *bin = nodeCast<BinaryExpr>(expr)) {
+    if (!isIntegerOp(bin->op) || !isIntegerConstant(bin->right.get())) {
+      return false;
+    }
+    expr = bin->left.get();
+  }
+  if (auto *lit = nodeCast<LiteralExpr>(expr)) {
+    return std::holds_alternative<int64_t>(lit->value);
+  }
+  if (auto *un = nodeCast<UnaryExpr>(expr)) {
+    return un->op == UnaryOp::NEGATE && isIntegerConstant(un->operand.get());
+  }
+  return false;
+}
+
+ValueType arithmeticResultType(BinaryOp op, const Expr *left, ValueType leftType,
+                               const Expr *right, ValueType rightType) {
+  if (!isIntegerOp(op)) {
+    return ValueType::NUMBER;
+  }
+  bool leftInt = leftType == ValueType::INT;
+  bool rightInt = rightType == ValueType::INT;
+  if ((leftInt && (rightInt || isIntegerConstant(right))) ||
+      (rightInt && isIntegerConstant(left))) {
+    return ValueType::INT;
+  }
+  return ValueType::NUMBER;
+}
+
+ValueType declarationType(const Expr *value, ValueType valueType) {
+  if (valueType == ValueType::INT && isIntegerConstant(value)) {
+    return ValueType::NUMBER;
+  }
+  return valueType;
+}
+
 std::string visibilityToString(Visibility vis) {
   switch (vis) {
   case Visibility::PUBLIC:
@@ -37,66 +98,128 @@ std::string visibilityToString(Visibility vis) {
   }
 }
 
+void DeclarationIndex::add(ASTNode *node) {
+  switch (node->kind) {
+  case NodeKind::ENUM_DECL:
+    enums.push_back(static_cast<EnumDecl *>(node));
+    break;
+  case NodeKind::STRUCT_DECL:
+    structs.push_back(static_cast<StructDecl *>(node));
+    break;
+  case NodeKind::CLASS_DECL:
+    classes.push_back(static_cast<ClassDecl *>(node));
+    break;
+  case NodeKind::FUNCTION_DECL:
+    functions.push_back(static_cast<FunctionDecl *>(node));
+    break;
+  case NodeKind::VAR_DECL:
+    globals.push_back(static_cast<VarDecl *>(node));
+    statements.push_back(node);
+    break;
+  default:
+    statements.push_back(node);
+    break;
+  }
+}
+
+void Program::abandon() {
+  for (auto &stmt : statements) {
+    stmt.release();
+  }
+  statements.clear();
+  declarations = DeclarationIndex();
+  arena.release();
+}
+
 void ASTPrinter::print(const ASTNode *node) {
   if (!node)
     return;
 
-  if (auto expr = dynamic_cast<const LiteralExpr *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const VarExpr *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const SelfExpr *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const LambdaExpr *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const FunctionCall *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const MethodCall *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const BinaryExpr *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const UnaryExpr *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const ForceUnwrapExpr *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const NilExpr *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const StructConstructor *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const ClassInstantiation *>(node)) {
-    print(expr);
-  } else if (auto expr = dynamic_cast<const FieldAccessExpr *>(node)) {
-    print(expr);
-  } else if (auto stmt = dynamic_cast<const VarDecl *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const FunctionDecl *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const ReturnStmt *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const Assignment *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const FieldAssignment *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const PrintStmt *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const IfStmt *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const InlineCStmt *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const WhileStmt *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const ForStmt *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const RepeatStmt *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const StructDecl *>(node)) {
-    print(stmt);
-  } else if (auto stmt = dynamic_cast<const ClassDecl *>(node)) {
-    print(stmt);
-  } else if (auto *stmt = dynamic_cast<const EnumDecl *>(node)) {
-    print(stmt);
-  } else if (auto *expr = dynamic_cast<const EnumAccessExpr *>(node)) {
-    print(expr);
+  switch (node->kind) {
+  case NodeKind::LITERAL:
+    print(static_cast<const LiteralExpr *>(node));
+    break;
+  case NodeKind::VAR:
+    print(static_cast<const VarExpr *>(node));
+    break;
+  case NodeKind::SELF:
+    print(static_cast<const SelfExpr *>(node));
+    break;
+  case NodeKind::LAMBDA:
+    print(static_cast<const LambdaExpr *>(node));
+    break;
+  case NodeKind::FUNCTION_CALL:
+    print(static_cast<const FunctionCall *>(node));
+    break;
+  case NodeKind::METHOD_CALL:
+    print(static_cast<const MethodCall *>(node));
+    break;
+  case NodeKind::BINARY:
+    print(static_cast<const BinaryExpr *>(node));
+    break;
+  case NodeKind::UNARY:
+    print(static_cast<const UnaryExpr *>(node));
+    break;
+  case NodeKind::FORCE_UNWRAP:
+    print(static_cast<const ForceUnwrapExpr *>(node));
+    break;
+  case NodeKind::NIL:
+    print(static_cast<const NilExpr *>(node));
+    break;
+  case NodeKind::STRUCT_CONSTRUCTOR:
+    print(static_cast<const StructConstructor *>(node));
+    break;
+  case NodeKind::CLASS_INSTANTIATION:
+    print(static_cast<const ClassInstantiation *>(node));
+    break;
+  case NodeKind::FIELD_ACCESS:
+    print(static_cast<const FieldAccessExpr *>(node));
+    break;
+  case NodeKind::ENUM_ACCESS:
+    print(static_cast<const EnumAccessExpr *>(node));
+    break;
+  case NodeKind::VAR_DECL:
+    print(static_cast<const VarDecl *>(node));
+    break;
+  case NodeKind::FUNCTION_DECL:
+    print(static_cast<const FunctionDecl *>(node));
+    break;
+  case NodeKind::RETURN:
+    print(static_cast<const ReturnStmt *>(node));
+    break;
+  case NodeKind::ASSIGNMENT:
+    print(static_cast<const Assignment *>(node));
+    break;
+  case NodeKind::FIELD_ASSIGNMENT:
+    print(static_cast<const FieldAssignment *>(node));
+    break;
+  case NodeKind::PRINT:
+    print(static_cast<const PrintStmt *>(node));
+    break;
+  case NodeKind::IF:
+    print(static_cast<const IfStmt *>(node));
+    break;
+  case NodeKind::INLINE_C:
+    print(static_cast<const InlineCStmt *>(node));
+    break;
+  case NodeKind::WHILE:
+    print(static_cast<const WhileStmt *>(node));
+    break;
+  case NodeKind::FOR:
+    print(static_cast<const ForStmt *>(node));
+    break;
+  case NodeKind::REPEAT:
+    print(static_cast<const RepeatStmt *>(node));
+    break;
+  case NodeKind::STRUCT_DECL:
+    print(static_cast<const StructDecl *>(node));
+    break;
+  case NodeKind::CLASS_DECL:
+    print(static_cast<const ClassDecl *>(node));
+    break;
+  case NodeKind::ENUM_DECL:
+    print(static_cast<const EnumDecl *>(node));
+    break;
   }
 }
 
@@ -330,24 +453,30 @@ void ASTPrinter::printBinaryOp(BinaryOp op) {
 }
 
 void ASTPrinter::print(const BinaryExpr *expr) {
-  std::cout << getIndent() << "BinaryExpr";
-  if (expr->line)
-    std::cout << " [line:" << expr->line << "]";
-  std::cout << ": (\n";
+  // the left spine of a chain is opened in a loop and closed innermost first
+  auto spine = leftSpine(expr);
+  for (const BinaryExpr *link : spine) {
+    std::cout << getIndent() << "BinaryExpr";
+    if (link->line)
+      std::cout << " [line:" << link->line << "]";
+    std::cout << ": (\n";
 
-  indentLevel++;
-  std::cout << getIndent() << "left: ";
-  print(expr->left.get());
+    indentLevel++;
+    std::cout << getIndent() << "left: ";
+  }
+  print(spine.back()->left.get());
 
-  std::cout << getIndent() << "op: ";
-  printBinaryOp(expr->op);
-  std::cout << "\n";
+  for (auto it = spine.rbegin(); it != spine.rend(); ++it) {
+    std::cout << getIndent() << "op: ";
+    printBinaryOp((*it)->op);
+    std::cout << "\n";
 
-  std::cout << getIndent() << "right: ";
-  print(expr->right.get());
-  indentLevel--;
+    std::cout << getIndent() << "right: ";
+    print((*it)->right.get());
+    indentLevel--;
 
-  std::cout << getIndent() << ")\n";
+    std::cout << getIndent() << ")\n";
+  }
 }
 
 void ASTPrinter::printUnaryOp(UnaryOp op) {
@@ -0,0 +1,40 @@
+#include "../../include/ast_arena.h"
+#include <cstdint>
+
+namespace HolyLua {
+
+void *AstArena::allocate(std::size_t size, std::size_t align) {
+  std::uintptr_t p = reinterpret_cast<std::uintptr_t>(cursor);
+  std::uintptr_t aligned = (p + align - 1) & ~(std::uintptr_t)(align - 1);
+
+  if (!cursor || aligned + size > reinterpret_cast<std::uintptr_t>(limit)) {
+    grow(size + align);
+    p = reinterpret_cast<std::uintptr_t>(cursor);
+    aligned = (p + align - 1) & ~(std::uintptr_t)(align - 1);
+  }
+
+  cursor = reinterpret_cast<char *>(aligned + size);
+  used += size;
+  return reinterpret_cast<void *>(aligned);
+}
+
+const std::string &AstArena::intern(std::string_view name) {
+  return *names.emplace(name).first;
+}
+
+void AstArena::grow(std::size_t minSize) {
+  std::size_t size = nextBlockSize;
+  while (size < minSize) {
+    size *= 2;
+  }
+  if (nextBlockSize < MAX_BLOCK_SIZE) {
+    nextBlockSize *= 2;
+  }
+
+  blocks.emplace_back(new char[size]);
+  cursor = blocks.back().get();
+  limit = cursor + size;
+  reserved += size;
+}
+
+} // namespace HolyLua
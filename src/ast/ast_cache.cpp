@@ -0,0 +1,908 @@
+#include "../../include/ast_cache.h"
+#include "../../include/utils/compiler_identity.h"
+#include "../../include/utils/content_hash.h"
+#include "../../include/utils/mapped_file.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace HolyLua {
+
+namespace {
+
+// bump when a node gains, loses or reorders a serialized field
+constexpr uint32_t FORMAT_VERSION = 2;
+constexpr char MAGIC[8] = {'H', 'L', 'A', 'S', 'T', '\0', '\0', '\0'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr uint8_t NULL_NODE = 0xFF;
+
+struct Header {
+  char magic[8];
+  uint32_t formatVersion;
+  uint32_t byteOrder;
+  uint64_t sourceHash;
+  uint64_t sourceSize;
+  // hash of everything after the header, so a damaged entry is a miss
+  uint64_t payloadHash;
+  uint32_t stringCount;
+  uint32_t statementCount;
+};
+
+uint64_t cacheKey(std::string_view source) {
+  static const uint64_t versionHash =
+      hashCombine(compilerIdentity(), FORMAT_VERSION);
+  return hashCombine(contentHash(source), versionHash);
+}
+
+// the body is written first and the string table it references is put in
+// front of it afterwards, so the reader can intern every name up front
+class AstWriter {
+public:
+  std::string body;
+  std::vector<std::string_view> strings;
+
+  template <typename T> void raw(T value) {
+    body.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  void u8(uint8_t value) { raw(value); }
+  void u32(uint32_t value) { raw(value); }
+  void flag(bool value) { raw(static_cast<uint8_t>(value)); }
+
+  void str(std::string_view text) {
+    auto inserted = ids.try_emplace(text, static_cast<uint32_t>(strings.size()));
+    if (inserted.second) {
+      strings.push_back(text);
+    }
+    u32(inserted.first->second);
+  }
+
+  void node(const ASTNode *node);
+
+  void expr(const std::unique_ptr<Expr> &expr) { node(expr.get()); }
+
+  template <typename T> void nodes(const std::vector<std::unique_ptr<T>> &list) {
+    u32(static_cast<uint32_t>(list.size()));
+    for (const auto &item : list) {
+      node(item.get());
+    }
+  }
+
+  void params(const std::vector<std::pair<std::string, ValueType>> &list) {
+    u32(static_cast<uint32_t>(list.size()));
+    for (const auto &param : list) {
+      str(param.first);
+      u8(static_cast<uint8_t>(param.second));
+    }
+  }
+
+  void flags(const std::vector<bool> &list) {
+    u32(static_cast<uint32_t>(list.size()));
+    for (bool value : list) {
+      flag(value);
+    }
+  }
+
+  template <typename Variant> void value(const Variant &variant) {
+    u8(static_cast<uint8_t>(variant.index()));
+    std::visit(
+        [&](const auto &arg) {
+          using T = std::decay_t<decltype(arg)>;
+          if constexpr (std::is_same_v<T, std::string>) {
+            str(arg);
+          } else if constexpr (std::is_same_v<T, bool>) {
+            flag(arg);
+          } else if constexpr (!std::is_same_v<T, std::nullptr_t>) {
+            raw(arg);
+          }
+        },
+        variant);
+  }
+
+  void method(const ClassMethod &method);
+
+private:
+  std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+void AstWriter::method(const ClassMethod &method) {
+  u8(static_cast<uint8_t>(method.visibility));
+  flag(method.isStatic);
+  str(method.name);
+  params(method.parameters);
+  flags(method.parameterOptionals);
+  u32(static_cast<uint32_t>(method.parameterTypeNames.size()));
+  for (const TypeName &typeName : method.parameterTypeNames) {
+    str(typeName.str());
+  }
+  u8(static_cast<uint8_t>(method.returnType));
+  nodes(method.body);
+  raw<int32_t>(method.line);
+}
+
+void AstWriter::node(const ASTNode *node) {
+  if (!node) {
+    u8(NULL_NODE);
+    return;
+  }
+  u8(static_cast<uint8_t>(node->kind));
+  raw<int32_t>(node->line);
+
+  switch (node->kind) {
+  case NodeKind::LITERAL:
+    value(static_cast<const LiteralExpr *>(node)->value);
+    break;
+  case NodeKind::VAR:
+    str(static_cast<const VarExpr *>(node)->name);
+    break;
+  case NodeKind::FUNCTION_CALL: {
+    auto *call = static_cast<const FunctionCall *>(node);
+    str(call->name);
+    nodes(call->arguments);
+    break;
+  }
+  case NodeKind::BINARY: {
+    // a chain's left spine is written outermost first in a loop, then its
+    // right operands innermost first: the bytes recursion would give
+    auto spine = leftSpine(static_cast<const BinaryExpr *>(node));
+    u8(static_cast<uint8_t>(spine.front()->op));
+    for (size_t i = 1; i < spine.size(); i++) {
+      u8(static_cast<uint8_t>(NodeKind::BINARY));
+      raw<int32_t>(spine[i]->line);
+      u8(static_cast<uint8_t>(spine[i]->op));
+    }
+    expr(spine.back()->left);
+    for (auto it = spine.rbegin(); it != spine.rend(); ++it) {
+      expr((*it)->right);
+    }
+    break;
+  }
+  case NodeKind::UNARY: {
+    auto *un = static_cast<const UnaryExpr *>(node);
+    u8(static_cast<uint8_t>(un->op));
+    expr(un->operand);
+    break;
+  }
+  case NodeKind::FORCE_UNWRAP:
+    expr(static_cast<const ForceUnwrapExpr *>(node)->operand);
+    break;
+  case NodeKind::NIL:
+  case NodeKind::SELF:
+    break;
+  case NodeKind::LAMBDA: {
+    auto *lambda = static_cast<const LambdaExpr *>(node);
+    params(lambda->parameters);
+    flags(lambda->parameterOptionals);
+    u8(static_cast<uint8_t>(lambda->returnType));
+    nodes(lambda->body);
+    break;
+  }
+  case NodeKind::STRUCT_CONSTRUCTOR: {
+    auto *cons = static_cast<const StructConstructor *>(node);
+    str(cons->structName);
+    u32(static_cast<uint32_t>(cons->namedArgs.size()));
+    for (const auto &arg : cons->namedArgs) {
+      str(arg.first);
+      expr(arg.second);
+    }
+    nodes(cons->positionalArgs);
+    flag(cons->useDefaults);
+    break;
+  }
+  case NodeKind::FIELD_ACCESS: {
+    auto *access = static_cast<const FieldAccessExpr *>(node);
+    expr(access->object);
+    str(access->fieldName);
+    break;
+  }
+  case NodeKind::CLASS_INSTANTIATION: {
+    auto *inst = static_cast<const ClassInstantiation *>(node);
+    str(inst->className);
+    nodes(inst->arguments);
+    break;
+  }
+  case NodeKind::METHOD_CALL: {
+    auto *call = static_cast<const MethodCall *>(node);
+    expr(call->object);
+    str(call->methodName);
+    nodes(call->arguments);
+    break;
+  }
+  case NodeKind::ENUM_ACCESS: {
+    auto *access = static_cast<const EnumAccessExpr *>(node);
+    str(access->enumName);
+    str(access->valueName);
+    break;
+  }
+  case NodeKind::VAR_DECL: {
+    auto *decl = static_cast<const VarDecl *>(node);
+    flag(decl->isGlobal);
+    flag(decl->isConst);
+    str(decl->name);
+    u8(static_cast<uint8_t>(decl->type));
+    flag(decl->isOptional);
+    expr(decl->value);
+    flag(decl->hasValue);
+    str(decl->typeName.str());
+    break;
+  }
+  case NodeKind::FUNCTION_DECL: {
+    auto *func = static_cast<const FunctionDecl *>(node);
+    str(func->name);
+    params(func->parameters);
+    flags(func->parameterOptionals);
+    u8(static_cast<uint8_t>(func->returnType));
+    nodes(func->body);
+    flag(func->isGlobal);
+    break;
+  }
+  case NodeKind::RETURN:
+    expr(static_cast<const ReturnStmt *>(node)->value);
+    break;
+  case NodeKind::ASSIGNMENT: {
+    auto *assign = static_cast<const Assignment *>(node);
+    str(assign->name);
+    expr(assign->value);
+    flag(assign->isCompound);
+    if (assign->isCompound) {
+      u8(static_cast<uint8_t>(assign->compoundOp));
+    }
+    break;
+  }
+  case NodeKind::PRINT: {
+    auto *print = static_cast<const PrintStmt *>(node);
+    u32(static_cast<uint32_t>(print->arguments.size()));
+    for (const auto &arg : print->arguments) {
+      flag(arg.isIdentifier);
+      if (arg.isIdentifier) {
+        str(arg.identifier);
+      } else {
+        expr(arg.expression);
+      }
+    }
+    break;
+  }
+  case NodeKind::IF: {
+    auto *ifStmt = static_cast<const IfStmt *>(node);
+    expr(ifStmt->condition);
+    nodes(ifStmt->thenBlock);
+    u32(static_cast<uint32_t>(ifStmt->elseifBranches.size()));
+    for (const auto &branch : ifStmt->elseifBranches) {
+      expr(branch.first);
+      nodes(branch.second);
+    }
+    nodes(ifStmt->elseBlock);
+    break;
+  }
+  case NodeKind::INLINE_C:
+    str(static_cast<const InlineCStmt *>(node)->cCode);
+    break;
+  case NodeKind::WHILE: {
+    auto *loop = static_cast<const WhileStmt *>(node);
+    expr(loop->condition);
+    nodes(loop->body);
+    break;
+  }
+  case NodeKind::FOR: {
+    auto *loop = static_cast<const ForStmt *>(node);
+    str(loop->varName);
+    expr(loop->start);
+    expr(loop->end);
+    expr(loop->step);
+    nodes(loop->body);
+    break;
+  }
+  case NodeKind::REPEAT: {
+    auto *loop = static_cast<const RepeatStmt *>(node);
+    expr(loop->condition);
+    nodes(loop->body);
+    break;
+  }
+  case NodeKind::STRUCT_DECL: {
+    auto *decl = static_cast<const StructDecl *>(node);
+    str(decl->name);
+    u32(static_cast<uint32_t>(decl->fields.size()));
+    for (const auto &field : decl->fields) {
+      str(field.name);
+      u8(static_cast<uint8_t>(field.type));
+      flag(field.isOptional);
+      flag(field.hasDefault);
+      value(field.defaultValue);
+      str(field.structTypeName.str());
+    }
+    break;
+  }
+  case NodeKind::CLASS_DECL: {
+    auto *decl = static_cast<const ClassDecl *>(node);
+    str(decl->name);
+    u32(static_cast<uint32_t>(decl->fields.size()));
+    for (const auto &field : decl->fields) {
+      u8(static_cast<uint8_t>(field.visibility));
+      flag(field.isStatic);
+      str(field.name);
+      u8(static_cast<uint8_t>(field.type));
+      flag(field.isOptional);
+      flag(field.hasDefault);
+      flag(field.isConst);
+      value(field.defaultValue);
+      str(field.structTypeName.str());
+    }
+    u32(static_cast<uint32_t>(decl->methods.size()));
+    for (const auto &m : decl->methods) {
+      method(m);
+    }
+    flag(decl->constructor != nullptr);
+    if (decl->constructor) {
+      method(*decl->constructor);
+    }
+    break;
+  }
+  case NodeKind::FIELD_ASSIGNMENT: {
+    auto *assign = static_cast<const FieldAssignment *>(node);
+    expr(assign->object);
+    str(assign->fieldName);
+    expr(assign->value);
+    flag(assign->isCompound);
+    if (assign->isCompound) {
+      u8(static_cast<uint8_t>(assign->compoundOp));
+    }
+    break;
+  }
+  case NodeKind::ENUM_DECL: {
+    auto *decl = static_cast<const EnumDecl *>(node);
+    str(decl->name);
+    u32(static_cast<uint32_t>(decl->values.size()));
+    for (const auto &value : decl->values) {
+      str(value);
+    }
+    break;
+  }
+  }
+}
+
+// every read is bounds-checked; the first bad byte clears `ok` and the
+// remaining reads return defaults, so a damaged file decodes to garbage
+// that is then thrown away rather than crashing
+class AstReader {
+public:
+  AstReader(const char *data, size_t size, AstArena &arena)
+      : cursor(data), end(data + size), arena(arena) {}
+
+  bool ok = true;
+
+  template <typename T> T raw() {
+    T value{};
+    if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+      ok = false;
+      return value;
+    }
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+  }
+
+  uint8_t u8() { return raw<uint8_t>(); }
+  uint32_t u32() { return raw<uint32_t>(); }
+  bool flag() { return raw<uint8_t>() != 0; }
+
+  // element counts are bounded by the bytes left, so a corrupt count
+  // cannot trigger a huge allocation
+  uint32_t count() {
+    uint32_t n = u32();
+    if (n > static_cast<size_t>(end - cursor)) {
+      ok = false;
+      return 0;
+    }
+    return n;
+  }
+
+  template <typename E> E enumValue(E last) {
+    uint8_t value = u8();
+    if (value > static_cast<uint8_t>(last)) {
+      ok = false;
+      return E();
+    }
+    return static_cast<E>(value);
+  }
+
+  ValueType valueType() { return enumValue(ValueType::INT); }
+  BinaryOp binaryOp() { return enumValue(BinaryOp::OR); }
+
+  bool readStrings(uint32_t stringCount) {
+    strings.reserve(stringCount);
+    for (uint32_t i = 0; i < stringCount && ok; i++) {
+      uint32_t length = count();
+      if (!ok) {
+        break;
+      }
+      strings.push_back(&arena.intern(std::string_view(cursor, length)));
+      cursor += length;
+    }
+    return ok;
+  }
+
+  const std::string &str() {
+    static const std::string empty;
+    uint32_t id = u32();
+    if (id >= strings.size()) {
+      ok = false;
+      return empty;
+    }
+    return *strings[id];
+  }
+
+  // a loaded tree skips the parser, so its type names are interned here
+  TypeName typeName() { return TypeName::intern(str()); }
+
+  std::unique_ptr<ASTNode> node();
+
+  std::unique_ptr<Expr> expr() {
+    auto result = node();
+    if (result && !result->isExpr()) {
+      ok = false;
+      return nullptr;
+    }
+    return std::unique_ptr<Expr>(static_cast<Expr *>(result.release()));
+  }
+
+  std::vector<std::unique_ptr<ASTNode>> nodes() {
+    std::vector<std::unique_ptr<ASTNode>> list(count());
+    for (auto &item : list) {
+      item = node();
+    }
+    return list;
+  }
+
+  std::vector<std::unique_ptr<Expr>> exprs() {
+    std::vector<std::unique_ptr<Expr>> list(count());
+    for (auto &item : list) {
+      item = expr();
+    }
+    return list;
+  }
+
+  std::vector<std::pair<std::string, ValueType>> params() {
+    std::vector<std::pair<std::string, ValueType>> list(count());
+    for (auto &param : list) {
+      param.first = str();
+      param.second = valueType();
+    }
+    return list;
+  }
+
+  std::vector<bool> flags() {
+    std::vector<bool> list(count());
+    for (size_t i = 0; i < list.size(); i++) {
+      list[i] = flag();
+    }
+    return list;
+  }
+
+  template <typename Variant> Variant value() {
+    switch (u8()) {
+    case 0:
+      return Variant(std::in_place_index<0>, raw<int64_t>());
+    case 1:
+      return Variant(std::in_place_index<1>, raw<double>());
+    case 2:
+      return Variant(std::in_place_index<2>, str());
+    case 3:
+      return Variant(std::in_place_index<3>, flag());
+    case 4:
+      if constexpr (std::variant_size_v<Variant> > 4) {
+        return Variant(std::in_place_index<4>, nullptr);
+      }
+      [[fallthrough]];
+    default:
+      ok = false;
+      return Variant();
+    }
+  }
+
+  ClassMethod method();
+
+private:
+  const char *cursor;
+  const char *end;
+  AstArena &arena;
+  std::vector<const std::string *> strings;
+
+  template <typename T, typename... Args>
+  std::unique_ptr<T> make(Args &&...args) {
+    return std::unique_ptr<T>(new (arena) T(std::forward<Args>(args)...));
+  }
+};
+
+ClassMethod AstReader::method() {
+  Visibility visibility = enumValue(Visibility::PRIVATE);
+  bool isStatic = flag();
+  const std::string &name = str();
+  auto parameters = params();
+  ClassMethod method(visibility, isStatic, name, std::move(parameters),
+                     ValueType::INFERRED);
+  method.parameterOptionals = flags();
+  method.parameterTypeNames.resize(count());
+  for (auto &paramType : method.parameterTypeNames) {
+    paramType = typeName();
+  }
+  method.returnType = valueType();
+  method.body = nodes();
+  method.line = raw<int32_t>();
+  return method;
+}
+
+std::unique_ptr<ASTNode> AstReader::node() {
+  uint8_t tag = u8();
+  if (!ok || tag == NULL_NODE) {
+    return nullptr;
+  }
+  if (tag > static_cast<uint8_t>(NodeKind::ENUM_DECL)) {
+    ok = false;
+    return nullptr;
+  }
+  int line = raw<int32_t>();
+
+  std::unique_ptr<ASTNode> result;
+  switch (static_cast<NodeKind>(tag)) {
+  case NodeKind::LITERAL:
+    result = make<LiteralExpr>(
+        value<std::variant<int64_t, double, std::string, bool>>());
+    break;
+  case NodeKind::VAR:
+    result = make<VarExpr>(str());
+    break;
+  case NodeKind::FUNCTION_CALL: {
+    const std::string &name = str();
+    result = make<FunctionCall>(name, exprs());
+    break;
+  }
+  case NodeKind::BINARY: {
+    // read back the way the writer lays out a chain, rebuilt innermost first
+    std::vector<std::pair<int, BinaryOp>> spine{{line, binaryOp()}};
+    while (ok && cursor < end &&
+           static_cast<uint8_t>(*cursor) == static_cast<uint8_t>(NodeKind::BINARY)) {
+      u8();
+      int innerLine = raw<int32_t>();
+      spine.emplace_back(innerLine, binaryOp());
+    }
+    auto operand = expr();
+    for (auto it = spine.rbegin(); it != spine.rend(); ++it) {
+      auto right = expr();
+      auto bin = make<BinaryExpr>(std::move(operand), it->second, std::move(right));
+      bin->line = it->first;
+      operand = std::move(bin);
+    }
+    result = std::move(operand);
+    break;
+  }
+  case NodeKind::UNARY: {
+    UnaryOp op = enumValue(UnaryOp::NOT);
+    result = make<UnaryExpr>(op, expr());
+    break;
+  }
+  case NodeKind::FORCE_UNWRAP:
+    result = make<ForceUnwrapExpr>(expr());
+    break;
+  case NodeKind::NIL:
+    result = make<NilExpr>();
+    break;
+  case NodeKind::SELF:
+    result = make<SelfExpr>();
+    break;
+  case NodeKind::LAMBDA: {
+    auto lambda = make<LambdaExpr>(params());
+    lambda->parameterOptionals = flags();
+    lambda->returnType = valueType();
+    lambda->body = nodes();
+    result = std::move(lambda);
+    break;
+  }
+  case NodeKind::STRUCT_CONSTRUCTOR: {
+    auto cons = make<StructConstructor>(str());
+    cons->namedArgs.resize(count());
+    for (auto &arg : cons->namedArgs) {
+      arg.first = str();
+      arg.second = expr();
+    }
+    cons->positionalArgs = exprs();
+    cons->useDefaults = flag();
+    result = std::move(cons);
+    break;
+  }
+  case NodeKind::FIELD_ACCESS: {
+    auto object = expr();
+    result = make<FieldAccessExpr>(std::move(object), str());
+    break;
+  }
+  case NodeKind::CLASS_INSTANTIATION: {
+    const std::string &name = str();
+    result = make<ClassInstantiation>(name, exprs());
+    break;
+  }
+  case NodeKind::METHOD_CALL: {
+    auto object = expr();
+    const std::string &name = str();
+    result = make<MethodCall>(std::move(object), name, exprs());
+    break;
+  }
+  case NodeKind::ENUM_ACCESS: {
+    const std::string &enumName = str();
+    result = make<EnumAccessExpr>(enumName, str());
+    break;
+  }
+  case NodeKind::VAR_DECL: {
+    bool isGlobal = flag();
+    bool isConst = flag();
+    const std::string &name = str();
+    ValueType type = valueType();
+    bool isOptional = flag();
+    auto decl = make<VarDecl>(isGlobal, isConst, name, type, isOptional);
+    decl->value = expr();
+    decl->hasValue = flag();
+    decl->typeName = typeName();
+    result = std::move(decl);
+    break;
+  }
+  case NodeKind::FUNCTION_DECL: {
+    const std::string &name = str();
+    auto parameters = params();
+    auto func = make<FunctionDecl>(name, std::move(parameters), ValueType::INFERRED);
+    func->parameterOptionals = flags();
+    func->returnType = valueType();
+    func->body = nodes();
+    func->isGlobal = flag();
+    result = std::move(func);
+    break;
+  }
+  case NodeKind::RETURN:
+    result = make<ReturnStmt>(expr());
+    break;
+  case NodeKind::ASSIGNMENT: {
+    const std::string &name = str();
+    auto value = expr();
+    if (flag()) {
+      result = make<Assignment>(name, std::move(value), binaryOp());
+    } else {
+      result = make<Assignment>(name, std::move(value));
+    }
+    break;
+  }
+  case NodeKind::PRINT: {
+    std::vector<PrintArg> arguments;
+    uint32_t n = count();
+    arguments.reserve(n);
+    for (uint32_t i = 0; i < n && ok; i++) {
+      if (flag()) {
+        arguments.emplace_back(std::string(str()));
+      } else {
+        arguments.emplace_back(expr());
+      }
+    }
+    result = make<PrintStmt>(std::move(arguments));
+    break;
+  }
+  case NodeKind::IF: {
+    auto ifStmt = make<IfStmt>(expr());
+    ifStmt->thenBlock = nodes();
+    ifStmt->elseifBranches.resize(count());
+    for (auto &branch : ifStmt->elseifBranches) {
+      branch.first = expr();
+      branch.second = nodes();
+    }
+    ifStmt->elseBlock = nodes();
+    result = std::move(ifStmt);
+    break;
+  }
+  case NodeKind::INLINE_C:
+    result = make<InlineCStmt>(str());
+    break;
+  case NodeKind::WHILE: {
+    auto loop = make<WhileStmt>(expr());
+    loop->body = nodes();
+    result = std::move(loop);
+    break;
+  }
+  case NodeKind::FOR: {
+    const std::string &var = str();
+    auto start = expr();
+    auto stop = expr();
+    auto step = expr();
+    auto loop = make<ForStmt>(var, std::move(start), std::move(stop), std::move(step));
+    loop->body = nodes();
+    result = std::move(loop);
+    break;
+  }
+  case NodeKind::REPEAT: {
+    auto loop = make<RepeatStmt>(expr());
+    loop->body = nodes();
+    result = std::move(loop);
+    break;
+  }
+  case NodeKind::STRUCT_DECL: {
+    auto decl = make<StructDecl>(typeName().str());
+    uint32_t n = count();
+    decl->fields.reserve(n);
+    for (uint32_t i = 0; i < n && ok; i++) {
+      std::string name = str();
+      ValueType type = valueType();
+      StructField field(std::move(name), type);
+      field.isOptional = flag();
+      field.hasDefault = flag();
+      field.defaultValue =
+          value<std::variant<int64_t, double, std::string, bool, std::nullptr_t>>();
+      field.structTypeName = typeName();
+      decl->fields.push_back(std::move(field));
+    }
+    result = std::move(decl);
+    break;
+  }
+  case NodeKind::CLASS_DECL: {
+    auto decl = make<ClassDecl>(typeName().str());
+    uint32_t n = count();
+    decl->fields.reserve(n);
+    for (uint32_t i = 0; i < n && ok; i++) {
+      Visibility visibility = enumValue(Visibility::PRIVATE);
+      bool isStatic = flag();
+      std::string name = str();
+      ValueType type = valueType();
+      ClassField field(visibility, isStatic, std::move(name), type);
+      field.isOptional = flag();
+      field.hasDefault = flag();
+      field.isConst = flag();
+      field.defaultValue =
+          value<std::variant<int64_t, double, std::string, bool, std::nullptr_t>>();
+      field.structTypeName = typeName();
+      decl->fields.push_back(std::move(field));
+    }
+    n = count();
+    decl->methods.reserve(n);
+    for (uint32_t i = 0; i < n && ok; i++) {
+      decl->methods.push_back(method());
+    }
+    if (flag()) {
+      decl->constructor = std::make_unique<ClassMethod>(method());
+    }
+    result = std::move(decl);
+    break;
+  }
+  case NodeKind::FIELD_ASSIGNMENT: {
+    auto object = expr();
+    const std::string &field = str();
+    auto value = expr();
+    if (flag()) {
+      result = make<FieldAssignment>(std::move(object), field, std::move(value),
+                                     binaryOp());
+    } else {
+      result = make<FieldAssignment>(std::move(object), field, std::move(value));
+    }
+    break;
+  }
+  case NodeKind::ENUM_DECL: {
+    auto decl = make<EnumDecl>(typeName().str());
+    decl->values.resize(count());
+    for (auto &value : decl->values) {
+      value = str();
+    }
+    result = std::move(decl);
+    break;
+  }
+  }
+
+  if (result) {
+    result->line = line;
+  }
+  return result;
+}
+
+} // namespace
+
+AstCache::AstCache(std::string directory) : directory(std::move(directory)) {}
+
+std::string AstCache::pathFor(std::string_view source) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.hlast",
+                static_cast<unsigned long long>(cacheKey(source)));
+  return (fs::path(directory) / name).string();
+}
+
+bool AstCache::load(std::string_view source, Program &program) const {
+  MappedFile file;
+  if (!file.open(pathFor(source))) {
+    return false;
+  }
+  std::string_view data = file.view();
+
+  Header header;
+  if (data.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.formatVersion != FORMAT_VERSION ||
+      header.byteOrder != BYTE_ORDER_MARK ||
+      header.sourceHash != contentHash(source) ||
+      header.sourceSize != source.size()) {
+    return false;
+  }
+  std::string_view payload = data.substr(sizeof(header));
+  if (header.payloadHash != contentHash(payload)) {
+    return false;
+  }
+
+  auto arena = std::make_unique<AstArena>();
+  AstReader reader(payload.data(), payload.size(), *arena);
+  if (!reader.readStrings(header.stringCount)) {
+    return false;
+  }
+
+  Program loaded;
+  loaded.statements.reserve(header.statementCount);
+  for (uint32_t i = 0; i < header.statementCount && reader.ok; i++) {
+    loaded.statements.push_back(reader.node());
+  }
+  loaded.arena = std::move(arena);
+  if (!reader.ok) {
+    return false;
+  }
+
+  for (const auto &stmt : loaded.statements) {
+    loaded.declarations.add(stmt.get());
+  }
+  program = std::move(loaded);
+  return true;
+}
+
+bool AstCache::store(std::string_view source, const Program &program) const {
+  AstWriter writer;
+  for (const auto &stmt : program.statements) {
+    writer.node(stmt.get());
+  }
+
+  std::string payload;
+  for (std::string_view text : writer.strings) {
+    uint32_t length = static_cast<uint32_t>(text.size());
+    payload.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    payload.append(text);
+  }
+  payload += writer.body;
+
+  Header header;
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.formatVersion = FORMAT_VERSION;
+  header.byteOrder = BYTE_ORDER_MARK;
+  header.sourceHash = contentHash(source);
+  header.sourceSize = source.size();
+  header.payloadHash = contentHash(payload);
+  header.stringCount = static_cast<uint32_t>(writer.strings.size());
+  header.statementCount = static_cast<uint32_t>(program.statements.size());
+
+  std::error_code ec;
+  fs::create_directories(directory, ec);
+  std::string path = pathFor(source);
+  // written aside and renamed, so a concurrent build never maps a partial file
+  std::string temporary = path + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(payload.data(), payload.size());
+    if (!out) {
+      return false;
+    }
+  }
+  fs::rename(temporary, path, ec);
+  if (ec) {
+    fs::remove(temporary, ec);
+    return false;
+  }
+  return true;
+}
+
+} // namespace HolyLua
@@ -2,17 +2,17 @@
 
 namespace HolyLua {
 
-Token::Token(TokenType t, std::string lex, int l)
-    : type(t), lexeme(lex), line(l) {}
+Token::Token(TokenType t, std::string_view lex, int l)
+    : type(t), line(l), lexeme(lex) {}
 
-Token::Token(TokenType t, std::string lex, int64_t num, int l)
-    : type(t), lexeme(lex), literal(num), line(l) {}
+Token::Token(TokenType t, std::string_view lex, int64_t num, int l)
+    : type(t), line(l), lexeme(lex), literal(num) {}
 
-Token::Token(TokenType t, std::string lex, double num, int l)
-    : type(t), lexeme(lex), literal(num), line(l) {}
+Token::Token(TokenType t, std::string_view lex, double num, int l)
+    : type(t), line(l), lexeme(lex), literal(num) {}
 
-Token::Token(TokenType t, std::string lex, std::string str, int l)
-    : type(t), lexeme(lex), literal(str), line(l) {}
+Token::Token(TokenType t, std::string_view lex, std::string_view str, int l)
+    : type(t), line(l), lexeme(lex), literal(str) {}
 
 std::string tokenTypeToString(TokenType type) {
   switch (type) {
@@ -0,0 +1,47 @@
+#include "../../include/type_name.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace HolyLua {
+
+namespace {
+
+std::mutex lock;
+// entries are never erased and a deque never moves its elements, so the
+// pointers handed out stay valid for the whole run. the index is keyed by
+// views of the stored names so find() needs no temporary string
+std::deque<std::string> entries;
+std::unordered_map<std::string_view, const std::string *> names;
+
+} // namespace
+
+// only the parser and the AST cache insert, before checking and codegen fan
+// out across threads
+TypeName TypeName::intern(std::string_view name) {
+  if (name.empty()) {
+    return TypeName();
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  auto it = names.find(name);
+  if (it != names.end()) {
+    return TypeName(it->second);
+  }
+  const std::string &entry = entries.emplace_back(name);
+  names.emplace(entry, &entry);
+  return TypeName(&entry);
+}
+
+// no insert can run alongside the passes that look names up, so the table
+// is read without the lock
+TypeName TypeName::find(std::string_view name) {
+  auto it = names.find(name);
+  return it == names.end() ? TypeName() : TypeName(it->second);
+}
+
+const std::string &TypeName::emptyName() {
+  static const std::string empty;
+  return empty;
+}
+
+} // namespace HolyLua
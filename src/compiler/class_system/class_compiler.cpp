@@ -3,21 +3,22 @@
 namespace HolyLua {
 
 void Compiler::compileClassDecl(const ClassDecl *decl) {
+  declareClass(decl);
+  compileClassBody(decl);
+}
+
+void Compiler::declareClass(const ClassDecl *decl) {
   auto &info = classTable[decl->name];
   info.name = decl->name;
   info.fields = decl->fields;
+  info.indexMembers(*decl);
   
-  for (const auto &field : decl->fields) {
-    info.fieldInfo[field.name] = {field.type, field.visibility};
-  }
-  
+  // untyped static factories are assumed to return an instance
   for (const auto &method : decl->methods) {
-    info.methodInfo[method.name] = {method.returnType, method.visibility};
-    
     if (method.isStatic && method.returnType == ValueType::INFERRED) {
       if (method.name == "new" || method.name.find("create") != std::string::npos ||
           method.name.find("New") != std::string::npos) {
-        info.methodInfo[method.name] = {ValueType::STRUCT, method.visibility};
+        info.members[method.name].type = ValueType::STRUCT;
       }
     }
   }
@@ -27,9 +28,10 @@ void Compiler::compileClassDecl(const ClassDecl *decl) {
     info.constructorParams = decl->constructor->parameters;
     info.constructorParamOptionals = decl->constructor->parameterOptionals;
     info.constructorParamTypeNames = decl->constructor->parameterTypeNames;
-    info.methodInfo["__init"] = {ValueType::INFERRED, Visibility::PUBLIC};
   }
-  
+}
+
+void Compiler::compileClassBody(const ClassDecl *decl) {
   // generate struct definition
   std::string structDef = "typedef struct {\n";
   
@@ -49,6 +51,7 @@ void Compiler::compileClassDecl(const ClassDecl *decl) {
   
   structDef += "} " + decl->name + ";\n\n";
   output += structDef;
+  output += ownershipHelpers(decl->name);
   
   // generate static field declarations
   for (const auto &field : decl->fields) {
@@ -80,7 +83,7 @@ void Compiler::compileClassDecl(const ClassDecl *decl) {
             [&](auto &&arg) {
               using T = std::decay_t<decltype(arg)>;
               if constexpr (std::is_same_v<T, int64_t>) {
-                if (field.type == ValueType::ENUM) {
+                if (field.type == ValueType::ENUM || field.type == ValueType::INT) {
                   staticFieldDecl += std::to_string(arg);
                 } else {
                   staticFieldDecl += std::to_string(arg) + ".0";
@@ -117,24 +120,22 @@ void Compiler::compileClassDecl(const ClassDecl *decl) {
   
   // Compile constructor
   if (decl->constructor) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileConstructor(decl->name, *decl->constructor);
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
   }
   
   // Compile methods
   for (const auto &method : decl->methods) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileMethod(decl->name, method);
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
   }
 }
 
 std::string Compiler::compileClassInstantiation(const ClassInstantiation *expr) {
+  // arguments are borrowed, the constructor copies what it keeps
+  StringLifetime lifetime(*this, true);
   if (!classTable.count(expr->className)) {
     error("Class '" + expr->className + "' not defined", expr->line);
     return "";
@@ -180,7 +181,7 @@ std::string Compiler::compileClassInstantiation(const ClassInstantiation *expr)
   
   // compile provided arguments
   for (size_t i = 0; i < providedArgs; i++) {
-    bool isNilArg = dynamic_cast<const NilExpr *>(expr->arguments[i].get()) != nullptr;
+    bool isNilArg = nodeCast<NilExpr>(expr->arguments[i].get()) != nullptr;
     
     if (isNilArg && i < totalParams && 
         i < classInfo.constructorParamOptionals.size() && 
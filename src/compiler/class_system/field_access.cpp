@@ -4,22 +4,15 @@
 namespace HolyLua {
 
 std::string Compiler::compileFieldAccess(const FieldAccessExpr *expr) {
-  if (auto *varExpr = dynamic_cast<const VarExpr *>(expr->object.get())) {
+  if (auto *varExpr = nodeCast<VarExpr>(expr->object.get())) {
     std::string className = varExpr->name;
     
     if (classTable.count(className) > 0 && !symbolTable.count(className)) {
       const auto &classInfo = classTable[className];
-      bool isStaticField = false;
+      const MemberInfo *field = classInfo.findField(expr->fieldName);
       
-      for (const auto &field : classInfo.fields) {
-        if (field.name == expr->fieldName && field.isStatic) {
-          isStaticField = true;
-          break;
-        }
-      }
-      
-      if (isStaticField) {
-        return className + "_" + expr->fieldName;
+      if (field && field->isStatic) {
+        return field->cName;
       } else {
         error("Field '" + expr->fieldName + "' is not static in class '" + className + "'", expr->line);
         return "0";
@@ -30,7 +23,7 @@ std::string Compiler::compileFieldAccess(const FieldAccessExpr *expr) {
   std::string object = compileExpr(expr->object.get());
   
   bool isSelfPointer = false;
-  if (auto *selfExpr = dynamic_cast<const SelfExpr *>(expr->object.get())) {
+  if (auto *selfExpr = nodeCast<SelfExpr>(expr->object.get())) {
     if (currentFunction.find("___init") == std::string::npos && 
         !currentClass.empty()) {
       isSelfPointer = true;
@@ -54,30 +47,24 @@ void Compiler::compileFieldAssignment(const FieldAssignment *assign) {
   std::string objectExpr = compileExpr(assign->object.get());
   std::string fieldName = assign->fieldName;
   
-  if (auto *varExpr = dynamic_cast<const VarExpr *>(assign->object.get())) {
+  if (auto *varExpr = nodeCast<VarExpr>(assign->object.get())) {
     std::string className = varExpr->name;
     
     if (classTable.count(className) > 0 && !symbolTable.count(className)) {
       const auto &classInfo = classTable[className];
-      bool isStaticField = false;
-      bool isConstField = false;
-      
-      for (const auto &field : classInfo.fields) {
-        if (field.name == fieldName && field.isStatic) {
-          isStaticField = true;
-          isConstField = field.isConst;
-          break;
-        }
-      }
+      const MemberInfo *field = classInfo.findField(fieldName);
       
-      if (isStaticField) {
-        if (isConstField) {
+      if (field && field->isStatic) {
+        if (classInfo.fields[field->slot].isConst) {
           error("Cannot assign to const field '" + fieldName + "'", assign->line);
           return;
         }
         
-        std::string valueExpr = compileExpr(assign->value.get());
-        output += indent() + className + "_" + fieldName + " = " + valueExpr + ";\n";
+        // the previous value may be the literal the field started with, so
+        // it is not freed
+        std::string valueExpr =
+            compileOwned(assign->value.get(), field->type, field->structTypeName);
+        output += indent() + field->cName + " = " + valueExpr + ";\n";
         return;
       } else {
         error("Field '" + fieldName + "' is not static in class '" + className + "'", assign->line);
@@ -88,54 +75,103 @@ void Compiler::compileFieldAssignment(const FieldAssignment *assign) {
   
   std::string typeName = "";
   
-  if (auto *varExpr = dynamic_cast<const VarExpr *>(assign->object.get())) {
+  if (auto *varExpr = nodeCast<VarExpr>(assign->object.get())) {
     if (symbolTable.count(varExpr->name)) {
       typeName = symbolTable[varExpr->name].structTypeName;
     }
-  } else if (dynamic_cast<const SelfExpr *>(assign->object.get())) {
+  } else if (nodeCast<SelfExpr>(assign->object.get())) {
     typeName = currentClass;
-  } else if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(assign->object.get())) {
-    
   }
   
   if (!typeName.empty() && classTable.count(typeName)) {
     const auto &classInfo = classTable[typeName];
     
-    for (const auto &field : classInfo.fields) {
-      if (field.name == fieldName && !field.isStatic) {
-        if (field.isConst) {
-          if (currentFunction.find("___init") == std::string::npos) {
-            error("Cannot assign to const field '" + fieldName + "' outside of constructor", assign->line);
-            return;
-          }
-          
-          static std::map<std::string, std::set<std::string>> constFieldAssignments;
-          std::string key = currentClass + "_" + currentFunction;
-          
-          if (constFieldAssignments[key].count(fieldName) > 0) {
-            error("Const field '" + fieldName + "' can only be assigned once in constructor", assign->line);
-            return;
-          }
-          
-          constFieldAssignments[key].insert(fieldName);
+    const MemberInfo *member = classInfo.findField(fieldName);
+    if (member && !member->isStatic) {
+      const auto &field = classInfo.fields[member->slot];
+      if (field.isConst) {
+        if (currentFunction.find("___init") == std::string::npos) {
+          error("Cannot assign to const field '" + fieldName + "' outside of constructor", assign->line);
+          return;
         }
-        break;
+        
+        std::string key = currentClass + "_" + currentFunction;
+        
+        if (constFieldAssignments[key].count(fieldName) > 0) {
+          error("Const field '" + fieldName + "' can only be assigned once in constructor", assign->line);
+          return;
+        }
+        
+        constFieldAssignments[key].insert(fieldName);
       }
     }
   }
   
+  // int fields keep integer arithmetic and integer constants
+  ValueType fieldType = ValueType::INFERRED;
+  if (!typeName.empty()) {
+    const MemberInfo *member = nullptr;
+    if (classTable.count(typeName)) {
+      member = classTable[typeName].findField(fieldName);
+    } else if (structTable.count(typeName)) {
+      member = structTable[typeName].findField(fieldName);
+    }
+    if (member) {
+      fieldType = member->type;
+    }
+  }
+  ValueType valueContext =
+      fieldType == ValueType::INT ? ValueType::INT : ValueType::INFERRED;
+
+  // a field reached through other fields owns its strings as well
+  std::string ownerType = typeName;
+  if (ownerType.empty()) {
+    resolveExprType(assign->object.get(), ownerType);
+  }
+  const MemberInfo *ownedField = nullptr;
+  if (classTable.count(ownerType)) {
+    ownedField = classTable[ownerType].findField(fieldName);
+  } else if (structTable.count(ownerType)) {
+    ownedField = structTable[ownerType].findField(fieldName);
+  }
+
   std::string accessor = ".";
   
-  if (auto *selfExpr = dynamic_cast<const SelfExpr *>(assign->object.get())) {
+  if (auto *selfExpr = nodeCast<SelfExpr>(assign->object.get())) {
     if (currentFunction.find("___init") == std::string::npos && 
         !currentClass.empty()) {
       accessor = "->";
     }
   }
   
-  output += indent() + objectExpr + accessor + fieldName;
+  std::string target = objectExpr + accessor + fieldName;
+  if (!assign->isCompound && ownedField &&
+      (ownedField->type == ValueType::STRING ||
+       (ownedField->type == ValueType::STRUCT &&
+        ownsStrings(ownedField->structTypeName)))) {
+    std::string valueExpr = compileOwned(assign->value.get(), ownedField->type,
+                                         ownedField->structTypeName);
+    output += indent() + storeOwned(target, valueExpr, ownedField->type,
+                                    ownedField->structTypeName);
+    return;
+  }
+
+  output += indent() + target;
   
+  ValueType valueType = inferExprType(assign->value.get());
   if (assign->isCompound) {
+    valueType = arithmeticResultType(assign->compoundOp, nullptr, fieldType,
+                                     assign->value.get(), valueType);
+  }
+  if (!checkIntValue(fieldType, valueType,
+                     assign->isCompound ? nullptr : assign->value.get(),
+                     "field '" + fieldName + "'", assign->line)) {
+    output = "";
+    return;
+  }
+
+  if (assign->isCompound) {
+    std::string valueExpr = compileExpr(assign->value.get(), valueContext);
     std::string op;
     switch (assign->compoundOp) {
     case BinaryOp::ADD:
@@ -151,26 +187,23 @@ void Compiler::compileFieldAssignment(const FieldAssignment *assign) {
       op = " / ";
       break;
     case BinaryOp::MODULO:
-      op = " % ";
-      break;
     case BinaryOp::POWER:
-      output = indent() + objectExpr + accessor + fieldName + " = pow(" + 
-               objectExpr + accessor + fieldName + ", " + 
-               compileExpr(assign->value.get()) + ");\n";
-      return;
     case BinaryOp::FLOOR_DIVIDE:
-      output = indent() + objectExpr + accessor + fieldName + " = (double)floor(" +
-               objectExpr + accessor + fieldName + " / " + 
-               compileExpr(assign->value.get()) + ");\n";
+      output += " = " + compileArithmetic(assign->compoundOp, target, valueExpr,
+                                          valueType) + ";\n";
       return;
     default:
       op = " + ";
       break;
     }
-    std::string valueExpr = compileExpr(assign->value.get());
-    output += " = " + objectExpr + accessor + fieldName + op + valueExpr;
+    if (valueType == ValueType::INT) {
+      output += " = " + compileArithmetic(assign->compoundOp, target,
+                                          valueExpr, valueType);
+    } else {
+      output += " = " + target + op + valueExpr;
+    }
   } else {
-    std::string valueExpr = compileExpr(assign->value.get());
+    std::string valueExpr = compileExpr(assign->value.get(), valueContext);
     output += " = " + valueExpr;
   }
   
@@ -9,7 +9,7 @@ void Compiler::compileConstructor(const std::string &className,
   currentFunction = className + "___init";
   currentClass = className;
   
-  auto savedSymbolTable = symbolTable;
+  symbolTable.enterScope();
   
   output += className + " " + className + "_new(";
   
@@ -22,15 +22,9 @@ void Compiler::compileConstructor(const std::string &className,
     
     // look up the field type from the class definition
     std::string fieldTypeName = "";
-    for (const auto &field : classInfo.fields) {
-      if (field.name == param.first) {
-        if (field.type == ValueType::STRUCT) {
-          fieldTypeName = field.structTypeName;
-        } else if (field.type == ValueType::ENUM) {
-          fieldTypeName = field.structTypeName;
-        }
-        break;
-      }
+    const MemberInfo *field = classInfo.findField(param.first);
+    if (field && (field->type == ValueType::STRUCT || field->type == ValueType::ENUM)) {
+      fieldTypeName = field->structTypeName;
     }
     
     if (param.second == ValueType::STRUCT) {
@@ -72,7 +66,7 @@ void Compiler::compileConstructor(const std::string &className,
   selfVar.isOptional = false;
   selfVar.isFunction = false;
   selfVar.isStruct = true;
-  selfVar.structTypeName = className;
+  selfVar.structTypeName = TypeName::find(className);
   symbolTable["self"] = selfVar;
   
   // add all parameters to symbol table
@@ -80,17 +74,13 @@ void Compiler::compileConstructor(const std::string &className,
     const auto &param = constructor.parameters[i];
     bool isOptional = (i < constructor.parameterOptionals.size()) && constructor.parameterOptionals[i];
     
-    std::string structTypeName = "";
+    TypeName structTypeName;
     bool isStruct = false;
     
-    for (const auto &field : classInfo.fields) {
-      if (field.name == param.first) {
-        if (field.type == ValueType::STRUCT || field.type == ValueType::ENUM) {
-          structTypeName = field.structTypeName;
-          isStruct = (field.type == ValueType::STRUCT);
-        }
-        break;
-      }
+    const MemberInfo *field = classInfo.findField(param.first);
+    if (field && (field->type == ValueType::STRUCT || field->type == ValueType::ENUM)) {
+      structTypeName = field->structTypeName;
+      isStruct = (field->type == ValueType::STRUCT);
     }
     
     if (structTypeName.empty() && param.second == ValueType::STRUCT) {
@@ -116,20 +106,21 @@ void Compiler::compileConstructor(const std::string &className,
   }
   
   // compile constructor body
+  ScratchState enclosingScratch = beginFunctionBody();
+  ownAssignedParameters(constructor.body, constructor.parameters);
   for (const auto &stmt : constructor.body) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileStatement(stmt.get());
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
   }
+  endFunctionBody(enclosingScratch);
   
   output += indent() + "return self;\n";
   
   indentLevel = 0;
   output += "}\n\n";
   
-  symbolTable = savedSymbolTable;
+  symbolTable.exitScope();
   currentFunction = savedFunction;
   currentClass = savedClass;
 }
@@ -146,7 +137,7 @@ void Compiler::compileMethod(const std::string &className, const ClassMethod &me
   
   currentClass = className;
   
-  auto savedSymbolTable = symbolTable;
+  symbolTable.enterScope();
   
   ValueType actualReturnType = method.returnType;
   
@@ -155,7 +146,7 @@ void Compiler::compileMethod(const std::string &className, const ClassMethod &me
     bool hasReturnValue = false;
     
     for (const auto &stmt : method.body) {
-      if (auto *ret = dynamic_cast<const ReturnStmt *>(stmt.get())) {
+      if (auto *ret = nodeCast<ReturnStmt>(stmt.get())) {
         if (ret->value) {
           hasReturnValue = true;
           actualReturnType = inferExprType(ret->value.get());
@@ -178,7 +169,7 @@ void Compiler::compileMethod(const std::string &className, const ClassMethod &me
     // for inferred type with no return value, use void
     bool hasReturnValue = false;
     for (const auto &stmt : method.body) {
-      if (auto *ret = dynamic_cast<const ReturnStmt *>(stmt.get())) {
+      if (auto *ret = nodeCast<ReturnStmt>(stmt.get())) {
         if (ret->value) {
           hasReturnValue = true;
           break;
@@ -244,7 +235,7 @@ void Compiler::compileMethod(const std::string &className, const ClassMethod &me
     selfVar.isOptional = false;
     selfVar.isFunction = false;
     selfVar.isStruct = true;
-    selfVar.structTypeName = className;
+    selfVar.structTypeName = TypeName::find(className);
     symbolTable["self"] = selfVar;
   }
   
@@ -252,7 +243,7 @@ void Compiler::compileMethod(const std::string &className, const ClassMethod &me
     const auto &param = method.parameters[i];
     bool isOptional = method.parameterOptionals[i];
     
-    std::string structTypeName = "";
+    TypeName structTypeName;
     bool isStruct = false;
     if (param.second == ValueType::STRUCT) {
       isStruct = true;
@@ -276,17 +267,18 @@ void Compiler::compileMethod(const std::string &className, const ClassMethod &me
     symbolTable[param.first] = paramVar;
   }
   
+  ScratchState enclosingScratch = beginFunctionBody();
+  ownAssignedParameters(method.body, method.parameters);
   for (const auto &stmt : method.body) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileStatement(stmt.get());
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
   }
+  endFunctionBody(enclosingScratch);
   
   bool hasReturnAtEnd = false;
   if (!method.body.empty()) {
-    hasReturnAtEnd = dynamic_cast<const ReturnStmt *>(method.body.back().get()) != nullptr;
+    hasReturnAtEnd = nodeCast<ReturnStmt>(method.body.back().get()) != nullptr;
   }
   
   // don't add default return for void methods
@@ -294,8 +286,9 @@ void Compiler::compileMethod(const std::string &className, const ClassMethod &me
     if (actualReturnType == ValueType::NUMBER || actualReturnType == ValueType::INFERRED) {
       output += indent() + "return 0.0;\n";
     } else if (actualReturnType == ValueType::STRING) {
-      output += indent() + "return \"\";\n";
-    } else if (actualReturnType == ValueType::BOOL) {
+      output += indent() + "return hl_string_copy(\"\");\n";
+    } else if (actualReturnType == ValueType::BOOL ||
+               actualReturnType == ValueType::INT) {
       output += indent() + "return 0;\n";
     } else if (actualReturnType == ValueType::STRUCT) {
       output += indent() + className + " result = {0};\n";
@@ -306,18 +299,20 @@ void Compiler::compileMethod(const std::string &className, const ClassMethod &me
   indentLevel = 0;
   output += "}\n\n";
   
-  symbolTable = savedSymbolTable;
+  symbolTable.exitScope();
   currentFunction = savedFunction;
   currentClass = savedClass;
 }
 
 std::string Compiler::compileMethodCall(const MethodCall *call) {
+  // arguments are borrowed, the method copies what it keeps
+  StringLifetime lifetime(*this, true);
   std::string objectExpr = compileExpr(call->object.get());
   
   bool isStatic = false;
   std::string className = "";
   
-  if (auto *varExpr = dynamic_cast<const VarExpr *>(call->object.get())) {
+  if (auto *varExpr = nodeCast<VarExpr>(call->object.get())) {
     if (classTable.count(varExpr->name)) {
       isStatic = true;
       className = varExpr->name;
@@ -327,7 +322,7 @@ std::string Compiler::compileMethodCall(const MethodCall *call) {
       error("Variable '" + varExpr->name + "' is declared but not initialized", call->line);
       return "0";
     }
-  } else if (dynamic_cast<const SelfExpr *>(call->object.get())) {
+  } else if (nodeCast<SelfExpr>(call->object.get())) {
     className = currentClass;
   }
   
@@ -343,7 +338,7 @@ std::string Compiler::compileMethodCall(const MethodCall *call) {
   
   auto &classInfo = classTable[className];
   
-  if (!classInfo.methodInfo.count(call->methodName)) {
+  if (!classInfo.findMethod(call->methodName)) {
     error("Method '" + call->methodName + "' does not exist in class '" + className + "'", call->line);
     return "0";
   }
@@ -371,7 +366,7 @@ std::string Compiler::compileMethodCall(const MethodCall *call) {
     result = methodName + "(";
     
     bool isSelfPointer = false;
-    if (dynamic_cast<const SelfExpr *>(call->object.get())) {
+    if (nodeCast<SelfExpr>(call->object.get())) {
       if (currentFunction.find("___init") == std::string::npos && 
           !currentClass.empty()) {
         isSelfPointer = true;
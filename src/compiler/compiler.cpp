@@ -1,49 +1,107 @@
 #include "../../include/compiler/compiler.h"
+#include "../../include/utils/parallel.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
 #include <sstream>
+#include <utility>
 
 namespace HolyLua {
 
-Compiler::Compiler(const std::string &source) : source(source) {
-  initSourceLines();
+Compiler::Compiler(const SourceManager &sources)
+    : sources(sources), diagnostics(&std::cerr) {}
+
+Compiler::Compiler(const Compiler &parent)
+    : symbolTable(parent.symbolTable), functionTable(parent.functionTable),
+      sources(parent.sources), structDefs(parent.structDefs),
+      structTable(parent.structTable), classTable(parent.classTable),
+      enumTable(parent.enumTable),
+      declaredReturnTypes(parent.declaredReturnTypes),
+      diagnostics(parent.diagnostics), jobs(1) {}
+
+void Compiler::setJobs(unsigned jobs) {
+  this->jobs = std::max(1u, jobs);
 }
 
-void Compiler::initSourceLines() {
-  std::stringstream ss(source);
-  std::string line;
-  while (std::getline(ss, line)) {
-    sourceLines.push_back(line);
+// every unit starts from the declaration state this compiler was copied
+// from: whatever a body registers (nested functions, lambdas, symbols) is
+// rolled back before the next unit, so a unit compiles the same on any
+// worker and in any order
+void Compiler::compileUnit(CodegenUnit &unit, size_t index) {
+  std::ostringstream messages;
+  diagnostics = &messages;
+
+  output.clear();
+  nestedFunctionDecls.clear();
+  indentLevel = 1;
+  currentFunction.clear();
+  currentFunctionParams.clear();
+  currentClass.clear();
+  nonNilVars.clear();
+  nonNilVarStack.clear();
+  constFieldAssignments.clear();
+  scratchStrings = false;
+  statementScratch = false;
+  functionScratch = false;
+  enclosingScratch = false;
+  uniqueNameSpace = index;
+  uniqueNameCounter = 0;
+
+  size_t functionMark = functionUndo.size();
+  int errorMark = errorCount;
+  symbolTable.enterScope();
+
+  if (unit.classDecl) {
+    compileClassBody(unit.classDecl);
+  } else {
+    compileFunctionDecl(unit.function);
   }
+
+  symbolTable.exitScope();
+  rollbackFunctions(functionMark);
+
+  unit.code = std::exchange(output, CodeBuffer());
+  unit.nestedDecls = std::exchange(nestedFunctionDecls, CodeBuffer());
+  unit.diagnostics = messages.str();
+  unit.failed = errorCount != errorMark ||
+                (unit.function && unit.code.empty());
+  diagnostics = &std::cerr;
+}
+
+void Compiler::compileUnits(std::vector<CodegenUnit> &units) {
+  std::vector<std::unique_ptr<Compiler>> workers(jobs);
+  parallelFor(units.size(), jobs, [&](unsigned worker, size_t index) {
+    if (!workers[worker]) {
+      workers[worker] = std::unique_ptr<Compiler>(new Compiler(*this));
+    }
+    workers[worker]->compileUnit(units[index], index);
+  });
 }
 
 std::string Compiler::indent() { 
   return std::string(indentLevel * 4, ' '); 
 }
 
-std::string Compiler::compile(const Program &program) {
+CodeBuffer Compiler::compile(const Program &program) {
   std::string globalDecls = "";
-  std::string mainBody = "";
-  std::string functionDecls = "";
-  std::string structDefinitions = "";
-  std::string enumDefinitions = "";
-  nestedFunctionDecls = "";
+  CodeBuffer functionDecls;
+  CodeBuffer structDefinitions;
+  CodeBuffer enumDefinitions;
+  nestedFunctionDecls.clear();
   bool hasErrors = false;
   bool hasMainFunction = false;
+  const DeclarationIndex &decls = program.declarations;
 
   // compile all enum declarations
-  for (const auto &stmt : program.statements) {
-    if (auto *enumDecl = dynamic_cast<EnumDecl *>(stmt.get())) {
-      output = "";
-      compileEnumDecl(enumDecl);
-      enumDefinitions += output;
-      output = "";
-    }
+  for (const EnumDecl *enumDecl : decls.enums) {
+    output.clear();
+    compileEnumDecl(enumDecl);
+    enumDefinitions += std::move(output);
   }
 
   // compile all struct declarations
-  for (const auto &stmt : program.statements) {
-    if (auto *structDecl = dynamic_cast<StructDecl *>(stmt.get())) {
-      compileStructDecl(structDecl);
-    }
+  for (const StructDecl *structDecl : decls.structs) {
+    compileStructDecl(structDecl);
   }
 
   // collect all struct definitions
@@ -52,142 +110,146 @@ std::string Compiler::compile(const Program &program) {
   }
 
   // collect class declarations
-  for (const auto &stmt : program.statements) {
-    if (auto *classDecl = dynamic_cast<ClassDecl *>(stmt.get())) {
-      ClassInfo info;
-      info.name = classDecl->name;
-      classTable.insert({classDecl->name, std::move(info)});
-    }
+  for (const ClassDecl *classDecl : decls.classes) {
+    ClassInfo info;
+    info.name = classDecl->name;
+    classTable.insert({classDecl->name, std::move(info)});
   }
 
   // collect function info
-  for (const auto &stmt : program.statements) {
-    if (auto *func = dynamic_cast<FunctionDecl *>(stmt.get())) {
-      FunctionInfo funcInfo;
-      funcInfo.name = func->name;
-      funcInfo.parameters = func->parameters;
-      funcInfo.parameterOptionals = func->parameterOptionals;
-      funcInfo.returnType = func->returnType;
-      funcInfo.isGlobal = func->isGlobal;
-      funcInfo.nestedFunctions = {};
-
-      functionTable[func->name] = funcInfo;
-
-      if (func->name == "main") {
-        hasMainFunction = true;
-      }
+  for (const FunctionDecl *func : decls.functions) {
+    FunctionInfo funcInfo;
+    funcInfo.name = func->name;
+    funcInfo.parameters = func->parameters;
+    funcInfo.parameterOptionals = func->parameterOptionals;
+    funcInfo.returnType = func->returnType;
+    funcInfo.isGlobal = func->isGlobal;
+    funcInfo.nestedFunctions = {};
+
+    functionTable[func->name] = funcInfo;
+
+    if (func->name == "main") {
+      hasMainFunction = true;
     }
   }
 
   // collect only global vars
-  for (const auto &stmt : program.statements) {
-    if (auto *decl = dynamic_cast<VarDecl *>(stmt.get())) {
-      if (decl->isGlobal) {
-        std::string varType;
-        std::string structTypeName = "";
-        ValueType actualType = decl->type;
+  for (const VarDecl *decl : decls.globals) {
+    if (!decl->isGlobal) {
+      continue;
+    }
+
+    std::string varType;
+    std::string structTypeName = "";
+    ValueType actualType = decl->type;
+    
+    if (decl->type == ValueType::INFERRED) {
+      if (decl->value) {
+        actualType = inferVarType(decl->value.get());
         
-        if (decl->type == ValueType::INFERRED) {
-          if (decl->value) {
-            actualType = inferExprType(decl->value.get());
-            
-            if (actualType == ValueType::STRUCT) {
-              if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
-                varType = classInst->className;
-                structTypeName = classInst->className;
-              } else {
-                varType = "void*";
-              }
-            } else {
-              varType = getCType(actualType);
-            }
+        if (actualType == ValueType::STRUCT) {
+          if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
+            varType = classInst->className;
+            structTypeName = classInst->className;
           } else {
-            actualType = ValueType::NUMBER;
-            varType = "double";
+            varType = "void*";
           }
         } else {
-          actualType = decl->type;
           varType = getCType(actualType);
         }
-        
-        globalDecls += varType + " " + decl->name + ";\n";
-        
-        Variable var;
-        var.type = actualType;
-        var.isConst = decl->isConst;
-        var.isDefined = false;
-        var.isOptional = false;
-        var.isFunction = false;
-        var.isStruct = (actualType == ValueType::STRUCT);
-        var.structTypeName = structTypeName;
-        symbolTable[decl->name] = var;
+      } else {
+        actualType = ValueType::NUMBER;
+        varType = "double";
       }
+    } else {
+      actualType = decl->type;
+      varType = getCType(actualType);
     }
+    
+    globalDecls += varType + " " + decl->name + ";\n";
+    
+    Variable var;
+    var.type = actualType;
+    var.isConst = decl->isConst;
+    var.isDefined = false;
+    var.isOptional = false;
+    var.isFunction = false;
+    var.isStruct = (actualType == ValueType::STRUCT);
+    var.structTypeName = TypeName::find(structTypeName);
+    symbolTable[decl->name] = var;
   }
 
-  // compile class declarations
-  for (const auto &stmt : program.statements) {
-    if (auto *classDecl = dynamic_cast<ClassDecl *>(stmt.get())) {
-      output = "";
-      compileClassDecl(classDecl);
-      structDefinitions += output;
-      output = "";
-    }
+  // resolve class layouts and function signatures
+  for (const ClassDecl *classDecl : decls.classes) {
+    declareClass(classDecl);
+  }
+  for (const FunctionDecl *func : decls.functions) {
+    declareFunction(func);
   }
 
-  // compile function definitions
-  for (const auto &stmt : program.statements) {
-    if (auto *func = dynamic_cast<FunctionDecl *>(stmt.get())) {
-      output = "";
-      compileFunctionDecl(func);
-      if (output.empty()) {
-        hasErrors = true;
-        break;
-      }
-      functionDecls += output + "\n";
+  // compile class and function bodies, then splice them in source order
+  std::vector<CodegenUnit> units(decls.classes.size() + decls.functions.size());
+  size_t unitCount = 0;
+  for (const ClassDecl *classDecl : decls.classes) {
+    units[unitCount++].classDecl = classDecl;
+  }
+  for (const FunctionDecl *func : decls.functions) {
+    units[unitCount++].function = func;
+  }
+
+  compileUnits(units);
+
+  for (auto &unit : units) {
+    if (!unit.diagnostics.empty()) {
+      *diagnostics << unit.diagnostics;
+    }
+    if (unit.failed) {
+      hasErrors = true;
+      break;
+    }
+
+    nestedFunctionDecls += std::move(unit.nestedDecls);
+    if (unit.classDecl) {
+      structDefinitions += std::move(unit.code);
+    } else {
+      functionDecls += std::move(unit.code);
+      functionDecls += "\n";
     }
   }
 
   if (hasErrors) {
-    return "";
+    return CodeBuffer();
   }
 
   // generate output
   output = "#include \"holylua_api.h\"\n\n";
-  output += enumDefinitions;
-  output += structDefinitions;
+  output += std::move(enumDefinitions);
+  output += std::move(structDefinitions);
   output += globalDecls + "\n";
 
   if (!nestedFunctionDecls.empty()) {
-    output += nestedFunctionDecls + "\n";
+    output += std::move(nestedFunctionDecls);
+    output += "\n";
   }
 
-  output += functionDecls + "\n";
+  output += std::move(functionDecls);
+  output += "\n";
 
   if (hasMainFunction) {
-    return output;
+    return std::exchange(output, CodeBuffer());
   }
 
   // generate main function
   output += "int main() {\n";
   indentLevel = 1;
-  std::string savedOutput = output;
-  output = "";
 
-  // clear symbol table for main() scope
-  auto mainSymbolTable = symbolTable;
+  // main() starts from an empty symbol table
+  symbolTable.enterScope();
   symbolTable.clear();
 
-  for (const auto &stmt : program.statements) {
-    if (dynamic_cast<EnumDecl *>(stmt.get())) {
-      // skip
-    } else if (dynamic_cast<StructDecl *>(stmt.get())) {
-      // skip
-    } else if (dynamic_cast<ClassDecl *>(stmt.get())) {
-      // skip
-    } else if (auto *func = dynamic_cast<FunctionDecl *>(stmt.get())) {
-      // skip
-    } else if (auto *decl = dynamic_cast<VarDecl *>(stmt.get())) {
+  ScratchState enclosingScratch = beginFunctionBody();
+  for (const ASTNode *stmt : decls.statements) {
+    if (auto *decl = nodeCast<VarDecl>(stmt)) {
       if (!decl->isGlobal) {
         // compile as a local variable declaration
         std::string varType;
@@ -196,11 +258,11 @@ std::string Compiler::compile(const Program &program) {
 
         if (actualType == ValueType::STRUCT && decl->typeName == "struct" && decl->value) {
           // try to infer actual type from value
-          if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
+          if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
             varType = classInst->className;
             structTypeName = classInst->className;
             actualType = ValueType::STRUCT;
-          } else if (auto *structCons = dynamic_cast<const StructConstructor *>(decl->value.get())) {
+          } else if (auto *structCons = nodeCast<StructConstructor>(decl->value.get())) {
             varType = structCons->structName;
             structTypeName = structCons->structName;
             actualType = ValueType::STRUCT;
@@ -215,13 +277,13 @@ std::string Compiler::compile(const Program &program) {
         // determine the type from type annotation or value
         else if (actualType == ValueType::INFERRED) {
           if (decl->value) {
-            actualType = inferExprType(decl->value.get());
+            actualType = inferVarType(decl->value.get());
             
             if (actualType == ValueType::STRUCT) {
-              if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
+              if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
                 varType = classInst->className;
                 structTypeName = classInst->className;
-              } else if (auto *structCons = dynamic_cast<const StructConstructor *>(decl->value.get())) {
+              } else if (auto *structCons = nodeCast<StructConstructor>(decl->value.get())) {
                 varType = structCons->structName;
                 structTypeName = structCons->structName;
               } else {
@@ -248,16 +310,39 @@ std::string Compiler::compile(const Program &program) {
           }
         }
         
+        if (decl->value &&
+            !checkIntValue(actualType, inferExprType(decl->value.get()),
+                           decl->value.get(), "variable '" + decl->name + "'",
+                           decl->line)) {
+          hasErrors = true;
+          break;
+        }
+
         // generate the declaration
         output += indent();
         if (decl->isConst) output += "const ";
         output += varType + " " + decl->name;
-        
-        if (decl->value) {
-          output += " = " + compileExpr(decl->value.get());
+
+        std::string ownedType =
+            actualType == ValueType::STRUCT ? structTypeName : "";
+        bool owned = actualType == ValueType::STRING || ownsStrings(ownedType);
+        if (owned && decl->isConst && nodeCast<LiteralExpr>(decl->value.get())) {
+          owned = false;
+        }
+
+        if (decl->value && owned) {
+          output += " = " + compileOwned(decl->value.get(), actualType, ownedType);
+        } else if (decl->value) {
+          output += " = " + compileExpr(decl->value.get(), actualType);
+        } else if (owned) {
+          output += actualType == ValueType::STRING ? " = NULL" : " = {0}";
         }
         
         output += ";\n";
+        releaseStatementScratch();
+        if (owned) {
+          ownLocal(decl->name, ownedType);
+        }
         
         // add to symbol table
         Variable var;
@@ -267,14 +352,27 @@ std::string Compiler::compile(const Program &program) {
         var.isOptional = false;
         var.isFunction = false;
         var.isStruct = (actualType == ValueType::STRUCT);
-        var.structTypeName = structTypeName;
+        var.structTypeName = TypeName::find(structTypeName);
         symbolTable[decl->name] = var;
         
         continue;
       } else {
-        // global var
+        // global var, it owns its strings like any other
         if (decl->value) {
-          output += indent() + decl->name + " = " + compileExpr(decl->value.get()) + ";\n";
+          ValueType globalType = decl->type;
+          std::string ownedType;
+          if (symbolTable.count(decl->name)) {
+            globalType = symbolTable[decl->name].type;
+            if (globalType == ValueType::STRUCT) {
+              ownedType = symbolTable[decl->name].structTypeName;
+            }
+          }
+          std::string value =
+              globalType == ValueType::STRING || ownsStrings(ownedType)
+                  ? compileOwned(decl->value.get(), globalType, ownedType)
+                  : compileExpr(decl->value.get(), decl->type);
+          output += indent() + decl->name + " = " + value + ";\n";
+          releaseStatementScratch();
           
           if (symbolTable.count(decl->name)) {
             symbolTable[decl->name].isDefined = true;
@@ -283,25 +381,24 @@ std::string Compiler::compile(const Program &program) {
       }
     } else {
       // other statements
-      std::string stmtOutput = output;
-      output = "";
-      compileStatement(stmt.get());
-      stmtOutput += output;
-      output = stmtOutput;
+      output.openSection();
+      compileStatement(stmt);
+      output.closeSection();
     }
   }
+  endFunctionBody(enclosingScratch);
 
-  if (hasErrors) {
-    return "";
+  if (hasErrors || errorCount > 0) {
+    return CodeBuffer();
   }
 
   indentLevel = 0;
-  output = savedOutput + output + "    return 0;\n}\n";
+  output += "    return 0;\n}\n";
 
   // restore symbol table
-  symbolTable = mainSymbolTable;
+  symbolTable.exitScope();
 
-  return output;
+  return std::exchange(output, CodeBuffer());
 }
 
 } // namespace HolyLua
\ No newline at end of file
@@ -9,17 +9,32 @@ std::string Compiler::compileFunctionCall(const FunctionCall *call) {
       return "";
     }
 
-    std::string arg = compileExpr(call->arguments[0].get());
+    // a string argument is copied when the result is kept
+    bool scratch = scratchStrings;
+    std::string arg;
+    {
+      StringLifetime lifetime(*this, true);
+      arg = compileExpr(call->arguments[0].get());
+    }
     ValueType argType = inferExprType(call->arguments[0].get());
 
-    if (argType == ValueType::NUMBER) {
-      return "hl_tostring_number(" + arg + ")";
-    } else if (argType == ValueType::STRING) {
-      return "hl_tostring_string(" + arg + ")";
+    if (argType == ValueType::STRING) {
+      return (scratch ? "hl_scratch_tostring_string(" : "hl_tostring_string(") +
+             arg + ")";
     } else if (argType == ValueType::BOOL) {
-      return "hl_tostring_bool(" + arg + ")";
+      return (scratch ? "hl_scratch_tostring_bool(" : "hl_tostring_bool(") +
+             arg + ")";
+    }
+
+    // strings and bools above come back without allocating
+    std::string prefix = scratch ? "hl_scratch_tostring_" : "hl_tostring_";
+    if (scratch) {
+      statementScratch = functionScratch = true;
+    }
+    if (argType == ValueType::INT) {
+      return prefix + "int(" + arg + ")";
     } else {
-      return "hl_tostring_number(" + arg + ")";
+      return prefix + "number(" + arg + ")";
     }
   }
 
@@ -29,6 +44,7 @@ std::string Compiler::compileFunctionCall(const FunctionCall *call) {
       return "";
     }
 
+    StringLifetime lifetime(*this, true);
     std::string arg = compileExpr(call->arguments[0].get());
     ValueType argType = inferExprType(call->arguments[0].get());
 
@@ -58,6 +74,8 @@ std::string Compiler::compileFunctionCall(const FunctionCall *call) {
     switch (argType) {
     case ValueType::NUMBER:
       return "\"number\"";
+    case ValueType::INT:
+      return "\"int\"";
     case ValueType::STRING:
       return "\"string\"";
     case ValueType::BOOL:
@@ -127,6 +145,8 @@ std::string Compiler::compileFunctionCall(const FunctionCall *call) {
     return "";
   }
 
+  // arguments are borrowed, the callee copies what it keeps
+  StringLifetime lifetime(*this, true);
   std::string result = call->name + "(";
 
   if (isNestedFunction) {
@@ -148,7 +168,7 @@ std::string Compiler::compileFunctionCall(const FunctionCall *call) {
       ValueType paramType = funcInfo.parameters[paramIdx].second;
       
       // check if this is an explicit nil for an optional parameter
-      bool isNilArg = dynamic_cast<const NilExpr *>(call->arguments[i].get()) != nullptr;
+      bool isNilArg = nodeCast<NilExpr>(call->arguments[i].get()) != nullptr;
       
       if (isNilArg && paramIdx < funcInfo.parameterOptionals.size() && 
           funcInfo.parameterOptionals[paramIdx]) {
@@ -203,22 +223,30 @@ std::string Compiler::compileFunctionCall(const FunctionCall *call) {
   return result;
 }
 
-void Compiler::compileFunctionDecl(const FunctionDecl *func) {
-  std::string savedFunction = currentFunction;
-  currentFunction = func->name;
-
-  auto savedFunctionParams = currentFunctionParams;
-  currentFunctionParams = func->parameters;
-
-  auto savedSymbolTable = symbolTable;
-
-  std::vector<std::pair<std::string, ValueType>> parentParams;
-  if (!func->isGlobal) {
-    // nested function
+void Compiler::defineFunction(const FunctionInfo &info) {
+  auto it = functionTable.find(info.name);
+  if (it != functionTable.end()) {
+    functionUndo.emplace_back(info.name, it->second);
+    it->second = info;
   } else {
-    parentParams = func->parameters;
+    functionUndo.emplace_back(info.name, std::nullopt);
+    functionTable.emplace(info.name, info);
+  }
+}
+
+void Compiler::rollbackFunctions(size_t mark) {
+  while (functionUndo.size() > mark) {
+    auto &undo = functionUndo.back();
+    if (undo.second) {
+      functionTable[undo.first] = std::move(*undo.second);
+    } else {
+      functionTable.erase(undo.first);
+    }
+    functionUndo.pop_back();
   }
+}
 
+void Compiler::bindFunctionParameters(const FunctionDecl *func) {
   for (size_t i = 0; i < func->parameters.size(); i++) {
     const auto &param = func->parameters[i];
     ValueType paramType = param.second;
@@ -228,55 +256,47 @@ void Compiler::compileFunctionDecl(const FunctionDecl *func) {
 
     bool isOptional = (i < func->parameterOptionals.size()) ? func->parameterOptionals[i] : false;
 
-    symbolTable[param.first] = {paramType, false, true, isOptional, false, false, ""};
+    symbolTable[param.first] = {paramType, false, true, isOptional, false, false, TypeName()};
   }
+}
 
-  for (const auto &stmt : func->body) {
-    if (auto *nestedFunc = dynamic_cast<const FunctionDecl *>(stmt.get())) {
-      FunctionInfo nestedInfo;
-      nestedInfo.name = nestedFunc->name;
-
-      std::vector<std::pair<std::string, ValueType>> allParams =
-          func->parameters;
-      allParams.insert(allParams.end(), nestedFunc->parameters.begin(),
-                       nestedFunc->parameters.end());
-
-      nestedInfo.parameters = allParams;
-      nestedInfo.parameterOptionals = nestedFunc->parameterOptionals;
-      nestedInfo.returnType = nestedFunc->returnType;
-      nestedInfo.isGlobal = false;
-      nestedInfo.nestedFunctions = {};
-      functionTable[nestedFunc->name] = nestedInfo;
-
-      symbolTable[nestedFunc->name] = {ValueType::INFERRED, false, true, false,
-                                       false};
+void Compiler::registerNestedFunction(const FunctionDecl *func,
+                                      const FunctionDecl *nestedFunc) {
+  FunctionInfo nestedInfo;
+  nestedInfo.name = nestedFunc->name;
 
-      std::string savedOutput = output;
-      output = "";
+  std::vector<std::pair<std::string, ValueType>> allParams = func->parameters;
+  allParams.insert(allParams.end(), nestedFunc->parameters.begin(),
+                   nestedFunc->parameters.end());
 
-      compileNestedFunction(nestedFunc, func->parameters);
+  nestedInfo.parameters = allParams;
+  nestedInfo.parameterOptionals = nestedFunc->parameterOptionals;
+  nestedInfo.returnType = nestedFunc->returnType;
+  nestedInfo.isGlobal = false;
+  nestedInfo.nestedFunctions = {};
+  defineFunction(nestedInfo);
 
-      nestedFunctionDecls += output + "\n";
-      output = savedOutput;
-    }
-  }
+  symbolTable[nestedFunc->name] = {ValueType::INFERRED, false, true, false,
+                                   false};
+}
 
+ValueType Compiler::inferFunctionReturnType(const FunctionDecl *func) {
   ValueType actualReturnType = func->returnType;
 
   if (actualReturnType == ValueType::INFERRED) {
     for (const auto &stmt : func->body) {
-      if (auto *ret = dynamic_cast<const ReturnStmt *>(stmt.get())) {
+      if (auto *ret = nodeCast<ReturnStmt>(stmt.get())) {
         if (ret->value) {
           actualReturnType = inferExprType(ret->value.get());
 
           if (actualReturnType == ValueType::INFERRED) {
             if (auto *call =
-                    dynamic_cast<const FunctionCall *>(ret->value.get())) {
+                    nodeCast<FunctionCall>(ret->value.get())) {
               if (call->name == "tostring") {
                 actualReturnType = ValueType::STRING;
               }
             } else if (auto *bin =
-                           dynamic_cast<const BinaryExpr *>(ret->value.get())) {
+                           nodeCast<BinaryExpr>(ret->value.get())) {
               if (bin->op == BinaryOp::CONCAT) {
                 actualReturnType = ValueType::STRING;
               }
@@ -289,7 +309,7 @@ void Compiler::compileFunctionDecl(const FunctionDecl *func) {
 
     if (actualReturnType == ValueType::INFERRED) {
       for (const auto &stmt : func->body) {
-        if (auto *ret = dynamic_cast<const ReturnStmt *>(stmt.get())) {
+        if (auto *ret = nodeCast<ReturnStmt>(stmt.get())) {
           if (ret->value) {
             if (isStringExpr(ret->value.get())) {
               actualReturnType = ValueType::STRING;
@@ -305,9 +325,77 @@ void Compiler::compileFunctionDecl(const FunctionDecl *func) {
     }
   }
 
+  return actualReturnType;
+}
+
+// resolves the signature of a top-level function before any body is
+// compiled, so every codegen unit starts from the same function table
+void Compiler::declareFunction(const FunctionDecl *func) {
+  std::string savedFunction = currentFunction;
+  currentFunction = func->name;
+
+  auto savedFunctionParams = currentFunctionParams;
+  currentFunctionParams = func->parameters;
+
+  symbolTable.enterScope();
+  size_t functionMark = functionUndo.size();
+
+  bindFunctionParameters(func);
+  for (const auto &stmt : func->body) {
+    if (auto *nestedFunc = nodeCast<FunctionDecl>(stmt.get())) {
+      registerNestedFunction(func, nestedFunc);
+    }
+  }
+
+  ValueType actualReturnType = inferFunctionReturnType(func);
+
+  // nested functions stay visible only inside their parent
+  rollbackFunctions(functionMark);
+  symbolTable.exitScope();
+
   if (func->isGlobal) {
     functionTable[func->name].returnType = actualReturnType;
   }
+  declaredReturnTypes[func] = actualReturnType;
+
+  currentFunction = savedFunction;
+  currentFunctionParams = savedFunctionParams;
+}
+
+void Compiler::compileFunctionDecl(const FunctionDecl *func) {
+  std::string savedFunction = currentFunction;
+  currentFunction = func->name;
+
+  auto savedFunctionParams = currentFunctionParams;
+  currentFunctionParams = func->parameters;
+
+  symbolTable.enterScope();
+
+  bindFunctionParameters(func);
+
+  for (const auto &stmt : func->body) {
+    if (auto *nestedFunc = nodeCast<FunctionDecl>(stmt.get())) {
+      registerNestedFunction(func, nestedFunc);
+
+      output.openSection();
+
+      compileNestedFunction(nestedFunc, func->parameters);
+
+      nestedFunctionDecls += output.takeSection();
+      nestedFunctionDecls += "\n";
+    }
+  }
+
+  ValueType actualReturnType;
+  auto declared = declaredReturnTypes.find(func);
+  if (declared != declaredReturnTypes.end()) {
+    actualReturnType = declared->second;
+  } else {
+    actualReturnType = inferFunctionReturnType(func);
+    if (func->isGlobal) {
+      functionTable[func->name].returnType = actualReturnType;
+    }
+  }
 
   std::string returnType = getCType(actualReturnType);
 
@@ -336,22 +424,23 @@ void Compiler::compileFunctionDecl(const FunctionDecl *func) {
   int savedIndent = indentLevel;
   indentLevel = 1;
 
+  ScratchState enclosingScratch = beginFunctionBody();
+  ownAssignedParameters(func->body, func->parameters);
   for (const auto &stmt : func->body) {
-    if (dynamic_cast<const FunctionDecl *>(stmt.get())) {
+    if (nodeCast<FunctionDecl>(stmt.get())) {
       continue;
     }
 
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileStatement(stmt.get());
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
   }
+  endFunctionBody(enclosingScratch);
 
   bool hasReturnAtEnd = false;
   if (!func->body.empty()) {
     hasReturnAtEnd =
-        dynamic_cast<const ReturnStmt *>(func->body.back().get()) != nullptr;
+        nodeCast<ReturnStmt>(func->body.back().get()) != nullptr;
   }
 
   if (!hasReturnAtEnd) {
@@ -360,7 +449,7 @@ void Compiler::compileFunctionDecl(const FunctionDecl *func) {
     } else if (actualReturnType == ValueType::NUMBER) {
       output += indent() + "return 0.0;\n";
     } else if (actualReturnType == ValueType::STRING) {
-      output += indent() + "return \"\";\n";
+      output += indent() + "return hl_string_copy(\"\");\n";
     } else if (actualReturnType == ValueType::BOOL) {
       output += indent() + "return 0;\n";
     } else {
@@ -371,7 +460,7 @@ void Compiler::compileFunctionDecl(const FunctionDecl *func) {
   indentLevel = savedIndent;
   output += "}\n";
 
-  symbolTable = savedSymbolTable;
+  symbolTable.exitScope();
   currentFunction = savedFunction;
   currentFunctionParams = savedFunctionParams;
 }
@@ -384,7 +473,7 @@ void Compiler::compileNestedFunction(
 
   std::string savedFunction = currentFunction;
   currentFunction = func->name;
-  auto savedSymbolTable = symbolTable;
+  symbolTable.enterScope();
 
   for (const auto &param : parentParams) {
     ValueType paramType = param.second;
@@ -403,7 +492,7 @@ void Compiler::compileNestedFunction(
     
     bool isOptional = (i < func->parameterOptionals.size()) ? func->parameterOptionals[i] : false;
     
-    symbolTable[param.first] = {paramType, false, true, isOptional, false, false, ""};
+    symbolTable[param.first] = {paramType, false, true, isOptional, false, false, TypeName()};
   }
 
   ValueType actualReturnType = func->returnType;
@@ -451,25 +540,27 @@ void Compiler::compileNestedFunction(
   int savedIndent = indentLevel;
   indentLevel = 1;
 
+  ScratchState enclosingScratch = beginFunctionBody();
+  ownAssignedParameters(func->body, parentParams);
+  ownAssignedParameters(func->body, func->parameters);
   for (const auto &stmt : func->body) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileStatement(stmt.get());
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
   }
+  endFunctionBody(enclosingScratch);
 
   bool hasReturnAtEnd = false;
   if (!func->body.empty()) {
     hasReturnAtEnd =
-        dynamic_cast<const ReturnStmt *>(func->body.back().get()) != nullptr;
+        nodeCast<ReturnStmt>(func->body.back().get()) != nullptr;
   }
 
   if (!hasReturnAtEnd) {
     if (actualReturnType == ValueType::NUMBER) {
       output += indent() + "return 0.0;\n";
     } else if (actualReturnType == ValueType::STRING) {
-      output += indent() + "return \"\";\n";
+      output += indent() + "return hl_string_copy(\"\");\n";
     } else if (actualReturnType == ValueType::BOOL) {
       output += indent() + "return 0;\n";
     } else {
@@ -480,7 +571,7 @@ void Compiler::compileNestedFunction(
   indentLevel = savedIndent;
   output += "}\n";
 
-  symbolTable = savedSymbolTable;
+  symbolTable.exitScope();
   currentFunction = savedFunction;
 }
 
@@ -495,7 +586,7 @@ void Compiler::compileLambdaExpr(const LambdaExpr *lambda,
 
   auto savedFunctionParams = currentFunctionParams;
   currentFunctionParams = lambda->parameters;
-  auto savedSymbolTable = symbolTable;
+  symbolTable.enterScope();
 
   for (size_t i = 0; i < lambda->parameters.size(); i++) {
     const auto &param = lambda->parameters[i];
@@ -506,14 +597,14 @@ void Compiler::compileLambdaExpr(const LambdaExpr *lambda,
 
     bool isOptional = (i < lambda->parameterOptionals.size()) ? lambda->parameterOptionals[i] : false;
 
-    symbolTable[param.first] = {paramType, false, true, isOptional, false, false, ""};
+    symbolTable[param.first] = {paramType, false, true, isOptional, false, false, TypeName()};
   }
 
   ValueType actualReturnType = lambda->returnType;
 
   if (actualReturnType == ValueType::INFERRED) {
     for (const auto &stmt : lambda->body) {
-      if (auto *ret = dynamic_cast<const ReturnStmt *>(stmt.get())) {
+      if (auto *ret = nodeCast<ReturnStmt>(stmt.get())) {
         if (ret->value) {
           actualReturnType = inferExprType(ret->value.get());
           break;
@@ -549,25 +640,26 @@ void Compiler::compileLambdaExpr(const LambdaExpr *lambda,
   int savedIndent = indentLevel;
   indentLevel = 1;
 
+  ScratchState enclosingScratch = beginFunctionBody();
+  ownAssignedParameters(lambda->body, lambda->parameters);
   for (const auto &stmt : lambda->body) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileStatement(stmt.get());
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
   }
+  endFunctionBody(enclosingScratch);
 
   bool hasReturnAtEnd = false;
   if (!lambda->body.empty()) {
     hasReturnAtEnd =
-        dynamic_cast<const ReturnStmt *>(lambda->body.back().get()) != nullptr;
+        nodeCast<ReturnStmt>(lambda->body.back().get()) != nullptr;
   }
 
   if (!hasReturnAtEnd) {
     if (actualReturnType == ValueType::NUMBER) {
       output += indent() + "return 0.0;\n";
     } else if (actualReturnType == ValueType::STRING) {
-      output += indent() + "return \"\";\n";
+      output += indent() + "return hl_string_copy(\"\");\n";
     } else if (actualReturnType == ValueType::BOOL) {
       output += indent() + "return 0;\n";
     } else {
@@ -585,9 +677,9 @@ void Compiler::compileLambdaExpr(const LambdaExpr *lambda,
   funcInfo.returnType = actualReturnType;
   funcInfo.isGlobal = false;
   funcInfo.nestedFunctions = {};
-  functionTable[funcName] = funcInfo;
+  defineFunction(funcInfo);
 
-  symbolTable = savedSymbolTable;
+  symbolTable.exitScope();
   currentFunction = savedFunction;
   currentFunctionParams = savedFunctionParams;
 }
@@ -6,10 +6,7 @@ void Compiler::compileStructDecl(const StructDecl *decl) {
   StructInfo info;
   info.name = decl->name;
   info.fields = decl->fields;
-
-  for (const auto &field : decl->fields) {
-    info.fieldTypes[field.name] = {field.type, field.isOptional};
-  }
+  info.indexMembers(*decl);
 
   structTable[decl->name] = info;
 
@@ -37,11 +34,13 @@ void Compiler::compileStructDecl(const StructDecl *decl) {
     structDef += "    " + fieldType + " " + field.name + ";\n";
   }
   structDef += "} " + decl->name + ";\n\n";
+  structDef += ownershipHelpers(decl->name);
   
   structDefs.push_back({decl->name, structDef});
 }
 
 std::string Compiler::compileStructConstructor(const StructConstructor *expr) {
+  // fields own what they are initialized with
   if (structTable.find(expr->structName) == structTable.end()) {
     error("Struct '" + expr->structName + "' not defined", expr->line);
     return "";
@@ -61,11 +60,11 @@ std::string Compiler::compileStructConstructor(const StructConstructor *expr) {
             [&](auto &&arg) {
               using T = std::decay_t<decltype(arg)>;
               if constexpr (std::is_same_v<T, int64_t>) {
-                result += std::to_string(arg) + ".0";
+                result += std::to_string(arg) + (field.type == ValueType::INT ? "" : ".0");
               } else if constexpr (std::is_same_v<T, double>) {
                 result += doubleToString(arg);
               } else if constexpr (std::is_same_v<T, std::string>) {
-                result += "\"" + arg + "\"";
+                result += "hl_string_copy(\"" + arg + "\")";
               } else if constexpr (std::is_same_v<T, bool>) {
                 result += arg ? "1" : "0";
               } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
@@ -102,7 +101,7 @@ std::string Compiler::compileStructConstructor(const StructConstructor *expr) {
         } else if (field.type == ValueType::NUMBER) {
           result += "0.0";
         } else if (field.type == ValueType::STRING) {
-          result += "\"\"";
+          result += "hl_string_copy(\"\")";
         } else if (field.type == ValueType::BOOL) {
           result += "0";
         } else {
@@ -123,7 +122,8 @@ std::string Compiler::compileStructConstructor(const StructConstructor *expr) {
 
       if (i < expr->positionalArgs.size()) {
         const auto &field = structInfo.fields[i];
-        result += compileExpr(expr->positionalArgs[i].get(), field.type);
+        result += compileOwned(expr->positionalArgs[i].get(), field.type,
+                               field.structTypeName);
       } else {
         const auto &field = structInfo.fields[i];
         // handle default values for missing positional args
@@ -132,11 +132,11 @@ std::string Compiler::compileStructConstructor(const StructConstructor *expr) {
               [&](auto &&arg) {
                 using T = std::decay_t<decltype(arg)>;
                 if constexpr (std::is_same_v<T, int64_t>) {
-                  result += std::to_string(arg) + ".0";
+                  result += std::to_string(arg) + (field.type == ValueType::INT ? "" : ".0");
                 } else if constexpr (std::is_same_v<T, double>) {
                   result += std::to_string(arg);
                 } else if constexpr (std::is_same_v<T, std::string>) {
-                  result += "\"" + arg + "\"";
+                  result += "hl_string_copy(\"" + arg + "\")";
                 } else if constexpr (std::is_same_v<T, bool>) {
                   result += arg ? "1" : "0";
                 } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
@@ -172,7 +172,7 @@ std::string Compiler::compileStructConstructor(const StructConstructor *expr) {
           } else if (field.type == ValueType::NUMBER) {
             result += "0.0";
           } else if (field.type == ValueType::STRING) {
-            result += "\"\"";
+            result += "hl_string_copy(\"\")";
           } else if (field.type == ValueType::BOOL) {
             result += "0";
           } else {
@@ -196,7 +196,8 @@ std::string Compiler::compileStructConstructor(const StructConstructor *expr) {
       if (argProvided[field.name]) {
         for (const auto &namedArg : expr->namedArgs) {
           if (namedArg.first == field.name) {
-            result += compileExpr(namedArg.second.get(), field.type);
+            result += compileOwned(namedArg.second.get(), field.type,
+                                   field.structTypeName);
             break;
           }
         }
@@ -205,11 +206,11 @@ std::string Compiler::compileStructConstructor(const StructConstructor *expr) {
             [&](auto &&arg) {
               using T = std::decay_t<decltype(arg)>;
               if constexpr (std::is_same_v<T, int64_t>) {
-                result += std::to_string(arg) + ".0";
+                result += std::to_string(arg) + (field.type == ValueType::INT ? "" : ".0");
               } else if constexpr (std::is_same_v<T, double>) {
                 result += std::to_string(arg);
               } else if constexpr (std::is_same_v<T, std::string>) {
-                result += "\"" + arg + "\"";
+                result += "hl_string_copy(\"" + arg + "\")";
               } else if constexpr (std::is_same_v<T, bool>) {
                 result += arg ? "1" : "0";
               } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
@@ -245,7 +246,7 @@ std::string Compiler::compileStructConstructor(const StructConstructor *expr) {
         } else if (field.type == ValueType::NUMBER) {
           result += "0.0";
         } else if (field.type == ValueType::STRING) {
-          result += "\"\"";
+          result += "hl_string_copy(\"\")";
         } else if (field.type == ValueType::BOOL) {
           result += "0";
         } else {
@@ -281,7 +282,7 @@ std::string Compiler::compileStructInitializer(const StructConstructor *expr) {
             [&](auto &&arg) {
               using T = std::decay_t<decltype(arg)>;
               if constexpr (std::is_same_v<T, int64_t>) {
-                result += std::to_string(arg) + ".0";
+                result += std::to_string(arg) + (field.type == ValueType::INT ? "" : ".0");
               } else if constexpr (std::is_same_v<T, double>) {
                 result += doubleToString(arg);
               } else if constexpr (std::is_same_v<T, std::string>) {
@@ -334,7 +335,7 @@ std::string Compiler::compileStructInitializer(const StructConstructor *expr) {
             compileExpr(expr->positionalArgs[i].get(), field.type, true);
 
         if (auto *varExpr =
-                dynamic_cast<const VarExpr *>(expr->positionalArgs[i].get())) {
+                nodeCast<VarExpr>(expr->positionalArgs[i].get())) {
           result += varExpr->name;
         } else {
           result += argValue;
@@ -346,7 +347,7 @@ std::string Compiler::compileStructInitializer(const StructConstructor *expr) {
               [&](auto &&arg) {
                 using T = std::decay_t<decltype(arg)>;
                 if constexpr (std::is_same_v<T, int64_t>) {
-                  result += std::to_string(arg) + ".0";
+                  result += std::to_string(arg) + (field.type == ValueType::INT ? "" : ".0");
                 } else if constexpr (std::is_same_v<T, double>) {
                   result += std::to_string(arg);
                 } else if constexpr (std::is_same_v<T, std::string>) {
@@ -396,11 +397,8 @@ std::string Compiler::compileStructInitializer(const StructConstructor *expr) {
       const auto &argExpr = namedArg.second;
 
       ValueType fieldType = ValueType::INFERRED;
-      for (const auto &field : structInfo.fields) {
-        if (field.name == fieldName) {
-          fieldType = field.type;
-          break;
-        }
+      if (const MemberInfo *field = structInfo.findField(fieldName)) {
+        fieldType = field->type;
       }
 
       namedArgValues[fieldName] = compileExpr(argExpr.get(), fieldType, true);
@@ -422,7 +420,7 @@ std::string Compiler::compileStructInitializer(const StructConstructor *expr) {
         }
 
         if (argExpr) {
-          if (auto *varExpr = dynamic_cast<const VarExpr *>(argExpr)) {
+          if (auto *varExpr = nodeCast<VarExpr>(argExpr)) {
             result += varExpr->name;
           } else {
             result += namedArgValues[field.name];
@@ -435,7 +433,7 @@ std::string Compiler::compileStructInitializer(const StructConstructor *expr) {
             [&](auto &&arg) {
               using T = std::decay_t<decltype(arg)>;
               if constexpr (std::is_same_v<T, int64_t>) {
-                result += std::to_string(arg) + ".0";
+                result += std::to_string(arg) + (field.type == ValueType::INT ? "" : ".0");
               } else if constexpr (std::is_same_v<T, double>) {
                 result += std::to_string(arg);
               } else if constexpr (std::is_same_v<T, std::string>) {
@@ -10,13 +10,13 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
   std::string structTypeName = decl->typeName;
 
   if (actualType == ValueType::STRUCT && structTypeName == "struct" && decl->hasValue) {
-    if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
+    if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
       structTypeName = classInst->className;
-    } else if (auto *structCons = dynamic_cast<const StructConstructor *>(decl->value.get())) {
+    } else if (auto *structCons = nodeCast<StructConstructor>(decl->value.get())) {
       structTypeName = structCons->structName;
-    } else if (auto *methodCall = dynamic_cast<const MethodCall *>(decl->value.get())) {
+    } else if (auto *methodCall = nodeCast<MethodCall>(decl->value.get())) {
       std::string className = "";
-      if (auto *varExpr = dynamic_cast<const VarExpr *>(methodCall->object.get())) {
+      if (auto *varExpr = nodeCast<VarExpr>(methodCall->object.get())) {
         if (classTable.count(varExpr->name)) {
           className = varExpr->name;
         }
@@ -29,12 +29,12 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
   }
   
   if (actualType == ValueType::INFERRED && decl->hasValue) {
-    actualType = inferExprType(decl->value.get());
+    actualType = inferVarType(decl->value.get());
     
     if (actualType == ValueType::STRUCT && decl->value) {
-      if (auto *methodCall = dynamic_cast<const MethodCall *>(decl->value.get())) {
+      if (auto *methodCall = nodeCast<MethodCall>(decl->value.get())) {
         std::string className = "";
-        if (auto *varExpr = dynamic_cast<const VarExpr *>(methodCall->object.get())) {
+        if (auto *varExpr = nodeCast<VarExpr>(methodCall->object.get())) {
           if (classTable.count(varExpr->name)) {
             className = varExpr->name;
           }
@@ -43,7 +43,7 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
         if (!className.empty()) {
           structTypeName = className;
         }
-      } else if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
+      } else if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
         structTypeName = classInst->className;
       }
     }
@@ -51,15 +51,13 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
 
   // handle lambda expressions
   if (decl->hasValue) {
-    if (auto *lambda = dynamic_cast<const LambdaExpr *>(decl->value.get())) {
+    if (auto *lambda = nodeCast<LambdaExpr>(decl->value.get())) {
       std::string funcName = decl->name;
-      std::string savedOutput = output;
-      output = "";
+      output.openSection();
 
       compileLambdaExpr(lambda, funcName);
 
-      nestedFunctionDecls += output;
-      output = savedOutput;
+      nestedFunctionDecls += output.takeSection();
 
       Variable var;
       var.type = actualType;
@@ -68,19 +66,22 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
       var.isOptional = decl->isOptional;
       var.isFunction = true;
       var.isStruct = false;
-      var.structTypeName = "";
+      var.structTypeName = TypeName();
       symbolTable[decl->name] = var;
       return;
     }
     // handle class instantiation
-    else if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
+    else if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
       std::string className = classInst->className;
 
       output += indent();
       if (decl->isConst)
         output += "const ";
       output += className + " " + decl->name;
-      output += " = " + compileExpr(decl->value.get(), ValueType::STRUCT, false) + ";\n";
+      output += " = " + compileOwned(decl->value.get(), ValueType::STRUCT) + ";\n";
+      if (ownsStrings(className)) {
+        ownLocal(decl->name, className);
+      }
 
       Variable var;
       var.type = ValueType::STRUCT;
@@ -89,19 +90,22 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
       var.isOptional = decl->isOptional;
       var.isFunction = false;
       var.isStruct = true;
-      var.structTypeName = className;
+      var.structTypeName = TypeName::find(className);
       symbolTable[decl->name] = var;
       return;
     }
     // handle struct constructor
-    else if (auto *structCons = dynamic_cast<const StructConstructor *>(decl->value.get())) {
+    else if (auto *structCons = nodeCast<StructConstructor>(decl->value.get())) {
       std::string structName = structCons->structName;
 
       output += indent();
       if (decl->isConst)
         output += "const ";
       output += structName + " " + decl->name;
-      output += " = " + compileExpr(decl->value.get(), ValueType::STRUCT, false) + ";\n";
+      output += " = " + compileOwned(decl->value.get(), ValueType::STRUCT) + ";\n";
+      if (ownsStrings(structName)) {
+        ownLocal(decl->name, structName);
+      }
 
       Variable var;
       var.type = ValueType::STRUCT;
@@ -110,12 +114,12 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
       var.isOptional = decl->isOptional;
       var.isFunction = false;
       var.isStruct = true;
-      var.structTypeName = structName;
+      var.structTypeName = TypeName::find(structName);
       symbolTable[decl->name] = var;
       return;
     }
     // handle enum access expressions, infer the enum type name
-    else if (auto *enumAccess = dynamic_cast<const EnumAccessExpr *>(decl->value.get())) {
+    else if (auto *enumAccess = nodeCast<EnumAccessExpr>(decl->value.get())) {
       structTypeName = enumAccess->enumName;
     }
   }
@@ -140,14 +144,34 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
     ctype = getCType(actualType);
   }
 
+  if (decl->hasValue &&
+      !checkIntValue(actualType, inferExprType(decl->value.get()),
+                     decl->value.get(), "variable '" + decl->name + "'",
+                     decl->line)) {
+    output = "";
+    return;
+  }
+
   // generate declaration
   output += indent();
   if (decl->isConst)
     output += "const ";
   output += ctype + " " + decl->name;
 
-  if (decl->hasValue) {
+  // a const string bound to a literal is never freed, so it needs no copy
+  std::string ownedType =
+      actualType == ValueType::STRUCT ? structTypeName : std::string();
+  bool owned = actualType == ValueType::STRING || ownsStrings(ownedType);
+  if (owned && decl->isConst && nodeCast<LiteralExpr>(decl->value.get())) {
+    owned = false;
+  }
+
+  if (decl->hasValue && owned) {
+    output += " = " + compileOwned(decl->value.get(), actualType, ownedType);
+  } else if (decl->hasValue) {
     output += " = " + compileExpr(decl->value.get(), actualType, false);
+  } else if (owned) {
+    output += actualType == ValueType::STRING ? " = NULL" : " = {0}";
   } else if (decl->isOptional) {
     // initialize optional variables to nil
     if (actualType == ValueType::ENUM) {
@@ -162,6 +186,9 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
   }
 
   output += ";\n";
+  if (owned) {
+    ownLocal(decl->name, ownedType);
+  }
 
   // register in symbol table
   Variable var;
@@ -171,7 +198,7 @@ void Compiler::compileVarDecl(const VarDecl *decl) {
   var.isOptional = decl->isOptional;
   var.isFunction = false;
   var.isStruct = (actualType == ValueType::STRUCT);
-  var.structTypeName = structTypeName;
+  var.structTypeName = TypeName::find(structTypeName);
   symbolTable[decl->name] = var;
 }
 
@@ -181,11 +208,11 @@ void Compiler::compileGlobalVarDecl(const VarDecl *decl, std::string &globalDecl
   std::string structTypeName = decl->typeName;
 
   if (actualType == ValueType::INFERRED && decl->hasValue) {
-    actualType = inferExprType(decl->value.get());
+    actualType = inferVarType(decl->value.get());
     
     // infer enum type name from enum access
     if (actualType == ValueType::ENUM && decl->hasValue) {
-      if (auto *enumAccess = dynamic_cast<const EnumAccessExpr *>(decl->value.get())) {
+      if (auto *enumAccess = nodeCast<EnumAccessExpr>(decl->value.get())) {
         structTypeName = enumAccess->enumName;
       }
     }
@@ -193,14 +220,12 @@ void Compiler::compileGlobalVarDecl(const VarDecl *decl, std::string &globalDecl
 
   // handle lambda expressions
   if (decl->hasValue) {
-    if (auto *lambda = dynamic_cast<const LambdaExpr *>(decl->value.get())) {
+    if (auto *lambda = nodeCast<LambdaExpr>(decl->value.get())) {
       std::string funcName = decl->name;
-      std::string savedOutput = output;
-      output = "";
+      output.openSection();
 
       compileLambdaExpr(lambda, funcName);
-      nestedFunctionDecls += output;
-      output = savedOutput;
+      nestedFunctionDecls += output.takeSection();
 
       Variable var;
       var.type = actualType;
@@ -209,7 +234,7 @@ void Compiler::compileGlobalVarDecl(const VarDecl *decl, std::string &globalDecl
       var.isOptional = decl->isOptional;
       var.isFunction = true;
       var.isStruct = false;
-      var.structTypeName = "";
+      var.structTypeName = TypeName();
       symbolTable[decl->name] = var;
       return;
     }
@@ -218,12 +243,12 @@ void Compiler::compileGlobalVarDecl(const VarDecl *decl, std::string &globalDecl
   std::string ctype = getCType(actualType);
 
   if (actualType == ValueType::STRUCT && decl->hasValue) {
-    if (auto *structCons = dynamic_cast<const StructConstructor *>(decl->value.get())) {
+    if (auto *structCons = nodeCast<StructConstructor>(decl->value.get())) {
       ctype = structCons->structName;
       if (structTypeName.empty()) {
         structTypeName = structCons->structName;
       }
-    } else if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
+    } else if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
       ctype = classInst->className;
       if (structTypeName.empty()) {
         structTypeName = classInst->className;
@@ -251,15 +276,15 @@ void Compiler::compileGlobalVarDecl(const VarDecl *decl, std::string &globalDecl
   
   if (decl->hasValue) {
     if (actualType == ValueType::STRUCT) {
-      if (auto *structCons = dynamic_cast<const StructConstructor *>(decl->value.get())) {
+      if (auto *structCons = nodeCast<StructConstructor>(decl->value.get())) {
         for (const auto &arg : structCons->positionalArgs) {
-          if (dynamic_cast<const VarExpr *>(arg.get())) {
+          if (nodeCast<VarExpr>(arg.get())) {
             canBeGlobalInitializer = false;
             break;
           }
         }
         for (const auto &namedArg : structCons->namedArgs) {
-          if (dynamic_cast<const VarExpr *>(namedArg.second.get())) {
+          if (nodeCast<VarExpr>(namedArg.second.get())) {
             canBeGlobalInitializer = false;
             break;
           }
@@ -268,7 +293,7 @@ void Compiler::compileGlobalVarDecl(const VarDecl *decl, std::string &globalDecl
         if (canBeGlobalInitializer) {
           initExpr = compileExpr(decl->value.get(), actualType, true);
         }
-      } else if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
+      } else if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
         canBeGlobalInitializer = false;
       }
     } else if (actualType == ValueType::ENUM) {
@@ -314,9 +339,9 @@ void Compiler::compileGlobalVarDecl(const VarDecl *decl, std::string &globalDecl
     if (decl->hasValue) {
       std::string initCode;
       if (actualType == ValueType::STRUCT) {
-        if (auto *structCons = dynamic_cast<const StructConstructor *>(decl->value.get())) {
+        if (auto *structCons = nodeCast<StructConstructor>(decl->value.get())) {
           initCode = decl->name + " = " + compileStructConstructor(structCons) + ";";
-        } else if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
+        } else if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
           initCode = decl->name + " = " + compileClassInstantiation(classInst) + ";";
         } else {
           initCode = decl->name + " = " + compileExpr(decl->value.get(), actualType, false) + ";";
@@ -336,7 +361,7 @@ void Compiler::compileGlobalVarDecl(const VarDecl *decl, std::string &globalDecl
   var.isOptional = decl->isOptional;
   var.isFunction = false;
   var.isStruct = (actualType == ValueType::STRUCT);
-  var.structTypeName = structTypeName;
+  var.structTypeName = TypeName::find(structTypeName);
   symbolTable[decl->name] = var;
 }
 
@@ -357,6 +382,17 @@ void Compiler::compileAssignment(const Assignment *assign) {
     return;
   }
 
+  // strings and structs holding strings replace what the variable owned
+  ValueType varType = var.type;
+  std::string ownedType =
+      varType == ValueType::STRUCT ? std::string(var.structTypeName) : "";
+  if (!assign->isCompound &&
+      (varType == ValueType::STRING || ownsStrings(ownedType))) {
+    std::string value = compileOwned(assign->value.get(), varType, ownedType);
+    output += indent() + storeOwned(assign->name, value, varType, ownedType);
+    return;
+  }
+
   output += indent() + assign->name;
 
   if (assign->isCompound) {
@@ -375,23 +411,37 @@ void Compiler::compileAssignment(const Assignment *assign) {
       op = " / ";
       break;
     case BinaryOp::MODULO:
-      op = " % ";
-      break;
     case BinaryOp::POWER:
-      output = indent() + assign->name + " = pow(" + assign->name + ", " +
-               compileExpr(assign->value.get(), var.type) + ");\n";
-      return;
     case BinaryOp::FLOOR_DIVIDE:
-      output = indent() + assign->name + " = (double)floor(" + assign->name +
-               " / " + compileExpr(assign->value.get(), var.type) + ");\n";
-      return;
+      break;
     default:
       op = " + ";
       break;
     }
-    output +=
-        " = " + assign->name + op + compileExpr(assign->value.get(), var.type);
+
+    ValueType resultType =
+        arithmeticResultType(assign->compoundOp, nullptr, var.type,
+                             assign->value.get(), inferExprType(assign->value.get()));
+    if (!checkIntValue(var.type, resultType, nullptr,
+                       "variable '" + assign->name + "'", assign->line)) {
+      output = "";
+      return;
+    }
+
+    std::string value = compileExpr(assign->value.get(), var.type);
+    if (op.empty() || resultType == ValueType::INT) {
+      output += " = " + compileArithmetic(assign->compoundOp, assign->name,
+                                          value, resultType);
+    } else {
+      output += " = " + assign->name + op + value;
+    }
   } else {
+    if (!checkIntValue(var.type, inferExprType(assign->value.get()),
+                       assign->value.get(), "variable '" + assign->name + "'",
+                       assign->line)) {
+      output = "";
+      return;
+    }
     output += " = " + compileExpr(assign->value.get(), var.type);
   }
 
@@ -405,18 +455,58 @@ void Compiler::compileReturnStmt(const ReturnStmt *ret) {
     return;
   }
 
-  output += indent() + "return";
-
-  if (ret->value) {
-    ValueType returnType = ValueType::INFERRED;
-    if (functionTable.count(currentFunction)) {
-      returnType = functionTable[currentFunction].returnType;
+  // temporaries of the enclosing conditions are still in the region, the
+  // statements after the return that would release them never run. the
+  // same goes for the strings owned by the function's locals
+  if (!ret->value) {
+    output += releaseOwnedLocals(indent());
+    if (enclosingScratch) {
+      output += indent() + "hl_scratch_restore(__scratch);\n";
     }
+    output += indent() + "return;\n";
+    return;
+  }
 
-    output += " " + compileExpr(ret->value.get(), returnType);
+  ValueType returnType = ValueType::INFERRED;
+  if (functionTable.count(currentFunction)) {
+    returnType = functionTable[currentFunction].returnType;
+  }
+  if (!checkIntValue(returnType, inferExprType(ret->value.get()),
+                     ret->value.get(),
+                     "return value of '" + currentFunction + "'", ret->line)) {
+    output = "";
+    return;
   }
 
-  output += ";\n";
+  // the caller owns what is returned: a local returned by name moves out,
+  // anything else is a fresh value or a copy
+  const OwnedLocal *moved = nullptr;
+  if (auto *var = nodeCast<VarExpr>(ret->value.get())) {
+    moved = findOwnedLocal(var->name);
+  }
+  std::string value =
+      moved ? moved->name : compileOwned(ret->value.get(), returnType);
+  std::string releases = releaseOwnedLocals(indent() + "    ", moved);
+
+  if (!statementScratch && (moved || releases.empty())) {
+    output += releaseOwnedLocals(indent(), moved);
+    if (enclosingScratch) {
+      output += indent() + "hl_scratch_restore(__scratch);\n";
+    }
+    output += indent() + "return " + value + ";\n";
+    return;
+  }
+
+  // the value is computed before anything it was computed from goes away
+  output += indent() + "{\n";
+  output += indent() + "    __typeof__(" + value + ") __result = " + value + ";\n";
+  output += releases;
+  if (statementScratch || enclosingScratch) {
+    output += indent() + "    hl_scratch_restore(__scratch);\n";
+  }
+  output += indent() + "    return __result;\n";
+  output += indent() + "}\n";
+  statementScratch = false;
 }
 
 } // namespace HolyLua
\ No newline at end of file
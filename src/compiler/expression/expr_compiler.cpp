@@ -4,9 +4,17 @@ namespace HolyLua {
 
 std::string Compiler::compileExpr(const Expr *expr, ValueType expectedType,
                                   bool forGlobalInit) {
-  if (auto *lit = dynamic_cast<const LiteralExpr *>(expr)) {
-    return valueToString(lit->value);
-  } else if (dynamic_cast<const NilExpr *>(expr)) {
+  if (!expr)
+    return "0.0";
+
+  // integer constants stored into an int stay integers
+  if (expectedType == ValueType::INT && isIntegerConstant(expr))
+    return compileIntConstant(expr);
+
+  switch (expr->kind) {
+  case NodeKind::LITERAL:
+    return valueToString(static_cast<const LiteralExpr *>(expr)->value);
+  case NodeKind::NIL:
     if (expectedType == ValueType::STRING) {
       return "NULL";
     } else if (expectedType == ValueType::NUMBER) {
@@ -20,214 +28,404 @@ std::string Compiler::compileExpr(const Expr *expr, ValueType expectedType,
     } else {
       return "HL_NIL_NUMBER";
     }
-  } else if (auto *var = dynamic_cast<const VarExpr *>(expr)) {
-    return var->name;
-  } else if (auto *enumAccess = dynamic_cast<const EnumAccessExpr *>(expr)) {
-    return compileEnumAccess(enumAccess);
-  } else if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
-    return compileFunctionCall(call);
-  } else if (auto *methodCall = dynamic_cast<const MethodCall *>(expr)) {
-    std::string result = compileMethodCall(methodCall);
+  case NodeKind::VAR:
+    return static_cast<const VarExpr *>(expr)->name;
+  case NodeKind::ENUM_ACCESS:
+    return compileEnumAccess(static_cast<const EnumAccessExpr *>(expr));
+  case NodeKind::FUNCTION_CALL:
+    return adoptTemporary(
+        expr, compileFunctionCall(static_cast<const FunctionCall *>(expr)));
+  case NodeKind::METHOD_CALL: {
+    std::string result =
+        compileMethodCall(static_cast<const MethodCall *>(expr));
     if (result.empty()) {
       return "0";
     }
-    return result;
-  } else if (auto *unwrap = dynamic_cast<const ForceUnwrapExpr *>(expr)) {
-    return compileExpr(unwrap->operand.get(), expectedType, forGlobalInit);
-  } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
-    if (bin->op == BinaryOp::NIL_COALESCE) {
-      std::string left =
-          compileExpr(bin->left.get(), expectedType, forGlobalInit);
-      std::string right =
-          compileExpr(bin->right.get(), expectedType, forGlobalInit);
-      ValueType leftType = inferExprType(bin->left.get());
+    return adoptTemporary(expr, result);
+  }
+  case NodeKind::FORCE_UNWRAP:
+    return compileExpr(static_cast<const ForceUnwrapExpr *>(expr)->operand.get(),
+                       expectedType, forGlobalInit);
+  case NodeKind::BINARY:
+    return compileBinaryExpr(static_cast<const BinaryExpr *>(expr),
+                             expectedType, forGlobalInit);
+  case NodeKind::UNARY:
+    return compileUnaryExpr(static_cast<const UnaryExpr *>(expr), expectedType,
+                            forGlobalInit);
+  case NodeKind::STRUCT_CONSTRUCTOR: {
+    auto *structCons = static_cast<const StructConstructor *>(expr);
+    if (forGlobalInit) {
+      return compileStructInitializer(structCons);
+    } else {
+      return adoptTemporary(expr, compileStructConstructor(structCons));
+    }
+  }
+  case NodeKind::FIELD_ACCESS: {
+    auto *fieldAccess = static_cast<const FieldAccessExpr *>(expr);
+    if (auto *varExpr = nodeCast<VarExpr>(fieldAccess->object.get())) {
+      std::string className = varExpr->name;
+      
+      if (classTable.count(className) > 0 && !symbolTable.count(className)) {
+        const auto &classInfo = classTable[className];
+        const MemberInfo *field = classInfo.findField(fieldAccess->fieldName);
+        
+        if (field && field->isStatic) {
+          return field->cName;
+        }
+      }
+    }
+    
+    return compileFieldAccess(fieldAccess);
+  }
+  case NodeKind::CLASS_INSTANTIATION:
+    return adoptTemporary(
+        expr,
+        compileClassInstantiation(static_cast<const ClassInstantiation *>(expr)));
+  case NodeKind::SELF:
+    return compileSelfExpr(static_cast<const SelfExpr *>(expr));
+  default:
+    break;
+  }
+  return "0.0";
+}
+
+// `(cond and a) or b`, lua's ternary, compiled as one c conditional
+static bool isTernary(const BinaryExpr *bin) {
+  auto *leftBin = nodeCast<BinaryExpr>(bin->left.get());
+  return bin->op == BinaryOp::OR && leftBin && leftBin->op == BinaryOp::AND;
+}
+
+static bool isArithmetic(BinaryOp op) {
+  return op == BinaryOp::ADD || op == BinaryOp::SUBTRACT ||
+         op == BinaryOp::MULTIPLY || op == BinaryOp::DIVIDE ||
+         op == BinaryOp::MODULO || op == BinaryOp::FLOOR_DIVIDE ||
+         op == BinaryOp::POWER;
+}
+
+static bool isComparison(BinaryOp op) {
+  return op == BinaryOp::EQUAL || op == BinaryOp::NOT_EQUAL ||
+         op == BinaryOp::LESS || op == BinaryOp::LESS_EQUAL ||
+         op == BinaryOp::GREATER || op == BinaryOp::GREATER_EQUAL;
+}
+
+// `value or default` on a nilable left operand tests it for nil
+static bool isNilDefault(BinaryOp op, ValueType leftType) {
+  return op == BinaryOp::OR &&
+         (leftType == ValueType::STRING || leftType == ValueType::NUMBER ||
+          leftType == ValueType::BOOL || leftType == ValueType::ENUM ||
+          leftType == ValueType::STRUCT);
+}
 
-      if (leftType == ValueType::STRING) {
-        return "((" + left + ") == NULL ? (" + right + ") : (" + left + "))";
-      } else if (leftType == ValueType::NUMBER) {
-        return "(isnan(" + left + ") ? (" + right + ") : (" + left + "))";
-      } else if (leftType == ValueType::ENUM) {
-        return "((" + left + ") == -1 ? (" + right + ") : (" + left + "))";
-      } else if (leftType == ValueType::STRUCT) {
-        return "(isnan(" + left + ") ? (" + right + ") : (" + left + "))";
-      } else {
-        return "((" + left + ") == -1 ? (" + right + ") : (" + left + "))";
+std::string Compiler::compileBinaryExpr(const BinaryExpr *bin,
+                                        ValueType expectedType,
+                                        bool forGlobalInit) {
+  if (bin->op == BinaryOp::CONCAT) {
+    // the whole chain becomes one call that allocates the result once
+    bool scratch = scratchStrings;
+    std::vector<const Expr *> operands;
+    collectConcatOperands(bin, operands);
+    std::string parts;
+    for (const Expr *operand : operands) {
+      if (!parts.empty()) {
+        parts += ", ";
       }
+      parts += compileExprForConcat(operand);
+    }
+    if (scratch) {
+      statementScratch = functionScratch = true;
     }
+    return (scratch ? "hl_scratch_concat_n(" : "hl_concat_n(") +
+           std::to_string(operands.size()) + ", (hl_part[]){" + parts + "})";
+  }
+
+  // detect lua-style ternary (condition and trueValue) or falseValue
+  if (isTernary(bin)) {
+    auto *leftBin = static_cast<const BinaryExpr *>(bin->left.get());
+    std::string condition = compileExpr(leftBin->left.get(), expectedType, forGlobalInit);
+    std::string trueValue = compileExpr(leftBin->right.get(), expectedType, forGlobalInit);
+    std::string falseValue = compileExpr(bin->right.get(), expectedType, forGlobalInit);
+    return "(" + condition + ") ? " + trueValue + " : " + falseValue;
+  }
 
-    if (bin->op == BinaryOp::CONCAT) {
-      std::string leftStr = compileExprForConcat(bin->left.get());
-      std::string rightStr = compileExprForConcat(bin->right.get());
-      return "hl_concat_strings(" + leftStr + ", " + rightStr + ")";
+  // a chain like a + b + c leans left as deep as it is long. its operators
+  // are visited outermost first to find what each expects of its operands,
+  // then joined innermost first, so only the right operands recurse
+  struct Link {
+    const BinaryExpr *bin;
+    ValueType operandType;
+    // strings in comparisons are only compared, never kept
+    bool scratch;
+  };
+  std::vector<Link> chain;
+  bool scratch = scratchStrings;
+  const Expr *innermost = bin;
+  ValueType expected = expectedType;
+  while (auto *link = nodeCast<BinaryExpr>(innermost)) {
+    if (!chain.empty() &&
+        (link->op == BinaryOp::CONCAT || isTernary(link) ||
+         (expected == ValueType::INT && isIntegerConstant(link)))) {
+      break;
     }
+    expected = binaryOperandType(link, expected);
+    scratch = scratch || isComparison(link->op);
+    chain.push_back({link, expected, scratch});
+    innermost = link->left.get();
+  }
 
-    if (bin->op == BinaryOp::POWER) {
-      std::string left =
-          compileExpr(bin->left.get(), expectedType, forGlobalInit);
-      std::string right =
-          compileExpr(bin->right.get(), expectedType, forGlobalInit);
-      return "pow(" + left + ", " + right + ")";
+  StringLifetime lifetime(*this, chain.back().scratch);
+  std::string compiled =
+      compileExpr(innermost, chain.back().operandType, forGlobalInit);
+  for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+    scratchStrings = it->scratch;
+    std::string right =
+        compileExpr(it->bin->right.get(), it->operandType, forGlobalInit);
+    compiled = joinBinaryOperands(it->bin, compiled, right);
+  }
+  return compiled;
+}
+
+// the type one operator compiles its operands to, given what is expected of
+// its result
+ValueType Compiler::binaryOperandType(const BinaryExpr *bin,
+                                      ValueType expectedType) {
+  if (isArithmetic(bin->op)) {
+    // an int result takes int operands, a number result never narrows them
+    if (inferExprType(bin) == ValueType::INT) {
+      return ValueType::INT;
     }
+    return expectedType == ValueType::INT ? ValueType::NUMBER : expectedType;
+  }
+  if (bin->op == BinaryOp::NIL_COALESCE ||
+      isNilDefault(bin->op, inferExprType(bin->left.get()))) {
+    return expectedType;
+  }
 
-    if (bin->op == BinaryOp::FLOOR_DIVIDE) {
-      std::string left =
-          compileExpr(bin->left.get(), expectedType, forGlobalInit);
-      std::string right =
-          compileExpr(bin->right.get(), expectedType, forGlobalInit);
-      return "(double)floor((" + left + ") / (" + right + "))";
+  // comparisons between ints and integer constants stay integer compares
+  ValueType leftType = inferExprType(bin->left.get());
+  ValueType rightType = inferExprType(bin->right.get());
+  if ((leftType == ValueType::INT || rightType == ValueType::INT) &&
+      (leftType == ValueType::INT || isIntegerConstant(bin->left.get())) &&
+      (rightType == ValueType::INT || isIntegerConstant(bin->right.get()))) {
+    return ValueType::INT;
+  }
+  return expectedType;
+}
+
+std::string Compiler::joinBinaryOperands(const BinaryExpr *bin,
+                                         std::string left,
+                                         const std::string &right) {
+  ValueType leftType = inferExprType(bin->left.get());
+
+  if (bin->op == BinaryOp::NIL_COALESCE) {
+    if (leftType == ValueType::STRING) {
+      return "((" + left + ") == NULL ? (" + right + ") : (" + left + "))";
+    } else if (leftType == ValueType::NUMBER) {
+      return "(isnan(" + left + ") ? (" + right + ") : (" + left + "))";
+    } else if (leftType == ValueType::ENUM) {
+      return "((" + left + ") == -1 ? (" + right + ") : (" + left + "))";
+    } else if (leftType == ValueType::STRUCT) {
+      return "(isnan(" + left + ") ? (" + right + ") : (" + left + "))";
+    } else {
+      return "((" + left + ") == -1 ? (" + right + ") : (" + left + "))";
     }
+  }
 
-    // detect lua-style ternary (condition and trueValue) or falseValue
-    if (bin->op == BinaryOp::OR) {
-      if (auto *leftBin = dynamic_cast<const BinaryExpr *>(bin->left.get())) {
-        if (leftBin->op == BinaryOp::AND) {
-          std::string condition = compileExpr(leftBin->left.get(), expectedType, forGlobalInit);
-          std::string trueValue = compileExpr(leftBin->right.get(), expectedType, forGlobalInit);
-          std::string falseValue = compileExpr(bin->right.get(), expectedType, forGlobalInit);
-          return "(" + condition + ") ? " + trueValue + " : " + falseValue;
-        }
-      }
-      
-      // handle simple nil-coalescing: value or default
-      ValueType leftType = inferExprType(bin->left.get());
-      std::string left = compileExpr(bin->left.get(), expectedType, forGlobalInit);
-      std::string right = compileExpr(bin->right.get(), expectedType, forGlobalInit);
-      
-      if (leftType == ValueType::STRING) {
-        return "(!hl_is_nil_string(" + left + ") ? (" + left + ") : (" + right + "))";
-      } else if (leftType == ValueType::NUMBER) {
-        return "(!hl_is_nil_number(" + left + ") ? (" + left + ") : (" + right + "))";
-      } else if (leftType == ValueType::BOOL) {
-        return "(!hl_is_nil_bool(" + left + ") ? (" + left + ") : (" + right + "))";
-      } else if (leftType == ValueType::ENUM) {
-        return "((" + left + ") != -1 ? (" + left + ") : (" + right + "))";
-      } else if (leftType == ValueType::STRUCT) {
-        return "(!hl_is_nil_number(" + left + ") ? (" + left + ") : (" + right + "))";
-      }
+  if (isArithmetic(bin->op)) {
+    if (bin->op == BinaryOp::DIVIDE && leftType == ValueType::INT) {
+      // int / int is still a float division
+      left = "(double)" + left;
     }
+    return compileArithmetic(bin->op, left, right, inferExprType(bin));
+  }
 
-    std::string left =
-        compileExpr(bin->left.get(), expectedType, forGlobalInit);
-    std::string right =
-        compileExpr(bin->right.get(), expectedType, forGlobalInit);
-    std::string op;
+  // handle simple nil-coalescing: value or default
+  if (isNilDefault(bin->op, leftType)) {
+    if (leftType == ValueType::STRING) {
+      return "(!hl_is_nil_string(" + left + ") ? (" + left + ") : (" + right + "))";
+    } else if (leftType == ValueType::NUMBER) {
+      return "(!hl_is_nil_number(" + left + ") ? (" + left + ") : (" + right + "))";
+    } else if (leftType == ValueType::BOOL) {
+      return "(!hl_is_nil_bool(" + left + ") ? (" + left + ") : (" + right + "))";
+    } else if (leftType == ValueType::ENUM) {
+      return "((" + left + ") != -1 ? (" + left + ") : (" + right + "))";
+    } else {
+      return "(!hl_is_nil_number(" + left + ") ? (" + left + ") : (" + right + "))";
+    }
+  }
 
-    switch (bin->op) {
-    case BinaryOp::ADD:
-      op = " + ";
-      break;
-    case BinaryOp::SUBTRACT:
-      op = " - ";
-      break;
-    case BinaryOp::MULTIPLY:
-      op = " * ";
-      break;
-    case BinaryOp::DIVIDE:
-      op = " / ";
-      break;
-    case BinaryOp::MODULO:
-      op = " % ";
-      break;
-    case BinaryOp::EQUAL:
-      op = " == ";
-      break;
-    case BinaryOp::NOT_EQUAL:
-      op = " != ";
-      break;
-    case BinaryOp::LESS:
-      op = " < ";
-      break;
-    case BinaryOp::LESS_EQUAL:
-      op = " <= ";
-      break;
-    case BinaryOp::GREATER:
-      op = " > ";
-      break;
-    case BinaryOp::GREATER_EQUAL:
-      op = " >= ";
-      break;
-    case BinaryOp::AND:
-      op = " && ";
-      break;
-    case BinaryOp::OR:
-      op = " || ";
-      break;
-    default:
-      op = " + ";
-      break;
+  std::string op;
+  switch (bin->op) {
+  case BinaryOp::EQUAL:
+    op = " == ";
+    break;
+  case BinaryOp::NOT_EQUAL:
+    op = " != ";
+    break;
+  case BinaryOp::LESS:
+    op = " < ";
+    break;
+  case BinaryOp::LESS_EQUAL:
+    op = " <= ";
+    break;
+  case BinaryOp::GREATER:
+    op = " > ";
+    break;
+  case BinaryOp::GREATER_EQUAL:
+    op = " >= ";
+    break;
+  case BinaryOp::AND:
+    op = " && ";
+    break;
+  case BinaryOp::OR:
+    op = " || ";
+    break;
+  default:
+    op = " + ";
+    break;
+  }
+  return "(" + left + op + right + ")";
+}
+
+// + - * / % // ^ on compiled operands. ints wrap around on overflow and
+// use the runtime's floored division and modulo, numbers follow lua's
+// float semantics
+std::string Compiler::compileArithmetic(BinaryOp op, const std::string &left,
+                                        const std::string &right,
+                                        ValueType resultType) {
+  bool isInt = resultType == ValueType::INT;
+  // signed overflow is undefined in c, unsigned arithmetic wraps
+  auto wrapping = [&](const char *op) {
+    return "(int64_t)((uint64_t)(" + left + ")" + op + "(uint64_t)(" + right +
+           "))";
+  };
+  switch (op) {
+  case BinaryOp::ADD:
+    if (isInt) {
+      return wrapping(" + ");
     }
-    return "(" + left + op + right + ")";
-  } else if (auto *un = dynamic_cast<const UnaryExpr *>(expr)) {
-    std::string operand =
-        compileExpr(un->operand.get(), expectedType, forGlobalInit);
-    if (un->op == UnaryOp::NEGATE) {
-      return "(-" + operand + ")";
-    } else if (un->op == UnaryOp::NOT) {
-      ValueType operandType = inferExprType(un->operand.get());
-      
-      if (operandType == ValueType::STRUCT) {
-        // check if it's an optional struct variable
-        if (auto *varExpr = dynamic_cast<const VarExpr *>(un->operand.get())) {
-          if (symbolTable.count(varExpr->name) && 
-              symbolTable[varExpr->name].isOptional) {
-            return "(isnan(" + operand + "))";
-          }
-        } else if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(un->operand.get())) {
-          return "(isnan(" + operand + "))";
-        }
-      }
-      
-      return "(!" + operand + ")";
+    return "(" + left + " + " + right + ")";
+  case BinaryOp::SUBTRACT:
+    if (isInt) {
+      return wrapping(" - ");
     }
-  } else if (auto *structCons = dynamic_cast<const StructConstructor *>(expr)) {
-    if (forGlobalInit) {
-      return compileStructInitializer(structCons);
-    } else {
-      return compileStructConstructor(structCons);
+    return "(" + left + " - " + right + ")";
+  case BinaryOp::MULTIPLY:
+    if (isInt) {
+      return wrapping(" * ");
     }
-  } else if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(expr)) {
-    if (auto *varExpr = dynamic_cast<const VarExpr *>(fieldAccess->object.get())) {
-      std::string className = varExpr->name;
-      
-      if (classTable.count(className) > 0 && !symbolTable.count(className)) {
-        const auto &classInfo = classTable[className];
-        bool isStaticField = false;
-        
-        for (const auto &field : classInfo.fields) {
-          if (field.name == fieldAccess->fieldName && field.isStatic) {
-            isStaticField = true;
-            break;
-          }
-        }
-        
-        if (isStaticField) {
-          return className + "_" + fieldAccess->fieldName;
+    return "(" + left + " * " + right + ")";
+  case BinaryOp::DIVIDE:
+    return "(" + left + " / " + right + ")";
+  case BinaryOp::MODULO:
+    return (isInt ? "hl_imod(" : "hl_mod_float(") + left + ", " + right + ")";
+  case BinaryOp::FLOOR_DIVIDE:
+    if (isInt) {
+      return "hl_idiv(" + left + ", " + right + ")";
+    }
+    return "(double)floor((" + left + ") / (" + right + "))";
+  case BinaryOp::POWER:
+    return "pow(" + left + ", " + right + ")";
+  default:
+    return "(" + left + " + " + right + ")";
+  }
+}
+
+std::string Compiler::compileIntConstant(const Expr *expr) {
+  if (auto *lit = nodeCast<LiteralExpr>(expr)) {
+    int64_t value = std::get<int64_t>(lit->value);
+    return value < 0 ? "(" + std::to_string(value) + ")" : std::to_string(value);
+  }
+  if (auto *un = nodeCast<UnaryExpr>(expr)) {
+    return "(-" + compileIntConstant(un->operand.get()) + ")";
+  }
+  // a long constant chain is joined innermost first instead of recursing
+  auto spine = leftSpine(static_cast<const BinaryExpr *>(expr));
+  std::string compiled = compileIntConstant(spine.back()->left.get());
+  for (auto it = spine.rbegin(); it != spine.rend(); ++it) {
+    compiled = compileArithmetic((*it)->op, compiled,
+                                 compileIntConstant((*it)->right.get()),
+                                 ValueType::INT);
+  }
+  return compiled;
+}
+
+std::string Compiler::compileUnaryExpr(const UnaryExpr *un,
+                                       ValueType expectedType,
+                                       bool forGlobalInit) {
+  std::string operand =
+      compileExpr(un->operand.get(), expectedType, forGlobalInit);
+  if (un->op == UnaryOp::NEGATE) {
+    if (!nodeCast<LiteralExpr>(un->operand.get()) &&
+        inferExprType(un->operand.get()) == ValueType::INT) {
+      // -INT64_MIN wraps like lua instead of overflowing
+      return "(int64_t)(0 - (uint64_t)(" + operand + "))";
+    }
+    return "(-" + operand + ")";
+  } else if (un->op == UnaryOp::NOT) {
+    ValueType operandType = inferExprType(un->operand.get());
+    
+    if (operandType == ValueType::STRUCT) {
+      // check if it's an optional struct variable
+      if (auto *varExpr = nodeCast<VarExpr>(un->operand.get())) {
+        if (symbolTable.count(varExpr->name) && 
+            symbolTable[varExpr->name].isOptional) {
+          return "(isnan(" + operand + "))";
         }
+      } else if (auto *fieldAccess = nodeCast<FieldAccessExpr>(un->operand.get())) {
+        return "(isnan(" + operand + "))";
       }
     }
     
-    return compileFieldAccess(fieldAccess);
-  } else if (auto *classInst = dynamic_cast<const ClassInstantiation *>(expr)) {
-    return compileClassInstantiation(classInst);
-  } else if (auto *selfExpr = dynamic_cast<const SelfExpr *>(expr)) {
-    return compileSelfExpr(selfExpr);
+    return "(!" + operand + ")";
   }
   return "0.0";
 }
 
+void Compiler::collectConcatOperands(const Expr *expr,
+                                     std::vector<const Expr *> &operands) {
+  // the left spine of the chain is walked in a loop, right operands of an
+  // inner concatenation (parenthesized) recurse
+  std::vector<const Expr *> rights;
+  auto *bin = nodeCast<BinaryExpr>(expr);
+  while (bin && bin->op == BinaryOp::CONCAT) {
+    rights.push_back(bin->right.get());
+    expr = bin->left.get();
+    bin = nodeCast<BinaryExpr>(expr);
+  }
+  operands.push_back(expr);
+  for (auto it = rights.rbegin(); it != rights.rend(); ++it) {
+    auto *rightBin = nodeCast<BinaryExpr>(*it);
+    if (rightBin && rightBin->op == BinaryOp::CONCAT) {
+      collectConcatOperands(*it, operands);
+    } else {
+      operands.push_back(*it);
+    }
+  }
+}
+
+// one hl_part of a concatenation, values are formatted by hl_concat_n
+// instead of going through a temporary string
 std::string Compiler::compileExprForConcat(const Expr *expr) {
+  StringLifetime lifetime(*this, true);
   ValueType type = inferExprType(expr);
   
-  if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
+  if (auto *call = nodeCast<FunctionCall>(expr)) {
     if (call->name == "tostring") {
-      return compileFunctionCall(call);
+      if (call->arguments.size() == 1) {
+        ValueType argType = inferExprType(call->arguments[0].get());
+        if (argType == ValueType::NUMBER || argType == ValueType::INT ||
+            argType == ValueType::STRING || argType == ValueType::BOOL) {
+          return compileExprForConcat(call->arguments[0].get());
+        }
+      }
+      return "HL_STR_PART(" + compileFunctionCall(call) + ")";
     }
   }
   
   // check if this is already a ternary expression that produces a string
-  if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
+  if (auto *bin = nodeCast<BinaryExpr>(expr)) {
     if (bin->op == BinaryOp::OR) {
-      if (auto *leftBin = dynamic_cast<const BinaryExpr *>(bin->left.get())) {
+      if (auto *leftBin = nodeCast<BinaryExpr>(bin->left.get())) {
         if (leftBin->op == BinaryOp::AND) {
           // check if both branches are string literals
           ValueType trueType = inferExprType(leftBin->right.get());
@@ -235,7 +433,7 @@ std::string Compiler::compileExprForConcat(const Expr *expr) {
           
           if (trueType == ValueType::STRING && falseType == ValueType::STRING) {
             // both are strings, the ternary will produce a string directly
-            return compileExpr(expr);
+            return "HL_STR_PART(" + compileExpr(expr) + ")";
           }
         }
       }
@@ -245,31 +443,35 @@ std::string Compiler::compileExprForConcat(const Expr *expr) {
   std::string compiled = compileExpr(expr);
 
   if (type == ValueType::NUMBER) {
-    return "hl_tostring_number(" + compiled + ")";
+    return "HL_NUM_PART(" + compiled + ")";
+  } else if (type == ValueType::INT) {
+    return "HL_INT_PART(" + compiled + ")";
   } else if (type == ValueType::BOOL) {
-    return "hl_tostring_bool(" + compiled + ")";
-  } else if (type == ValueType::STRING) {
-    return compiled;
+    return "HL_BOOL_PART(" + compiled + ")";
   } else if (type == ValueType::ENUM) {
-    return "hl_tostring_number((double)" + compiled + ")";
+    return "HL_NUM_PART((double)" + compiled + ")";
   } else {
-    return "hl_tostring_string(" + compiled + ")";
+    return "HL_STR_PART(" + compiled + ")";
   }
 }
 
 bool Compiler::containsVariables(const Expr *expr) {
-  if (dynamic_cast<const VarExpr *>(expr)) {
+  if (nodeCast<VarExpr>(expr)) {
     return true;
-  } else if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
+  } else if (auto *call = nodeCast<FunctionCall>(expr)) {
     for (const auto &arg : call->arguments) {
       if (containsVariables(arg.get())) return true;
     }
     return false;
-  } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
-    return containsVariables(bin->left.get()) || containsVariables(bin->right.get());
-  } else if (auto *un = dynamic_cast<const UnaryExpr *>(expr)) {
+  } else if (auto *bin = nodeCast<BinaryExpr>(expr)) {
+    auto spine = leftSpine(bin);
+    for (auto *link : spine) {
+      if (containsVariables(link->right.get())) return true;
+    }
+    return containsVariables(spine.back()->left.get());
+  } else if (auto *un = nodeCast<UnaryExpr>(expr)) {
     return containsVariables(un->operand.get());
-  } else if (auto *structCons = dynamic_cast<const StructConstructor *>(expr)) {
+  } else if (auto *structCons = nodeCast<StructConstructor>(expr)) {
     for (const auto &arg : structCons->positionalArgs) {
       if (containsVariables(arg.get())) return true;
     }
@@ -277,9 +479,9 @@ bool Compiler::containsVariables(const Expr *expr) {
       if (containsVariables(namedArg.second.get())) return true;
     }
     return false;
-  } else if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(expr)) {
+  } else if (auto *fieldAccess = nodeCast<FieldAccessExpr>(expr)) {
     return containsVariables(fieldAccess->object.get());
-  } else if (auto *unwrap = dynamic_cast<const ForceUnwrapExpr *>(expr)) {
+  } else if (auto *unwrap = nodeCast<ForceUnwrapExpr>(expr)) {
     return containsVariables(unwrap->operand.get());
   }
   return false;
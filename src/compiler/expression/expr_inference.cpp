@@ -3,20 +3,59 @@
 namespace HolyLua {
 
 ValueType Compiler::inferExprType(const Expr *expr) {
-  if (auto *lit = dynamic_cast<const LiteralExpr *>(expr)) {
-    return inferType(lit->value);
-  } else if (dynamic_cast<const NilExpr *>(expr)) {
+  if (!expr)
     return ValueType::INFERRED;
-  } else if (auto *var = dynamic_cast<const VarExpr *>(expr)) {
+
+  // the type checker annotates what it resolved, codegen resolves the rest
+  // once per node. the unresolved part of a chain's left spine is resolved
+  // innermost first, so no operator recurses into its left operand
+  if (expr->resolvedType.resolved) {
+    return expr->resolvedType.type;
+  }
+  std::vector<const Expr *> pending;
+  for (const Expr *node = expr; node && !node->resolvedType.resolved;) {
+    pending.push_back(node);
+    auto *bin = nodeCast<BinaryExpr>(node);
+    node = bin ? bin->left.get() : nullptr;
+  }
+  ValueType type = ValueType::INFERRED;
+  for (auto it = pending.rbegin(); it != pending.rend(); ++it) {
+    std::string typeName;
+    type = resolveExprType(*it, typeName);
+    // a miss usually means a name is not declared yet, e.g. a local read
+    // while a method's return type is worked out, so it is not kept
+    if (type != ValueType::INFERRED) {
+      (*it)->annotate(type, typeName);
+    }
+  }
+  return type;
+}
+
+// declarations without an annotation, typed the way the checker types them
+ValueType Compiler::inferVarType(const Expr *value) {
+  return declarationType(value, inferExprType(value));
+}
+
+ValueType Compiler::resolveExprType(const Expr *expr, std::string &typeName) {
+  switch (expr->kind) {
+  case NodeKind::LITERAL:
+    return inferType(static_cast<const LiteralExpr *>(expr)->value);
+  case NodeKind::NIL:
+    return ValueType::INFERRED;
+  case NodeKind::VAR: {
+    auto *var = static_cast<const VarExpr *>(expr);
     if (symbolTable.count(var->name)) {
       return symbolTable[var->name].type;
     }
     return ValueType::INFERRED;
-  } else if (auto *enumAccess = dynamic_cast<const EnumAccessExpr *>(expr)) {
+  }
+  case NodeKind::ENUM_ACCESS:
+    typeName = static_cast<const EnumAccessExpr *>(expr)->enumName;
     return ValueType::ENUM;
-  } else if (dynamic_cast<const LambdaExpr *>(expr)) {
+  case NodeKind::LAMBDA:
     return ValueType::FUNCTION;
-  } else if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
+  case NodeKind::FUNCTION_CALL: {
+    auto *call = static_cast<const FunctionCall *>(expr);
     if (call->name == "tostring") {
       return ValueType::STRING;
     }
@@ -24,33 +63,35 @@ ValueType Compiler::inferExprType(const Expr *expr) {
       return functionTable[call->name].returnType;
     }
     return ValueType::NUMBER;
-  } else if (auto *methodCall = dynamic_cast<const MethodCall *>(expr)) {
+  }
+  case NodeKind::METHOD_CALL: {
+    auto *methodCall = static_cast<const MethodCall *>(expr);
     std::string className = "";
-    if (auto *varExpr = dynamic_cast<const VarExpr *>(methodCall->object.get())) {
+    if (auto *varExpr = nodeCast<VarExpr>(methodCall->object.get())) {
       if (symbolTable.count(varExpr->name)) {
         className = symbolTable[varExpr->name].structTypeName;
       } else if (classTable.count(varExpr->name)) {
         className = varExpr->name;
       }
-    } else if (dynamic_cast<const SelfExpr *>(methodCall->object.get())) {
+    } else if (nodeCast<SelfExpr>(methodCall->object.get())) {
       className = currentClass;
     }
     
     if (!className.empty() && classTable.count(className)) {
       auto &classInfo = classTable[className];
-      if (classInfo.methodInfo.count(methodCall->methodName)) {
-        auto methodInfo = classInfo.methodInfo[methodCall->methodName];
-        ValueType returnType = methodInfo.first;
-        
-        return returnType;
+      if (const MemberInfo *method = classInfo.findMethod(methodCall->methodName)) {
+        return method->type;
       }
     }
     return ValueType::INFERRED;
-  } else if (dynamic_cast<const ClassInstantiation *>(expr)) {
+  }
+  case NodeKind::CLASS_INSTANTIATION:
+    typeName = static_cast<const ClassInstantiation *>(expr)->className;
     return ValueType::STRUCT;
-  } else if (dynamic_cast<const ForceUnwrapExpr *>(expr)) {
+  case NodeKind::FORCE_UNWRAP:
     return ValueType::NUMBER;
-  } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
+  case NodeKind::BINARY: {
+    auto *bin = static_cast<const BinaryExpr *>(expr);
     if (bin->op == BinaryOp::CONCAT) {
       return ValueType::STRING;
     }
@@ -65,16 +106,34 @@ ValueType Compiler::inferExprType(const Expr *expr) {
     if (bin->op == BinaryOp::NIL_COALESCE) {
       return inferExprType(bin->right.get());
     }
-    return ValueType::NUMBER;
-  } else if (auto *un = dynamic_cast<const UnaryExpr *>(expr)) {
+    return arithmeticResultType(bin->op, bin->left.get(),
+                                inferExprType(bin->left.get()),
+                                bin->right.get(),
+                                inferExprType(bin->right.get()));
+  }
+  case NodeKind::UNARY: {
+    auto *un = static_cast<const UnaryExpr *>(expr);
     if (un->op == UnaryOp::NOT) {
       return ValueType::BOOL;
     }
+    if (inferExprType(un->operand.get()) == ValueType::INT) {
+      return ValueType::INT;
+    }
     return ValueType::NUMBER;
-  } else if (dynamic_cast<const StructConstructor *>(expr)) {
+  }
+  case NodeKind::STRUCT_CONSTRUCTOR:
+    typeName = static_cast<const StructConstructor *>(expr)->structName;
     return ValueType::STRUCT;
-  } else if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(expr)) {
-    return inferFieldAccessType(fieldAccess);
+  case NodeKind::FIELD_ACCESS: {
+    auto *fieldAccess = static_cast<const FieldAccessExpr *>(expr);
+    ValueType type = inferFieldAccessType(fieldAccess);
+    if (type == ValueType::STRUCT) {
+      typeName = getStructTypeNameFromFieldAccess(fieldAccess);
+    }
+    return type;
+  }
+  default:
+    break;
   }
   return ValueType::INFERRED;
 }
@@ -84,21 +143,22 @@ ValueType Compiler::inferFieldAccessType(const FieldAccessExpr *fieldAccess) {
   ValueType objectType = ValueType::INFERRED;
   
   // first, determine the type of the object being accessed
-  if (auto *varExpr = dynamic_cast<const VarExpr *>(fieldAccess->object.get())) {
+  if (auto *varExpr = nodeCast<VarExpr>(fieldAccess->object.get())) {
     if (symbolTable.count(varExpr->name)) {
       structOrClassName = symbolTable[varExpr->name].structTypeName;
       objectType = symbolTable[varExpr->name].type;
     }
-  } else if (dynamic_cast<const SelfExpr *>(fieldAccess->object.get())) {
+  } else if (nodeCast<SelfExpr>(fieldAccess->object.get())) {
     structOrClassName = currentClass;
     objectType = ValueType::STRUCT;
-  } else if (auto *nestedFieldAccess = dynamic_cast<const FieldAccessExpr *>(fieldAccess->object.get())) {
-    // handle nested field access recursively
-    objectType = inferFieldAccessType(nestedFieldAccess);
+  } else if (auto *nestedFieldAccess = nodeCast<FieldAccessExpr>(fieldAccess->object.get())) {
+    // nested accesses are resolved once and cached on the node, so a chain
+    // a.b.c.d costs one lookup per link
+    objectType = inferExprType(nestedFieldAccess);
     
     // if the nested field access returns a struct, get its type name
     if (objectType == ValueType::STRUCT) {
-      structOrClassName = getStructTypeNameFromFieldAccess(nestedFieldAccess);
+      structOrClassName = nestedFieldAccess->resolvedType.typeName;
     }
   }
   
@@ -106,17 +166,15 @@ ValueType Compiler::inferFieldAccessType(const FieldAccessExpr *fieldAccess) {
   if (!structOrClassName.empty()) {
     if (classTable.count(structOrClassName)) {
       auto &classInfo = classTable[structOrClassName];
-      if (classInfo.fieldInfo.count(fieldAccess->fieldName)) {
-        return classInfo.fieldInfo[fieldAccess->fieldName].first;
+      if (const MemberInfo *field = classInfo.findField(fieldAccess->fieldName)) {
+        return field->type;
       }
     }
     
     if (structTable.count(structOrClassName)) {
       const auto &structInfo = structTable[structOrClassName];
-      for (const auto &field : structInfo.fields) {
-        if (field.name == fieldAccess->fieldName) {
-          return field.type;
-        }
+      if (const MemberInfo *field = structInfo.findField(fieldAccess->fieldName)) {
+        return field->type;
       }
     }
   }
@@ -128,15 +186,17 @@ std::string Compiler::getStructTypeNameFromFieldAccess(const FieldAccessExpr *fi
   std::string structOrClassName = "";
   
   // determine the object's struct type
-  if (auto *varExpr = dynamic_cast<const VarExpr *>(fieldAccess->object.get())) {
+  if (auto *varExpr = nodeCast<VarExpr>(fieldAccess->object.get())) {
     if (symbolTable.count(varExpr->name)) {
       structOrClassName = symbolTable[varExpr->name].structTypeName;
     }
-  } else if (dynamic_cast<const SelfExpr *>(fieldAccess->object.get())) {
+  } else if (nodeCast<SelfExpr>(fieldAccess->object.get())) {
     structOrClassName = currentClass;
-  } else if (auto *nestedFieldAccess = dynamic_cast<const FieldAccessExpr *>(fieldAccess->object.get())) {
-    // recursively resolve nested accesses
-    structOrClassName = getStructTypeNameFromFieldAccess(nestedFieldAccess);
+  } else if (auto *nestedFieldAccess = nodeCast<FieldAccessExpr>(fieldAccess->object.get())) {
+    // nested accesses carry their struct name once resolved
+    if (inferExprType(nestedFieldAccess) == ValueType::STRUCT) {
+      structOrClassName = nestedFieldAccess->resolvedType.typeName;
+    }
   }
   
   if (structOrClassName.empty()) {
@@ -145,28 +205,18 @@ std::string Compiler::getStructTypeNameFromFieldAccess(const FieldAccessExpr *fi
   
   if (classTable.count(structOrClassName)) {
     auto &classInfo = classTable[structOrClassName];
-    if (classInfo.fieldInfo.count(fieldAccess->fieldName)) {
-      auto fieldType = classInfo.fieldInfo[fieldAccess->fieldName].first;
-      if (fieldType == ValueType::STRUCT) {
-        // find the struct type name for this field
-        for (const auto &field : classInfo.fields) {
-          if (field.name == fieldAccess->fieldName) {
-            return field.structTypeName;
-          }
-        }
-      }
+    const MemberInfo *field = classInfo.findField(fieldAccess->fieldName);
+    if (field && field->type == ValueType::STRUCT) {
+      return field->structTypeName;
     }
   }
   
   // check struct table
   if (structTable.count(structOrClassName)) {
     const auto &structInfo = structTable[structOrClassName];
-    for (const auto &field : structInfo.fields) {
-      if (field.name == fieldAccess->fieldName) {
-        if (field.type == ValueType::STRUCT) {
-          return field.structTypeName;
-        }
-      }
+    const MemberInfo *field = structInfo.findField(fieldAccess->fieldName);
+    if (field && field->type == ValueType::STRUCT) {
+      return field->structTypeName;
     }
   }
   
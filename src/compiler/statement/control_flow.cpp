@@ -5,7 +5,7 @@ namespace HolyLua {
 void Compiler::compileIfStmt(const IfStmt *ifStmt) {
   pushScope();
 
-  if (auto *varExpr = dynamic_cast<const VarExpr *>(ifStmt->condition.get())) {
+  if (auto *varExpr = nodeCast<VarExpr>(ifStmt->condition.get())) {
     if (symbolTable.count(varExpr->name)) {
       auto &varInfo = symbolTable[varExpr->name];
       if (varInfo.isOptional) {
@@ -14,10 +14,10 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
     }
   }
   else if (auto *unaryExpr =
-               dynamic_cast<const UnaryExpr *>(ifStmt->condition.get())) {
+               nodeCast<UnaryExpr>(ifStmt->condition.get())) {
     if (unaryExpr->op == UnaryOp::NOT) {
       if (auto *innerVar =
-              dynamic_cast<const VarExpr *>(unaryExpr->operand.get())) {
+              nodeCast<VarExpr>(unaryExpr->operand.get())) {
         if (symbolTable.count(innerVar->name)) {
           auto &varInfo = symbolTable[innerVar->name];
           if (varInfo.isOptional) {
@@ -28,10 +28,10 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
     }
   }
   else if (auto *binExpr =
-               dynamic_cast<const BinaryExpr *>(ifStmt->condition.get())) {
+               nodeCast<BinaryExpr>(ifStmt->condition.get())) {
     if (binExpr->op == BinaryOp::NOT_EQUAL) {
-      if (dynamic_cast<const VarExpr *>(binExpr->left.get()) &&
-          dynamic_cast<const NilExpr *>(binExpr->right.get())) {
+      if (nodeCast<VarExpr>(binExpr->left.get()) &&
+          nodeCast<NilExpr>(binExpr->right.get())) {
         // this is "x != nil", x is non-nil in then block
       }
     }
@@ -39,7 +39,7 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
 
   output += indent() + "if (";
 
-  if (auto *varExpr = dynamic_cast<const VarExpr *>(ifStmt->condition.get())) {
+  if (auto *varExpr = nodeCast<VarExpr>(ifStmt->condition.get())) {
     if (symbolTable.count(varExpr->name)) {
       auto &varInfo = symbolTable[varExpr->name];
       if (varInfo.isOptional) {
@@ -52,10 +52,10 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
     }
   }
   else if (auto *unaryExpr =
-               dynamic_cast<const UnaryExpr *>(ifStmt->condition.get())) {
+               nodeCast<UnaryExpr>(ifStmt->condition.get())) {
     if (unaryExpr->op == UnaryOp::NOT) {
       if (auto *innerVar =
-              dynamic_cast<const VarExpr *>(unaryExpr->operand.get())) {
+              nodeCast<VarExpr>(unaryExpr->operand.get())) {
         if (symbolTable.count(innerVar->name)) {
           auto &varInfo = symbolTable[innerVar->name];
           if (varInfo.isOptional) {
@@ -79,13 +79,13 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
   output += ") {\n";
   indentLevel++;
 
+  openOwnedBlock();
   for (const auto &stmt : ifStmt->thenBlock) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileStatement(stmt.get());
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
   }
+  closeOwnedBlock();
   indentLevel--;
 
   popScope();
@@ -95,7 +95,7 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
 
     output += indent() + "} else if (";
 
-    if (auto *varExpr = dynamic_cast<const VarExpr *>(elseifBranch.first.get())) {
+    if (auto *varExpr = nodeCast<VarExpr>(elseifBranch.first.get())) {
       if (symbolTable.count(varExpr->name)) {
         auto &varInfo = symbolTable[varExpr->name];
         if (varInfo.isOptional) {
@@ -109,10 +109,10 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
       }
     }
     else if (auto *unaryExpr =
-                 dynamic_cast<const UnaryExpr *>(elseifBranch.first.get())) {
+                 nodeCast<UnaryExpr>(elseifBranch.first.get())) {
       if (unaryExpr->op == UnaryOp::NOT) {
         if (auto *innerVar =
-                dynamic_cast<const VarExpr *>(unaryExpr->operand.get())) {
+                nodeCast<VarExpr>(unaryExpr->operand.get())) {
           if (symbolTable.count(innerVar->name)) {
             auto &varInfo = symbolTable[innerVar->name];
             if (varInfo.isOptional) {
@@ -136,13 +136,13 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
     output += ") {\n";
     indentLevel++;
 
+    openOwnedBlock();
     for (const auto &stmt : elseifBranch.second) {
-      std::string savedOutput = output;
-      output = "";
+      output.openSection();
       compileStatement(stmt.get());
-      savedOutput += output;
-      output = savedOutput;
+      output.closeSection();
     }
+    closeOwnedBlock();
     indentLevel--;
 
     popScope();
@@ -157,7 +157,7 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
     indentLevel++;
 
     if (auto *varExpr =
-            dynamic_cast<const VarExpr *>(ifStmt->condition.get())) {
+            nodeCast<VarExpr>(ifStmt->condition.get())) {
       if (symbolTable.count(varExpr->name)) {
         auto &varInfo = symbolTable[varExpr->name];
         if (varInfo.isOptional) {
@@ -166,10 +166,10 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
       }
     }
     else if (auto *unaryExpr =
-                 dynamic_cast<const UnaryExpr *>(ifStmt->condition.get())) {
+                 nodeCast<UnaryExpr>(ifStmt->condition.get())) {
       if (unaryExpr->op == UnaryOp::NOT) {
         if (auto *innerVar =
-                dynamic_cast<const VarExpr *>(unaryExpr->operand.get())) {
+                nodeCast<VarExpr>(unaryExpr->operand.get())) {
           if (symbolTable.count(innerVar->name)) {
             auto &varInfo = symbolTable[innerVar->name];
             if (varInfo.isOptional) {
@@ -180,27 +180,27 @@ void Compiler::compileIfStmt(const IfStmt *ifStmt) {
       }
     }
     else if (auto *binExpr =
-                 dynamic_cast<const BinaryExpr *>(ifStmt->condition.get())) {
+                 nodeCast<BinaryExpr>(ifStmt->condition.get())) {
       if (binExpr->op == BinaryOp::EQUAL) {
-        if (dynamic_cast<const VarExpr *>(binExpr->left.get()) &&
-            dynamic_cast<const NilExpr *>(binExpr->right.get())) {
+        if (nodeCast<VarExpr>(binExpr->left.get()) &&
+            nodeCast<NilExpr>(binExpr->right.get())) {
           // this is "x == nil", x is non-nil in else block
         }
       } else if (binExpr->op == BinaryOp::NOT_EQUAL) {
-        if (dynamic_cast<const VarExpr *>(binExpr->left.get()) &&
-            dynamic_cast<const NilExpr *>(binExpr->right.get())) {
+        if (nodeCast<VarExpr>(binExpr->left.get()) &&
+            nodeCast<NilExpr>(binExpr->right.get())) {
           // this is "x != nil", x is nil in else block
         }
       }
     }
 
+    openOwnedBlock();
     for (const auto &stmt : ifStmt->elseBlock) {
-      std::string savedOutput = output;
-      output = "";
+      output.openSection();
       compileStatement(stmt.get());
-      savedOutput += output;
-      output = savedOutput;
+      output.closeSection();
     }
+    closeOwnedBlock();
     indentLevel--;
     output += indent() + "}";
 
@@ -217,46 +217,215 @@ void Compiler::compileWhileStmt(const WhileStmt *whileStmt) {
   pushScope();
   indentLevel++;
 
+  // the condition runs again on every iteration
+  if (statementScratch) {
+    output += indent() + "hl_scratch_restore(__scratch);\n";
+  }
+
+  openOwnedBlock();
   for (const auto &stmt : whileStmt->body) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileStatement(stmt.get());
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
   }
+  closeOwnedBlock();
 
   indentLevel--;
   popScope();
   output += indent() + "}\n";
 }
 
+// sign of a literal step, 2 when it is only known at runtime
+static int literalSign(const Expr *expr) {
+  bool negate = false;
+  if (auto *un = nodeCast<UnaryExpr>(expr)) {
+    if (un->op != UnaryOp::NEGATE) {
+      return 2;
+    }
+    negate = true;
+    expr = un->operand.get();
+  }
+  auto *lit = nodeCast<LiteralExpr>(expr);
+  if (!lit) {
+    return 2;
+  }
+  double value;
+  if (auto *i = std::get_if<int64_t>(&lit->value)) {
+    value = static_cast<double>(*i);
+  } else if (auto *d = std::get_if<double>(&lit->value)) {
+    value = *d;
+  } else {
+    return 2;
+  }
+  if (negate) {
+    value = -value;
+  }
+  return value > 0 ? 1 : (value < 0 ? -1 : 0);
+}
+
+// magnitude of an integer literal step, 0 when it is only known at runtime
+static uint64_t literalStepMagnitude(const Expr *expr) {
+  if (auto *un = nodeCast<UnaryExpr>(expr)) {
+    expr = un->operand.get();
+  }
+  auto *lit = nodeCast<LiteralExpr>(expr);
+  const int64_t *value = lit ? std::get_if<int64_t>(&lit->value) : nullptr;
+  if (!value) {
+    return 0;
+  }
+  return *value < 0 ? 0 - static_cast<uint64_t>(*value)
+                    : static_cast<uint64_t>(*value);
+}
+
+// lua semantics: start, limit and step are evaluated once, the loop and
+// its variable are int64_t when start and step are integral, and the body
+// works on its own copy of the counter
 void Compiler::compileForStmt(const ForStmt *forStmt) {
-  pushScope();
-  
-  symbolTable[forStmt->varName] = {ValueType::NUMBER, false, true, false, false};
+  const Expr *start = forStmt->start.get();
+  const Expr *end = forStmt->end.get();
+  const Expr *step = forStmt->step.get();
+
+  auto isIntegral = [&](const Expr *expr) {
+    return isIntegerConstant(expr) || inferExprType(expr) == ValueType::INT;
+  };
+
+  int stepSign = step ? literalSign(step) : 1;
+  if (stepSign == 0) {
+    error("'for' step is zero", forStmt->line);
+    return;
+  }
 
-  output += indent() + "for (double " + forStmt->varName + " = ";
-  output += compileExpr(forStmt->start.get());
-  output += "; " + forStmt->varName + " <= ";
-  output += compileExpr(forStmt->end.get());
-  output += "; " + forStmt->varName + " += ";
+  bool integral = isIntegral(start) && (!step || isIntegral(step));
+  std::string counterType = integral ? "int64_t" : "double";
+  std::string counter = "__" + forStmt->varName;
 
-  if (forStmt->step) {
-    output += compileExpr(forStmt->step.get());
-  } else {
-    output += "1.0";
+  auto compileBound = [&](const Expr *expr) {
+    if (!integral) {
+      return compileExpr(expr, ValueType::NUMBER);
+    }
+    return isIntegerConstant(expr) ? compileIntConstant(expr)
+                                   : compileExpr(expr, ValueType::INT);
+  };
+  auto isConstant = [&](const Expr *expr) {
+    return isIntegerConstant(expr) || nodeCast<LiteralExpr>(expr);
+  };
+
+  // bounds that are not constants are evaluated once into temporaries, in
+  // source order: start, limit, step, for int and float loops alike
+  std::vector<std::string> temporaries;
+  auto temporary = [&](const std::string &type, const std::string &name,
+                       const std::string &value) {
+    temporaries.push_back("const " + type + " " + name + " = " + value + ";");
+    return name;
+  };
+
+  std::string startValue = compileBound(start);
+  if (!isConstant(start)) {
+    startValue = temporary(counterType, counter + "_start", startValue);
   }
 
-  output += ") {\n";
+  // a float limit of an integer loop is floored, or ceiled when counting
+  // down, once the step is known
+  bool floatLimit = integral && !isIntegral(end);
+  std::string limitValue = floatLimit ? compileExpr(end, ValueType::NUMBER)
+                                      : compileBound(end);
+  if (!isConstant(end)) {
+    limitValue = temporary(floatLimit ? "double" : counterType,
+                           counter + "_limit", limitValue);
+  }
+
+  std::string stepValue = integral ? "1" : "1.0";
+  if (step) {
+    stepValue = compileBound(step);
+    if (stepSign == 2) {
+      stepValue = temporary(counterType, counter + "_step", stepValue);
+    }
+  }
+
+  if (floatLimit) {
+    limitValue = temporary(counterType, counter + "_last",
+                           "hl_for_limit(" + limitValue + ", " + stepValue + ")");
+  }
 
+  if (!temporaries.empty()) {
+    output += indent() + "{\n";
+    indentLevel++;
+    for (const auto &line : temporaries) {
+      output += indent() + line + "\n";
+    }
+    if (stepSign == 2) {
+      output += indent() + "if (" + stepValue +
+                " == 0) hl_error_for_step_zero();\n";
+    }
+  }
+
+  if (integral) {
+    // the iteration count is taken up front in unsigned arithmetic, so the
+    // counter never steps past the limit and cannot overflow near the ends
+    // of the int64 range
+    std::string up = "(uint64_t)" + limitValue + " - (uint64_t)" + startValue;
+    std::string down = "(uint64_t)" + startValue + " - (uint64_t)" + limitValue;
+    uint64_t magnitude = step ? literalStepMagnitude(step) : 1;
+    auto divided = [&](const std::string &distance, const std::string &by) {
+      return by.empty() ? distance : "(" + distance + ") / " + by;
+    };
+    std::string by = magnitude == 1 ? "" : std::to_string(magnitude) + "u";
+
+    std::string guard;
+    std::string count;
+    if (stepSign == 1) {
+      guard = startValue + " <= " + limitValue;
+      count = divided(up, by);
+    } else if (stepSign == -1) {
+      guard = startValue + " >= " + limitValue;
+      count = divided(down, by);
+    } else {
+      guard = "(" + stepValue + " > 0 ? " + startValue + " <= " + limitValue +
+              " : " + startValue + " >= " + limitValue + ")";
+      count = "(" + stepValue + " > 0 ? " +
+              divided(up, "(uint64_t)" + stepValue) + " : " +
+              divided(down, "((uint64_t)(-(" + stepValue + " + 1)) + 1u)") +
+              ")";
+    }
+
+    output += indent() + "if (" + guard + ") {\n";
+    indentLevel++;
+    output += indent() + "uint64_t " + counter + "_count = " + count + ";\n";
+    output += indent() + "for (int64_t " + counter + " = " + startValue +
+              ";; " + counter + " += " + stepValue + ") {\n";
+  } else {
+    std::string condition;
+    if (stepSign == 1) {
+      condition = counter + " <= " + limitValue;
+    } else if (stepSign == -1) {
+      condition = counter + " >= " + limitValue;
+    } else {
+      condition = "(" + stepValue + " > 0 ? " + counter + " <= " +
+                  limitValue + " : " + counter + " >= " + limitValue + ")";
+    }
+    output += indent() + "for (double " + counter + " = " + startValue +
+              "; " + condition + "; " + counter + " += " + stepValue +
+              ") {\n";
+  }
+
+  pushScope();
   indentLevel++;
 
+  symbolTable[forStmt->varName] = {integral ? ValueType::INT : ValueType::NUMBER,
+                                   false, true, false, false};
+  output += indent() + counterType + " " + forStmt->varName + " = " + counter +
+            ";\n";
+
+  openOwnedBlock();
   for (const auto &stmt : forStmt->body) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileStatement(stmt.get());
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
+  }
+  closeOwnedBlock();
+
+  if (integral) {
+    output += indent() + "if (" + counter + "_count-- == 0) break;\n";
   }
 
   indentLevel--;
@@ -264,6 +433,16 @@ void Compiler::compileForStmt(const ForStmt *forStmt) {
 
   symbolTable.erase(forStmt->varName);
   popScope();
+
+  if (integral) {
+    indentLevel--;
+    output += indent() + "}\n";
+  }
+
+  if (!temporaries.empty()) {
+    indentLevel--;
+    output += indent() + "}\n";
+  }
 }
 
 void Compiler::compileRepeatStmt(const RepeatStmt *repeatStmt) {
@@ -273,17 +452,26 @@ void Compiler::compileRepeatStmt(const RepeatStmt *repeatStmt) {
 
   indentLevel++;
 
+  output.openSection();
+  openOwnedBlock();
   for (const auto &stmt : repeatStmt->body) {
-    std::string savedOutput = output;
-    output = "";
+    output.openSection();
     compileStatement(stmt.get());
-    savedOutput += output;
-    output = savedOutput;
+    output.closeSection();
+  }
+  closeOwnedBlock();
+  CodeBuffer body = output.takeSection();
+
+  // the condition of the previous iteration is released before the body
+  // runs, so a return inside the body finds no temporaries of it
+  std::string condition = compileExpr(repeatStmt->condition.get());
+  if (statementScratch) {
+    output += indent() + "hl_scratch_restore(__scratch);\n";
   }
+  output += std::move(body);
 
   indentLevel--;
-  output += indent() + "} while (!(" +
-            compileExpr(repeatStmt->condition.get()) + "));\n";
+  output += indent() + "} while (!(" + condition + "));\n";
 
   popScope();
 }
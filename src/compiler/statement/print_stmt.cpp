@@ -56,42 +56,36 @@ void Compiler::compilePrintStmt(const PrintStmt *print) {
                   arg.identifier + ");";
       }
     } else if (arg.expression) {
+      // printed strings are dead once the statement has run
+      StringLifetime lifetime(*this, true);
       std::string expr = compileExpr(arg.expression.get());
       ValueType type = inferExprType(arg.expression.get());
       
-      if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(arg.expression.get())) {
-        if (auto *varExpr = dynamic_cast<const VarExpr *>(fieldAccess->object.get())) {
+      if (auto *fieldAccess = nodeCast<FieldAccessExpr>(arg.expression.get())) {
+        if (auto *varExpr = nodeCast<VarExpr>(fieldAccess->object.get())) {
           if (classTable.count(varExpr->name) > 0) {
             const auto &classInfo = classTable.at(varExpr->name);
-            bool isStaticField = false;
+            const MemberInfo *field = classInfo.findField(fieldAccess->fieldName);
             
-            for (const auto &field : classInfo.fields) {
-              if (field.name == fieldAccess->fieldName && field.isStatic) {
-                isStaticField = true;
-                type = field.type;
-                break;
-              }
-            }
-            
-            if (isStaticField) {
-              std::string fieldName = varExpr->name + "_" + fieldAccess->fieldName;
-              output += "hl_print_" + typeToString(type) + "_no_newline(" + fieldName + ");";
+            if (field && field->isStatic) {
+              type = field->type;
+              output += "hl_print_" + typeToString(type) + "_no_newline(" + field->cName + ");";
               continue;
             }
           }
         }
       }
 
-      if (auto *binExpr = dynamic_cast<const BinaryExpr *>(arg.expression.get())) {
+      if (auto *binExpr = nodeCast<BinaryExpr>(arg.expression.get())) {
         if (binExpr->op == BinaryOp::CONCAT) {
           output += "hl_print_string_no_newline(" + expr + ");";
           continue;
         }
       }
 
-      if (auto *methodCall = dynamic_cast<const MethodCall *>(arg.expression.get())) {
+      if (auto *methodCall = nodeCast<MethodCall>(arg.expression.get())) {
         std::string className = "";
-        if (auto *varExpr = dynamic_cast<const VarExpr *>(methodCall->object.get())) {
+        if (auto *varExpr = nodeCast<VarExpr>(methodCall->object.get())) {
           if (classTable.count(varExpr->name)) {
             className = varExpr->name;
           }
@@ -99,22 +93,21 @@ void Compiler::compilePrintStmt(const PrintStmt *print) {
         
         if (!className.empty()) {
           const auto &classInfo = classTable.at(className);
-          auto it = classInfo.methodInfo.find(methodCall->methodName);
-          if (it != classInfo.methodInfo.end()) {
-            type = it->second.first;
+          if (const MemberInfo *method = classInfo.findMethod(methodCall->methodName)) {
+            type = method->type;
           }
         }
       }
 
       bool isOptional = false;
-      if (auto *varExpr = dynamic_cast<const VarExpr *>(arg.expression.get())) {
+      if (auto *varExpr = nodeCast<VarExpr>(arg.expression.get())) {
         if (symbolTable.count(varExpr->name)) {
           isOptional = symbolTable[varExpr->name].isOptional;
         }
-      } else if (auto *unwrap = dynamic_cast<const ForceUnwrapExpr *>(
+      } else if (auto *unwrap = nodeCast<ForceUnwrapExpr>(
                    arg.expression.get())) {
         if (auto *innerVar =
-                dynamic_cast<const VarExpr *>(unwrap->operand.get())) {
+                nodeCast<VarExpr>(unwrap->operand.get())) {
           if (symbolTable.count(innerVar->name)) {
             isOptional = symbolTable[innerVar->name].isOptional;
           }
@@ -135,11 +128,11 @@ void Compiler::compilePrintStmt(const PrintStmt *print) {
 }
 
 bool Compiler::validateExprForPrint(const Expr *expr) {
-  if (auto *var = dynamic_cast<const VarExpr *>(expr)) {
+  if (auto *var = nodeCast<VarExpr>(expr)) {
     if (!checkVariable(var->name)) {
       return false;
     }
-  } else if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
+  } else if (auto *call = nodeCast<FunctionCall>(expr)) {
     if (!checkFunction(call->name)) {
       if (call->name != "tostring" && call->name != "tonumber" && 
           call->name != "type") {
@@ -151,17 +144,23 @@ bool Compiler::validateExprForPrint(const Expr *expr) {
         return false;
       }
     }
-  } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
-    if (!validateExprForPrint(bin->left.get()) || !validateExprForPrint(bin->right.get())) {
+  } else if (auto *bin = nodeCast<BinaryExpr>(expr)) {
+    auto spine = leftSpine(bin);
+    if (!validateExprForPrint(spine.back()->left.get())) {
       return false;
     }
-  } else if (auto *lit = dynamic_cast<const LiteralExpr *>(expr)) {
+    for (auto it = spine.rbegin(); it != spine.rend(); ++it) {
+      if (!validateExprForPrint((*it)->right.get())) {
+        return false;
+      }
+    }
+  } else if (auto *lit = nodeCast<LiteralExpr>(expr)) {
     return true;
-  } else if (auto *un = dynamic_cast<const UnaryExpr *>(expr)) {
+  } else if (auto *un = nodeCast<UnaryExpr>(expr)) {
     if (!validateExprForPrint(un->operand.get())) {
       return false;
     }
-  } else if (auto *structCons = dynamic_cast<const StructConstructor *>(expr)) {
+  } else if (auto *structCons = nodeCast<StructConstructor>(expr)) {
     for (const auto &arg : structCons->positionalArgs) {
       if (!validateExprForPrint(arg.get())) {
         return false;
@@ -172,7 +171,7 @@ bool Compiler::validateExprForPrint(const Expr *expr) {
         return false;
       }
     }
-  } else if (dynamic_cast<const NilExpr *>(expr)) {
+  } else if (nodeCast<NilExpr>(expr)) {
     return true;
   }
   return true;
@@ -1,4 +1,5 @@
 #include "../../../include/compiler/compiler.h"
+#include <utility>
 
 namespace HolyLua {
 
@@ -6,45 +7,119 @@ void Compiler::compileStatement(const ASTNode *node) {
   if (!node)
     return;
 
-  if (auto *decl = dynamic_cast<const VarDecl *>(node)) {
-    compileVarDecl(decl);
-  } else if (auto *func = dynamic_cast<const FunctionDecl *>(node)) {
-    compileFunctionDecl(func);
-  } else if (auto *ret = dynamic_cast<const ReturnStmt *>(node)) {
-    compileReturnStmt(ret);
-  } else if (auto *assign = dynamic_cast<const Assignment *>(node)) {
-    compileAssignment(assign);
-  } else if (auto *fieldAssign = dynamic_cast<const FieldAssignment *>(node)) {
-    compileFieldAssignment(fieldAssign);
-  } else if (auto *print = dynamic_cast<const PrintStmt *>(node)) {
-    compilePrintStmt(print);
-  } else if (auto *ifStmt = dynamic_cast<const IfStmt *>(node)) {
-    compileIfStmt(ifStmt);
-  } else if (auto *call = dynamic_cast<const FunctionCall *>(node)) {
+  bool enclosingStatement = std::exchange(statementScratch, false);
+  bool enclosingAny =
+      std::exchange(enclosingScratch, enclosingScratch || enclosingStatement);
+
+  switch (node->kind) {
+  case NodeKind::VAR_DECL:
+    compileVarDecl(static_cast<const VarDecl *>(node));
+    break;
+  case NodeKind::FUNCTION_DECL:
+    compileFunctionDecl(static_cast<const FunctionDecl *>(node));
+    break;
+  case NodeKind::RETURN:
+    compileReturnStmt(static_cast<const ReturnStmt *>(node));
+    break;
+  case NodeKind::ASSIGNMENT:
+    compileAssignment(static_cast<const Assignment *>(node));
+    break;
+  case NodeKind::FIELD_ASSIGNMENT:
+    compileFieldAssignment(static_cast<const FieldAssignment *>(node));
+    break;
+  case NodeKind::PRINT:
+    compilePrintStmt(static_cast<const PrintStmt *>(node));
+    break;
+  case NodeKind::IF:
+    compileIfStmt(static_cast<const IfStmt *>(node));
+    break;
+  case NodeKind::FUNCTION_CALL: {
+    auto *call = static_cast<const FunctionCall *>(node);
     std::string result = compileFunctionCall(call);
     if (!result.empty()) {
-      output += indent() + result + ";\n";
+      output += indent() + discardResult(call, result) + "\n";
     }
-  } else if (auto *methodCall = dynamic_cast<const MethodCall *>(node)) {
-    std::string result = compileMethodCall(methodCall);
+    break;
+  }
+  case NodeKind::METHOD_CALL: {
+    auto *call = static_cast<const MethodCall *>(node);
+    std::string result = compileMethodCall(call);
     if (!result.empty()) {
-      output += indent() + result + ";\n";
+      output += indent() + discardResult(call, result) + "\n";
     }
-  } else if (auto *inlineC = dynamic_cast<const InlineCStmt *>(node)) {
-    compileInlineCStmt(inlineC);
-  } else if (auto *whileStmt = dynamic_cast<const WhileStmt *>(node)) {
-    compileWhileStmt(whileStmt);
-  } else if (auto *forStmt = dynamic_cast<const ForStmt *>(node)) {
-    compileForStmt(forStmt);
-  } else if (auto *repeatStmt = dynamic_cast<const RepeatStmt *>(node)) {
-    compileRepeatStmt(repeatStmt);
-  } else if (auto *structDecl = dynamic_cast<const StructDecl *>(node)) {
-    compileStructDecl(structDecl);
-  } else if (auto *classDecl = dynamic_cast<const ClassDecl *>(node)) {
-    compileClassDecl(classDecl);
-  } else if (auto *enumDecl = dynamic_cast<const EnumDecl *>(node)) {
-    compileEnumDecl(enumDecl);
+    break;
+  }
+  case NodeKind::INLINE_C:
+    compileInlineCStmt(static_cast<const InlineCStmt *>(node));
+    break;
+  case NodeKind::WHILE:
+    compileWhileStmt(static_cast<const WhileStmt *>(node));
+    break;
+  case NodeKind::FOR:
+    compileForStmt(static_cast<const ForStmt *>(node));
+    break;
+  case NodeKind::REPEAT:
+    compileRepeatStmt(static_cast<const RepeatStmt *>(node));
+    break;
+  case NodeKind::STRUCT_DECL:
+    compileStructDecl(static_cast<const StructDecl *>(node));
+    break;
+  case NodeKind::CLASS_DECL:
+    compileClassDecl(static_cast<const ClassDecl *>(node));
+    break;
+  case NodeKind::ENUM_DECL:
+    compileEnumDecl(static_cast<const EnumDecl *>(node));
+    break;
+  default:
+    break;
+  }
+
+  // a return releases its own temporaries before leaving
+  if (node->kind != NodeKind::RETURN) {
+    releaseStatementScratch();
+  }
+  statementScratch = enclosingStatement;
+  enclosingScratch = enclosingAny;
+  returned = node->kind == NodeKind::RETURN;
+}
+
+// temporaries of a statement are dead once it has run. releasing back to
+// the mark of the function keeps those of its callers alive
+void Compiler::releaseStatementScratch() {
+  if (statementScratch) {
+    output += indent() + "hl_scratch_restore(__scratch);\n";
+    statementScratch = false;
+  }
+}
+
+// the statements of a function body go into their own section so the mark
+// can be declared in front of them once one of them needed it
+Compiler::ScratchState Compiler::beginFunctionBody() {
+  ScratchState enclosing{scratchStrings, statementScratch, functionScratch,
+                         enclosingScratch, std::move(ownedLocals)};
+  scratchStrings = false;
+  statementScratch = false;
+  functionScratch = false;
+  enclosingScratch = false;
+  ownedLocals.clear();
+  openOwnedBlock();
+  returned = false;
+  output.openSection();
+  return enclosing;
+}
+
+void Compiler::endFunctionBody(ScratchState &enclosing) {
+  closeOwnedBlock();
+  CodeBuffer body = output.takeSection();
+  if (functionScratch) {
+    output += indent() + "hl_scratch_mark __scratch = hl_scratch_save();\n";
   }
+  output += std::move(body);
+  scratchStrings = enclosing.strings;
+  statementScratch = enclosing.statement;
+  functionScratch = enclosing.function;
+  enclosingScratch = enclosing.enclosing;
+  ownedLocals = std::move(enclosing.owned);
 }
 
 void Compiler::compileInlineCStmt(const InlineCStmt *stmt) {
@@ -0,0 +1,88 @@
+#include "../../../include/compiler/code_buffer.h"
+#include <iterator>
+
+namespace HolyLua {
+
+CodeBuffer &CodeBuffer::operator+=(const std::string &text) {
+  if (text.empty()) {
+    return *this;
+  }
+  if (chunks.empty()) {
+    chunks.push_back(text);
+  } else {
+    chunks.back() += text;
+  }
+  length += text.size();
+  return *this;
+}
+
+CodeBuffer &CodeBuffer::operator+=(CodeBuffer &&other) {
+  chunks.insert(chunks.end(), std::make_move_iterator(other.chunks.begin()),
+                std::make_move_iterator(other.chunks.end()));
+  length += other.length;
+  other.clear();
+  return *this;
+}
+
+CodeBuffer &CodeBuffer::operator=(const std::string &text) {
+  chunks.clear();
+  length = 0;
+  return *this += text;
+}
+
+void CodeBuffer::clear() {
+  chunks.clear();
+  length = 0;
+}
+
+void CodeBuffer::openSection() {
+  enclosing.push_back({std::move(chunks), length});
+  chunks.clear();
+  length = 0;
+}
+
+void CodeBuffer::closeSection() {
+  std::vector<std::string> section = std::move(chunks);
+  std::size_t sectionLength = length;
+  restoreEnclosing();
+
+  chunks.insert(chunks.end(), std::make_move_iterator(section.begin()),
+                std::make_move_iterator(section.end()));
+  length += sectionLength;
+}
+
+CodeBuffer CodeBuffer::takeSection() {
+  CodeBuffer section;
+  section.chunks = std::move(chunks);
+  section.length = length;
+  restoreEnclosing();
+  return section;
+}
+
+void CodeBuffer::restoreEnclosing() {
+  if (enclosing.empty()) {
+    chunks.clear();
+    length = 0;
+    return;
+  }
+  chunks = std::move(enclosing.back().chunks);
+  length = enclosing.back().length;
+  enclosing.pop_back();
+}
+
+std::string CodeBuffer::str() const {
+  std::string result;
+  result.reserve(length);
+  for (const auto &chunk : chunks) {
+    result += chunk;
+  }
+  return result;
+}
+
+void CodeBuffer::writeTo(std::ostream &out) const {
+  for (const auto &chunk : chunks) {
+    out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+  }
+}
+
+} // namespace HolyLua
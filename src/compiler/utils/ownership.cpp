@@ -0,0 +1,356 @@
+#include "../../../include/compiler/compiler.h"
+
+namespace HolyLua {
+
+// every variable and field owns the strings it holds: a fresh value
+// (concatenation, tostring, a call or constructor) moves into its slot,
+// anything else is copied, and the old value is freed on overwrite. struct
+// values own the strings of their fields and get drop / clone / adopt
+// helpers generated next to their definition
+
+// string and owning struct fields of a struct or class, in layout order.
+// the second element is the struct type, empty for a string
+void Compiler::ownedFields(
+    const std::string &typeName,
+    std::vector<std::pair<std::string, std::string>> &fields) {
+  auto add = [&](const std::string &name, ValueType type,
+                 const std::string &structType) {
+    if (type == ValueType::STRING) {
+      fields.push_back({name, ""});
+    } else if (type == ValueType::STRUCT && ownsStrings(structType)) {
+      fields.push_back({name, structType});
+    }
+  };
+
+  auto classIt = classTable.find(typeName);
+  if (classIt != classTable.end()) {
+    for (const auto &field : classIt->second.fields) {
+      if (!field.isStatic) {
+        add(field.name, field.type, field.structTypeName);
+      }
+    }
+    return;
+  }
+  auto structIt = structTable.find(typeName);
+  if (structIt != structTable.end()) {
+    for (const auto &field : structIt->second.fields) {
+      add(field.name, field.type, field.structTypeName);
+    }
+  }
+}
+
+bool Compiler::ownsStrings(const std::string &typeName) {
+  if (typeName.empty()) {
+    return false;
+  }
+  std::vector<std::pair<std::string, std::string>> fields;
+  ownedFields(typeName, fields);
+  return !fields.empty();
+}
+
+std::string Compiler::ownershipHelpers(const std::string &typeName) {
+  std::vector<std::pair<std::string, std::string>> fields;
+  ownedFields(typeName, fields);
+  if (fields.empty()) {
+    return "";
+  }
+
+  std::string drop = "static inline void " + typeName + "__drop(const " +
+                     typeName + "* value) {\n";
+  std::string clone = "static inline " + typeName + " " + typeName +
+                      "__clone(" + typeName + " value) {\n";
+  std::string adopt = "static inline " + typeName + " " + typeName +
+                      "__adopt(" + typeName + " value) {\n";
+  for (const auto &field : fields) {
+    const std::string &name = field.first;
+    const std::string &type = field.second;
+    if (type.empty()) {
+      drop += "    hl_free_string(value->" + name + ");\n";
+      clone += "    value." + name + " = hl_string_copy(value." + name + ");\n";
+      adopt += "    hl_scratch_adopt(value." + name + ");\n";
+    } else {
+      drop += "    " + type + "__drop(&value->" + name + ");\n";
+      clone += "    value." + name + " = " + type + "__clone(value." + name +
+               ");\n";
+      adopt += "    " + type + "__adopt(value." + name + ");\n";
+    }
+  }
+  drop += "}\n\n";
+  clone += "    return value;\n}\n\n";
+  adopt += "    return value;\n}\n\n";
+  return drop + clone + adopt;
+}
+
+// struct type of a struct value, when that type owns strings
+std::string Compiler::ownedStructType(const Expr *expr) {
+  std::string typeName;
+  if (auto *var = nodeCast<VarExpr>(expr)) {
+    if (symbolTable.count(var->name) &&
+        symbolTable[var->name].type == ValueType::STRUCT) {
+      typeName = symbolTable[var->name].structTypeName;
+    }
+  } else if (nodeCast<SelfExpr>(expr)) {
+    typeName = currentClass;
+  } else if (auto *call = nodeCast<MethodCall>(expr)) {
+    // methods return instances of their own class
+    if (resolveExprType(call, typeName) == ValueType::STRUCT) {
+      typeName.clear();
+      if (auto *object = nodeCast<VarExpr>(call->object.get())) {
+        if (classTable.count(object->name)) {
+          typeName = object->name;
+        } else if (symbolTable.count(object->name)) {
+          typeName = symbolTable[object->name].structTypeName;
+        }
+      } else {
+        typeName = currentClass;
+      }
+    }
+  } else if (resolveExprType(expr, typeName) != ValueType::STRUCT) {
+    typeName.clear();
+  }
+  return ownsStrings(typeName) ? typeName : "";
+}
+
+bool Compiler::isFreshString(const Expr *expr) {
+  if (auto *bin = nodeCast<BinaryExpr>(expr)) {
+    return bin->op == BinaryOp::CONCAT;
+  }
+  if (auto *call = nodeCast<FunctionCall>(expr)) {
+    if (call->name == "tostring") {
+      return true;
+    }
+    auto it = functionTable.find(call->name);
+    return it != functionTable.end() &&
+           it->second.returnType == ValueType::STRING;
+  }
+  if (nodeCast<MethodCall>(expr)) {
+    return inferExprType(expr) == ValueType::STRING;
+  }
+  return false;
+}
+
+bool Compiler::isFreshStruct(const Expr *expr) {
+  return nodeCast<StructConstructor>(expr) ||
+         nodeCast<ClassInstantiation>(expr) || nodeCast<MethodCall>(expr);
+}
+
+// a value stored into a slot that owns it
+std::string Compiler::compileOwned(const Expr *expr, ValueType slotType,
+                                   const std::string &structType) {
+  if (nodeCast<NilExpr>(expr)) {
+    return compileExpr(expr, slotType);
+  }
+
+  if (slotType == ValueType::STRING ||
+      (slotType != ValueType::STRUCT &&
+       inferExprType(expr) == ValueType::STRING)) {
+    if (isFreshString(expr)) {
+      StringLifetime lifetime(*this, false);
+      return compileExpr(expr, slotType);
+    }
+    StringLifetime lifetime(*this, true);
+    return "hl_string_copy(" + compileExpr(expr, slotType) + ")";
+  }
+
+  std::string typeName =
+      structType.empty() ? ownedStructType(expr) : structType;
+  if (!ownsStrings(typeName) || isFreshStruct(expr)) {
+    StringLifetime lifetime(*this, false);
+    return compileExpr(expr, slotType);
+  }
+  StringLifetime lifetime(*this, true);
+  return typeName + "__clone(" + compileExpr(expr, slotType) + ")";
+}
+
+// a call or constructor result that is only looked at: its strings are
+// handed to the scratch region and die with the statement
+std::string Compiler::adoptTemporary(const Expr *expr,
+                                     const std::string &value) {
+  if (!scratchStrings || value.empty()) {
+    return value;
+  }
+  // tostring() builds its scratch variant instead
+  auto *call = nodeCast<FunctionCall>(expr);
+  bool userCall =
+      nodeCast<MethodCall>(expr) || (call && call->name != "tostring");
+
+  std::string adopted;
+  if (userCall && isFreshString(expr)) {
+    adopted = "hl_scratch_adopt(" + value + ")";
+  } else if (isFreshStruct(expr)) {
+    std::string typeName = ownedStructType(expr);
+    if (!typeName.empty()) {
+      adopted = typeName + "__adopt(" + value + ")";
+    }
+  }
+  if (adopted.empty()) {
+    return value;
+  }
+  statementScratch = functionScratch = true;
+  return adopted;
+}
+
+// replaces the value of a slot that owns its strings
+std::string Compiler::storeOwned(const std::string &slot,
+                                 const std::string &value, ValueType slotType,
+                                 const std::string &structType) {
+  if (slotType == ValueType::STRING) {
+    return "hl_string_set(&" + slot + ", " + value + ");\n";
+  }
+  if (ownsStrings(structType)) {
+    return "{ " + structType + " __old = " + slot + "; " + slot + " = " +
+           value + "; " + structType + "__drop(&__old); }\n";
+  }
+  return slot + " = " + value + ";\n";
+}
+
+std::string Compiler::releaseCode(const OwnedLocal &local) {
+  if (local.structType.empty()) {
+    return "hl_free_string(" + local.name + ");\n";
+  }
+  return local.structType + "__drop(&" + local.name + ");\n";
+}
+
+void Compiler::ownLocal(const std::string &name,
+                        const std::string &structType) {
+  if (!ownedLocals.empty()) {
+    ownedLocals.back().push_back({name, structType});
+  }
+}
+
+// innermost owned local of that name, it shadows any outer one
+const Compiler::OwnedLocal *
+Compiler::findOwnedLocal(const std::string &name) {
+  for (auto block = ownedLocals.rbegin(); block != ownedLocals.rend();
+       ++block) {
+    for (auto local = block->rbegin(); local != block->rend(); ++local) {
+      if (local->name == name) {
+        return &*local;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void Compiler::openOwnedBlock() {
+  ownedLocals.emplace_back();
+  returned = false;
+}
+
+// a block ending in a return released its locals there already
+void Compiler::closeOwnedBlock() {
+  if (ownedLocals.empty()) {
+    return;
+  }
+  if (!returned) {
+    const auto &block = ownedLocals.back();
+    for (auto local = block.rbegin(); local != block.rend(); ++local) {
+      output += indent() + releaseCode(*local);
+    }
+  }
+  ownedLocals.pop_back();
+}
+
+// everything the function owns, for a return
+std::string Compiler::releaseOwnedLocals(const std::string &lineIndent,
+                                         const OwnedLocal *keep) {
+  std::string code;
+  for (auto block = ownedLocals.rbegin(); block != ownedLocals.rend();
+       ++block) {
+    for (auto local = block->rbegin(); local != block->rend(); ++local) {
+      if (&*local != keep) {
+        code += lineIndent + releaseCode(*local);
+      }
+    }
+  }
+  return code;
+}
+
+// an expression statement: a fresh result nobody looks at is freed
+std::string Compiler::discardResult(const Expr *expr,
+                                    const std::string &value) {
+  if (isFreshString(expr)) {
+    return "hl_free_string(" + value + ");";
+  }
+  if (isFreshStruct(expr)) {
+    std::string typeName = ownedStructType(expr);
+    if (!typeName.empty()) {
+      return "{ " + typeName + " __discarded = " + value + "; " + typeName +
+             "__drop(&__discarded); }";
+    }
+  }
+  return value + ";";
+}
+
+static bool isRootedAt(const Expr *expr, const std::string &name) {
+  while (auto *access = nodeCast<FieldAccessExpr>(expr)) {
+    expr = access->object.get();
+  }
+  auto *var = nodeCast<VarExpr>(expr);
+  return var && var->name == name;
+}
+
+static bool writesVariable(const std::vector<std::unique_ptr<ASTNode>> &body,
+                           const std::string &name) {
+  for (const auto &stmt : body) {
+    if (auto *assign = nodeCast<Assignment>(stmt.get())) {
+      if (assign->name == name) {
+        return true;
+      }
+    } else if (auto *assign = nodeCast<FieldAssignment>(stmt.get())) {
+      if (isRootedAt(assign->object.get(), name)) {
+        return true;
+      }
+    } else if (auto *ifStmt = nodeCast<IfStmt>(stmt.get())) {
+      if (writesVariable(ifStmt->thenBlock, name) ||
+          writesVariable(ifStmt->elseBlock, name)) {
+        return true;
+      }
+      for (const auto &branch : ifStmt->elseifBranches) {
+        if (writesVariable(branch.second, name)) {
+          return true;
+        }
+      }
+    } else if (auto *whileStmt = nodeCast<WhileStmt>(stmt.get())) {
+      if (writesVariable(whileStmt->body, name)) {
+        return true;
+      }
+    } else if (auto *forStmt = nodeCast<ForStmt>(stmt.get())) {
+      if (writesVariable(forStmt->body, name)) {
+        return true;
+      }
+    } else if (auto *repeatStmt = nodeCast<RepeatStmt>(stmt.get())) {
+      if (writesVariable(repeatStmt->body, name)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// parameters are borrowed from the caller. one the body writes to is
+// copied on entry and owned like a local
+void Compiler::ownAssignedParameters(
+    const std::vector<std::unique_ptr<ASTNode>> &body,
+    const std::vector<std::pair<std::string, ValueType>> &params) {
+  for (const auto &param : params) {
+    if (!symbolTable.count(param.first) ||
+        !writesVariable(body, param.first)) {
+      continue;
+    }
+    const Variable &var = symbolTable[param.first];
+    if (var.type == ValueType::STRING) {
+      output += indent() + param.first + " = hl_string_copy(" + param.first +
+                ");\n";
+      ownLocal(param.first);
+    } else if (var.type == ValueType::STRUCT &&
+               ownsStrings(var.structTypeName)) {
+      std::string typeName = var.structTypeName;
+      output += indent() + param.first + " = " + typeName + "__clone(" +
+                param.first + ");\n";
+      ownLocal(param.first, typeName);
+    }
+  }
+}
+
+} // namespace HolyLua
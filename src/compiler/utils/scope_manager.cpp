@@ -2,14 +2,15 @@
 
 namespace HolyLua {
 
+// the enclosing scope's facts are moved onto the stack, never copied
 void Compiler::pushScope() {
-  nonNilVarStack.push_back(nonNilVars);
+  nonNilVarStack.push_back(std::move(nonNilVars));
   nonNilVars.clear();
 }
 
 void Compiler::popScope() {
   if (!nonNilVarStack.empty()) {
-    nonNilVars = nonNilVarStack.back();
+    nonNilVars = std::move(nonNilVarStack.back());
     nonNilVarStack.pop_back();
   }
 }
@@ -42,12 +43,26 @@ bool Compiler::checkFunction(const std::string &name) {
   return functionTable.count(name) > 0;
 }
 
+// an int takes ints and integer constants, a number never narrows silently
+bool Compiler::checkIntValue(ValueType target, ValueType valueType,
+                             const Expr *value, const std::string &name,
+                             int line) {
+  if (target != ValueType::INT || valueType == ValueType::INT ||
+      valueType == ValueType::INFERRED || isIntegerConstant(value)) {
+    return true;
+  }
+  error("Type mismatch: cannot assign " + typeToString(valueType) + " to " +
+            name + " of type int",
+        line);
+  return false;
+}
+
 bool Compiler::validateExpr(const Expr *expr) {
-  if (auto *var = dynamic_cast<const VarExpr *>(expr)) {
+  if (auto *var = nodeCast<VarExpr>(expr)) {
     if (!checkVariable(var->name)) {
       return false;
     }
-  } else if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
+  } else if (auto *call = nodeCast<FunctionCall>(expr)) {
     if (!checkFunction(call->name)) {
       return false;
     }
@@ -56,15 +71,21 @@ bool Compiler::validateExpr(const Expr *expr) {
         return false;
       }
     }
-  } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
-    if (!validateExpr(bin->left.get()) || !validateExpr(bin->right.get())) {
+  } else if (auto *bin = nodeCast<BinaryExpr>(expr)) {
+    auto spine = leftSpine(bin);
+    if (!validateExpr(spine.back()->left.get())) {
       return false;
     }
-  } else if (auto *un = dynamic_cast<const UnaryExpr *>(expr)) {
+    for (auto it = spine.rbegin(); it != spine.rend(); ++it) {
+      if (!validateExpr((*it)->right.get())) {
+        return false;
+      }
+    }
+  } else if (auto *un = nodeCast<UnaryExpr>(expr)) {
     if (!validateExpr(un->operand.get())) {
       return false;
     }
-  } else if (auto *unwrap = dynamic_cast<const ForceUnwrapExpr *>(expr)) {
+  } else if (auto *unwrap = nodeCast<ForceUnwrapExpr>(expr)) {
     if (!validateExpr(unwrap->operand.get())) {
       return false;
     }
@@ -73,21 +94,22 @@ bool Compiler::validateExpr(const Expr *expr) {
 }
 
 bool Compiler::isOptionalExpr(const Expr *expr) {
-  if (auto *var = dynamic_cast<const VarExpr *>(expr)) {
+  if (auto *var = nodeCast<VarExpr>(expr)) {
     if (symbolTable.count(var->name)) {
       return symbolTable[var->name].isOptional;
     }
-  } else if (auto *unwrap = dynamic_cast<const ForceUnwrapExpr *>(expr)) {
+  } else if (auto *unwrap = nodeCast<ForceUnwrapExpr>(expr)) {
     return isOptionalExpr(unwrap->operand.get());
-  } else if (dynamic_cast<const FunctionCall *>(expr)) {
+  } else if (nodeCast<FunctionCall>(expr)) {
     return false;
   }
   return false;
 }
 
 std::string Compiler::generateUniqueName(const std::string &base) {
-  static int counter = 0;
-  return "__lambda_" + base + "_" + std::to_string(counter++);
+  // prefixed with the codegen unit so names never depend on scheduling
+  return "__lambda_" + base + "_" + std::to_string(uniqueNameSpace) + "_" +
+         std::to_string(uniqueNameCounter++);
 }
 
 } // namespace HolyLua
\ No newline at end of file
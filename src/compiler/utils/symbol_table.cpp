@@ -0,0 +1,74 @@
+#include "../../../include/compiler/symbol_table.h"
+
+namespace HolyLua {
+
+Variable &SymbolTable::operator[](const std::string &name) {
+  auto it = entries.find(name);
+  if (it == entries.end()) {
+    record(name, nullptr);
+    it = entries.emplace(name, Entry()).first;
+  } else if (!scopes.empty() && it->second.scope != currentScope) {
+    // first touch in this scope, remember what to restore
+    record(name, &it->second);
+  }
+  it->second.scope = currentScope;
+  return it->second.var;
+}
+
+void SymbolTable::erase(const std::string &name) {
+  auto it = entries.find(name);
+  if (it == entries.end()) {
+    return;
+  }
+  if (it->second.scope != currentScope) {
+    record(name, &it->second);
+  }
+  entries.erase(it);
+}
+
+void SymbolTable::clear() {
+  if (scopes.empty()) {
+    entries.clear();
+    return;
+  }
+  for (auto &pair : entries) {
+    if (pair.second.scope != currentScope) {
+      record(pair.first, &pair.second);
+    }
+  }
+  entries.clear();
+}
+
+void SymbolTable::enterScope() {
+  scopes.emplace_back(undoLog.size(), currentScope);
+  currentScope = nextScope++;
+}
+
+void SymbolTable::exitScope() {
+  if (scopes.empty()) {
+    return;
+  }
+
+  size_t mark = scopes.back().first;
+  while (undoLog.size() > mark) {
+    UndoRecord &undo = undoLog.back();
+    if (undo.existed) {
+      entries[undo.name] = std::move(undo.previous);
+    } else {
+      entries.erase(undo.name);
+    }
+    undoLog.pop_back();
+  }
+
+  currentScope = scopes.back().second;
+  scopes.pop_back();
+}
+
+void SymbolTable::record(const std::string &name, const Entry *previous) {
+  if (scopes.empty()) {
+    return;
+  }
+  undoLog.push_back({name, previous != nullptr, previous ? *previous : Entry()});
+}
+
+} // namespace HolyLua
@@ -1,5 +1,7 @@
 #include "../../../include/compiler/compiler.h"
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
 
 namespace HolyLua {
 
@@ -23,6 +25,8 @@ std::string Compiler::getCType(ValueType type, const std::string &structTypeName
     return "char*";
   case ValueType::BOOL:
     return "int";
+  case ValueType::INT:
+    return "int64_t";
   case ValueType::INFERRED:
     return "double";
   case ValueType::FUNCTION:
@@ -61,6 +65,8 @@ std::string Compiler::typeToString(ValueType type) {
     return "string";
   case ValueType::BOOL:
     return "bool";
+  case ValueType::INT:
+    return "int";
   case ValueType::INFERRED:
     return "number";
   case ValueType::FUNCTION:
@@ -107,31 +113,33 @@ ValueType Compiler::inferType(
 
 std::string Compiler::doubleToString(double value) {
   char buffer[64];
-  
-  snprintf(buffer, sizeof(buffer), "%.9f", value);
-  
-  std::string result = buffer;
-  
-  // remove trailing zeros
-  size_t dot = result.find('.');
-  if (dot != std::string::npos) {
-    while (!result.empty() && result.back() == '0') {
-      result.pop_back();
-    }
-    if (!result.empty() && result.back() == '.') {
-      result.pop_back();
+
+  // shortest spelling that reads back as the same double
+  for (int precision = 15; precision <= 17; precision++) {
+    snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    if (strtod(buffer, nullptr) == value) {
+      break;
     }
   }
-  
+
+  std::string result = buffer;
+
+  // keep it a floating literal, "3" would make C divide as integers
+  if (result.find_first_of(".e") == std::string::npos) {
+    result += ".0";
+  }
+
   return result;
 }
 
 std::string Compiler::valueToString(
     const std::variant<int64_t, double, std::string, bool> &value) {
+  // negative literals come from constant folding, parenthesized so they
+  // never merge with a preceding '-'
   if (auto *i = std::get_if<int64_t>(&value)) {
-    return std::to_string(*i) + ".0";
+    return *i < 0 ? "(" + std::to_string(*i) + ".0)" : std::to_string(*i) + ".0";
   } else if (auto *d = std::get_if<double>(&value)) {
-    return doubleToString(*d);
+    return std::signbit(*d) ? "(" + doubleToString(*d) + ")" : doubleToString(*d);
   } else if (auto *s = std::get_if<std::string>(&value)) {
     return "\"" + *s + "\"";
   } else if (auto *b = std::get_if<bool>(&value)) {
@@ -141,17 +149,20 @@ std::string Compiler::valueToString(
 }
 
 bool Compiler::isStringExpr(const Expr *expr) {
-  if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
+  if (auto *call = nodeCast<FunctionCall>(expr)) {
     if (call->name == "tostring")
       return true;
     return false;
-  } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
-    if (bin->op == BinaryOp::CONCAT)
-      return true;
-    return isStringExpr(bin->left.get()) || isStringExpr(bin->right.get());
-  } else if (auto *lit = dynamic_cast<const LiteralExpr *>(expr)) {
+  } else if (auto *bin = nodeCast<BinaryExpr>(expr)) {
+    auto spine = leftSpine(bin);
+    for (auto *link : spine) {
+      if (link->op == BinaryOp::CONCAT || isStringExpr(link->right.get()))
+        return true;
+    }
+    return isStringExpr(spine.back()->left.get());
+  } else if (auto *lit = nodeCast<LiteralExpr>(expr)) {
     return std::holds_alternative<std::string>(lit->value);
-  } else if (auto *var = dynamic_cast<const VarExpr *>(expr)) {
+  } else if (auto *var = nodeCast<VarExpr>(expr)) {
     if (symbolTable.count(var->name)) {
       return symbolTable[var->name].type == ValueType::STRING;
     }
@@ -160,10 +171,10 @@ bool Compiler::isStringExpr(const Expr *expr) {
 }
 
 bool Compiler::isNumberExpr(const Expr *expr) {
-  if (auto *lit = dynamic_cast<const LiteralExpr *>(expr)) {
+  if (auto *lit = nodeCast<LiteralExpr>(expr)) {
     return std::holds_alternative<int64_t>(lit->value) ||
            std::holds_alternative<double>(lit->value);
-  } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
+  } else if (auto *bin = nodeCast<BinaryExpr>(expr)) {
     if (bin->op == BinaryOp::ADD || bin->op == BinaryOp::SUBTRACT ||
         bin->op == BinaryOp::MULTIPLY || bin->op == BinaryOp::DIVIDE ||
         bin->op == BinaryOp::MODULO || bin->op == BinaryOp::POWER ||
@@ -175,15 +186,15 @@ bool Compiler::isNumberExpr(const Expr *expr) {
 }
 
 bool Compiler::isBoolExpr(const Expr *expr) {
-  if (auto *lit = dynamic_cast<const LiteralExpr *>(expr)) {
+  if (auto *lit = nodeCast<LiteralExpr>(expr)) {
     return std::holds_alternative<bool>(lit->value);
-  } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
+  } else if (auto *bin = nodeCast<BinaryExpr>(expr)) {
     if (bin->op == BinaryOp::EQUAL || bin->op == BinaryOp::NOT_EQUAL ||
         bin->op == BinaryOp::LESS || bin->op == BinaryOp::LESS_EQUAL ||
         bin->op == BinaryOp::GREATER || bin->op == BinaryOp::GREATER_EQUAL) {
       return true;
     }
-  } else if (auto *un = dynamic_cast<const UnaryExpr *>(expr)) {
+  } else if (auto *un = nodeCast<UnaryExpr>(expr)) {
     return un->op == UnaryOp::NOT;
   }
   return false;
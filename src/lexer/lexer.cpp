@@ -1,46 +1,175 @@
 #include "../../include/lexer.h"
 #include <iostream>
 #include <stdexcept>
+#include <utility>
 
 namespace HolyLua {
 
-Lexer::Lexer(const std::string &source)
-    : source(source), current(0), start(0), line(1), errorCount(0) {
-  keywords["local"] = TokenType::LOCAL;
-  keywords["global"] = TokenType::GLOBAL;
-  keywords["const"] = TokenType::CONST;
-  keywords["print"] = TokenType::PRINT;
-  keywords["if"] = TokenType::IF;
-  keywords["then"] = TokenType::THEN;
-  keywords["else"] = TokenType::ELSE;
-  keywords["elseif"] = TokenType::ELSEIF;
-  keywords["end"] = TokenType::END;
-  keywords["function"] = TokenType::FUNCTION;
-  keywords["return"] = TokenType::RETURN;
-  keywords["number"] = TokenType::TYPE_NUMBER;
-  keywords["string"] = TokenType::TYPE_STRING;
-  keywords["bool"] = TokenType::TYPE_BOOL;
-  keywords["true"] = TokenType::TRUE;
-  keywords["false"] = TokenType::FALSE;
-  keywords["nil"] = TokenType::NIL;
-  keywords["and"] = TokenType::AND;
-  keywords["or"] = TokenType::OR;
-  keywords["not"] = TokenType::NOT;
-  keywords["while"] = TokenType::WHILE;
-  keywords["do"] = TokenType::DO;
-  keywords["for"] = TokenType::FOR;
-  keywords["repeat"] = TokenType::REPEAT;
-  keywords["until"] = TokenType::UNTIL;
-  keywords["inline"] = TokenType::INLINE;
-  keywords["struct"] = TokenType::STRUCT;
-  keywords["enum"] = TokenType::ENUM;
-  keywords["class"] = TokenType::CLASS;
-  keywords["public"] = TokenType::PUBLIC;
-  keywords["private"] = TokenType::PRIVATE;
-  keywords["static"] = TokenType::STATIC;
-  keywords["self"] = TokenType::SELF;
+namespace {
+
+// keywords are matched by length, then first character, then a single
+// compare. no table to build per lexer and nothing allocated per identifier.
+constexpr TokenType keywordType(std::string_view text) {
+  switch (text.size()) {
+  case 2:
+    switch (text[0]) {
+    case 'd':
+      if (text == "do")
+        return TokenType::DO;
+      break;
+    case 'i':
+      if (text == "if")
+        return TokenType::IF;
+      break;
+    case 'o':
+      if (text == "or")
+        return TokenType::OR;
+      break;
+    }
+    break;
+  case 3:
+    switch (text[0]) {
+    case 'a':
+      if (text == "and")
+        return TokenType::AND;
+      break;
+    case 'e':
+      if (text == "end")
+        return TokenType::END;
+      break;
+    case 'f':
+      if (text == "for")
+        return TokenType::FOR;
+      break;
+    case 'i':
+      if (text == "int")
+        return TokenType::TYPE_INT;
+      break;
+    case 'n':
+      if (text == "nil")
+        return TokenType::NIL;
+      if (text == "not")
+        return TokenType::NOT;
+      break;
+    }
+    break;
+  case 4:
+    switch (text[0]) {
+    case 'b':
+      if (text == "bool")
+        return TokenType::TYPE_BOOL;
+      break;
+    case 'e':
+      if (text == "else")
+        return TokenType::ELSE;
+      if (text == "enum")
+        return TokenType::ENUM;
+      break;
+    case 's':
+      if (text == "self")
+        return TokenType::SELF;
+      break;
+    case 't':
+      if (text == "then")
+        return TokenType::THEN;
+      if (text == "true")
+        return TokenType::TRUE;
+      break;
+    }
+    break;
+  case 5:
+    switch (text[0]) {
+    case 'c':
+      if (text == "const")
+        return TokenType::CONST;
+      if (text == "class")
+        return TokenType::CLASS;
+      break;
+    case 'f':
+      if (text == "false")
+        return TokenType::FALSE;
+      break;
+    case 'l':
+      if (text == "local")
+        return TokenType::LOCAL;
+      break;
+    case 'p':
+      if (text == "print")
+        return TokenType::PRINT;
+      break;
+    case 'u':
+      if (text == "until")
+        return TokenType::UNTIL;
+      break;
+    case 'w':
+      if (text == "while")
+        return TokenType::WHILE;
+      break;
+    }
+    break;
+  case 6:
+    switch (text[0]) {
+    case 'e':
+      if (text == "elseif")
+        return TokenType::ELSEIF;
+      break;
+    case 'g':
+      if (text == "global")
+        return TokenType::GLOBAL;
+      break;
+    case 'i':
+      if (text == "inline")
+        return TokenType::INLINE;
+      break;
+    case 'n':
+      if (text == "number")
+        return TokenType::TYPE_NUMBER;
+      break;
+    case 'p':
+      if (text == "public")
+        return TokenType::PUBLIC;
+      break;
+    case 'r':
+      if (text == "return")
+        return TokenType::RETURN;
+      if (text == "repeat")
+        return TokenType::REPEAT;
+      break;
+    case 's':
+      if (text == "string")
+        return TokenType::TYPE_STRING;
+      if (text == "struct")
+        return TokenType::STRUCT;
+      if (text == "static")
+        return TokenType::STATIC;
+      break;
+    }
+    break;
+  case 7:
+    switch (text[0]) {
+    case 'p':
+      if (text == "private")
+        return TokenType::PRIVATE;
+      break;
+    }
+    break;
+  case 8:
+    switch (text[0]) {
+    case 'f':
+      if (text == "function")
+        return TokenType::FUNCTION;
+      break;
+    }
+    break;
+  }
+  return TokenType::IDENTIFIER;
 }
 
+} // namespace
+
+Lexer::Lexer(std::string_view source)
+    : source(source), current(0), start(0), line(1), errorCount(0) {}
+
 void Lexer::error(const std::string &msg, int line) {
   std::cerr << "\033[1;31mLexer Error:\033[0m " << msg << " on line " << line
             << "\n";
@@ -53,11 +182,25 @@ std::vector<Token> Lexer::scanTokens() {
     scanToken();
   }
   tokens.emplace_back(TokenType::END_OF_FILE, "", line);
-  return tokens;
+  return std::move(tokens);
+}
+
+Token Lexer::nextToken() {
+  // scanToken emits at most one token, skip calls that only consumed
+  // whitespace or comments
+  tokens.clear();
+  while (tokens.empty() && !isAtEnd()) {
+    start = current;
+    scanToken();
+  }
+  if (tokens.empty()) {
+    return Token(TokenType::END_OF_FILE, "", line);
+  }
+  return tokens.back();
 }
 
 bool Lexer::isAtEnd() {
-  return static_cast<size_t>(current) >= source.length();
+  return current >= source.length();
 }
 
 char Lexer::advance() { return source[current++]; }
@@ -69,7 +212,7 @@ char Lexer::peek() {
 }
 
 char Lexer::peekNext() {
-  if (static_cast<size_t>(current) + 1 >= source.length())
+  if (current + 1 >= source.length())
     return '\0';
   return source[current + 1];
 }
@@ -242,7 +385,7 @@ void Lexer::string() {
   if (isAtEnd())
     return;
   advance();
-  std::string value = source.substr(start + 1, current - start - 2);
+  std::string_view value = source.substr(start + 1, current - start - 2);
   tokens.emplace_back(TokenType::STRING, value, value, line);
 }
 
@@ -259,19 +402,21 @@ void Lexer::number() {
       advance();
   }
 
-  std::string value = source.substr(start, current - start);
+  std::string_view lexeme = source.substr(start, current - start);
+  // stod/stoll need a terminated string, numbers are short enough for SSO
+  std::string value(lexeme);
 
   try {
     if (isFloat) {
       double num = std::stod(value);
-      tokens.emplace_back(TokenType::NUMBER, value, num, line);
+      tokens.emplace_back(TokenType::NUMBER, lexeme, num, line);
     } else {
       if (value == "9223372036854775808") {
-        tokens.emplace_back(TokenType::NUMBER, value,
+        tokens.emplace_back(TokenType::NUMBER, lexeme,
                             static_cast<int64_t>(9223372036854775808ULL), line);
       } else {
         int64_t num = std::stoll(value);
-        tokens.emplace_back(TokenType::NUMBER, value, num, line);
+        tokens.emplace_back(TokenType::NUMBER, lexeme, num, line);
       }
     }
   } catch (const std::out_of_range &e) {
@@ -279,9 +424,9 @@ void Lexer::number() {
               << "' is out of range\n";
     errorCount++;
     if (isFloat) {
-      tokens.emplace_back(TokenType::NUMBER, value, 0.0, line);
+      tokens.emplace_back(TokenType::NUMBER, lexeme, 0.0, line);
     } else {
-      tokens.emplace_back(TokenType::NUMBER, value, static_cast<int64_t>(0),
+      tokens.emplace_back(TokenType::NUMBER, lexeme, static_cast<int64_t>(0),
                           line);
     }
   } catch (const std::invalid_argument &e) {
@@ -289,9 +434,9 @@ void Lexer::number() {
               << value << "'\n";
     errorCount++;
     if (isFloat) {
-      tokens.emplace_back(TokenType::NUMBER, value, 0.0, line);
+      tokens.emplace_back(TokenType::NUMBER, lexeme, 0.0, line);
     } else {
-      tokens.emplace_back(TokenType::NUMBER, value, static_cast<int64_t>(0),
+      tokens.emplace_back(TokenType::NUMBER, lexeme, static_cast<int64_t>(0),
                           line);
     }
   }
@@ -300,10 +445,8 @@ void Lexer::number() {
 void Lexer::identifier() {
   while (isAlphaNumeric(peek()))
     advance();
-  std::string text = source.substr(start, current - start);
-  TokenType type =
-      keywords.count(text) ? keywords[text] : TokenType::IDENTIFIER;
-  tokens.emplace_back(type, text, line);
+  std::string_view text = source.substr(start, current - start);
+  tokens.emplace_back(keywordType(text), text, line);
 }
 
 bool Lexer::isDigit(char c) { return c >= '0' && c <= '9'; }
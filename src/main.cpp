@@ -1,14 +1,26 @@
 #include "../include/ast.h"
+#include "../include/ast_cache.h"
 #include "../include/compiler/compiler.h"
 #include "../include/lexer.h"
+#include "../include/optimizer/constant_folder.h"
 #include "../include/parser.h"
+#include "../include/utils/build_cache.h"
+#include "../include/utils/compiler_identity.h"
+#include "../include/utils/content_hash.h"
+#include "../include/utils/pass_timer.h"
+#include "../include/utils/process.h"
+#include "../include/utils/source_manager.h"
 #include "../include/validation/type_checker.h"
+#include <charconv>
+#include <chrono>
+#include <utility>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <filesystem>
 #include <algorithm>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -93,30 +105,99 @@ void initProject() {
   std::cout << "\nRun 'holylua run' to execute your project.\n";
 }
 
-int compileFile(const std::string& inputFile, const std::string& outputName, 
-                bool printAST, bool keepC, bool generateAsm) {
-  std::ifstream file(inputFile);
-  if (!file.is_open()) {
+int lexFile(const std::string& inputFile) {
+  HolyLua::SourceManager sources;
+  if (!sources.open(inputFile)) {
     std::cerr << "Could not open file: " << inputFile << "\n";
     return 1;
   }
 
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  std::string source = buffer.str();
+  // stream tokens without keeping them, so the input size is not bounded
+  // by memory for the token vector
+  auto startTime = std::chrono::steady_clock::now();
+  HolyLua::Lexer lexer(sources.text());
+  size_t tokenCount = 0;
+  while (lexer.nextToken().type != HolyLua::TokenType::END_OF_FILE) {
+    tokenCount++;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - startTime;
+
+  double megabytes = static_cast<double>(sources.size()) / (1024.0 * 1024.0);
+  double seconds = elapsed.count();
+  std::cout << "Lexed " << tokenCount << " tokens from " << megabytes
+            << " MB in " << seconds << " s";
+  if (seconds > 0) {
+    std::cout << " (" << megabytes / seconds << " MB/s)";
+  }
+  std::cout << "\n";
 
-  // lexical analysis
-  HolyLua::Lexer lexer(source);
-  auto tokens = lexer.scanTokens();
+  return lexer.hasErrors() ? 1 : 0;
+}
 
-  if (lexer.hasErrors()) {
-    std::cerr << "Lexical analysis failed due to errors.\n";
-    return 1;
+struct CompileOptions {
+  bool printAST = false;
+  bool keepC = false;
+  bool generateAsm = false;
+  unsigned jobs = 1;
+  HolyLua::PassTimer *timer = nullptr;
+  // directory parsed programs are cached in, empty to always parse
+  std::string astCacheDir;
+  // directory generated C, objects and executables are cached in, empty to
+  // always rebuild
+  std::string buildCacheDir;
+  bool verbose = false;
+};
+
+// lex, parse, check and generate C for an opened source
+int generateC(const HolyLua::SourceManager &sources,
+              const CompileOptions &options, HolyLua::CodeBuffer &cCode) {
+  bool printAST = options.printAST;
+  unsigned jobs = options.jobs;
+  HolyLua::PassTimer *timer = options.timer;
+
+  // tokens point into the source buffer and every later stage borrows it,
+  // so it stays alive until codegen is done. error messages quote it too,
+  // which is why it is read even when the tree comes from the cache.
+  HolyLua::Program program;
+  bool cached = false;
+  if (!options.astCacheDir.empty()) {
+    HolyLua::PassTimer::Scope scope(timer, "load AST cache");
+    cached = HolyLua::AstCache(options.astCacheDir).load(sources.text(), program);
   }
 
-  // parsing
-  HolyLua::Parser parser(tokens, source);
-  auto program = parser.parse();
+  if (!cached) {
+    // lexical analysis
+    std::vector<HolyLua::Token> tokens;
+    {
+      HolyLua::PassTimer::Scope scope(timer, "lex");
+      HolyLua::Lexer lexer(sources.text());
+      tokens = lexer.scanTokens();
+
+      if (lexer.hasErrors()) {
+        std::cerr << "Lexical analysis failed due to errors.\n";
+        return 1;
+      }
+    }
+
+    // parsing
+    HolyLua::Parser parser(std::move(tokens), sources);
+    {
+      HolyLua::PassTimer::Scope scope(timer, "parse");
+      program = parser.parse();
+    }
+
+    if (parser.hasErrors()) {
+      std::cerr << "Parsing failed due to errors.\n";
+      return 1;
+    }
+
+    // only a clean parse is stored, so a cached tree never hides an error
+    if (!options.astCacheDir.empty()) {
+      HolyLua::PassTimer::Scope scope(timer, "store AST cache");
+      HolyLua::AstCache(options.astCacheDir).store(sources.text(), program);
+    }
+  }
 
   if (printAST) {
     std::cout << "\nAbstract Syntax Tree\n";
@@ -124,84 +205,223 @@ int compileFile(const std::string& inputFile, const std::string& outputName,
     printer.print(program);
   }
 
-  HolyLua::TypeChecker typeChecker(source);
-  if (!typeChecker.check(program)) {
-    std::cerr << "Type checking failed due to errors.\n";
-    return 1;
+  {
+    HolyLua::PassTimer::Scope scope(timer, "typecheck");
+    HolyLua::TypeChecker typeChecker(sources);
+    typeChecker.setJobs(jobs);
+    typeChecker.setTimer(timer);
+    if (!typeChecker.check(program)) {
+      std::cerr << "Type checking failed due to errors.\n";
+      return 1;
+    }
+  }
+
+  {
+    HolyLua::PassTimer::Scope scope(timer, "fold constants");
+    HolyLua::ConstantFolder().fold(program);
   }
 
   // code generation
-  HolyLua::Compiler compiler(source);
-  std::string cCode = compiler.compile(program);
+  {
+    HolyLua::PassTimer::Scope scope(timer, "codegen");
+    HolyLua::Compiler compiler(sources);
+    compiler.setJobs(jobs);
+    cCode = compiler.compile(program);
+  }
+
+  // the tree is not needed past codegen and the driver exits soon after,
+  // so it is not torn down node by node
+  program.abandon();
 
   if (cCode.empty()) {
     std::cerr << "Compilation failed due to errors.\n";
     return 1;
   }
 
-  // write C output
-  std::string cFileName = outputName + ".c";
-  std::ofstream outFile(cFileName);
-  outFile << cCode;
-  outFile.close();
+  return 0;
+}
+
+// every stage whose inputs are unchanged is taken from the build cache, down
+// to the finished executable. each key covers the key of the stage before it
+// plus whatever its own stage reads.
+int compileCached(const HolyLua::SourceManager &sources,
+                  const std::string &outputName, const CompileOptions &options) {
+  using Artifact = HolyLua::BuildCache::Artifact;
+  HolyLua::PassTimer *timer = options.timer;
+  HolyLua::BuildCache cache(options.buildCacheDir);
 
-  // get paths from environment variable
   std::string libPath = getLibraryPath();
   std::string includePath = getIncludePath();
-
-  if (generateAsm) {
-    std::string asmFileName = outputName + ".s";
-    
-    std::string gccCommand = "gcc -S -m64 -masm=intel "
-                             "-fno-asynchronous-unwind-tables "
-                             "-fno-ident "
-                             "-fno-stack-protector "
-                             "-O3 "
-                             + cFileName + " -o " + asmFileName + 
-                             " -I\"" + includePath + "\" -L\"" + libPath + "\" -lholylua -lm 2>&1";
-    
-    int result = system(gccCommand.c_str());
-    
-    if (result != 0) {
-      std::cerr << "Failed to generate assembly with gcc.\n";
-      if (!keepC) {
-        std::remove(cFileName.c_str());
-      }
-      return 1;
-    }
-    
-    if (!keepC) {
-      std::remove(cFileName.c_str());
+  std::vector<std::string> compileFlags = {"-I" + includePath};
+  std::vector<std::string> linkFlags = {"-L" + libPath, "-lholylua", "-lm"};
+  auto hashFlags = [](const std::vector<std::string> &flags) {
+    uint64_t hash = 0;
+    for (const std::string &flag : flags) {
+      hash = HolyLua::hashCombine(hash, HolyLua::contentHash(flag));
     }
-    
-  } else {
+    return hash;
+  };
+
+  uint64_t cKey = HolyLua::hashCombine(HolyLua::contentHash(sources.text()),
+                                       HolyLua::compilerIdentity());
+  uint64_t objectKey = HolyLua::hashCombine(
+      HolyLua::hashCombine(cKey, hashFlags(compileFlags)),
+      HolyLua::BuildCache::hashFile(
+          (fs::path(includePath) / "holylua_api.h").string()));
+  uint64_t exeKey = HolyLua::hashCombine(
+      HolyLua::hashCombine(objectKey, hashFlags(linkFlags)),
+      HolyLua::BuildCache::hashFile(
+          (fs::path(libPath) / "libholylua.a").string()));
+
 #ifdef _WIN32
-    std::string exeName = outputName + ".exe";
+  std::string exeName = outputName + ".exe";
 #else
-    std::string exeName = outputName;
+  std::string exeName = outputName;
 #endif
-    std::string gccCommand = "gcc \"" + cFileName + "\" -o \"" + exeName +
-                           "\" -I\"" + includePath + "\" -L\"" + libPath + "\" -lholylua -lm 2>&1";
 
-    int result = system(gccCommand.c_str());
+  auto finish = [&](int result) {
+    if (options.verbose) {
+      cache.report(std::cout);
+    }
+    return result;
+  };
+
+  if (cache.contains(Artifact::EXECUTABLE, exeKey)) {
+    return finish(cache.fetch(Artifact::EXECUTABLE, exeKey, exeName) ? 0 : 1);
+  }
+
+  if (!cache.contains(Artifact::C_SOURCE, cKey)) {
+    HolyLua::CodeBuffer cCode;
+    if (generateC(sources, options, cCode) != 0) {
+      return finish(1);
+    }
+
+    HolyLua::PassTimer::Scope scope(timer, "write C");
+    std::ofstream outFile(cache.stagingPathFor(Artifact::C_SOURCE, cKey));
+    cCode.writeTo(outFile);
+    outFile.close();
+    cache.commit(Artifact::C_SOURCE, cKey);
+  }
+
+  if (!cache.contains(Artifact::OBJECT, objectKey)) {
+    std::vector<std::string> gcc = {
+        "gcc", "-c", cache.pathFor(Artifact::C_SOURCE, cKey), "-o",
+        cache.stagingPathFor(Artifact::OBJECT, objectKey)};
+    gcc.insert(gcc.end(), compileFlags.begin(), compileFlags.end());
+
+    int result;
+    {
+      HolyLua::PassTimer::Scope scope(timer, "cc", true);
+      result = HolyLua::runProcess(gcc);
+    }
 
     if (result != 0) {
       std::cerr << "Failed to compile C code with gcc.\n";
-      if (!keepC) {
-        std::remove(cFileName.c_str());
-      }
+      return finish(1);
+    }
+    cache.commit(Artifact::OBJECT, objectKey);
+  }
+
+  std::vector<std::string> gcc = {
+      "gcc", cache.pathFor(Artifact::OBJECT, objectKey), "-o",
+      cache.stagingPathFor(Artifact::EXECUTABLE, exeKey)};
+  gcc.insert(gcc.end(), linkFlags.begin(), linkFlags.end());
+
+  int result;
+  {
+    HolyLua::PassTimer::Scope scope(timer, "link", true);
+    result = HolyLua::runProcess(gcc);
+  }
+
+  if (result != 0 || !cache.commit(Artifact::EXECUTABLE, exeKey) ||
+      !cache.fetch(Artifact::EXECUTABLE, exeKey, exeName)) {
+    std::cerr << "Failed to link the executable with gcc.\n";
+    return finish(1);
+  }
+  return finish(0);
+}
+
+int compileFile(const std::string& inputFile, const std::string& outputName,
+                const CompileOptions &options) {
+  bool keepC = options.keepC;
+  bool generateAsm = options.generateAsm;
+  HolyLua::PassTimer *timer = options.timer;
+
+  HolyLua::SourceManager sources;
+  {
+    HolyLua::PassTimer::Scope scope(timer, "read source");
+    if (!sources.open(inputFile)) {
+      std::cerr << "Could not open file: " << inputFile << "\n";
       return 1;
     }
+  }
+
+  if (!options.buildCacheDir.empty()) {
+    return compileCached(sources, outputName, options);
+  }
+
+  HolyLua::CodeBuffer cCode;
+  if (generateC(sources, options, cCode) != 0) {
+    return 1;
+  }
+
+  // the C goes to gcc over a pipe and only touches the disk with --keep-c
+  std::string cFileName = outputName + ".c";
+  std::string cText;
+  if (keepC) {
+    HolyLua::PassTimer::Scope scope(timer, "write C");
+    std::ofstream outFile(cFileName);
+    cCode.writeTo(outFile);
+    outFile.close();
+  } else {
+    cText = cCode.str();
+  }
+  std::string_view cInput = cText;
+
+  // get paths from environment variable
+  std::string libPath = getLibraryPath();
+  std::string includePath = getIncludePath();
+
+  std::vector<std::string> gcc = {"gcc"};
+  if (keepC) {
+    gcc.push_back(cFileName);
+  } else {
+    gcc.insert(gcc.end(), {"-x", "c", "-", "-x", "none"});
+  }
+
+  if (generateAsm) {
+    gcc.insert(gcc.end(), {"-S", "-m64", "-masm=intel",
+                           "-fno-asynchronous-unwind-tables", "-fno-ident",
+                           "-fno-stack-protector", "-O3", "-o",
+                           outputName + ".s"});
+  } else {
+#ifdef _WIN32
+    gcc.insert(gcc.end(), {"-o", outputName + ".exe"});
+#else
+    gcc.insert(gcc.end(), {"-o", outputName});
+#endif
+  }
+  gcc.insert(gcc.end(), {"-I" + includePath, "-L" + libPath, "-lholylua", "-lm"});
 
-    if (!keepC) {
-      std::remove(cFileName.c_str());
+  int result;
+  {
+    HolyLua::PassTimer::Scope scope(timer, "cc", true);
+    result = HolyLua::runProcess(gcc, keepC ? nullptr : &cInput);
+  }
+
+  if (result != 0) {
+    if (generateAsm) {
+      std::cerr << "Failed to generate assembly with gcc.\n";
+    } else {
+      std::cerr << "Failed to compile C code with gcc.\n";
     }
+    return 1;
   }
 
   return 0;
 }
 
-void runProject() {
+void runProject(bool verbose) {
   if (!fs::exists("project.toml")) {
     std::cerr << "Error: No project.toml found. Run 'holylua init' first.\n";
     return;
@@ -232,16 +452,23 @@ void runProject() {
 
   std::string outputName = projectName + "-v" + version;
   std::string outputPath = "build" + std::string(1, fs::path::preferred_separator) + outputName;
-  if (compileFile(mainFile, outputPath, false, false, false) == 0) {
+  CompileOptions options;
+  options.astCacheDir = (fs::path("build") / ".cache" / "ast").string();
+  options.buildCacheDir = (fs::path("build") / ".cache").string();
+  options.verbose = verbose;
+  if (compileFile(mainFile, outputPath, options) == 0) {
 #ifdef _WIN32
-    system(("\"" + outputPath + ".exe\"").c_str());
+    std::string exePath = outputPath + ".exe";
 #else
-    system(("./" + outputPath).c_str());
+    std::string exePath = outputPath;
 #endif
+    if (HolyLua::execProgram(exePath) < 0) {
+      std::cerr << "Error: Could not run '" << exePath << "'.\n";
+    }
   }
 }
 
-void buildProject() {
+void buildProject(bool verbose) {
   if (!fs::exists("project.toml")) {
     std::cerr << "Error: No project.toml found. Run 'holylua init' first.\n";
     return;
@@ -272,7 +499,11 @@ void buildProject() {
   
   std::string outputName = projectName + "-v" + version;
   std::string outputPath = "build" + std::string(1, fs::path::preferred_separator) + outputName;
-  if (compileFile(mainFile, outputPath, false, false, false) == 0) {
+  CompileOptions options;
+  options.astCacheDir = (fs::path("build") / ".cache" / "ast").string();
+  options.buildCacheDir = (fs::path("build") / ".cache").string();
+  options.verbose = verbose;
+  if (compileFile(mainFile, outputPath, options) == 0) {
 #ifdef _WIN32
     std::cout << "Build successful: " << outputPath << ".exe\n";
 #else
@@ -286,14 +517,19 @@ void printHelp() {
   std::cout << "Usage:\n";
   std::cout << "  holylua <file.hlua> [options]   Compile a single file\n";
   std::cout << "  holylua init                    Initialize a new project\n";
-  std::cout << "  holylua run                     Run the current project\n";
-  std::cout << "  holylua build                   Build the current project\n";
+  std::cout << "  holylua run [-v]                Run the current project\n";
+  std::cout << "  holylua build [-v]              Build the current project\n";
   std::cout << "  holylua help                    Show this help message\n";
   std::cout << "\nOptions:\n";
   std::cout << "  --ast         Print the AST (Abstract Syntax Tree)\n";
   std::cout << "  --keep-c      Keep the generated C file\n";
   std::cout << "  --asm         Generate assembly file instead of executable\n";
   std::cout << "  --o <name>    Specify output name\n";
+  std::cout << "  --lex-only    Only run the lexer and report its throughput\n";
+  std::cout << "  --time-passes Report time and memory per compiler phase on stderr\n";
+  std::cout << "  --time-passes=json  Same report as JSON\n";
+  std::cout << "  -j <n>        Type-check and generate code on n threads (0 = one per core)\n";
+  std::cout << "  -v            With run/build: report build cache hits and misses\n";
 }
 
 int main(int argc, char *argv[]) {
@@ -305,15 +541,23 @@ int main(int argc, char *argv[]) {
   std::string command = argv[1];
   
   std::transform(command.begin(), command.end(), command.begin(), ::tolower);
+
+  bool verbose = false;
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-v" || arg == "--verbose") {
+      verbose = true;
+    }
+  }
   
   if (command == "init") {
     initProject();
     return 0;
   } else if (command == "run") {
-    runProject();
+    runProject(verbose);
     return 0;
   } else if (command == "build") {
-    buildProject();
+    buildProject(verbose);
     return 0;
   } else if (command == "help" || command == "--help" || command == "-h") {
     printHelp();
@@ -324,11 +568,17 @@ int main(int argc, char *argv[]) {
   bool printAST = false;
   bool keepC = false;
   bool generateAsm = false;
+  bool lexOnly = false;
+  unsigned jobs = 1;
+  bool timePasses = false;
+  bool timePassesJson = false;
   std::string outputName = "";
 
   for (int i = 2; i < argc; i++) {
     std::string arg = argv[i];
-    if (arg == "--ast") {
+    if (arg == "--lex-only") {
+      lexOnly = true;
+    } else if (arg == "--ast") {
       printAST = true;
     } else if (arg == "--keep-c") {
       keepC = true;
@@ -337,12 +587,57 @@ int main(int argc, char *argv[]) {
     } else if (arg == "--o" && i + 1 < argc) {
       outputName = argv[i + 1];
       i++;
+    } else if (arg == "--time-passes") {
+      timePasses = true;
+    } else if (arg == "--time-passes=json") {
+      timePasses = true;
+      timePassesJson = true;
+    } else if (arg.rfind("-j", 0) == 0) {
+      std::string count = arg.substr(2);
+      if (count.empty() && i + 1 < argc) {
+        count = argv[++i];
+      }
+      if (count.empty()) {
+        std::cerr << "Error: -j expects a thread count.\n";
+        return 1;
+      }
+      const char *end = count.data() + count.size();
+      auto parsed = std::from_chars(count.data(), end, jobs);
+      if (parsed.ec != std::errc() || parsed.ptr != end) {
+        std::cerr << "Error: Invalid thread count '" << count << "' for -j.\n";
+        return 1;
+      }
+      if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+      }
     }
   }
 
+  if (lexOnly) {
+    return lexFile(inputFile);
+  }
+
   if (outputName.empty()) {
     outputName = getBaseName(inputFile);
   }
 
-  return compileFile(inputFile, outputName, printAST, keepC, generateAsm);
+  CompileOptions options;
+  options.printAST = printAST;
+  options.keepC = keepC;
+  options.generateAsm = generateAsm;
+  options.jobs = jobs;
+
+  if (!timePasses) {
+    return compileFile(inputFile, outputName, options);
+  }
+
+  HolyLua::PassTimer timer;
+  options.timer = &timer;
+  int result = compileFile(inputFile, outputName, options);
+  if (timePassesJson) {
+    timer.reportJson(std::cerr);
+  } else {
+    timer.report(std::cerr);
+  }
+  return result;
 }
\ No newline at end of file
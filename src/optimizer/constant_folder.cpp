@@ -0,0 +1,605 @@
+#include "../../include/optimizer/constant_folder.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+
+namespace HolyLua {
+
+namespace {
+
+bool isArithmetic(BinaryOp op) {
+  switch (op) {
+  case BinaryOp::ADD:
+  case BinaryOp::SUBTRACT:
+  case BinaryOp::MULTIPLY:
+  case BinaryOp::DIVIDE:
+  case BinaryOp::MODULO:
+  case BinaryOp::POWER:
+  case BinaryOp::FLOOR_DIVIDE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool isComparison(BinaryOp op) {
+  switch (op) {
+  case BinaryOp::EQUAL:
+  case BinaryOp::NOT_EQUAL:
+  case BinaryOp::LESS:
+  case BinaryOp::LESS_EQUAL:
+  case BinaryOp::GREATER:
+  case BinaryOp::GREATER_EQUAL:
+    return true;
+  default:
+    return false;
+  }
+}
+
+template <typename T> bool compare(BinaryOp op, const T &l, const T &r) {
+  switch (op) {
+  case BinaryOp::EQUAL:
+    return l == r;
+  case BinaryOp::NOT_EQUAL:
+    return l != r;
+  case BinaryOp::LESS:
+    return l < r;
+  case BinaryOp::LESS_EQUAL:
+    return l <= r;
+  case BinaryOp::GREATER:
+    return l > r;
+  default:
+    return l >= r;
+  }
+}
+
+// same results as hl_idiv/hl_imod, false where those would raise an error
+// or the result does not fit an int64 literal
+bool integerArithmetic(BinaryOp op, int64_t l, int64_t r, int64_t &result) {
+  switch (op) {
+  case BinaryOp::ADD:
+    if (__builtin_add_overflow(l, r, &result)) return false;
+    break;
+  case BinaryOp::SUBTRACT:
+    if (__builtin_sub_overflow(l, r, &result)) return false;
+    break;
+  case BinaryOp::MULTIPLY:
+    if (__builtin_mul_overflow(l, r, &result)) return false;
+    break;
+  case BinaryOp::FLOOR_DIVIDE:
+    if (r == 0 || (l == INT64_MIN && r == -1)) return false;
+    result = l / r;
+    if ((l % r != 0) && ((l < 0) != (r < 0))) result--;
+    break;
+  case BinaryOp::MODULO:
+    if (r == 0) return false;
+    result = r == -1 ? 0 : l % r;
+    if (result != 0 && ((result < 0) != (r < 0))) result += r;
+    break;
+  default:
+    return false;
+  }
+  // INT64_MIN has no literal spelling in C
+  return result != INT64_MIN;
+}
+
+// same results as the C codegen emits for numbers, false where the result
+// is not a finite double
+bool floatArithmetic(BinaryOp op, double l, double r, double &result) {
+  switch (op) {
+  case BinaryOp::ADD:
+    result = l + r;
+    break;
+  case BinaryOp::SUBTRACT:
+    result = l - r;
+    break;
+  case BinaryOp::MULTIPLY:
+    result = l * r;
+    break;
+  case BinaryOp::DIVIDE:
+    if (r == 0) return false;
+    result = l / r;
+    break;
+  case BinaryOp::MODULO:
+    if (r == 0) return false;
+    result = l - std::floor(l / r) * r;
+    break;
+  case BinaryOp::FLOOR_DIVIDE:
+    if (r == 0) return false;
+    result = std::floor(l / r);
+    break;
+  case BinaryOp::POWER:
+    result = std::pow(l, r);
+    break;
+  default:
+    return false;
+  }
+  return std::isfinite(result);
+}
+
+// string literals keep their escapes, so joining must not turn the tail of
+// one escape plus the head of the next literal into a different escape
+bool canJoin(const std::string &left, const std::string &right) {
+  return left.find('\\') == std::string::npos || right.empty() ||
+         !std::isxdigit(static_cast<unsigned char>(right[0]));
+}
+
+} // namespace
+
+void ConstantFolder::fold(Program &program) {
+  arena = program.arena.get();
+  DeclarationIndex &decls = program.declarations;
+
+  // globals are visible to every function, top-level locals only to main()
+  scopes.clear();
+  pushScope();
+  for (VarDecl *decl : decls.globals) {
+    if (decl->isGlobal) {
+      foldExpr(decl->value);
+      declareVar(decl);
+    }
+  }
+
+  for (FunctionDecl *func : decls.functions) {
+    declare(func->name);
+  }
+  for (FunctionDecl *func : decls.functions) {
+    foldFunction(func);
+  }
+
+  for (ClassDecl *classDecl : decls.classes) {
+    if (classDecl->constructor) {
+      foldMethod(*classDecl->constructor);
+    }
+    for (auto &method : classDecl->methods) {
+      foldMethod(method);
+    }
+  }
+
+  pushScope();
+  std::vector<ASTNode *> dead;
+  for (ASTNode *stmt : decls.statements) {
+    if (!foldStatement(stmt)) {
+      dead.push_back(stmt);
+    }
+  }
+  popScope();
+
+  for (ASTNode *stmt : dead) {
+    decls.statements.erase(
+        std::find(decls.statements.begin(), decls.statements.end(), stmt));
+    program.statements.erase(std::find_if(
+        program.statements.begin(), program.statements.end(),
+        [&](const std::unique_ptr<ASTNode> &node) { return node.get() == stmt; }));
+  }
+
+  scopes.clear();
+}
+
+// only a literal initializer is propagated, converted the way codegen would
+// store it so uses keep the declared type
+void ConstantFolder::declareVar(const VarDecl *decl) {
+  auto *lit = nodeCast<LiteralExpr>(decl->value.get());
+  if (!decl->isConst || decl->isOptional || !lit) {
+    declare(decl->name);
+    return;
+  }
+
+  Value value = lit->value;
+  if (auto *i = std::get_if<int64_t>(&value)) {
+    if (decl->type != ValueType::INT) {
+      value = static_cast<double>(*i);
+    }
+  }
+  scopes.back()[decl->name] = std::move(value);
+}
+
+const ConstantFolder::Value *ConstantFolder::lookup(const std::string &name) const {
+  for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+    auto it = scope->find(name);
+    if (it != scope->end()) {
+      return it->second ? &*it->second : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+void ConstantFolder::foldFunction(FunctionDecl *func) {
+  pushScope();
+  for (const auto &param : func->parameters) {
+    declare(param.first);
+  }
+  foldBlock(func->body);
+  popScope();
+}
+
+void ConstantFolder::foldMethod(ClassMethod &method) {
+  pushScope();
+  for (const auto &param : method.parameters) {
+    declare(param.first);
+  }
+  foldBlock(method.body);
+  popScope();
+}
+
+void ConstantFolder::foldBlock(std::vector<std::unique_ptr<ASTNode>> &block) {
+  pushScope();
+  foldStatements(block);
+  popScope();
+}
+
+void ConstantFolder::foldStatements(
+    std::vector<std::unique_ptr<ASTNode>> &block) {
+  block.erase(std::remove_if(block.begin(), block.end(),
+                             [&](std::unique_ptr<ASTNode> &stmt) {
+                               return stmt && !foldStatement(stmt.get());
+                             }),
+              block.end());
+}
+
+bool ConstantFolder::foldStatement(ASTNode *stmt) {
+  switch (stmt->kind) {
+  case NodeKind::VAR_DECL: {
+    auto *decl = static_cast<VarDecl *>(stmt);
+    foldExpr(decl->value);
+    declareVar(decl);
+    break;
+  }
+  case NodeKind::FUNCTION_DECL: {
+    auto *func = static_cast<FunctionDecl *>(stmt);
+    declare(func->name);
+    foldFunction(func);
+    break;
+  }
+  case NodeKind::RETURN:
+    foldExpr(static_cast<ReturnStmt *>(stmt)->value);
+    break;
+  case NodeKind::ASSIGNMENT:
+    foldExpr(static_cast<Assignment *>(stmt)->value);
+    break;
+  case NodeKind::FIELD_ASSIGNMENT: {
+    auto *assign = static_cast<FieldAssignment *>(stmt);
+    foldExpr(assign->object);
+    foldExpr(assign->value);
+    break;
+  }
+  case NodeKind::PRINT:
+    for (auto &arg : static_cast<PrintStmt *>(stmt)->arguments) {
+      if (!arg.isIdentifier) {
+        foldExpr(arg.expression);
+      } else if (const Value *value = lookup(arg.identifier)) {
+        arg = PrintArg(makeLiteral(*value, stmt->line));
+      }
+    }
+    break;
+  case NodeKind::IF:
+    return foldIf(static_cast<IfStmt *>(stmt));
+  case NodeKind::WHILE: {
+    auto *whileStmt = static_cast<WhileStmt *>(stmt);
+    foldExpr(whileStmt->condition);
+    foldBlock(whileStmt->body);
+    break;
+  }
+  case NodeKind::FOR: {
+    auto *forStmt = static_cast<ForStmt *>(stmt);
+    foldExpr(forStmt->start);
+    foldExpr(forStmt->end);
+    foldExpr(forStmt->step);
+    pushScope();
+    declare(forStmt->varName);
+    foldBlock(forStmt->body);
+    popScope();
+    break;
+  }
+  case NodeKind::REPEAT: {
+    // the condition sees the locals of the body
+    auto *repeatStmt = static_cast<RepeatStmt *>(stmt);
+    pushScope();
+    foldStatements(repeatStmt->body);
+    foldExpr(repeatStmt->condition);
+    popScope();
+    break;
+  }
+  default:
+    // calls used as statements never fold away themselves
+    if (stmt->isExpr()) {
+      foldOperands(static_cast<Expr *>(stmt));
+    }
+    break;
+  }
+  return true;
+}
+
+// branches behind a false condition are dropped, a true condition ends the
+// chain and becomes its else. what is left always keeps its block, so the
+// scoping of the C output does not change.
+bool ConstantFolder::foldIf(IfStmt *ifStmt) {
+  using Branch =
+      std::pair<std::unique_ptr<Expr>, std::vector<std::unique_ptr<ASTNode>>>;
+
+  std::vector<Branch> branches;
+  branches.emplace_back(std::move(ifStmt->condition),
+                        std::move(ifStmt->thenBlock));
+  for (auto &branch : ifStmt->elseifBranches) {
+    branches.push_back(std::move(branch));
+  }
+  ifStmt->elseifBranches.clear();
+
+  std::vector<Branch> live;
+  std::vector<std::unique_ptr<ASTNode>> elseBlock = std::move(ifStmt->elseBlock);
+  for (auto &branch : branches) {
+    foldExpr(branch.first);
+    auto *lit = nodeCast<LiteralExpr>(branch.first.get());
+    const bool *constant = lit ? std::get_if<bool>(&lit->value) : nullptr;
+    if (!constant) {
+      live.push_back(std::move(branch));
+    } else if (*constant) {
+      elseBlock = std::move(branch.second);
+      break;
+    }
+  }
+
+  if (live.empty()) {
+    if (elseBlock.empty()) {
+      return false;
+    }
+    live.emplace_back(makeLiteral(true, ifStmt->line), std::move(elseBlock));
+    elseBlock.clear();
+  }
+
+  ifStmt->condition = std::move(live[0].first);
+  ifStmt->thenBlock = std::move(live[0].second);
+  for (size_t i = 1; i < live.size(); i++) {
+    ifStmt->elseifBranches.push_back(std::move(live[i]));
+  }
+  ifStmt->elseBlock = std::move(elseBlock);
+
+  foldBlock(ifStmt->thenBlock);
+  for (auto &branch : ifStmt->elseifBranches) {
+    foldBlock(branch.second);
+  }
+  foldBlock(ifStmt->elseBlock);
+  return true;
+}
+
+void ConstantFolder::foldExpr(std::unique_ptr<Expr> &expr) {
+  if (!expr) {
+    return;
+  }
+  if (expr->kind == NodeKind::BINARY) {
+    foldBinaryChain(expr);
+    return;
+  }
+  foldOperands(expr.get());
+  if (auto folded = evaluate(expr.get())) {
+    expr = std::move(folded);
+  }
+}
+
+// a chain like a + b + c leans left as deep as it is long. its spine is
+// folded bottom-up in a loop, in the order recursing on each left operand
+// would, so only the right operands recurse
+void ConstantFolder::foldBinaryChain(std::unique_ptr<Expr> &expr) {
+  std::vector<std::unique_ptr<Expr> *> spine;
+  std::unique_ptr<Expr> *node = &expr;
+  while (*node && (*node)->kind == NodeKind::BINARY) {
+    spine.push_back(node);
+    node = &static_cast<BinaryExpr *>(node->get())->left;
+  }
+  foldExpr(*node);
+
+  for (auto it = spine.rbegin(); it != spine.rend(); ++it) {
+    std::unique_ptr<Expr> &link = **it;
+    foldExpr(static_cast<BinaryExpr *>(link.get())->right);
+    if (auto folded = evaluate(link.get())) {
+      link = std::move(folded);
+    }
+  }
+}
+
+void ConstantFolder::foldOperands(Expr *expr) {
+  switch (expr->kind) {
+  case NodeKind::FUNCTION_CALL:
+    for (auto &arg : static_cast<FunctionCall *>(expr)->arguments) {
+      foldExpr(arg);
+    }
+    break;
+  case NodeKind::METHOD_CALL: {
+    auto *call = static_cast<MethodCall *>(expr);
+    foldExpr(call->object);
+    for (auto &arg : call->arguments) {
+      foldExpr(arg);
+    }
+    break;
+  }
+  case NodeKind::CLASS_INSTANTIATION:
+    for (auto &arg : static_cast<ClassInstantiation *>(expr)->arguments) {
+      foldExpr(arg);
+    }
+    break;
+  case NodeKind::STRUCT_CONSTRUCTOR: {
+    auto *cons = static_cast<StructConstructor *>(expr);
+    for (auto &arg : cons->namedArgs) {
+      foldExpr(arg.second);
+    }
+    for (auto &arg : cons->positionalArgs) {
+      foldExpr(arg);
+    }
+    break;
+  }
+  case NodeKind::BINARY: {
+    auto *bin = static_cast<BinaryExpr *>(expr);
+    foldExpr(bin->left);
+    foldExpr(bin->right);
+    break;
+  }
+  case NodeKind::UNARY:
+    foldExpr(static_cast<UnaryExpr *>(expr)->operand);
+    break;
+  case NodeKind::FORCE_UNWRAP:
+    foldExpr(static_cast<ForceUnwrapExpr *>(expr)->operand);
+    break;
+  case NodeKind::FIELD_ACCESS:
+    foldExpr(static_cast<FieldAccessExpr *>(expr)->object);
+    break;
+  case NodeKind::LAMBDA: {
+    auto *lambda = static_cast<LambdaExpr *>(expr);
+    pushScope();
+    for (const auto &param : lambda->parameters) {
+      declare(param.first);
+    }
+    foldBlock(lambda->body);
+    popScope();
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+std::unique_ptr<Expr> ConstantFolder::evaluate(Expr *expr) {
+  switch (expr->kind) {
+  case NodeKind::VAR:
+    if (const Value *value = lookup(static_cast<const VarExpr *>(expr)->name)) {
+      return makeLiteral(*value, expr->line);
+    }
+    return nullptr;
+  case NodeKind::UNARY:
+    return evaluateUnary(static_cast<const UnaryExpr *>(expr));
+  case NodeKind::BINARY:
+    return evaluateBinary(static_cast<BinaryExpr *>(expr));
+  default:
+    return nullptr;
+  }
+}
+
+std::unique_ptr<Expr> ConstantFolder::evaluateUnary(const UnaryExpr *un) {
+  auto *lit = nodeCast<LiteralExpr>(un->operand.get());
+  if (!lit) {
+    return nullptr;
+  }
+
+  if (un->op == UnaryOp::NOT) {
+    if (auto *b = std::get_if<bool>(&lit->value)) {
+      return makeLiteral(!*b, un->line);
+    }
+  } else if (auto *i = std::get_if<int64_t>(&lit->value)) {
+    if (*i != INT64_MIN) {
+      return makeLiteral(-*i, un->line);
+    }
+  } else if (auto *d = std::get_if<double>(&lit->value)) {
+    return makeLiteral(-*d, un->line);
+  }
+  return nullptr;
+}
+
+std::unique_ptr<Expr> ConstantFolder::evaluateBinary(BinaryExpr *bin) {
+  auto *left = nodeCast<LiteralExpr>(bin->left.get());
+  auto *right = nodeCast<LiteralExpr>(bin->right.get());
+  BinaryOp op = bin->op;
+
+  // `x .. "a" .. "b"` parses as (x .. "a") .. "b", join the literal tail
+  if (op == BinaryOp::CONCAT && !left && right) {
+    auto *inner = nodeCast<BinaryExpr>(bin->left.get());
+    auto *tail = inner ? nodeCast<LiteralExpr>(inner->right.get()) : nullptr;
+    if (inner && inner->op == BinaryOp::CONCAT && tail) {
+      auto *l = std::get_if<std::string>(&tail->value);
+      auto *r = std::get_if<std::string>(&right->value);
+      if (l && r && canJoin(*l, *r)) {
+        tail->value = *l + *r;
+        return std::move(bin->left);
+      }
+    }
+    return nullptr;
+  }
+
+  // a constant left side decides `and`/`or` without the right one
+  if (left && (op == BinaryOp::AND || op == BinaryOp::OR)) {
+    auto *b = std::get_if<bool>(&left->value);
+    if (b && *b == (op == BinaryOp::OR)) {
+      return makeLiteral(*b, bin->line);
+    }
+  }
+
+  if (!left || !right) {
+    return nullptr;
+  }
+  const Value &l = left->value;
+  const Value &r = right->value;
+
+  auto *li = std::get_if<int64_t>(&l);
+  auto *ri = std::get_if<int64_t>(&r);
+  auto *ld = std::get_if<double>(&l);
+  auto *rd = std::get_if<double>(&r);
+  bool numeric = (li || ld) && (ri || rd);
+
+  if (isArithmetic(op) && numeric) {
+    if (li && ri && op != BinaryOp::DIVIDE && op != BinaryOp::POWER) {
+      int64_t result;
+      if (integerArithmetic(op, *li, *ri, result)) {
+        return makeLiteral(result, bin->line);
+      }
+      return nullptr;
+    }
+    double result;
+    if (floatArithmetic(op, li ? static_cast<double>(*li) : *ld,
+                        ri ? static_cast<double>(*ri) : *rd, result)) {
+      return makeLiteral(result, bin->line);
+    }
+    return nullptr;
+  }
+
+  if (isComparison(op)) {
+    if (li && ri) {
+      return makeLiteral(compare(op, *li, *ri), bin->line);
+    }
+    if (numeric) {
+      return makeLiteral(compare(op, li ? static_cast<double>(*li) : *ld,
+                                 ri ? static_cast<double>(*ri) : *rd),
+                         bin->line);
+    }
+    if (op != BinaryOp::EQUAL && op != BinaryOp::NOT_EQUAL) {
+      return nullptr;
+    }
+    auto *ls = std::get_if<std::string>(&l);
+    auto *rs = std::get_if<std::string>(&r);
+    if (ls && rs && ls->find('\\') == std::string::npos &&
+        rs->find('\\') == std::string::npos) {
+      return makeLiteral(compare(op, *ls, *rs), bin->line);
+    }
+    auto *lb = std::get_if<bool>(&l);
+    auto *rb = std::get_if<bool>(&r);
+    if (lb && rb) {
+      return makeLiteral(compare(op, *lb, *rb), bin->line);
+    }
+    return nullptr;
+  }
+
+  if (op == BinaryOp::AND || op == BinaryOp::OR) {
+    auto *lb = std::get_if<bool>(&l);
+    auto *rb = std::get_if<bool>(&r);
+    if (lb && rb) {
+      return makeLiteral(op == BinaryOp::AND ? (*lb && *rb) : (*lb || *rb),
+                         bin->line);
+    }
+    return nullptr;
+  }
+
+  if (op == BinaryOp::CONCAT) {
+    auto *ls = std::get_if<std::string>(&l);
+    auto *rs = std::get_if<std::string>(&r);
+    if (ls && rs && canJoin(*ls, *rs)) {
+      return makeLiteral(*ls + *rs, bin->line);
+    }
+  }
+  return nullptr;
+}
+
+std::unique_ptr<Expr> ConstantFolder::makeLiteral(Value value, int line) {
+  auto lit = std::unique_ptr<LiteralExpr>(new (*arena) LiteralExpr(std::move(value)));
+  lit->line = line;
+  return lit;
+}
+
+} // namespace HolyLua
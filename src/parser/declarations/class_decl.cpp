@@ -11,12 +11,13 @@ std::unique_ptr<ClassDecl> Parser::classDeclaration() {
     return nullptr;
   }
 
-  Token name = advance();
-  auto classDecl = std::make_unique<ClassDecl>(name.lexeme);
+  const Token &name = advance();
+  auto classDecl = make<ClassDecl>(intern(name.lexeme));
   classDecl->line = classLine;
 
-  // register this class as declared
+  // register this class as declared, later passes look its name up
   declaredClasses.insert(name.lexeme);
+  TypeName::intern(name.lexeme);
 
   skipNewlines();
 
@@ -32,22 +33,22 @@ std::unique_ptr<ClassDecl> Parser::classDeclaration() {
     Visibility visibility = Visibility::PRIVATE;
     bool isStatic = false;
 
-    if (match({TokenType::PUBLIC})) {
+    if (match(TokenType::PUBLIC)) {
       visibility = Visibility::PUBLIC;
       skipNewlines();
-    } else if (match({TokenType::PRIVATE})) {
+    } else if (match(TokenType::PRIVATE)) {
       visibility = Visibility::PRIVATE;
       skipNewlines();
     }
 
     // check for static modifier
-    if (match({TokenType::STATIC})) {
+    if (match(TokenType::STATIC)) {
       isStatic = true;
       skipNewlines();
     }
 
     // parse member, either field or method
-    if (match({TokenType::FUNCTION})) {
+    if (match(TokenType::FUNCTION)) {
       auto method = classMethod(visibility, isStatic);
       if (!method) {
         return nullptr;
@@ -79,7 +80,7 @@ std::unique_ptr<ClassDecl> Parser::classDeclaration() {
     skipNewlines();
   }
 
-  if (!match({TokenType::END})) {
+  if (!match(TokenType::END)) {
     error("Expected 'end' to close class", peek().line);
     return nullptr;
   }
@@ -89,10 +90,10 @@ std::unique_ptr<ClassDecl> Parser::classDeclaration() {
 }
 
 std::unique_ptr<ClassInstantiation> Parser::classInstantiation() {
-  Token className = previous();
+  const Token &className = previous();
   int line = className.line;
 
-  if (!match({TokenType::LPAREN})) {
+  if (!match(TokenType::LPAREN)) {
     error("Expected '(' after class name", peek().line);
     return nullptr;
   }
@@ -102,16 +103,16 @@ std::unique_ptr<ClassInstantiation> Parser::classInstantiation() {
   if (!check(TokenType::RPAREN)) {
     do {
       arguments.push_back(expression());
-    } while (match({TokenType::COMMA}));
+    } while (match(TokenType::COMMA));
   }
 
-  if (!match({TokenType::RPAREN})) {
+  if (!match(TokenType::RPAREN)) {
     error("Expected ')' after arguments", peek().line);
     return nullptr;
   }
 
-  auto instantiation = std::make_unique<ClassInstantiation>(className.lexeme,
-                                                             std::move(arguments));
+  auto instantiation = make<ClassInstantiation>(intern(className.lexeme),
+                                                std::move(arguments));
   instantiation->line = line;
   return instantiation;
 }
@@ -6,7 +6,7 @@ namespace HolyLua {
 std::unique_ptr<ClassField> Parser::classField(Visibility visibility, bool isStatic) {
   // check for const modifier
   bool isConst = false;
-  if (match({TokenType::CONST})) {
+  if (match(TokenType::CONST)) {
     isConst = true;
   }
 
@@ -15,7 +15,7 @@ std::unique_ptr<ClassField> Parser::classField(Visibility visibility, bool isSta
     return nullptr;
   }
 
-  Token fieldName = advance();
+  const Token &fieldName = advance();
   ValueType fieldType = ValueType::INFERRED;
   std::string structTypeName = "";
   bool isOptional = false;
@@ -23,10 +23,10 @@ std::unique_ptr<ClassField> Parser::classField(Visibility visibility, bool isSta
   std::variant<int64_t, double, std::string, bool, std::nullptr_t> defaultValue = nullptr;
 
   // parse type annotation
-  if (match({TokenType::COLON})) {
+  if (match(TokenType::COLON)) {
     if (check(TokenType::IDENTIFIER)) {
-      Token typeToken = advance();
-      std::string typeName = typeToken.lexeme;
+      const Token &typeToken = advance();
+      std::string typeName(typeToken.lexeme);
 
       if (declaredClasses.count(typeName) > 0 || declaredStructs.count(typeName) > 0) {
         fieldType = ValueType::STRUCT;
@@ -44,30 +44,36 @@ std::unique_ptr<ClassField> Parser::classField(Visibility visibility, bool isSta
         error("Unknown type '" + typeName + "'", typeToken.line);
         return nullptr;
       }
-    } else if (match({TokenType::TYPE_NUMBER})) {
+    } else if (match(TokenType::TYPE_NUMBER)) {
       fieldType = ValueType::NUMBER;
-    } else if (match({TokenType::TYPE_STRING})) {
+    } else if (match(TokenType::TYPE_STRING)) {
       fieldType = ValueType::STRING;
-    } else if (match({TokenType::TYPE_BOOL})) {
+    } else if (match(TokenType::TYPE_BOOL)) {
       fieldType = ValueType::BOOL;
+    } else if (match(TokenType::TYPE_INT)) {
+      fieldType = ValueType::INT;
     } else {
       error("Expected type after ':'", peek().line);
       return nullptr;
     }
 
     // check for optional marker
-    if (match({TokenType::QUESTION})) {
+    if (match(TokenType::QUESTION)) {
+      if (fieldType == ValueType::INT) {
+        error("Optional 'int' is not supported, use 'number?'", previous().line);
+        return nullptr;
+      }
       isOptional = true;
     }
   }
 
   // parse default value
-  if (match({TokenType::ASSIGN})) {
+  if (match(TokenType::ASSIGN)) {
     hasDefault = true;
 
     if (isConst) {
       // only allow literals for const fields
-      if (match({TokenType::NUMBER})) {
+      if (match(TokenType::NUMBER)) {
         const auto &lit = previous().literal;
         if (std::holds_alternative<int64_t>(lit)) {
           defaultValue = std::get<int64_t>(lit);
@@ -76,16 +82,16 @@ std::unique_ptr<ClassField> Parser::classField(Visibility visibility, bool isSta
           defaultValue = std::get<double>(lit);
           if (fieldType == ValueType::INFERRED) fieldType = ValueType::NUMBER;
         }
-      } else if (match({TokenType::STRING})) {
-        defaultValue = std::get<std::string>(previous().literal);
+      } else if (match(TokenType::STRING)) {
+        defaultValue = std::string(std::get<std::string_view>(previous().literal));
         if (fieldType == ValueType::INFERRED) fieldType = ValueType::STRING;
-      } else if (match({TokenType::TRUE})) {
+      } else if (match(TokenType::TRUE)) {
         defaultValue = true;
         if (fieldType == ValueType::INFERRED) fieldType = ValueType::BOOL;
-      } else if (match({TokenType::FALSE})) {
+      } else if (match(TokenType::FALSE)) {
         defaultValue = false;
         if (fieldType == ValueType::INFERRED) fieldType = ValueType::BOOL;
-      } else if (match({TokenType::NIL})) {
+      } else if (match(TokenType::NIL)) {
         defaultValue = nullptr;
       } else {
         error("Const fields must be initialized with literals", peek().line);
@@ -94,20 +100,20 @@ std::unique_ptr<ClassField> Parser::classField(Visibility visibility, bool isSta
     } else if (isStatic && declaredClasses.count(peek().lexeme) > 0) {
       error("Complex default values for static fields should be handled in initialization", peek().line);
       return nullptr;
-    } else if (match({TokenType::NUMBER})) {
+    } else if (match(TokenType::NUMBER)) {
       const auto &lit = previous().literal;
       if (std::holds_alternative<int64_t>(lit)) {
         defaultValue = std::get<int64_t>(lit);
       } else if (std::holds_alternative<double>(lit)) {
         defaultValue = std::get<double>(lit);
       }
-    } else if (match({TokenType::STRING})) {
-      defaultValue = std::get<std::string>(previous().literal);
-    } else if (match({TokenType::TRUE})) {
+    } else if (match(TokenType::STRING)) {
+      defaultValue = std::string(std::get<std::string_view>(previous().literal));
+    } else if (match(TokenType::TRUE)) {
       defaultValue = true;
-    } else if (match({TokenType::FALSE})) {
+    } else if (match(TokenType::FALSE)) {
       defaultValue = false;
-    } else if (match({TokenType::NIL})) {
+    } else if (match(TokenType::NIL)) {
       defaultValue = nullptr;
     } else {
       error("Default value must be a literal or class instantiation", peek().line);
@@ -130,10 +136,10 @@ std::unique_ptr<ClassField> Parser::classField(Visibility visibility, bool isSta
     return nullptr;
   }
 
-  auto field = std::make_unique<ClassField>(visibility, isStatic, fieldName.lexeme,
+  auto field = std::make_unique<ClassField>(visibility, isStatic, std::string(fieldName.lexeme),
                                              fieldType, isOptional, hasDefault);
   field->isConst = isConst;
-  field->structTypeName = structTypeName;
+  field->structTypeName = TypeName::intern(structTypeName);
   if (hasDefault) {
     field->defaultValue = defaultValue;
   }
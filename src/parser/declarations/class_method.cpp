@@ -11,9 +11,9 @@ std::unique_ptr<ClassMethod> Parser::classMethod(Visibility visibility, bool isS
     return nullptr;
   }
 
-  Token name = advance();
+  const Token &name = advance();
 
-  if (!match({TokenType::LPAREN})) {
+  if (!match(TokenType::LPAREN)) {
     error("Expected '(' after method name", peek().line);
     return nullptr;
   }
@@ -28,14 +28,14 @@ std::unique_ptr<ClassMethod> Parser::classMethod(Visibility visibility, bool isS
         return nullptr;
       }
 
-      Token paramName = advance();
+      const Token &paramName = advance();
       ValueType paramType = ValueType::INFERRED;
       bool isOptional = false;
 
-      if (match({TokenType::COLON})) {
+      if (match(TokenType::COLON)) {
         if (check(TokenType::IDENTIFIER)) {
-          Token typeToken = advance();
-          std::string typeName = typeToken.lexeme;
+          const Token &typeToken = advance();
+          std::string typeName(typeToken.lexeme);
 
           if (declaredClasses.count(typeName) > 0 || declaredStructs.count(typeName) > 0) {
             paramType = ValueType::STRUCT;
@@ -51,37 +51,43 @@ std::unique_ptr<ClassMethod> Parser::classMethod(Visibility visibility, bool isS
             error("Unknown type '" + typeName + "'", typeToken.line);
             return nullptr;
           }
-        } else if (match({TokenType::TYPE_NUMBER})) {
+        } else if (match(TokenType::TYPE_NUMBER)) {
           paramType = ValueType::NUMBER;
-        } else if (match({TokenType::TYPE_STRING})) {
+        } else if (match(TokenType::TYPE_STRING)) {
           paramType = ValueType::STRING;
-        } else if (match({TokenType::TYPE_BOOL})) {
+        } else if (match(TokenType::TYPE_BOOL)) {
           paramType = ValueType::BOOL;
+        } else if (match(TokenType::TYPE_INT)) {
+          paramType = ValueType::INT;
         } else {
           error("Expected type after ':'", peek().line);
           return nullptr;
         }
 
-        if (match({TokenType::QUESTION})) {
+        if (match(TokenType::QUESTION)) {
+          if (paramType == ValueType::INT) {
+            error("Optional 'int' is not supported, use 'number?'", previous().line);
+            return nullptr;
+          }
           isOptional = true;
         }
       }
 
       parameters.emplace_back(paramName.lexeme, paramType);
       parameterOptionals.push_back(isOptional);
-    } while (match({TokenType::COMMA}));
+    } while (match(TokenType::COMMA));
   }
 
-  if (!match({TokenType::RPAREN})) {
+  if (!match(TokenType::RPAREN)) {
     error("Expected ')' after parameters", peek().line);
     return nullptr;
   }
 
   ValueType returnType = ValueType::INFERRED;
-  if (match({TokenType::COLON})) {
+  if (match(TokenType::COLON)) {
     if (check(TokenType::IDENTIFIER)) {
-      Token typeToken = advance();
-      std::string typeName = typeToken.lexeme;
+      const Token &typeToken = advance();
+      std::string typeName(typeToken.lexeme);
 
       if (declaredClasses.count(typeName) > 0 || declaredStructs.count(typeName) > 0) {
         returnType = ValueType::STRUCT;
@@ -97,25 +103,27 @@ std::unique_ptr<ClassMethod> Parser::classMethod(Visibility visibility, bool isS
         error("Unknown return type '" + typeName + "'", typeToken.line);
         return nullptr;
       }
-    } else if (match({TokenType::TYPE_NUMBER})) {
+    } else if (match(TokenType::TYPE_NUMBER)) {
       returnType = ValueType::NUMBER;
-    } else if (match({TokenType::TYPE_STRING})) {
+    } else if (match(TokenType::TYPE_STRING)) {
       returnType = ValueType::STRING;
-    } else if (match({TokenType::TYPE_BOOL})) {
+    } else if (match(TokenType::TYPE_BOOL)) {
       returnType = ValueType::BOOL;
+    } else if (match(TokenType::TYPE_INT)) {
+      returnType = ValueType::INT;
     } else {
       error("Expected return type after ':'", peek().line);
       return nullptr;
     }
 
-    if (match({TokenType::QUESTION})) {
+    if (match(TokenType::QUESTION)) {
       // optional return type
     }
   }
 
   skipNewlines();
 
-  auto method = std::make_unique<ClassMethod>(visibility, isStatic, name.lexeme,
+  auto method = std::make_unique<ClassMethod>(visibility, isStatic, std::string(name.lexeme),
                                                parameters, returnType);
   method->parameterOptionals = parameterOptionals;
   method->line = methodLine;
@@ -131,7 +139,7 @@ std::unique_ptr<ClassMethod> Parser::classMethod(Visibility visibility, bool isS
     }
   }
 
-  if (!match({TokenType::END})) {
+  if (!match(TokenType::END)) {
     error("Expected 'end' to close method", peek().line);
     return nullptr;
   }
@@ -11,8 +11,8 @@ std::unique_ptr<ASTNode> Parser::enumDeclaration() {
     return nullptr;
   }
   
-  Token nameToken = advance();
-  std::string enumName = nameToken.lexeme;
+  const Token &nameToken = advance();
+  std::string enumName(nameToken.lexeme);
   
   if (declaredEnums.count(enumName) || declaredStructs.count(enumName) || 
       declaredClasses.count(enumName)) {
@@ -20,7 +20,7 @@ std::unique_ptr<ASTNode> Parser::enumDeclaration() {
     return nullptr;
   }
   
-  auto enumDecl = std::make_unique<EnumDecl>(enumName);
+  auto enumDecl = make<EnumDecl>(intern(enumName));
   enumDecl->line = line;
   
   skipNewlines();
@@ -41,21 +41,22 @@ std::unique_ptr<ASTNode> Parser::enumDeclaration() {
       continue;
     }
     
-    Token valueToken = advance();
-    std::string valueName = valueToken.lexeme;
+    const Token &valueToken = advance();
+    std::string valueName(valueToken.lexeme);
     
     values.push_back(valueName);
     
     skipNewlines();
   }
   
-  if (!match({TokenType::END})) {
+  if (!match(TokenType::END)) {
     error("Expected 'end' after enum declaration", line);
     return nullptr;
   }
   
   enumDecl->values = values;
-  declaredEnums.insert(enumName);
+  declaredEnums.insert(nameToken.lexeme);
+  TypeName::intern(enumName);
   enumValues[enumName] = values;
   
   skipNewlines();
@@ -7,7 +7,7 @@ std::unique_ptr<FunctionDecl> Parser::functionDeclaration() {
   int funcLine = previous().line;
 
   bool isGlobal = false;
-  if (match({TokenType::GLOBAL})) {
+  if (match(TokenType::GLOBAL)) {
     isGlobal = true;
   }
 
@@ -20,9 +20,9 @@ std::unique_ptr<FunctionDecl> Parser::functionDeclaration() {
     return nullptr;
   }
 
-  Token name = advance();
+  const Token &name = advance();
 
-  if (!match({TokenType::LPAREN})) {
+  if (!match(TokenType::LPAREN)) {
     error("Expected '(' after function name", peek().line);
     return nullptr;
   }
@@ -37,14 +37,14 @@ std::unique_ptr<FunctionDecl> Parser::functionDeclaration() {
         return nullptr;
       }
 
-      Token paramName = advance();
+      const Token &paramName = advance();
       ValueType paramType = ValueType::INFERRED;
       bool isOptional = false;
 
-      if (match({TokenType::COLON})) {
+      if (match(TokenType::COLON)) {
         if (check(TokenType::IDENTIFIER)) {
-          Token typeToken = advance();
-          std::string typeName = typeToken.lexeme;
+          const Token &typeToken = advance();
+          std::string typeName(typeToken.lexeme);
           
           if (typeName == "number") {
             paramType = ValueType::NUMBER;
@@ -60,45 +60,51 @@ std::unique_ptr<FunctionDecl> Parser::functionDeclaration() {
             error("Unknown type '" + typeName + "'", typeToken.line);
             return nullptr;
           }
-        } else if (match({TokenType::TYPE_NUMBER})) {
+        } else if (match(TokenType::TYPE_NUMBER)) {
           paramType = ValueType::NUMBER;
-        } else if (match({TokenType::TYPE_STRING})) {
+        } else if (match(TokenType::TYPE_STRING)) {
           paramType = ValueType::STRING;
-        } else if (match({TokenType::TYPE_BOOL})) {
+        } else if (match(TokenType::TYPE_BOOL)) {
           paramType = ValueType::BOOL;
+        } else if (match(TokenType::TYPE_INT)) {
+          paramType = ValueType::INT;
         } else {
           error("Expected type after ':'", peek().line);
           return nullptr;
         }
 
-        if (match({TokenType::QUESTION})) {
+        if (match(TokenType::QUESTION)) {
+          if (paramType == ValueType::INT) {
+            error("Optional 'int' is not supported, use 'number?'", previous().line);
+            return nullptr;
+          }
           isOptional = true;
         }
       }
 
       parameters.emplace_back(paramName.lexeme, paramType);
       parameterOptionals.push_back(isOptional);
-    } while (match({TokenType::COMMA}));
+    } while (match(TokenType::COMMA));
   }
 
-  if (!match({TokenType::RPAREN})) {
+  if (!match(TokenType::RPAREN)) {
     error("Expected ')' after parameters", peek().line);
     return nullptr;
   }
 
   ValueType returnType = ValueType::INFERRED;
-  if (match({TokenType::COLON})) {
+  if (match(TokenType::COLON)) {
     returnType = parseType();
 
-    if (match({TokenType::QUESTION})) {
+    if (match(TokenType::QUESTION)) {
       // optional return type
     }
   }
 
   skipNewlines();
 
-  auto funcDecl = std::make_unique<FunctionDecl>(name.lexeme, parameters,
-                                                 returnType, isGlobal);
+  auto funcDecl = make<FunctionDecl>(intern(name.lexeme), parameters,
+                                     returnType, isGlobal);
   funcDecl->parameterOptionals = parameterOptionals;
   funcDecl->line = funcLine;
 
@@ -117,7 +123,7 @@ std::unique_ptr<FunctionDecl> Parser::functionDeclaration() {
 
   functionDepth--;
 
-  if (!match({TokenType::END})) {
+  if (!match(TokenType::END)) {
     error("Expected 'end' to close function", peek().line);
     return nullptr;
   }
@@ -127,10 +133,10 @@ std::unique_ptr<FunctionDecl> Parser::functionDeclaration() {
 }
 
 std::unique_ptr<FunctionCall> Parser::functionCall() {
-  Token funcName = previous();
+  const Token &funcName = previous();
   int line = funcName.line;
 
-  if (!match({TokenType::LPAREN})) {
+  if (!match(TokenType::LPAREN)) {
     error("Expected '(' after function name", peek().line);
     return nullptr;
   }
@@ -140,16 +146,16 @@ std::unique_ptr<FunctionCall> Parser::functionCall() {
   if (!check(TokenType::RPAREN)) {
     do {
       arguments.push_back(expression());
-    } while (match({TokenType::COMMA}));
+    } while (match(TokenType::COMMA));
   }
 
-  if (!match({TokenType::RPAREN})) {
+  if (!match(TokenType::RPAREN)) {
     error("Expected ')' after function arguments", peek().line);
     return nullptr;
   }
 
   auto call =
-      std::make_unique<FunctionCall>(funcName.lexeme, std::move(arguments));
+      make<FunctionCall>(intern(funcName.lexeme), std::move(arguments));
   call->line = line;
   return call;
 }
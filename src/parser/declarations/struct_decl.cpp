@@ -11,12 +11,13 @@ std::unique_ptr<StructDecl> Parser::structDeclaration() {
     return nullptr;
   }
 
-  Token name = advance();
-  auto structDecl = std::make_unique<StructDecl>(name.lexeme);
+  const Token &name = advance();
+  auto structDecl = make<StructDecl>(intern(name.lexeme));
   structDecl->line = structLine;
 
-  // register this struct as declared
+  // register this struct as declared, later passes look its name up
   declaredStructs.insert(name.lexeme);
+  TypeName::intern(name.lexeme);
 
   skipNewlines();
 
@@ -34,7 +35,7 @@ std::unique_ptr<StructDecl> Parser::structDeclaration() {
       return nullptr;
     }
 
-    Token fieldName = advance();
+    const Token &fieldName = advance();
     ValueType fieldType = ValueType::INFERRED;
     std::string structTypeName = "";
     bool isOptional = false;
@@ -43,10 +44,10 @@ std::unique_ptr<StructDecl> Parser::structDeclaration() {
         defaultValue = nullptr;
 
     // parse type annotation
-    if (match({TokenType::COLON})) {
+    if (match(TokenType::COLON)) {
       if (check(TokenType::IDENTIFIER)) {
-        Token typeToken = advance();
-        std::string typeName = typeToken.lexeme;
+        const Token &typeToken = advance();
+        std::string typeName(typeToken.lexeme);
 
         if (declaredStructs.count(typeName) > 0) {
           fieldType = ValueType::STRUCT;
@@ -75,30 +76,30 @@ std::unique_ptr<StructDecl> Parser::structDeclaration() {
         fieldType = parseType();
       }
 
-      if (match({TokenType::QUESTION})) {
+      if (match(TokenType::QUESTION)) {
         isOptional = true;
       }
     }
 
     // parse default value
-    if (match({TokenType::ASSIGN})) {
+    if (match(TokenType::ASSIGN)) {
       hasDefault = true;
 
       // parse literal default value
-      if (match({TokenType::NUMBER})) {
+      if (match(TokenType::NUMBER)) {
         const auto &lit = previous().literal;
         if (std::holds_alternative<int64_t>(lit)) {
           defaultValue = std::get<int64_t>(lit);
         } else if (std::holds_alternative<double>(lit)) {
           defaultValue = std::get<double>(lit);
         }
-      } else if (match({TokenType::STRING})) {
-        defaultValue = std::get<std::string>(previous().literal);
-      } else if (match({TokenType::TRUE})) {
+      } else if (match(TokenType::STRING)) {
+        defaultValue = std::string(std::get<std::string_view>(previous().literal));
+      } else if (match(TokenType::TRUE)) {
         defaultValue = true;
-      } else if (match({TokenType::FALSE})) {
+      } else if (match(TokenType::FALSE)) {
         defaultValue = false;
-      } else if (match({TokenType::NIL})) {
+      } else if (match(TokenType::NIL)) {
         defaultValue = nullptr;
       } else {
         error("Default value must be a literal", peek().line);
@@ -106,7 +107,7 @@ std::unique_ptr<StructDecl> Parser::structDeclaration() {
       }
     }
 
-    if (match({TokenType::COMMA})) {
+    if (match(TokenType::COMMA)) {
       skipNewlines();
     }
     else {
@@ -114,9 +115,9 @@ std::unique_ptr<StructDecl> Parser::structDeclaration() {
     }
 
     // create field with struct type info if applicable
-    StructField field(fieldName.lexeme, fieldType, isOptional, hasDefault);
+    StructField field(std::string(fieldName.lexeme), fieldType, isOptional, hasDefault);
     if (!structTypeName.empty()) {
-      field.structTypeName = structTypeName;
+      field.structTypeName = TypeName::intern(structTypeName);
     }
     if (hasDefault) {
       field.defaultValue = defaultValue;
@@ -124,7 +125,7 @@ std::unique_ptr<StructDecl> Parser::structDeclaration() {
     structDecl->fields.push_back(std::move(field));
   }
 
-  if (!match({TokenType::END})) {
+  if (!match(TokenType::END)) {
     error("Expected 'end' to close struct", peek().line);
     return nullptr;
   }
@@ -135,12 +136,12 @@ std::unique_ptr<StructDecl> Parser::structDeclaration() {
 
 std::unique_ptr<StructConstructor> Parser::structConstructor() {
   int line = previous().line;
-  Token structName = previous();
+  const Token &structName = previous();
 
-  auto constructor = std::make_unique<StructConstructor>(structName.lexeme);
+  auto constructor = make<StructConstructor>(intern(structName.lexeme));
   constructor->line = line;
 
-  if (!match({TokenType::LBRACE})) {
+  if (!match(TokenType::LBRACE)) {
     error("Expected '{' after struct name", peek().line);
     return nullptr;
   }
@@ -148,7 +149,7 @@ std::unique_ptr<StructConstructor> Parser::structConstructor() {
   skipNewlines();
 
   // check if it's empty constructor with defaults
-  if (match({TokenType::RBRACE})) {
+  if (match(TokenType::RBRACE)) {
     constructor->useDefaults = true;
     return constructor;
   }
@@ -208,7 +209,7 @@ std::unique_ptr<StructConstructor> Parser::structConstructor() {
         return nullptr;
       }
 
-      Token fieldName = advance();
+      const Token &fieldName = advance();
 
       // accept either '=' or ':' as assignment operator
       if (!match({TokenType::ASSIGN, TokenType::COLON})) {
@@ -226,7 +227,7 @@ std::unique_ptr<StructConstructor> Parser::structConstructor() {
         break;
       }
       
-      if (!match({TokenType::COMMA})) {
+      if (!match(TokenType::COMMA)) {
         if (!check(TokenType::RBRACE)) {
           error("Expected ',' or '}' after field assignment", peek().line);
           return nullptr;
@@ -234,7 +235,7 @@ std::unique_ptr<StructConstructor> Parser::structConstructor() {
       }
     }
 
-    if (!match({TokenType::RBRACE})) {
+    if (!match(TokenType::RBRACE)) {
       error("Expected '}' after struct constructor", peek().line);
       return nullptr;
     }
@@ -256,7 +257,7 @@ std::unique_ptr<StructConstructor> Parser::structConstructor() {
         break;
       }
       
-      if (!match({TokenType::COMMA})) {
+      if (!match(TokenType::COMMA)) {
         if (!check(TokenType::RBRACE)) {
           error("Expected ',' or '}' after argument", peek().line);
           return nullptr;
@@ -264,7 +265,7 @@ std::unique_ptr<StructConstructor> Parser::structConstructor() {
       }
     }
 
-    if (!match({TokenType::RBRACE})) {
+    if (!match(TokenType::RBRACE)) {
       error("Expected '}' after struct constructor arguments", peek().line);
       return nullptr;
     }
@@ -8,7 +8,7 @@ std::unique_ptr<ASTNode> Parser::declaration() {
   
   // check for simple identifier assignment
   if (check(TokenType::IDENTIFIER)) {
-    Token name = peek();
+    const Token &name = peek();
     advance();
 
     // check for compound assignment operators
@@ -16,7 +16,7 @@ std::unique_ptr<ASTNode> Parser::declaration() {
                TokenType::STAR_ASSIGN, TokenType::SLASH_ASSIGN,
                TokenType::PERCENT_ASSIGN, TokenType::DOUBLE_STAR_ASSIGN,
                TokenType::DOUBLE_SLASH_ASSIGN})) {
-      Token op = previous();
+      const Token &op = previous();
       auto expr = expression();
       skipNewlines();
 
@@ -37,13 +37,13 @@ std::unique_ptr<ASTNode> Parser::declaration() {
         binOp = BinaryOp::FLOOR_DIVIDE;
 
       auto assign =
-          std::make_unique<Assignment>(name.lexeme, std::move(expr), binOp);
+          make<Assignment>(intern(name.lexeme), std::move(expr), binOp);
       assign->line = name.line;
       return assign;
-    } else if (match({TokenType::ASSIGN})) {
+    } else if (match(TokenType::ASSIGN)) {
       auto expr = expression();
       skipNewlines();
-      auto assign = std::make_unique<Assignment>(name.lexeme, std::move(expr));
+      auto assign = make<Assignment>(intern(name.lexeme), std::move(expr));
       assign->line = name.line;
       return assign;
     } else if (check(TokenType::LPAREN)) {
@@ -59,13 +59,13 @@ std::unique_ptr<ASTNode> Parser::declaration() {
       auto leftExpr = postfix();
       
       // now check if there's an assignment
-      if (auto *fieldAccess = dynamic_cast<FieldAccessExpr*>(leftExpr.get())) {
-        if (match({TokenType::ASSIGN})) {
+      if (auto *fieldAccess = nodeCast<FieldAccessExpr>(leftExpr.get())) {
+        if (match(TokenType::ASSIGN)) {
           int line = previous().line;
           auto value = expression();
           skipNewlines();
           
-          auto assignment = std::make_unique<FieldAssignment>(
+          auto assignment = make<FieldAssignment>(
               std::move(fieldAccess->object),
               fieldAccess->fieldName,
               std::move(value)
@@ -77,7 +77,7 @@ std::unique_ptr<ASTNode> Parser::declaration() {
                           TokenType::PERCENT_ASSIGN, TokenType::DOUBLE_STAR_ASSIGN,
                           TokenType::DOUBLE_SLASH_ASSIGN})) {
           // compound field assignment
-          Token op = previous();
+          const Token &op = previous();
           int line = op.line;
           auto value = expression();
           skipNewlines();
@@ -98,7 +98,7 @@ std::unique_ptr<ASTNode> Parser::declaration() {
           else
             binOp = BinaryOp::FLOOR_DIVIDE;
           
-          auto assignment = std::make_unique<FieldAssignment>(
+          auto assignment = make<FieldAssignment>(
               std::move(fieldAccess->object),
               fieldAccess->fieldName,
               std::move(value),
@@ -120,13 +120,13 @@ std::unique_ptr<ASTNode> Parser::declaration() {
     savedPos = current;
     auto leftExpr = postfix();
     
-    if (auto *fieldAccess = dynamic_cast<FieldAccessExpr*>(leftExpr.get())) {
-      if (match({TokenType::ASSIGN})) {
+    if (auto *fieldAccess = nodeCast<FieldAccessExpr>(leftExpr.get())) {
+      if (match(TokenType::ASSIGN)) {
         int line = previous().line;
         auto value = expression();
         skipNewlines();
         
-        auto assignment = std::make_unique<FieldAssignment>(
+        auto assignment = make<FieldAssignment>(
             std::move(fieldAccess->object),
             fieldAccess->fieldName,
             std::move(value)
@@ -137,7 +137,7 @@ std::unique_ptr<ASTNode> Parser::declaration() {
                         TokenType::STAR_ASSIGN, TokenType::SLASH_ASSIGN,
                         TokenType::PERCENT_ASSIGN, TokenType::DOUBLE_STAR_ASSIGN,
                         TokenType::DOUBLE_SLASH_ASSIGN})) {
-        Token op = previous();
+        const Token &op = previous();
         int line = op.line;
         auto value = expression();
         skipNewlines();
@@ -158,7 +158,7 @@ std::unique_ptr<ASTNode> Parser::declaration() {
         else
           binOp = BinaryOp::FLOOR_DIVIDE;
         
-        auto assignment = std::make_unique<FieldAssignment>(
+        auto assignment = make<FieldAssignment>(
             std::move(fieldAccess->object),
             fieldAccess->fieldName,
             std::move(value),
@@ -184,14 +184,14 @@ std::unique_ptr<ASTNode> Parser::declaration() {
 }
 
 std::unique_ptr<VarDecl> Parser::varDeclaration() {
-  Token firstKeyword = peek();
+  const Token &firstKeyword = peek();
 
   bool isLocal = false;
   bool isGlobal = false;
   bool isConst = false;
 
   while (match({TokenType::LOCAL, TokenType::GLOBAL, TokenType::CONST})) {
-    Token modifier = previous();
+    const Token &modifier = previous();
     if (modifier.type == TokenType::LOCAL) {
       isLocal = true;
     } else if (modifier.type == TokenType::GLOBAL) {
@@ -220,18 +220,18 @@ std::unique_ptr<VarDecl> Parser::varDeclaration() {
     return nullptr;
   }
 
-  Token name = advance();
+  const Token &name = advance();
 
   ValueType type = ValueType::INFERRED;
   bool isOptional = false;
   std::string typeName = "";
 
   // optional type annotation
-  if (match({TokenType::COLON})) {
+  if (match(TokenType::COLON)) {
     // check if type is an identifier
     if (check(TokenType::IDENTIFIER)) {
-      Token typeToken = advance();
-      std::string identifier = typeToken.lexeme;
+      const Token &typeToken = advance();
+      std::string identifier(typeToken.lexeme);
       
       if (declaredEnums.count(identifier) > 0) {
         type = ValueType::ENUM;
@@ -255,32 +255,39 @@ std::unique_ptr<VarDecl> Parser::varDeclaration() {
         return nullptr;
       }
     }
-    else if (match({TokenType::TYPE_NUMBER})) {
+    else if (match(TokenType::TYPE_NUMBER)) {
       type = ValueType::NUMBER;
       typeName = "number";
-    } else if (match({TokenType::TYPE_STRING})) {
+    } else if (match(TokenType::TYPE_STRING)) {
       type = ValueType::STRING;
       typeName = "string";
-    } else if (match({TokenType::TYPE_BOOL})) {
+    } else if (match(TokenType::TYPE_BOOL)) {
       type = ValueType::BOOL;
       typeName = "bool";
+    } else if (match(TokenType::TYPE_INT)) {
+      type = ValueType::INT;
+      typeName = "int";
     } else {
       error("Expected type after ':'", peek().line);
       return nullptr;
     }
 
     // check for optional type marker (?)
-    if (match({TokenType::QUESTION})) {
+    if (match(TokenType::QUESTION)) {
+      if (type == ValueType::INT) {
+        error("Optional 'int' is not supported, use 'number?'", previous().line);
+        return nullptr;
+      }
       isOptional = true;
     }
   }
 
-  auto decl = std::make_unique<VarDecl>(isGlobalVar, isConst, name.lexeme, type, isOptional);
+  auto decl = make<VarDecl>(isGlobalVar, isConst, intern(name.lexeme), type, isOptional);
   decl->line = declLine;
-  decl->typeName = typeName;
+  decl->typeName = TypeName::intern(typeName);
 
   // optional initializer
-  if (match({TokenType::ASSIGN})) {
+  if (match(TokenType::ASSIGN)) {
     decl->value = expression();
     decl->hasValue = true;
   }
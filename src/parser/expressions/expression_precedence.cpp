@@ -3,104 +3,116 @@
 
 namespace HolyLua {
 
-std::unique_ptr<Expr> Parser::expression() { 
-  return logicalOr(); 
-}
-
-std::unique_ptr<Expr> Parser::logicalOr() {
-  auto expr = logicalAnd();
-
-  while (match({TokenType::OR})) {
-    Token op = previous();
-    int line = op.line;
-    auto right = logicalAnd();
-
-    auto binExpr = std::make_unique<BinaryExpr>(std::move(expr), BinaryOp::OR,
-                                                std::move(right));
-    binExpr->line = line;
-    expr = std::move(binExpr);
+namespace {
+
+// binding power of the binary operators, loosest first. all of them are
+// left associative except '**'.
+enum Precedence {
+  PREC_NONE,
+  PREC_OR,
+  PREC_AND,
+  PREC_NIL_COALESCE,
+  PREC_CONCAT,
+  PREC_COMPARISON,
+  PREC_ADDITIVE,
+  PREC_MULTIPLICATIVE,
+  PREC_POWER
+};
+
+struct BinaryRule {
+  Precedence precedence;
+  BinaryOp op;
+};
+
+constexpr BinaryRule binaryRule(TokenType type) {
+  switch (type) {
+  case TokenType::OR:
+    return {PREC_OR, BinaryOp::OR};
+  case TokenType::AND:
+    return {PREC_AND, BinaryOp::AND};
+  case TokenType::DOUBLE_QUESTION:
+    return {PREC_NIL_COALESCE, BinaryOp::NIL_COALESCE};
+  case TokenType::CONCAT:
+    return {PREC_CONCAT, BinaryOp::CONCAT};
+  case TokenType::EQUAL:
+    return {PREC_COMPARISON, BinaryOp::EQUAL};
+  case TokenType::NOT_EQUAL:
+    return {PREC_COMPARISON, BinaryOp::NOT_EQUAL};
+  case TokenType::LESS:
+    return {PREC_COMPARISON, BinaryOp::LESS};
+  case TokenType::LESS_EQUAL:
+    return {PREC_COMPARISON, BinaryOp::LESS_EQUAL};
+  case TokenType::GREATER:
+    return {PREC_COMPARISON, BinaryOp::GREATER};
+  case TokenType::GREATER_EQUAL:
+    return {PREC_COMPARISON, BinaryOp::GREATER_EQUAL};
+  case TokenType::PLUS:
+    return {PREC_ADDITIVE, BinaryOp::ADD};
+  case TokenType::MINUS:
+    return {PREC_ADDITIVE, BinaryOp::SUBTRACT};
+  case TokenType::STAR:
+    return {PREC_MULTIPLICATIVE, BinaryOp::MULTIPLY};
+  case TokenType::SLASH:
+    return {PREC_MULTIPLICATIVE, BinaryOp::DIVIDE};
+  case TokenType::PERCENT:
+    return {PREC_MULTIPLICATIVE, BinaryOp::MODULO};
+  case TokenType::DOUBLE_SLASH:
+    return {PREC_MULTIPLICATIVE, BinaryOp::FLOOR_DIVIDE};
+  case TokenType::DOUBLE_STAR:
+    return {PREC_POWER, BinaryOp::POWER};
+  default:
+    return {PREC_NONE, BinaryOp::ADD};
   }
-
-  return expr;
 }
 
-std::unique_ptr<Expr> Parser::logicalAnd() {
-  auto expr = nilCoalescing();
-
-  while (match({TokenType::AND})) {
-    Token op = previous();
-    int line = op.line;
-    auto right = nilCoalescing();
-
-    auto binExpr = std::make_unique<BinaryExpr>(std::move(expr), BinaryOp::AND,
-                                                std::move(right));
-    binExpr->line = line;
-    expr = std::move(binExpr);
+} // namespace
+
+std::unique_ptr<Expr> Parser::expression() {
+  // parentheses, call arguments and lambdas nest expressions recursively,
+  // refuse input deep enough to exhaust the stack
+  if (expressionDepth >= MAX_EXPRESSION_DEPTH) {
+    int line = peek().line;
+    if (!expressionTooDeep) {
+      error("Expression is nested too deeply", line);
+      expressionTooDeep = true;
+    }
+    while (!check(TokenType::NEWLINE) && !isAtEnd()) {
+      advance();
+    }
+    return nullptr;
   }
 
-  return expr;
-}
-
-std::unique_ptr<Expr> Parser::nilCoalescing() {
-  auto expr = concat();
-
-  while (match({TokenType::DOUBLE_QUESTION})) {
-    Token op = previous();
-    int line = op.line;
-    auto right = concat();
+  expressionDepth++;
+  auto expr = binary(PREC_OR);
+  expressionDepth--;
 
-    auto binExpr = std::make_unique<BinaryExpr>(
-        std::move(expr), BinaryOp::NIL_COALESCE, std::move(right));
-    binExpr->line = line;
-    expr = std::move(binExpr);
+  if (expressionDepth == 0) {
+    expressionTooDeep = false;
   }
-
   return expr;
 }
 
-std::unique_ptr<Expr> Parser::concat() {
-  auto expr = comparison();
+// precedence climbing: operands of looser operators are parsed by the loop,
+// only a tighter operator on the right recurses, so the depth is bounded by
+// the number of precedence levels rather than the length of the expression.
+std::unique_ptr<Expr> Parser::binary(int minPrecedence) {
+  auto expr = unary();
 
-  while (match({TokenType::CONCAT})) {
-    Token op = previous();
-    int line = op.line;
-    auto right = comparison();
+  while (true) {
+    BinaryRule rule = binaryRule(peek().type);
+    if (rule.precedence == PREC_NONE || rule.precedence < minPrecedence) {
+      break;
+    }
 
-    auto binExpr = std::make_unique<BinaryExpr>(
-        std::move(expr), BinaryOp::CONCAT, std::move(right));
-    binExpr->line = line;
-    expr = std::move(binExpr);
-  }
+    int line = advance().line;
 
-  return expr;
-}
+    if (rule.op == BinaryOp::POWER) {
+      expr = powerChain(std::move(expr), line);
+      continue;
+    }
 
-std::unique_ptr<Expr> Parser::comparison() {
-  auto expr = additive();
-
-  while (match({TokenType::EQUAL, TokenType::NOT_EQUAL, TokenType::LESS,
-                TokenType::LESS_EQUAL, TokenType::GREATER,
-                TokenType::GREATER_EQUAL})) {
-    Token op = previous();
-    int line = op.line;
-    auto right = additive();
-
-    BinaryOp binOp;
-    if (op.type == TokenType::EQUAL)
-      binOp = BinaryOp::EQUAL;
-    else if (op.type == TokenType::NOT_EQUAL)
-      binOp = BinaryOp::NOT_EQUAL;
-    else if (op.type == TokenType::LESS)
-      binOp = BinaryOp::LESS;
-    else if (op.type == TokenType::LESS_EQUAL)
-      binOp = BinaryOp::LESS_EQUAL;
-    else if (op.type == TokenType::GREATER)
-      binOp = BinaryOp::GREATER;
-    else
-      binOp = BinaryOp::GREATER_EQUAL;
-
-    auto binExpr =
-        std::make_unique<BinaryExpr>(std::move(expr), binOp, std::move(right));
+    auto right = binary(rule.precedence + 1);
+    auto binExpr = make<BinaryExpr>(std::move(expr), rule.op, std::move(right));
     binExpr->line = line;
     expr = std::move(binExpr);
   }
@@ -108,86 +120,52 @@ std::unique_ptr<Expr> Parser::comparison() {
   return expr;
 }
 
-std::unique_ptr<Expr> Parser::additive() {
-  auto expr = multiplicative();
-
-  while (match({TokenType::PLUS, TokenType::MINUS})) {
-    Token op = previous();
-    int line = op.line;
-    auto right = multiplicative();
-    BinaryOp binOp =
-        (op.type == TokenType::PLUS) ? BinaryOp::ADD : BinaryOp::SUBTRACT;
-    auto binExpr =
-        std::make_unique<BinaryExpr>(std::move(expr), binOp, std::move(right));
-    binExpr->line = line;
-    expr = std::move(binExpr);
+// '**' is right associative: collect the whole chain a ** b ** c, then fold
+// it from the right instead of recursing once per operator
+std::unique_ptr<Expr> Parser::powerChain(std::unique_ptr<Expr> base,
+                                         int line) {
+  std::vector<std::unique_ptr<Expr>> operands;
+  std::vector<int> lines;
+  operands.push_back(std::move(base));
+  lines.push_back(line);
+  operands.push_back(unary());
+
+  while (match(TokenType::DOUBLE_STAR)) {
+    lines.push_back(previous().line);
+    operands.push_back(unary());
   }
 
-  return expr;
-}
-
-std::unique_ptr<Expr> Parser::multiplicative() {
-  auto expr = power();
-
-  while (match({TokenType::STAR, TokenType::SLASH, TokenType::PERCENT,
-                TokenType::DOUBLE_SLASH})) {
-    Token op = previous();
-    int line = op.line;
-    auto right = power();
-    BinaryOp binOp;
-    if (op.type == TokenType::STAR)
-      binOp = BinaryOp::MULTIPLY;
-    else if (op.type == TokenType::SLASH)
-      binOp = BinaryOp::DIVIDE;
-    else if (op.type == TokenType::PERCENT)
-      binOp = BinaryOp::MODULO;
-    else
-      binOp = BinaryOp::FLOOR_DIVIDE;
-    auto binExpr =
-        std::make_unique<BinaryExpr>(std::move(expr), binOp, std::move(right));
-    binExpr->line = line;
+  auto expr = std::move(operands.back());
+  for (size_t i = operands.size() - 1; i-- > 0;) {
+    auto binExpr = make<BinaryExpr>(std::move(operands[i]), BinaryOp::POWER,
+                                    std::move(expr));
+    binExpr->line = lines[i];
     expr = std::move(binExpr);
   }
-
-  return expr;
-}
-
-std::unique_ptr<Expr> Parser::power() {
-  auto expr = unary();
-
-  if (match({TokenType::DOUBLE_STAR})) {
-    Token op = previous();
-    int line = op.line;
-    // right-associative, recursively call power()
-    auto right = power();
-    auto binExpr = std::make_unique<BinaryExpr>(
-        std::move(expr), BinaryOp::POWER, std::move(right));
-    binExpr->line = line;
-    return binExpr;
-  }
-
   return expr;
 }
 
 std::unique_ptr<Expr> Parser::unary() {
-  if (match({TokenType::MINUS})) {
-    int line = previous().line;
-    auto operand = unary();
-    auto expr =
-        std::make_unique<UnaryExpr>(UnaryOp::NEGATE, std::move(operand));
-    expr->line = line;
-    return expr;
+  // skip over the prefix operators, parse the operand, then wrap it from the
+  // innermost operator outwards
+  size_t first = current;
+  while (check(TokenType::MINUS) || check(TokenType::NOT)) {
+    advance();
   }
+  size_t last = current;
 
-  if (match({TokenType::NOT})) {
-    int line = previous().line;
-    auto operand = unary();
-    auto expr = std::make_unique<UnaryExpr>(UnaryOp::NOT, std::move(operand));
-    expr->line = line;
-    return expr;
+  auto expr = postfix();
+
+  for (size_t i = last; i-- > first;) {
+    const Token &op = tokens[i];
+    UnaryOp unaryOp =
+        op.type == TokenType::MINUS ? UnaryOp::NEGATE : UnaryOp::NOT;
+    auto unaryExpr = make<UnaryExpr>(unaryOp, std::move(expr));
+    unaryExpr->line = op.line;
+    expr = std::move(unaryExpr);
   }
 
-  return postfix();
+  return expr;
 }
 
 } // namespace HolyLua
@@ -5,7 +5,7 @@ namespace HolyLua {
 
 std::unique_ptr<LambdaExpr> Parser::lambdaExpression(int line) {
   // parameters
-  if (!match({TokenType::LPAREN})) {
+  if (!match(TokenType::LPAREN)) {
     error("Expected '(' after function keyword", peek().line);
     return nullptr;
   }
@@ -20,39 +20,39 @@ std::unique_ptr<LambdaExpr> Parser::lambdaExpression(int line) {
         return nullptr;
       }
 
-      Token paramName = advance();
+      const Token &paramName = advance();
       ValueType paramType = ValueType::INFERRED;
       bool isOptional = false;
 
       // optional type annotation
-      if (match({TokenType::COLON})) {
+      if (match(TokenType::COLON)) {
         paramType = parseType();
 
         // check for optional marker '?' after the type
-        if (match({TokenType::QUESTION})) {
+        if (match(TokenType::QUESTION)) {
           isOptional = true;
         }
       }
 
       parameters.emplace_back(paramName.lexeme, paramType);
       parameterOptionals.push_back(isOptional);
-    } while (match({TokenType::COMMA}));
+    } while (match(TokenType::COMMA));
   }
 
-  if (!match({TokenType::RPAREN})) {
+  if (!match(TokenType::RPAREN)) {
     error("Expected ')' after parameters", peek().line);
     return nullptr;
   }
 
   // optional return type annotation
   ValueType returnType = ValueType::INFERRED;
-  if (match({TokenType::COLON})) {
+  if (match(TokenType::COLON)) {
     returnType = parseType();
   }
 
   skipNewlines();
 
-  auto lambda = std::make_unique<LambdaExpr>(parameters, returnType);
+  auto lambda = make<LambdaExpr>(parameters, returnType);
   lambda->parameterOptionals = parameterOptionals;
   lambda->line = line;
 
@@ -74,7 +74,7 @@ std::unique_ptr<LambdaExpr> Parser::lambdaExpression(int line) {
   // decrement depth when leaving function body
   functionDepth--;
 
-  if (!match({TokenType::END})) {
+  if (!match(TokenType::END)) {
     error("Expected 'end' to close anonymous function", peek().line);
     return nullptr;
   }
@@ -14,18 +14,18 @@ std::unique_ptr<Expr> Parser::postfix() {
       break;
     }
 
-    if (match({TokenType::DOT})) {
+    if (match(TokenType::DOT)) {
       if (!check(TokenType::IDENTIFIER)) {
         error("Expected member name after '.'", peek().line);
         return expr;
       }
 
-      Token member = advance();
+      const Token &member = advance();
       // check if the left side is an enum type
-      if (auto *varExpr = dynamic_cast<VarExpr*>(expr.get())) {
+      if (auto *varExpr = nodeCast<VarExpr>(expr.get())) {
         if (declaredEnums.count(varExpr->name) > 0) {
           std::string enumName = varExpr->name;
-          std::string valueName = member.lexeme;
+          std::string valueName(member.lexeme);
           
           // verify the value exists in the enum
           if (enumValues.count(enumName)) {
@@ -42,7 +42,7 @@ std::unique_ptr<Expr> Parser::postfix() {
             }
           }
           
-          auto enumExpr = std::make_unique<EnumAccessExpr>(enumName, valueName);
+          auto enumExpr = make<EnumAccessExpr>(intern(enumName), intern(valueName));
           enumExpr->line = member.line;
           expr = std::move(enumExpr);
           continue;
@@ -58,28 +58,28 @@ std::unique_ptr<Expr> Parser::postfix() {
         if (!check(TokenType::RPAREN)) {
           do {
             arguments.push_back(expression());
-          } while (match({TokenType::COMMA}));
+          } while (match(TokenType::COMMA));
         }
 
-        if (!match({TokenType::RPAREN})) {
+        if (!match(TokenType::RPAREN)) {
           error("Expected ')' after arguments", peek().line);
           return expr;
         }
 
-        auto methodCall = std::make_unique<MethodCall>(std::move(expr),
-                                                        member.lexeme,
-                                                        std::move(arguments));
+        auto methodCall = make<MethodCall>(std::move(expr),
+                                           intern(member.lexeme),
+                                           std::move(arguments));
         methodCall->line = member.line;
         expr = std::move(methodCall);
       } else {
-        auto fieldAccess = std::make_unique<FieldAccessExpr>(std::move(expr),
-                                                              member.lexeme);
+        auto fieldAccess = make<FieldAccessExpr>(std::move(expr),
+                                                 intern(member.lexeme));
         fieldAccess->line = member.line;
         expr = std::move(fieldAccess);
       }
-    } else if (match({TokenType::BANG})) {
+    } else if (match(TokenType::BANG)) {
       int line = previous().line;
-      auto unwrap = std::make_unique<ForceUnwrapExpr>(std::move(expr));
+      auto unwrap = make<ForceUnwrapExpr>(std::move(expr));
       unwrap->line = line;
       expr = std::move(unwrap);
     } else {
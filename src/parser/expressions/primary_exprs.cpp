@@ -6,13 +6,13 @@ namespace HolyLua {
 std::unique_ptr<Expr> Parser::primary() {
   int line = peek().line;
 
-  if (match({TokenType::NUMBER})) {
+  if (match(TokenType::NUMBER)) {
     const auto &lit = previous().literal;
     auto expr = std::unique_ptr<LiteralExpr>(nullptr);
     if (std::holds_alternative<int64_t>(lit)) {
-      expr = std::make_unique<LiteralExpr>(std::get<int64_t>(lit));
+      expr = make<LiteralExpr>(std::get<int64_t>(lit));
     } else if (std::holds_alternative<double>(lit)) {
-      expr = std::make_unique<LiteralExpr>(std::get<double>(lit));
+      expr = make<LiteralExpr>(std::get<double>(lit));
     }
     if (expr) {
       expr->line = line;
@@ -20,43 +20,43 @@ std::unique_ptr<Expr> Parser::primary() {
     }
   }
 
-  if (match({TokenType::FUNCTION})) {
+  if (match(TokenType::FUNCTION)) {
     return lambdaExpression(line);
   }
 
-  if (match({TokenType::STRING})) {
-    auto expr = std::make_unique<LiteralExpr>(
-        std::get<std::string>(previous().literal));
+  if (match(TokenType::STRING)) {
+    auto expr = make<LiteralExpr>(
+        std::string(std::get<std::string_view>(previous().literal)));
     expr->line = line;
     return expr;
   }
 
-  if (match({TokenType::TRUE})) {
-    auto expr = std::make_unique<LiteralExpr>(true);
+  if (match(TokenType::TRUE)) {
+    auto expr = make<LiteralExpr>(true);
     expr->line = line;
     return expr;
   }
 
-  if (match({TokenType::FALSE})) {
-    auto expr = std::make_unique<LiteralExpr>(false);
+  if (match(TokenType::FALSE)) {
+    auto expr = make<LiteralExpr>(false);
     expr->line = line;
     return expr;
   }
 
-  if (match({TokenType::NIL})) {
-    auto expr = std::make_unique<NilExpr>();
+  if (match(TokenType::NIL)) {
+    auto expr = make<NilExpr>();
     expr->line = line;
     return expr;
   }
 
-  if (match({TokenType::SELF})) {
-    auto expr = std::make_unique<SelfExpr>();
+  if (match(TokenType::SELF)) {
+    auto expr = make<SelfExpr>();
     expr->line = line;
     return expr;
   }
 
-  if (match({TokenType::IDENTIFIER})) {
-    Token ident = previous();
+  if (match(TokenType::IDENTIFIER)) {
+    const Token &ident = previous();
 
     // check if it's a class instantiation
     if (declaredClasses.count(ident.lexeme) > 0 && check(TokenType::LPAREN)) {
@@ -72,10 +72,10 @@ std::unique_ptr<Expr> Parser::primary() {
           return constructor;
         }
       } else {
-        auto expr = std::make_unique<VarExpr>(ident.lexeme);
+        auto expr = make<VarExpr>(intern(ident.lexeme));
         expr->line = line;
 
-        if (match({TokenType::LBRACE})) {
+        if (match(TokenType::LBRACE)) {
           error("Unexpected '{' after identifier", peek().line);
           return expr;
         }
@@ -88,14 +88,14 @@ std::unique_ptr<Expr> Parser::primary() {
       return functionCall();
     }
 
-    auto expr = std::make_unique<VarExpr>(ident.lexeme);
+    auto expr = make<VarExpr>(intern(ident.lexeme));
     expr->line = line;
     return expr;
   }
 
-  if (match({TokenType::LPAREN})) {
+  if (match(TokenType::LPAREN)) {
     auto expr = expression();
-    if (!match({TokenType::RPAREN})) {
+    if (!match(TokenType::RPAREN) && !expressionTooDeep) {
       error("Expected ')' after expression", line);
     }
     return expr;
@@ -105,7 +105,7 @@ std::unique_ptr<Expr> Parser::primary() {
   if (!isAtEnd()) {
       advance();
   }
-  auto expr = std::make_unique<LiteralExpr>((int64_t)0);
+  auto expr = make<LiteralExpr>((int64_t)0);
   expr->line = line;
   return expr;
 }
@@ -1,46 +1,22 @@
 #include "../../include/parser.h"
 #include "../../include/token.h"
 #include <iostream>
-#include <sstream>
+#include <utility>
 
 namespace HolyLua {
 
-Parser::Parser(const std::vector<Token> &tokens, const std::string &source)
-    : tokens(tokens), source(source) {
-  initSourceLines();
-}
-
-void Parser::initSourceLines() {
-  std::stringstream ss(source);
-  std::string line;
-  while (std::getline(ss, line)) {
-    sourceLines.push_back(line);
-  }
-}
+Parser::Parser(std::vector<Token> tokens, const SourceManager &sources)
+    : tokens(std::move(tokens)), arena(std::make_unique<AstArena>()),
+      sources(sources) {}
 
 void Parser::error(const std::string &msg, int line) {
+  errorCount++;
   std::cerr << "\033[1;31mError:\033[0m " << msg << "\n";
   showErrorContext(line);
 }
 
 void Parser::showErrorContext(int line) {
-  if (line < 1 || line > (int)sourceLines.size())
-    return;
-
-  int lineIdx = line - 1;
-
-  if (lineIdx > 0) {
-    std::cerr << "  " << (lineIdx) << " | " << sourceLines[lineIdx - 1] << "\n";
-  }
-
-  std::cerr << "\033[1;33m> " << line << " | " << sourceLines[lineIdx]
-            << "\033[0m\n";
-
-  if (lineIdx < (int)sourceLines.size() - 1) {
-    std::cerr << "  " << (lineIdx + 2) << " | " << sourceLines[lineIdx + 1]
-              << "\n";
-  }
-  std::cerr << "\n";
+  sources.printContext(std::cerr, line);
 }
 
 Program Parser::parse() {
@@ -51,6 +27,7 @@ Program Parser::parse() {
     if (!isAtEnd() && peek().type != TokenType::END_OF_FILE) {
       auto stmt = statement();
       if (stmt) {
+        program.declarations.add(stmt.get());
         program.statements.push_back(std::move(stmt));
       } else {
         // if parsing fails just stop there
@@ -59,6 +36,8 @@ Program Parser::parse() {
     }
   }
 
+  // the nodes go with the program, a later parse() starts a new arena
+  program.arena = std::exchange(arena, std::make_unique<AstArena>());
   return program;
 }
 
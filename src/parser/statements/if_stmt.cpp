@@ -8,14 +8,14 @@ std::unique_ptr<IfStmt> Parser::ifStatement() {
 
   auto condition = expression();
 
-  if (!match({TokenType::THEN})) {
+  if (!match(TokenType::THEN)) {
     error("Expected 'then' after if condition", peek().line);
     return nullptr;
   }
 
   skipNewlines();
 
-  auto ifStmt = std::make_unique<IfStmt>(std::move(condition));
+  auto ifStmt = make<IfStmt>(std::move(condition));
   ifStmt->line = ifLine;
 
   // parse then block
@@ -30,10 +30,10 @@ std::unique_ptr<IfStmt> Parser::ifStatement() {
   }
 
   // parse elseif branches
-  while (match({TokenType::ELSEIF})) {
+  while (match(TokenType::ELSEIF)) {
     auto elseifCondition = expression();
 
-    if (!match({TokenType::THEN})) {
+    if (!match(TokenType::THEN)) {
       error("Expected 'then' after elseif condition", peek().line);
       return nullptr;
     }
@@ -56,7 +56,7 @@ std::unique_ptr<IfStmt> Parser::ifStatement() {
   }
 
   // parse optional else block
-  if (match({TokenType::ELSE})) {
+  if (match(TokenType::ELSE)) {
     skipNewlines();
     while (!check(TokenType::END) && !isAtEnd()) {
       skipNewlines();
@@ -69,7 +69,7 @@ std::unique_ptr<IfStmt> Parser::ifStatement() {
     }
   }
 
-  if (!match({TokenType::END})) {
+  if (!match(TokenType::END)) {
     error("Expected 'end' to close if statement", peek().line);
     return nullptr;
   }
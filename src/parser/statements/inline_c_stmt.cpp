@@ -12,12 +12,12 @@ std::unique_ptr<InlineCStmt> Parser::inlineCStatement() {
   }
   advance();
 
-  if (!match({TokenType::LBRACKET})) {
+  if (!match(TokenType::LBRACKET)) {
     error("Expected '[' after 'C'", peek().line);
     return nullptr;
   }
 
-  if (!match({TokenType::LBRACKET})) {
+  if (!match(TokenType::LBRACKET)) {
     error("Expected second '[' for C[[ syntax", peek().line);
     return nullptr;
   }
@@ -35,14 +35,14 @@ std::unique_ptr<InlineCStmt> Parser::inlineCStatement() {
       }
     }
 
-    Token token = advance();
+    const Token &token = advance();
     if (token.type == TokenType::NEWLINE) {
       cCode += "\n";
       continue;
     }
 
     if (token.type == TokenType::STRING) {
-      cCode += "\"" + std::get<std::string>(token.literal) + "\"";
+      cCode += "\"" + std::string(std::get<std::string_view>(token.literal)) + "\"";
     } else {
       cCode += token.lexeme;
     }
@@ -53,12 +53,12 @@ std::unique_ptr<InlineCStmt> Parser::inlineCStatement() {
     }
   }
 
-  if (!match({TokenType::RBRACKET})) {
+  if (!match(TokenType::RBRACKET)) {
     error("Expected ']]' to close inline C block", peek().line);
     return nullptr;
   }
 
-  if (!match({TokenType::RBRACKET})) {
+  if (!match(TokenType::RBRACKET)) {
     error("Expected second ']' for ]] syntax", peek().line);
     return nullptr;
   }
@@ -67,7 +67,7 @@ std::unique_ptr<InlineCStmt> Parser::inlineCStatement() {
     cCode.pop_back();
   }
 
-  auto inlineC = std::make_unique<InlineCStmt>(cCode);
+  auto inlineC = make<InlineCStmt>(cCode);
   inlineC->line = line;
   skipNewlines();
   return inlineC;
@@ -12,7 +12,7 @@ std::unique_ptr<WhileStmt> Parser::whileStatement() {
     return nullptr;
   }
 
-  if (!match({TokenType::DO})) {
+  if (!match(TokenType::DO)) {
     error("Expected 'do' after while condition", peek().line);
     synchronize();
     return nullptr;
@@ -20,7 +20,7 @@ std::unique_ptr<WhileStmt> Parser::whileStatement() {
 
   skipNewlines();
 
-  auto whileStmt = std::make_unique<WhileStmt>(std::move(condition));
+  auto whileStmt = make<WhileStmt>(std::move(condition));
   whileStmt->line = whileLine;
 
   // parse while loop body
@@ -39,7 +39,7 @@ std::unique_ptr<WhileStmt> Parser::whileStatement() {
     }
   }
 
-  if (!match({TokenType::END})) {
+  if (!match(TokenType::END)) {
     error("Expected 'end' to close while statement", peek().line);
     synchronize();
     return nullptr;
@@ -51,7 +51,7 @@ std::unique_ptr<WhileStmt> Parser::whileStatement() {
 
 std::unique_ptr<RepeatStmt> Parser::repeatStatement() {
   int repeatLine = previous().line;
-  auto repeatStmt = std::make_unique<RepeatStmt>(nullptr);
+  auto repeatStmt = make<RepeatStmt>(nullptr);
   repeatStmt->line = repeatLine;
 
   skipNewlines();
@@ -72,7 +72,7 @@ std::unique_ptr<RepeatStmt> Parser::repeatStatement() {
     }
   }
 
-  if (!match({TokenType::UNTIL})) {
+  if (!match(TokenType::UNTIL)) {
     error("Expected 'until' after repeat body", peek().line);
     synchronize();
     return nullptr;
@@ -92,12 +92,12 @@ std::unique_ptr<RepeatStmt> Parser::repeatStatement() {
 std::unique_ptr<ForStmt> Parser::forStatement() {
   int forLine = previous().line;
 
-  if (!match({TokenType::LOCAL})) {
+  if (!match(TokenType::LOCAL)) {
     error("Expected 'local' in for loop declaration", peek().line);
     while (!check(TokenType::END) && !isAtEnd()) {
       advance();
     }
-    if (match({TokenType::END})) {
+    if (match(TokenType::END)) {
       skipNewlines();
     }
     return nullptr;
@@ -109,9 +109,9 @@ std::unique_ptr<ForStmt> Parser::forStatement() {
     return nullptr;
   }
 
-  Token varName = advance();
+  const Token &varName = advance();
 
-  if (!match({TokenType::ASSIGN})) {
+  if (!match(TokenType::ASSIGN)) {
     error("Expected '=' after for loop variable", peek().line);
     synchronize();
     return nullptr;
@@ -123,7 +123,7 @@ std::unique_ptr<ForStmt> Parser::forStatement() {
     return nullptr;
   }
 
-  if (!match({TokenType::COMMA})) {
+  if (!match(TokenType::COMMA)) {
     error("Expected ',' after start value", peek().line);
     synchronize();
     return nullptr;
@@ -136,7 +136,7 @@ std::unique_ptr<ForStmt> Parser::forStatement() {
   }
 
   std::unique_ptr<Expr> step = nullptr;
-  if (match({TokenType::COMMA})) {
+  if (match(TokenType::COMMA)) {
     step = expression();
     if (!step) {
       synchronize();
@@ -144,7 +144,7 @@ std::unique_ptr<ForStmt> Parser::forStatement() {
     }
   }
 
-  if (!match({TokenType::DO})) {
+  if (!match(TokenType::DO)) {
     error("Expected 'do' after for loop range", peek().line);
     synchronize();
     return nullptr;
@@ -152,8 +152,8 @@ std::unique_ptr<ForStmt> Parser::forStatement() {
 
   skipNewlines();
 
-  auto forStmt = std::make_unique<ForStmt>(varName.lexeme, std::move(start),
-                                           std::move(end), std::move(step));
+  auto forStmt = make<ForStmt>(intern(varName.lexeme), std::move(start),
+                               std::move(end), std::move(step));
   forStmt->line = forLine;
 
   // parse for loop body
@@ -172,7 +172,7 @@ std::unique_ptr<ForStmt> Parser::forStatement() {
     }
   }
 
-  if (!match({TokenType::END})) {
+  if (!match(TokenType::END)) {
     error("Expected 'end' to close for loop", peek().line);
     synchronize();
     return nullptr;
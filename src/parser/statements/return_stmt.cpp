@@ -5,7 +5,7 @@ namespace HolyLua {
 
 std::unique_ptr<ReturnStmt> Parser::returnStatement() {
   int returnLine = previous().line;
-  auto returnStmt = std::make_unique<ReturnStmt>();
+  auto returnStmt = make<ReturnStmt>();
 
   if (!check(TokenType::NEWLINE) && !check(TokenType::END) && !isAtEnd()) {
     returnStmt->value = expression();
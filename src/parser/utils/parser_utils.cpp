@@ -3,30 +3,38 @@
 
 namespace HolyLua {
 
-bool Parser::isAtEnd() { 
+bool Parser::isAtEnd() const { 
   return peek().type == TokenType::END_OF_FILE; 
 }
 
-Token Parser::peek() { 
+const Token &Parser::peek() const { 
   return tokens[current]; 
 }
 
-Token Parser::previous() { 
+const Token &Parser::previous() const { 
   return tokens[current - 1]; 
 }
 
-Token Parser::advance() {
+const Token &Parser::advance() {
   if (!isAtEnd())
     current++;
   return previous();
 }
 
-bool Parser::check(TokenType type) {
+bool Parser::check(TokenType type) const {
   if (isAtEnd())
     return false;
   return peek().type == type;
 }
 
+bool Parser::match(TokenType type) {
+  if (check(type)) {
+    advance();
+    return true;
+  }
+  return false;
+}
+
 bool Parser::match(std::initializer_list<TokenType> types) {
   for (TokenType type : types) {
     if (check(type)) {
@@ -38,28 +46,30 @@ bool Parser::match(std::initializer_list<TokenType> types) {
 }
 
 void Parser::skipNewlines() {
-  while (match({TokenType::NEWLINE})) {
+  while (match(TokenType::NEWLINE)) {
   }
 }
 
-bool Parser::peekNextIs(TokenType type) {
+bool Parser::peekNextIs(TokenType type) const {
   if (isAtEnd() || current + 1 >= tokens.size())
     return false;
   return tokens[current + 1].type == type;
 }
 
 ValueType Parser::parseType() {
-  if (match({TokenType::TYPE_NUMBER}))
+  if (match(TokenType::TYPE_NUMBER))
     return ValueType::NUMBER;
-  if (match({TokenType::TYPE_STRING}))
+  if (match(TokenType::TYPE_STRING))
     return ValueType::STRING;
-  if (match({TokenType::TYPE_BOOL}))
+  if (match(TokenType::TYPE_BOOL))
     return ValueType::BOOL;
+  if (match(TokenType::TYPE_INT))
+    return ValueType::INT;
   
   // check if it's a struct, class, or enum type identifier
   if (check(TokenType::IDENTIFIER)) {
-    Token typeToken = advance();
-    std::string typeName = typeToken.lexeme;
+    const Token &typeToken = advance();
+    std::string typeName(typeToken.lexeme);
     
     // check if it's a declared struct, class, or enum
     if (declaredStructs.count(typeName) > 0 || declaredClasses.count(typeName) > 0) {
@@ -0,0 +1,110 @@
+#include "../../include/utils/build_cache.h"
+#include "../../include/utils/content_hash.h"
+#include "../../include/utils/mapped_file.h"
+#include <cstdio>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace HolyLua {
+
+namespace {
+
+const char *artifactName(BuildCache::Artifact artifact) {
+  switch (artifact) {
+  case BuildCache::Artifact::EXECUTABLE:
+    return "executable";
+  case BuildCache::Artifact::C_SOURCE:
+    return "C source";
+  case BuildCache::Artifact::OBJECT:
+    return "object";
+  }
+  return "";
+}
+
+const char *artifactExtension(BuildCache::Artifact artifact) {
+  switch (artifact) {
+  case BuildCache::Artifact::EXECUTABLE:
+#ifdef _WIN32
+    return ".exe";
+#else
+    return ".bin";
+#endif
+  case BuildCache::Artifact::C_SOURCE:
+    return ".c";
+  case BuildCache::Artifact::OBJECT:
+    return ".o";
+  }
+  return "";
+}
+
+} // namespace
+
+BuildCache::BuildCache(std::string directory) : directory(std::move(directory)) {
+  std::error_code ec;
+  fs::create_directories(this->directory, ec);
+}
+
+std::string BuildCache::pathFor(Artifact artifact, uint64_t key) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx%s",
+                static_cast<unsigned long long>(key), artifactExtension(artifact));
+  return (fs::path(directory) / name).string();
+}
+
+std::string BuildCache::stagingPathFor(Artifact artifact, uint64_t key) const {
+  return pathFor(artifact, key) + ".tmp";
+}
+
+bool BuildCache::contains(Artifact artifact, uint64_t key) {
+  std::error_code ec;
+  bool found = fs::is_regular_file(pathFor(artifact, key), ec);
+  (found ? hits : misses)[static_cast<int>(artifact)]++;
+  return found;
+}
+
+bool BuildCache::fetch(Artifact artifact, uint64_t key,
+                       const std::string &destination) const {
+  // copied next to the destination and renamed over it, which also works
+  // while the previous build of the program is still running
+  std::string temporary = destination + ".tmp";
+  std::error_code ec;
+  fs::copy_file(pathFor(artifact, key), temporary,
+                fs::copy_options::overwrite_existing, ec);
+  if (!ec) {
+    fs::rename(temporary, destination, ec);
+  }
+  if (ec) {
+    fs::remove(temporary, ec);
+    return false;
+  }
+  return true;
+}
+
+bool BuildCache::commit(Artifact artifact, uint64_t key) const {
+  std::error_code ec;
+  fs::rename(stagingPathFor(artifact, key), pathFor(artifact, key), ec);
+  return !ec;
+}
+
+uint64_t BuildCache::hashFile(const std::string &path) {
+  MappedFile file;
+  if (!file.open(path)) {
+    return 0;
+  }
+  return contentHash(file.view());
+}
+
+void BuildCache::report(std::ostream &out) const {
+  out << "Build cache (" << directory << "):\n";
+  for (int i = 0; i < ARTIFACT_COUNT; i++) {
+    if (hits[i] == 0 && misses[i] == 0) {
+      continue;
+    }
+    out << "  " << artifactName(static_cast<Artifact>(i)) << ": " << hits[i]
+        << (hits[i] == 1 ? " hit, " : " hits, ") << misses[i]
+        << (misses[i] == 1 ? " miss\n" : " misses\n");
+  }
+}
+
+} // namespace HolyLua
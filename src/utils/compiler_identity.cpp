@@ -0,0 +1,59 @@
+#include "../../include/utils/compiler_identity.h"
+#include "../../include/utils/content_hash.h"
+#include "../../include/utils/mapped_file.h"
+#include "../../include/version.h"
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace HolyLua {
+
+namespace {
+
+std::string executablePath() {
+#ifdef _WIN32
+  char path[MAX_PATH];
+  DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+  return length > 0 && length < MAX_PATH ? std::string(path, length) : "";
+#elif defined(__APPLE__)
+  uint32_t size = 0;
+  _NSGetExecutablePath(nullptr, &size);
+  std::string path(size, '\0');
+  if (_NSGetExecutablePath(&path[0], &size) != 0) {
+    return "";
+  }
+  path.resize(std::strlen(path.c_str()));
+  return path;
+#else
+  std::error_code error;
+  fs::path path = fs::read_symlink("/proc/self/exe", error);
+  return error ? "" : path.string();
+#endif
+}
+
+} // namespace
+
+uint64_t compilerIdentity() {
+  static const uint64_t identity = [] {
+    uint64_t version = contentHash(HOLYLUA_VERSION);
+    MappedFile self;
+    std::string path = executablePath();
+    if (path.empty() || !self.open(path)) {
+      // the binary cannot be read back: tell builds apart by when this
+      // file was compiled instead
+      return hashCombine(version, contentHash(__DATE__ " " __TIME__));
+    }
+    return hashCombine(version, contentHash(self.view()));
+  }();
+  return identity;
+}
+
+} // namespace HolyLua
@@ -0,0 +1,31 @@
+#include "../../include/utils/content_hash.h"
+#include <cstring>
+
+namespace HolyLua {
+
+namespace {
+constexpr uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+}
+
+uint64_t contentHash(std::string_view data, uint64_t seed) {
+  // word-at-a-time multiply/xor-shift
+  uint64_t hash = (0xcbf29ce484222325ull ^ seed) ^ (data.size() * PRIME);
+  size_t i = 0;
+  for (; i + 8 <= data.size(); i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data.data() + i, 8);
+    hash = (hash ^ word) * PRIME;
+    hash ^= hash >> 29;
+  }
+  uint64_t tail = 0;
+  std::memcpy(&tail, data.data() + i, data.size() - i);
+  hash = (hash ^ tail) * PRIME;
+  return hash ^ (hash >> 32);
+}
+
+uint64_t hashCombine(uint64_t seed, uint64_t value) {
+  uint64_t hash = (seed ^ value) * PRIME;
+  return hash ^ (hash >> 32);
+}
+
+} // namespace HolyLua
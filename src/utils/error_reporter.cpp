@@ -1,44 +1,25 @@
 #include "../../include/utils/error_reporter.h"
-#include <sstream>
 
 namespace HolyLua {
 
-ErrorReporter::ErrorReporter(const std::string &source) : source(source), errorCount(0) {
-    initSourceLines();
-}
-
-void ErrorReporter::initSourceLines() {
-    std::stringstream ss(source);
-    std::string line;
-    while (std::getline(ss, line)) {
-        sourceLines.push_back(line);
-    }
-}
+ErrorReporter::ErrorReporter(const SourceManager &sources, std::ostream &out)
+    : sources(sources), out(out), errorCount(0) {}
 
 void ErrorReporter::reportError(const std::string &msg, int line) {
-    std::cerr << "\033[1;31mType Error:\033[0m " << msg << "\n";
+    out << "\033[1;31mType Error:\033[0m " << msg << "\n";
     showErrorContext(line);
     errorCount++;
 }
 
 void ErrorReporter::showErrorContext(int line) {
-    if (line < 1 || line > static_cast<int>(sourceLines.size()))
-        return;
-
-    int lineIdx = line - 1;
-
-    if (lineIdx > 0) {
-        std::cerr << "  " << (lineIdx) << " | " << sourceLines[lineIdx - 1] << "\n";
-    }
-
-    std::cerr << "\033[1;33m> " << line << " | " << sourceLines[lineIdx]
-              << "\033[0m\n";
+    sources.printContext(out, line);
+}
 
-    if (lineIdx < static_cast<int>(sourceLines.size()) - 1) {
-        std::cerr << "  " << (lineIdx + 2) << " | " << sourceLines[lineIdx + 1]
-                  << "\n";
+void ErrorReporter::replay(const std::string &diagnostics, int errors) {
+    if (!diagnostics.empty()) {
+        out << diagnostics;
     }
-    std::cerr << "\n";
+    errorCount += errors;
 }
 
-} // namespace HolyLua
\ No newline at end of file
+} // namespace HolyLua
@@ -0,0 +1,73 @@
+#include "../../include/utils/mapped_file.h"
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HolyLua {
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string &path) {
+  close();
+
+#ifndef _WIN32
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    length = static_cast<size_t>(st.st_size);
+    if (length == 0) {
+      ::close(fd);
+      data = "";
+      return true;
+    }
+
+    void *addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr != MAP_FAILED) {
+      madvise(addr, length, MADV_SEQUENTIAL);
+      data = static_cast<const char *>(addr);
+      mapped = true;
+      return true;
+    }
+    length = 0;
+  } else {
+    ::close(fd);
+  }
+#endif
+
+  // not mappable (pipes, special files, no mmap), read it instead
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::stringstream ss;
+  ss << file.rdbuf();
+  buffer = ss.str();
+  data = buffer.data();
+  length = buffer.size();
+  return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+  if (mapped) {
+    munmap(const_cast<char *>(data), length);
+  }
+#endif
+  data = nullptr;
+  length = 0;
+  mapped = false;
+  buffer.clear();
+}
+
+} // namespace HolyLua
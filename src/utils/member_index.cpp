@@ -0,0 +1,108 @@
+#include "../../include/common.h"
+
+namespace HolyLua {
+
+// the first declaration of a name wins, matching a front-to-back scan of
+// the member lists. duplicates are reported by the validators.
+static MemberInfo *addMember(MemberIndex &members, const std::string &name) {
+  auto inserted = members.try_emplace(name);
+  return inserted.second ? &inserted.first->second : nullptr;
+}
+
+void ClassInfo::indexMembers(const ClassDecl &decl) {
+  members.clear();
+  members.reserve(decl.fields.size() + decl.methods.size() + 1);
+
+  for (size_t i = 0; i < decl.fields.size(); i++) {
+    const auto &field = decl.fields[i];
+    MemberInfo *member = addMember(members, field.name);
+    if (!member) {
+      continue;
+    }
+    member->kind = MemberKind::FIELD;
+    member->type = field.type;
+    member->visibility = field.visibility;
+    member->isStatic = field.isStatic;
+    member->isOptional = field.isOptional;
+    member->structTypeName = field.structTypeName;
+    member->cName = field.isStatic ? decl.name + "_" + field.name : field.name;
+    member->slot = i;
+  }
+
+  for (size_t i = 0; i < decl.methods.size(); i++) {
+    const auto &method = decl.methods[i];
+    MemberInfo *member = addMember(members, method.name);
+    if (!member) {
+      continue;
+    }
+    member->kind = MemberKind::METHOD;
+    member->type = method.returnType;
+    member->visibility = method.visibility;
+    member->isStatic = method.isStatic;
+    member->isOptional = false;
+    member->structTypeName = TypeName();
+    member->cName = (method.isStatic && method.name == "new")
+                       ? decl.name + "_static_new"
+                       : decl.name + "_" + method.name;
+    member->slot = i;
+  }
+
+  if (decl.constructor) {
+    MemberInfo *member = addMember(members, "__init");
+    if (!member) {
+      return;
+    }
+    member->kind = MemberKind::METHOD;
+    member->type = ValueType::INFERRED;
+    member->visibility = Visibility::PUBLIC;
+    member->isStatic = false;
+    member->isOptional = false;
+    member->structTypeName = TypeName();
+    member->cName = decl.name + "_new";
+    member->slot = decl.methods.size();
+  }
+}
+
+const MemberInfo *ClassInfo::findField(const std::string &member) const {
+  auto it = members.find(member);
+  if (it == members.end() || it->second.kind != MemberKind::FIELD) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+const MemberInfo *ClassInfo::findMethod(const std::string &member) const {
+  auto it = members.find(member);
+  if (it == members.end() || it->second.kind != MemberKind::METHOD) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+void StructInfo::indexMembers(const StructDecl &decl) {
+  members.clear();
+  members.reserve(decl.fields.size());
+
+  for (size_t i = 0; i < decl.fields.size(); i++) {
+    const auto &field = decl.fields[i];
+    MemberInfo *member = addMember(members, field.name);
+    if (!member) {
+      continue;
+    }
+    member->kind = MemberKind::FIELD;
+    member->type = field.type;
+    member->visibility = Visibility::PUBLIC;
+    member->isStatic = false;
+    member->isOptional = field.isOptional;
+    member->structTypeName = field.structTypeName;
+    member->cName = field.name;
+    member->slot = i;
+  }
+}
+
+const MemberInfo *StructInfo::findField(const std::string &member) const {
+  auto it = members.find(member);
+  return it == members.end() ? nullptr : &it->second;
+}
+
+} // namespace HolyLua
@@ -0,0 +1,48 @@
+#include "../../include/utils/parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace HolyLua {
+
+void parallelFor(size_t count, unsigned jobs,
+                 const std::function<void(unsigned worker, size_t index)> &task) {
+  unsigned workers = static_cast<unsigned>(
+      std::min<size_t>(std::max(1u, jobs), count));
+  if (workers == 0) {
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  std::vector<std::exception_ptr> failures(workers);
+
+  auto work = [&](unsigned worker) {
+    try {
+      for (size_t i = next++; i < count; i = next++) {
+        task(worker, i);
+      }
+    } catch (...) {
+      failures[worker] = std::current_exception();
+      next = count;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned worker = 1; worker < workers; worker++) {
+    threads.emplace_back(work, worker);
+  }
+  work(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (const auto &failure : failures) {
+    if (failure) {
+      std::rethrow_exception(failure);
+    }
+  }
+}
+
+} // namespace HolyLua
@@ -0,0 +1,173 @@
+#include "../../include/utils/pass_timer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <new>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocatedBytes{0};
+
+void *allocate(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  void *ptr = std::malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+} // namespace
+
+// counting is two relaxed atomic adds, cheap enough to leave on when the
+// report is not requested
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace HolyLua {
+
+namespace {
+
+// cpu time and peak RSS of this process, or of its waited-for children
+PassSample snapshot(bool children) {
+  PassSample sample;
+  sample.allocations = allocationCount.load(std::memory_order_relaxed);
+  sample.allocatedBytes = allocatedBytes.load(std::memory_order_relaxed);
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(children ? RUSAGE_CHILDREN : RUSAGE_SELF, &usage) == 0) {
+    sample.cpuMs = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+                   (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+#ifdef __APPLE__
+    sample.peakRssKb = usage.ru_maxrss / 1024;
+#else
+    sample.peakRssKb = usage.ru_maxrss;
+#endif
+  }
+#else
+  // no child accounting or RSS high-water mark without psapi
+  if (!children) {
+    sample.cpuMs = 1000.0 * std::clock() / CLOCKS_PER_SEC;
+  }
+#endif
+  return sample;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void writeJsonSample(std::ostream &out, const PassSample &sample) {
+  out << "\"wall_ms\": " << sample.wallMs << ", \"cpu_ms\": " << sample.cpuMs
+      << ", \"allocations\": " << sample.allocations
+      << ", \"allocated_bytes\": " << sample.allocatedBytes
+      << ", \"peak_rss_kb\": " << sample.peakRssKb;
+}
+
+void writeRow(std::ostream &out, const PassSample &sample,
+              const std::string &name, int depth) {
+  out << std::setw(11) << sample.wallMs << std::setw(11) << sample.cpuMs
+      << std::setw(12) << sample.allocations << std::setw(12)
+      << sample.allocatedBytes / 1024 << std::setw(13) << sample.peakRssKb
+      << "  " << std::string(depth * 2, ' ') << name << "\n";
+}
+
+} // namespace
+
+PassTimer::PassTimer()
+    : start(snapshot(false)), childrenStart(snapshot(true)),
+      wallStart(std::chrono::steady_clock::now()) {}
+
+PassTimer::Scope::Scope(PassTimer *timer, const std::string &name,
+                        bool external)
+    : timer(timer), external(external) {
+  if (!timer) {
+    return;
+  }
+  index = timer->phases.size();
+  timer->phases.push_back({name, timer->depth++, PassSample()});
+  start = snapshot(external);
+  wallStart = std::chrono::steady_clock::now();
+}
+
+PassTimer::Scope::~Scope() {
+  if (!timer) {
+    return;
+  }
+  PassSample end = snapshot(external);
+  PassSample &sample = timer->phases[index].sample;
+  sample.wallMs = millisecondsSince(wallStart);
+  sample.cpuMs = end.cpuMs - start.cpuMs;
+  sample.allocations = end.allocations - start.allocations;
+  sample.allocatedBytes = end.allocatedBytes - start.allocatedBytes;
+  sample.peakRssKb = end.peakRssKb;
+  timer->depth--;
+}
+
+PassSample PassTimer::total() const {
+  PassSample self = snapshot(false);
+  PassSample children = snapshot(true);
+  PassSample sample;
+  sample.wallMs = millisecondsSince(wallStart);
+  sample.cpuMs = (self.cpuMs - start.cpuMs) +
+                 (children.cpuMs - childrenStart.cpuMs);
+  sample.allocations = self.allocations - start.allocations;
+  sample.allocatedBytes = self.allocatedBytes - start.allocatedBytes;
+  sample.peakRssKb = std::max(self.peakRssKb, children.peakRssKb);
+  return sample;
+}
+
+void PassTimer::report(std::ostream &out) const {
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(3);
+
+  out << "===--- pass timing ---===\n";
+  out << std::setw(11) << "wall ms" << std::setw(11) << "cpu ms"
+      << std::setw(12) << "allocs" << std::setw(12) << "alloc KB"
+      << std::setw(13) << "peak RSS KB" << "  phase\n";
+  for (const auto &phase : phases) {
+    writeRow(out, phase.sample, phase.name, phase.depth);
+  }
+  writeRow(out, total(), "total", 0);
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void PassTimer::reportJson(std::ostream &out) const {
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(3);
+
+  out << "{\"phases\": [";
+  for (size_t i = 0; i < phases.size(); i++) {
+    const auto &phase = phases[i];
+    out << (i ? ",\n  " : "\n  ") << "{\"name\": \"" << phase.name
+        << "\", \"depth\": " << phase.depth << ", ";
+    writeJsonSample(out, phase.sample);
+    out << "}";
+  }
+  out << "\n], \"total\": {";
+  writeJsonSample(out, total());
+  out << "}}\n";
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+} // namespace HolyLua
@@ -0,0 +1,173 @@
+#include "../../include/utils/process.h"
+#include <cstdio>
+#include <iostream>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+namespace HolyLua {
+
+namespace {
+
+std::vector<char *> argvOf(const std::vector<std::string> &args) {
+  std::vector<char *> argv;
+  argv.reserve(args.size() + 1);
+  for (const std::string &arg : args) {
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  return argv;
+}
+
+#ifdef _WIN32
+// _spawnvp joins argv with spaces, so arguments need their own quotes
+std::string quote(const std::string &arg) {
+  if (!arg.empty() && arg.find_first_of(" \t\"") == std::string::npos) {
+    return arg;
+  }
+  std::string quoted = "\"";
+  for (char c : arg) {
+    if (c == '"') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+#endif
+
+} // namespace
+
+#ifndef _WIN32
+
+int runProcess(const std::vector<std::string> &args,
+               const std::string_view *input) {
+  // whatever we printed so far has to come out before the child's output
+  std::cout.flush();
+  std::cerr.flush();
+
+  int pipeFds[2] = {-1, -1};
+  if (input && pipe(pipeFds) != 0) {
+    return -1;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (input) {
+    posix_spawn_file_actions_adddup2(&actions, pipeFds[0], STDIN_FILENO);
+    posix_spawn_file_actions_addclose(&actions, pipeFds[0]);
+    posix_spawn_file_actions_addclose(&actions, pipeFds[1]);
+  }
+  posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+  std::vector<char *> argv = argvOf(args);
+  pid_t pid;
+  int spawnError =
+      posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (input) {
+    close(pipeFds[0]);
+    if (spawnError == 0) {
+      // a child that exits early closes the pipe; that has to surface as a
+      // failed write here, not as SIGPIPE killing the compiler
+      struct sigaction ignore = {}, previous;
+      ignore.sa_handler = SIG_IGN;
+      sigaction(SIGPIPE, &ignore, &previous);
+
+      const char *data = input->data();
+      size_t remaining = input->size();
+      while (remaining > 0) {
+        ssize_t written = write(pipeFds[1], data, remaining);
+        if (written < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          break;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+      }
+
+      sigaction(SIGPIPE, &previous, nullptr);
+    }
+    close(pipeFds[1]);
+  }
+
+  if (spawnError != 0) {
+    return -1;
+  }
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return -1;
+    }
+  }
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int execProgram(const std::string &path) {
+  std::cout.flush();
+  std::cerr.flush();
+
+  std::vector<std::string> args = {path};
+  std::vector<char *> argv = argvOf(args);
+  execv(path.c_str(), argv.data());
+  return -1;
+}
+
+#else
+
+int runProcess(const std::vector<std::string> &args,
+               const std::string_view *input) {
+  std::cout.flush();
+  std::cerr.flush();
+
+  std::vector<std::string> quoted;
+  for (const std::string &arg : args) {
+    quoted.push_back(quote(arg));
+  }
+
+  if (!input) {
+    std::vector<char *> argv = argvOf(quoted);
+    intptr_t status = _spawnvp(_P_WAIT, args[0].c_str(), argv.data());
+    return static_cast<int>(status);
+  }
+
+  // no spawn call here takes a stdin handle, so the input goes through a
+  // pipe opened by _popen
+  std::string command;
+  for (const std::string &arg : quoted) {
+    command += (command.empty() ? "" : " ") + arg;
+  }
+  command += " 2>&1";
+  FILE *pipe = _popen(command.c_str(), "wb");
+  if (!pipe) {
+    return -1;
+  }
+  fwrite(input->data(), 1, input->size(), pipe);
+  return _pclose(pipe);
+}
+
+int execProgram(const std::string &path) {
+  std::cout.flush();
+  std::cerr.flush();
+
+  std::vector<std::string> args = {quote(path)};
+  std::vector<char *> argv = argvOf(args);
+  return static_cast<int>(_spawnv(_P_WAIT, path.c_str(), argv.data()));
+}
+
+#endif
+
+} // namespace HolyLua
@@ -0,0 +1,63 @@
+#include "../../include/utils/source_manager.h"
+
+namespace HolyLua {
+
+bool SourceManager::open(const std::string &path) {
+  filePath = path;
+  return file.open(path);
+}
+
+void SourceManager::buildLineIndex() const {
+  std::call_once(indexed, [this]() {
+    std::string_view source = text();
+    size_t pos = 0;
+    while (pos < source.size()) {
+      lineStarts.push_back(pos);
+      size_t newline = source.find('\n', pos);
+      if (newline == std::string_view::npos) {
+        break;
+      }
+      pos = newline + 1;
+    }
+  });
+}
+
+size_t SourceManager::lineCount() const {
+  buildLineIndex();
+  return lineStarts.size();
+}
+
+std::string_view SourceManager::line(size_t number) const {
+  buildLineIndex();
+  if (number < 1 || number > lineStarts.size()) {
+    return std::string_view();
+  }
+
+  std::string_view source = text();
+  size_t begin = lineStarts[number - 1];
+  size_t end = number < lineStarts.size() ? lineStarts[number] - 1
+                                          : source.size();
+  if (end > begin && number == lineStarts.size() && source[end - 1] == '\n') {
+    end--;
+  }
+  return source.substr(begin, end - begin);
+}
+
+void SourceManager::printContext(std::ostream &out, int line) const {
+  int count = static_cast<int>(lineCount());
+  if (line < 1 || line > count)
+    return;
+
+  if (line > 1) {
+    out << "  " << (line - 1) << " | " << this->line(line - 1) << "\n";
+  }
+
+  out << "\033[1;33m> " << line << " | " << this->line(line) << "\033[0m\n";
+
+  if (line < count) {
+    out << "  " << (line + 1) << " | " << this->line(line + 1) << "\n";
+  }
+  out << "\n";
+}
+
+} // namespace HolyLua
@@ -10,6 +10,8 @@ std::string TypeUtils::typeToString(ValueType type) {
         return "string";
     case ValueType::BOOL:
         return "bool";
+    case ValueType::INT:
+        return "int";
     case ValueType::FUNCTION:
         return "function";
     case ValueType::STRUCT:
@@ -30,9 +32,26 @@ bool TypeUtils::isCompatible(ValueType expected, ValueType actual) {
         return true;
     }
 
+    // an int widens to a number, the other way needs an explicit int
+    if (expected == ValueType::NUMBER && actual == ValueType::INT) {
+        return true;
+    }
+
     return expected == actual;
 }
 
+bool TypeUtils::isNumeric(ValueType type) {
+    return type == ValueType::NUMBER || type == ValueType::INT;
+}
+
+// integer constants are numbers unless they are stored into an int
+ValueType TypeUtils::valueTypeFor(ValueType target, const Expr *value, ValueType valueType) {
+    if (target == ValueType::INT && valueType == ValueType::NUMBER && isIntegerConstant(value)) {
+        return ValueType::INT;
+    }
+    return valueType;
+}
+
 std::string TypeUtils::binaryOpToString(BinaryOp op) {
     switch (op) {
     case BinaryOp::ADD:
@@ -85,6 +104,30 @@ bool TypeUtils::operatorRequiresType(BinaryOp op, ValueType &requiredType) {
     }
 }
 
+ValueType TypeUtils::binaryResultType(BinaryOp op) {
+    switch (op) {
+    case BinaryOp::CONCAT:
+        return ValueType::STRING;
+
+    case BinaryOp::EQUAL:
+    case BinaryOp::NOT_EQUAL:
+    case BinaryOp::LESS:
+    case BinaryOp::LESS_EQUAL:
+    case BinaryOp::GREATER:
+    case BinaryOp::GREATER_EQUAL:
+    case BinaryOp::AND:
+    case BinaryOp::OR:
+        return ValueType::BOOL;
+
+    case BinaryOp::NIL_COALESCE:
+        // depends on the operands
+        return ValueType::INFERRED;
+
+    default:
+        return ValueType::NUMBER;
+    }
+}
+
 ValueType TypeUtils::resolveTypeName(const std::string &typeName) {
     if (typeName == "number")
         return ValueType::NUMBER;
@@ -92,6 +135,8 @@ ValueType TypeUtils::resolveTypeName(const std::string &typeName) {
         return ValueType::STRING;
     if (typeName == "bool")
         return ValueType::BOOL;
+    if (typeName == "int")
+        return ValueType::INT;
     if (typeName == "function")
         return ValueType::FUNCTION;
     return ValueType::INFERRED;
@@ -14,11 +14,16 @@ ValueType ExpressionValidator::validateExpression(const Expr *expr,
     if (!expr)
         return ValueType::INFERRED;
 
-    if (auto *lit = dynamic_cast<const LiteralExpr *>(expr)) {
-        return validateLiteral(lit);
-    } else if (dynamic_cast<const NilExpr *>(expr)) {
+    switch (expr->kind) {
+    case NodeKind::LITERAL: {
+        ValueType type = validateLiteral(static_cast<const LiteralExpr *>(expr));
+        expr->annotate(type);
+        return type;
+    }
+    case NodeKind::NIL:
         return ValueType::INFERRED;
-    } else if (auto *var = dynamic_cast<const VarExpr *>(expr)) {
+    case NodeKind::VAR: {
+        auto *var = static_cast<const VarExpr *>(expr);
         if (symbolTable.count(var->name)) {
             auto &info = symbolTable.at(var->name);
             if (info.isOptional) {
@@ -26,31 +31,89 @@ ValueType ExpressionValidator::validateExpression(const Expr *expr,
             }
         }
         return validateVariable(var, symbolTable);
-    } else if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
-        return validateFunctionCall(call, symbolTable, functionTable, structTable, classTable, currentClass);
-    } else if (auto *methodCall = dynamic_cast<const MethodCall *>(expr)) {
-        return validateMethodCall(methodCall, symbolTable, functionTable, 
-                                 structTable, classTable, currentClass);
-    } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
-        return validateBinaryExpr(bin, symbolTable, functionTable, structTable, classTable, currentClass);
-    } else if (auto *un = dynamic_cast<const UnaryExpr *>(expr)) {
-        return validateUnaryExpr(un, symbolTable);
-    } else if (auto *field = dynamic_cast<const FieldAccessExpr *>(expr)) {
-        return validateFieldAccess(field, symbolTable, structTable, classTable, currentClass);
-    } else if (auto *unwrap = dynamic_cast<const ForceUnwrapExpr *>(expr)) {
-        return validateForceUnwrap(unwrap, symbolTable);
-    } else if (auto *classInst = dynamic_cast<const ClassInstantiation *>(expr)) {
-        return validateClassInstantiation(classInst, classTable);
-    } else if (auto *structCons = dynamic_cast<const StructConstructor *>(expr)) {
+    }
+    case NodeKind::FUNCTION_CALL: {
+        ValueType type = validateFunctionCall(static_cast<const FunctionCall *>(expr), symbolTable,
+                                              functionTable, structTable, classTable, currentClass);
+        // a call or field access the checker could not resolve is left to
+        // codegen, everything else is typed the way codegen would type it
+        if (type != ValueType::INFERRED)
+            expr->annotate(type);
+        return type;
+    }
+    case NodeKind::METHOD_CALL: {
+        ValueType type = validateMethodCall(static_cast<const MethodCall *>(expr), symbolTable,
+                                            functionTable, structTable, classTable, currentClass);
+        if (type != ValueType::INFERRED)
+            expr->annotate(type);
+        return type;
+    }
+    case NodeKind::BINARY: {
+        // a chain is typed from its innermost operator out, carrying the
+        // type of the left operand instead of recursing into it
+        auto spine = leftSpine(static_cast<const BinaryExpr *>(expr));
+        ValueType type = validateExpression(spine.back()->left.get(), symbolTable, functionTable,
+                                            structTable, classTable, currentClass);
+        for (auto it = spine.rbegin(); it != spine.rend(); ++it) {
+            const BinaryExpr *bin = *it;
+            type = validateBinaryExpr(bin, type, symbolTable, functionTable,
+                                      structTable, classTable, currentClass);
+            // the result type of everything but ?? is fixed by the operator,
+            // arithmetic is int or number depending on the operands
+            ValueType resultType = TypeUtils::binaryResultType(bin->op);
+            if (resultType == ValueType::NUMBER && TypeUtils::isNumeric(type))
+                resultType = type;
+            if (bin->op != BinaryOp::NIL_COALESCE)
+                bin->annotate(resultType);
+        }
+        return type;
+    }
+    case NodeKind::UNARY: {
+        auto *un = static_cast<const UnaryExpr *>(expr);
+        ValueType type = validateUnaryExpr(un, symbolTable);
+        expr->annotate(un->op == UnaryOp::NOT ? ValueType::BOOL : type);
+        return type;
+    }
+    case NodeKind::FIELD_ACCESS: {
+        auto *field = static_cast<const FieldAccessExpr *>(expr);
+        ValueType type = validateFieldAccess(field, symbolTable, structTable, classTable,
+                                             currentClass);
+        if (type == ValueType::STRUCT)
+            expr->annotate(type, getFieldStructType(field, symbolTable, structTable,
+                                                    classTable, currentClass));
+        else if (type != ValueType::INFERRED)
+            expr->annotate(type);
+        return type;
+    }
+    case NodeKind::FORCE_UNWRAP:
+        return validateForceUnwrap(static_cast<const ForceUnwrapExpr *>(expr), symbolTable);
+    case NodeKind::CLASS_INSTANTIATION: {
+        auto *inst = static_cast<const ClassInstantiation *>(expr);
+        ValueType type = validateClassInstantiation(inst, classTable);
+        if (type == ValueType::STRUCT)
+            expr->annotate(type, inst->className);
+        return type;
+    }
+    case NodeKind::STRUCT_CONSTRUCTOR: {
+        auto *structCons = static_cast<const StructConstructor *>(expr);
         if (!structTable.count(structCons->structName) && !classTable.count(structCons->structName)) {
             reporter.reportError("Struct/Class '" + structCons->structName + "' is not defined", expr->line);
             return ValueType::INFERRED;
         }
+        expr->annotate(ValueType::STRUCT, structCons->structName);
         return ValueType::STRUCT;
-    } else if (dynamic_cast<const SelfExpr *>(expr)) {
+    }
+    case NodeKind::SELF:
         return ValueType::STRUCT;
-    } else if (dynamic_cast<const LambdaExpr *>(expr)) {
+    case NodeKind::LAMBDA:
+        expr->annotate(ValueType::FUNCTION);
         return ValueType::FUNCTION;
+    case NodeKind::ENUM_ACCESS:
+        expr->annotate(ValueType::ENUM,
+                       static_cast<const EnumAccessExpr *>(expr)->enumName);
+        return ValueType::INFERRED;
+    default:
+        break;
     }
 
     return ValueType::INFERRED;
@@ -77,20 +140,18 @@ ValueType ExpressionValidator::validateVariable(const VarExpr *var,
     return ValueType::INFERRED;
 }
 
-ValueType ExpressionValidator::validateBinaryExpr(const BinaryExpr *bin,
+ValueType ExpressionValidator::validateBinaryExpr(const BinaryExpr *bin, ValueType leftType,
                                                  const std::unordered_map<std::string, TypeInfo> &symbolTable,
                                                  const std::unordered_map<std::string, FunctionInfo> &functionTable,
                                                  const std::map<std::string, StructInfo> &structTable,
                                                  const std::map<std::string, ClassInfo> &classTable,
                                                  const std::string &currentClass) {
     if (bin->op == BinaryOp::NIL_COALESCE) {
-        ValueType leftType = validateExpression(bin->left.get(), symbolTable, functionTable, 
-                                               structTable, classTable, currentClass);
         validateExpression(bin->right.get(), symbolTable, functionTable, 
                           structTable, classTable, currentClass);
 
         bool leftIsOptional = false;
-        if (auto *v = dynamic_cast<const VarExpr *>(bin->left.get()))
+        if (auto *v = nodeCast<VarExpr>(bin->left.get()))
             if (symbolTable.count(v->name))
                 leftIsOptional = symbolTable.at(v->name).isOptional;
 
@@ -100,19 +161,18 @@ ValueType ExpressionValidator::validateBinaryExpr(const BinaryExpr *bin,
         return leftType;
     }
 
-    ValueType leftType = validateExpression(bin->left.get(), symbolTable, functionTable, 
-                                           structTable, classTable, currentClass);
     ValueType rightType = validateExpression(bin->right.get(), symbolTable, functionTable, 
                                             structTable, classTable, currentClass);
 
     if (bin->op == BinaryOp::ADD || bin->op == BinaryOp::SUBTRACT ||
         bin->op == BinaryOp::MULTIPLY || bin->op == BinaryOp::DIVIDE ||
-        bin->op == BinaryOp::MODULO) {
-        if (leftType != ValueType::NUMBER && leftType != ValueType::INFERRED)
+        bin->op == BinaryOp::MODULO || bin->op == BinaryOp::FLOOR_DIVIDE) {
+        if (!TypeUtils::isNumeric(leftType) && leftType != ValueType::INFERRED)
             reporter.reportError("Left operand must be a number", bin->line);
-        if (rightType != ValueType::NUMBER && rightType != ValueType::INFERRED)
+        if (!TypeUtils::isNumeric(rightType) && rightType != ValueType::INFERRED)
             reporter.reportError("Right operand must be a number", bin->line);
-        return ValueType::NUMBER;
+        return arithmeticResultType(bin->op, bin->left.get(), leftType,
+                                    bin->right.get(), rightType);
     }
 
     if (bin->op == BinaryOp::CONCAT) {
@@ -128,6 +188,7 @@ ValueType ExpressionValidator::validateBinaryExpr(const BinaryExpr *bin,
         bin->op == BinaryOp::GREATER || bin->op == BinaryOp::GREATER_EQUAL) {
         if (leftType != ValueType::INFERRED &&
             rightType != ValueType::INFERRED &&
+            !(TypeUtils::isNumeric(leftType) && TypeUtils::isNumeric(rightType)) &&
             !TypeUtils::isCompatible(leftType, rightType)) {
             reporter.reportError("Cannot compare " + TypeUtils::typeToString(leftType) + 
                                " with " + TypeUtils::typeToString(rightType), bin->line);
@@ -146,9 +207,9 @@ ValueType ExpressionValidator::validateUnaryExpr(const UnaryExpr *un,
                                               std::map<std::string, ClassInfo>(), "");
     
     if (un->op == UnaryOp::NEGATE) {
-        if (operandType != ValueType::NUMBER && operandType != ValueType::INFERRED)
+        if (!TypeUtils::isNumeric(operandType) && operandType != ValueType::INFERRED)
             reporter.reportError("Cannot negate non-numeric value", un->line);
-        return ValueType::NUMBER;
+        return operandType == ValueType::INT ? ValueType::INT : ValueType::NUMBER;
     }
     if (un->op == UnaryOp::NOT)
         return ValueType::BOOL;
@@ -219,7 +280,7 @@ ValueType ExpressionValidator::validateMethodCall(const MethodCall *call,
     bool isStaticCall = false;
 
     // check if this is a static method call
-    if (auto *varExpr = dynamic_cast<const VarExpr *>(call->object.get())) {
+    if (auto *varExpr = nodeCast<VarExpr>(call->object.get())) {
         if (classTable.count(varExpr->name)) {
             className = varExpr->name;
             isStaticCall = true;
@@ -231,7 +292,7 @@ ValueType ExpressionValidator::validateMethodCall(const MethodCall *call,
             reporter.reportError("Variable/Class '" + varExpr->name + "' is not declared", call->line);
             return ValueType::INFERRED;
         }
-    } else if (dynamic_cast<const SelfExpr *>(call->object.get())) {
+    } else if (nodeCast<SelfExpr>(call->object.get())) {
         // calling on self
         className = currentClass;
     } else {
@@ -255,15 +316,15 @@ ValueType ExpressionValidator::validateMethodCall(const MethodCall *call,
     auto &classInfo = classTable.at(className);
     
     // check if method exists
-    if (!classInfo.methodInfo.count(call->methodName)) {
+    const MemberInfo *method = classInfo.findMethod(call->methodName);
+    if (!method) {
         reporter.reportError("Method '" + call->methodName +
                             "' does not exist in class '" + className + "'", call->line);
         return ValueType::INFERRED;
     }
 
     // get method info
-    auto methodInfoPair = classInfo.methodInfo.at(call->methodName);
-    Visibility methodVisibility = methodInfoPair.second;
+    Visibility methodVisibility = method->visibility;
     
     // for static calls, check if method is static
     if (isStaticCall) {
@@ -283,7 +344,7 @@ ValueType ExpressionValidator::validateMethodCall(const MethodCall *call,
     for (const auto &arg : call->arguments)
         validateExpression(arg.get(), symbolTable, functionTable, structTable, classTable, currentClass);
 
-    return methodInfoPair.first;
+    return method->type;
 }
 
 ValueType ExpressionValidator::validateFieldAccess(const FieldAccessExpr *field,
@@ -302,15 +363,15 @@ ValueType ExpressionValidator::validateFieldAccess(const FieldAccessExpr *field,
 
     std::string containerName = "";
     
-    if (auto *v = dynamic_cast<const VarExpr *>(field->object.get())) {
+    if (auto *v = nodeCast<VarExpr>(field->object.get())) {
         if (symbolTable.count(v->name)) {
             containerName = symbolTable.at(v->name).structTypeName;
         }
     }
-    else if (dynamic_cast<const SelfExpr *>(field->object.get())) {
+    else if (nodeCast<SelfExpr>(field->object.get())) {
         containerName = currentClass;
     }
-    else if (auto *innerField = dynamic_cast<const FieldAccessExpr *>(field->object.get())) {
+    else if (auto *innerField = nodeCast<FieldAccessExpr>(field->object.get())) {
         containerName = getFieldStructType(innerField, symbolTable, structTable, classTable, currentClass);
     }
 
@@ -323,10 +384,8 @@ ValueType ExpressionValidator::validateFieldAccess(const FieldAccessExpr *field,
     if (structTable.count(containerName)) {
         auto &info = structTable.at(containerName);
 
-        for (auto &f : info.fields) {
-            if (f.name == field->fieldName) {
-                return f.type;
-            }
+        if (const MemberInfo *f = info.findField(field->fieldName)) {
+            return f->type;
         }
 
         reporter.reportError("Struct '" + containerName + "' has no field '" + field->fieldName + "'",
@@ -338,16 +397,14 @@ ValueType ExpressionValidator::validateFieldAccess(const FieldAccessExpr *field,
         auto &classInfo = classTable.at(containerName);
 
         // check field visibility
-        for (const auto &f : classInfo.fields) {
-            if (f.name == field->fieldName) {
-                // check if field is private
-                if (f.visibility == Visibility::PRIVATE && currentClass != containerName) {
-                    reporter.reportError("Cannot access private field '" + field->fieldName + 
-                                      "' from outside class '" + containerName + "'", field->line);
-                    return ValueType::INFERRED;
-                }
-                return f.type;
+        if (const MemberInfo *f = classInfo.findField(field->fieldName)) {
+            // check if field is private
+            if (f->visibility == Visibility::PRIVATE && currentClass != containerName) {
+                reporter.reportError("Cannot access private field '" + field->fieldName + 
+                                  "' from outside class '" + containerName + "'", field->line);
+                return ValueType::INFERRED;
             }
+            return f->type;
         }
         
         reporter.reportError("Class '" + containerName + "' has no field '" + field->fieldName + "'",
@@ -369,7 +426,7 @@ ValueType ExpressionValidator::validateForceUnwrap(const ForceUnwrapExpr *unwrap
     
     // check if operand is optional
     bool isOptional = false;
-    if (auto *var = dynamic_cast<const VarExpr *>(unwrap->operand.get())) {
+    if (auto *var = nodeCast<VarExpr>(unwrap->operand.get())) {
         if (symbolTable.count(var->name)) {
             isOptional = symbolTable.at(var->name).isOptional;
         }
@@ -411,15 +468,15 @@ std::string ExpressionValidator::getFieldStructType(const FieldAccessExpr *field
         
     std::string objectStructName;
     
-    if (auto *v = dynamic_cast<const VarExpr *>(field->object.get())) {
+    if (auto *v = nodeCast<VarExpr>(field->object.get())) {
         if (symbolTable.count(v->name)) {
             objectStructName = symbolTable.at(v->name).structTypeName;
         }
     }
-    else if (dynamic_cast<const SelfExpr *>(field->object.get())) {
+    else if (nodeCast<SelfExpr>(field->object.get())) {
         objectStructName = currentClass;
     }
-    else if (auto *innerField = dynamic_cast<const FieldAccessExpr *>(field->object.get())) {
+    else if (auto *innerField = nodeCast<FieldAccessExpr>(field->object.get())) {
         // recursively get the struct type of the inner field
         objectStructName = getFieldStructType(innerField, symbolTable, structTable, classTable, currentClass);
     }
@@ -430,24 +487,20 @@ std::string ExpressionValidator::getFieldStructType(const FieldAccessExpr *field
     
     if (structTable.count(objectStructName)) {
         auto &info = structTable.at(objectStructName);
-        for (const auto &f : info.fields) {
-            if (f.name == field->fieldName) {
-                if (f.type == ValueType::STRUCT && !f.structTypeName.empty()) {
-                    return f.structTypeName;
-                }
-                return objectStructName;
+        if (const MemberInfo *f = info.findField(field->fieldName)) {
+            if (f->type == ValueType::STRUCT && !f->structTypeName.empty()) {
+                return f->structTypeName;
             }
+            return objectStructName;
         }
     }
     else if (classTable.count(objectStructName)) {
         auto &classInfo = classTable.at(objectStructName);
-        for (const auto &f : classInfo.fields) {
-            if (f.name == field->fieldName) {
-                if (f.type == ValueType::STRUCT && !f.structTypeName.empty()) {
-                    return f.structTypeName;
-                }
-                return objectStructName;
+        if (const MemberInfo *f = classInfo.findField(field->fieldName)) {
+            if (f->type == ValueType::STRUCT && !f->structTypeName.empty()) {
+                return f->structTypeName;
             }
+            return objectStructName;
         }
     }
     
@@ -17,32 +17,36 @@ bool StatementValidator::validateStatement(const ASTNode *node,
     if (!node)
         return true;
 
-    
-    if (auto *decl = dynamic_cast<const VarDecl *>(node)) {
-        return validateVarDecl(decl, symbolTable, structTable, classTable);
-    } else if (auto *func = dynamic_cast<const FunctionDecl *>(node)) {
-        return true;
-    } else if (auto *ret = dynamic_cast<const ReturnStmt *>(node)) {
-        return validateReturnStmt(ret, symbolTable, functionTable, structTable, classTable, currentClass);
-    } else if (auto *assign = dynamic_cast<const Assignment *>(node)) {
-        return validateAssignment(assign, symbolTable, nonNilVars);
-    } else if (auto *fieldAssign = dynamic_cast<const FieldAssignment *>(node)) {
-        return validateFieldAssignment(fieldAssign, symbolTable, structTable, classTable, currentClass);
-    } else if (auto *print = dynamic_cast<const PrintStmt *>(node)) {
-        return validatePrintStmt(print, symbolTable, nonNilVars,
+    switch (node->kind) {
+    case NodeKind::VAR_DECL:
+        return validateVarDecl(static_cast<const VarDecl *>(node), symbolTable,
+                               functionTable, structTable, classTable);
+    case NodeKind::RETURN:
+        return validateReturnStmt(static_cast<const ReturnStmt *>(node), symbolTable,
+                                  functionTable, structTable, classTable, currentClass);
+    case NodeKind::ASSIGNMENT:
+        return validateAssignment(static_cast<const Assignment *>(node), symbolTable, nonNilVars);
+    case NodeKind::FIELD_ASSIGNMENT:
+        return validateFieldAssignment(static_cast<const FieldAssignment *>(node), symbolTable,
+                                       structTable, classTable, currentClass);
+    case NodeKind::PRINT:
+        return validatePrintStmt(static_cast<const PrintStmt *>(node), symbolTable, nonNilVars,
                                 structTable, classTable, currentClass);
-    } else if (auto *ifStmt = dynamic_cast<const IfStmt *>(node)) {
-        return validateIfStmt(ifStmt, symbolTable, functionTable, structTable, classTable, 
-                             nonNilVars, currentFunction, currentClass);
-    } else if (auto *classDecl = dynamic_cast<const ClassDecl *>(node)) {
-        return true;
-    } else if (auto *structDecl = dynamic_cast<const StructDecl *>(node)) {
-        return true;
-    } else if (auto *inlineC = dynamic_cast<const InlineCStmt *>(node)) {
-        return true;
-    } else if (auto *expr = dynamic_cast<const Expr *>(node)) {
-        exprValidator.validateExpression(expr, symbolTable, functionTable, structTable, classTable, currentClass);
+    case NodeKind::IF:
+        return validateIfStmt(static_cast<const IfStmt *>(node), symbolTable, functionTable,
+                             structTable, classTable, nonNilVars, currentFunction, currentClass);
+    case NodeKind::FUNCTION_DECL:
+    case NodeKind::CLASS_DECL:
+    case NodeKind::STRUCT_DECL:
+    case NodeKind::INLINE_C:
         return true;
+    default:
+        break;
+    }
+
+    if (node->isExpr()) {
+        exprValidator.validateExpression(static_cast<const Expr *>(node), symbolTable,
+                                         functionTable, structTable, classTable, currentClass);
     }
     
     return true;
@@ -50,6 +54,7 @@ bool StatementValidator::validateStatement(const ASTNode *node,
 
 bool StatementValidator::validateVarDecl(const VarDecl *decl,
                                         std::unordered_map<std::string, TypeInfo> &symbolTable,
+                                        const std::unordered_map<std::string, FunctionInfo> &functionTable,
                                         const std::map<std::string, StructInfo> &structTable,
                                         const std::map<std::string, ClassInfo> &classTable) {
     if (!decl)
@@ -57,7 +62,7 @@ bool StatementValidator::validateVarDecl(const VarDecl *decl,
 
     if (decl->hasValue && decl->value) {
         // check if assigning a lambda
-        if (auto *lambda = dynamic_cast<const LambdaExpr *>(decl->value.get())) {
+        if (auto *lambda = nodeCast<LambdaExpr>(decl->value.get())) {
             auto savedSymbolTable = symbolTable;
             std::string savedFunction = "";
             std::unordered_set<std::string> emptyNonNilVars;
@@ -73,7 +78,7 @@ bool StatementValidator::validateVarDecl(const VarDecl *decl,
                     return false;
                 }
                 symbolTable[param.first] = {param.second, false, true, paramIsOptional,
-                                            false,        false, ""};
+                                            false,        false, TypeName()};
             }
 
             // check lambda body
@@ -95,6 +100,20 @@ bool StatementValidator::validateVarDecl(const VarDecl *decl,
                 return false;
             }
         }
+
+        // an int only takes int values, numbers have to stay numbers
+        if (decl->type == ValueType::INT) {
+            std::string emptyClass = "";
+            ValueType valueType = exprValidator.validateExpression(decl->value.get(), symbolTable,
+                                                                  functionTable, structTable,
+                                                                  classTable, emptyClass);
+            valueType = TypeUtils::valueTypeFor(decl->type, decl->value.get(), valueType);
+            if (valueType != ValueType::INT && valueType != ValueType::INFERRED) {
+                reporter.reportError("Type mismatch: cannot initialize int variable '" + decl->name +
+                                    "' with " + TypeUtils::typeToString(valueType), decl->line);
+                return false;
+            }
+        }
     }
 
     return true;
@@ -131,16 +150,16 @@ bool StatementValidator::validateAssignment(const Assignment *assign,
                                                           emptyClassTable, emptyClass);
     
     bool valueCanBeNil = false;
-    if (dynamic_cast<const NilExpr *>(assign->value.get())) {
+    if (nodeCast<NilExpr>(assign->value.get())) {
         valueCanBeNil = true;
-    } else if (auto *var = dynamic_cast<const VarExpr *>(assign->value.get())) {
+    } else if (auto *var = nodeCast<VarExpr>(assign->value.get())) {
         if (symbolTable.count(var->name)) {
             valueCanBeNil = symbolTable[var->name].isOptional;
         }
     }
 
     // check if assigning a lambda
-    if (auto *lambda = dynamic_cast<const LambdaExpr *>(assign->value.get())) {
+    if (auto *lambda = nodeCast<LambdaExpr>(assign->value.get())) {
         auto savedSymbolTable = symbolTable;
         std::string savedFunction = "";
 
@@ -154,7 +173,7 @@ bool StatementValidator::validateAssignment(const Assignment *assign,
                 return false;
             }
             symbolTable[param.first] = {param.second, false, true, paramIsOptional,
-                                        false,        false, ""};
+                                        false,        false, TypeName()};
         }
 
         // check lambda body
@@ -192,11 +211,20 @@ bool StatementValidator::validateAssignment(const Assignment *assign,
             return false;
         }
 
-        if (varInfo.type != ValueType::NUMBER || valueType != ValueType::NUMBER) {
+        if (!TypeUtils::isNumeric(varInfo.type) || !TypeUtils::isNumeric(valueType)) {
             reporter.reportError("Compound assignment requires number types", assign->line);
             return false;
         }
+
+        if (varInfo.type == ValueType::INT &&
+            arithmeticResultType(assign->compoundOp, nullptr, varInfo.type,
+                                 assign->value.get(), valueType) != ValueType::INT) {
+            reporter.reportError("Compound assignment on int variable '" + assign->name +
+                                "' produces a number", assign->line);
+            return false;
+        }
     } else {
+        valueType = TypeUtils::valueTypeFor(varInfo.type, assign->value.get(), valueType);
         if (!TypeCompatibility::checkAssignment(assign->name, varInfo, valueType, 
                                                valueCanBeNil, assign->line, reporter)) {
             return false;
@@ -228,38 +256,34 @@ bool StatementValidator::validateFieldAssignment(const FieldAssignment *assign,
     
     std::string typeName = "";
     
-    if (auto *varExpr = dynamic_cast<const VarExpr *>(assign->object.get())) {
+    if (auto *varExpr = nodeCast<VarExpr>(assign->object.get())) {
         if (symbolTable.count(varExpr->name)) {
             typeName = symbolTable[varExpr->name].structTypeName;
         }
-    } else if (dynamic_cast<const SelfExpr *>(assign->object.get())) {
+    } else if (nodeCast<SelfExpr>(assign->object.get())) {
         typeName = currentClass;
     }
-    else if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(assign->object.get())) {
+    else if (auto *fieldAccess = nodeCast<FieldAccessExpr>(assign->object.get())) {
         typeName = exprValidator.getFieldStructType(fieldAccess, symbolTable, structTable, classTable, currentClass);
     }
     
     if (typeName.empty()) {
-        if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(assign->object.get())) {
+        if (auto *fieldAccess = nodeCast<FieldAccessExpr>(assign->object.get())) {
             // validate the field access to get its type
             ValueType fieldType = exprValidator.validateExpression(fieldAccess, symbolTable,
                                                                  emptyFunctionTable,
                                                                  structTable, classTable, currentClass);
 
             if (fieldType == ValueType::STRUCT) {
-                if (auto *innerField = dynamic_cast<const FieldAccessExpr *>(fieldAccess->object.get())) {
+                if (auto *innerField = nodeCast<FieldAccessExpr>(fieldAccess->object.get())) {
                     std::string innerTypeName = exprValidator.getFieldStructType(innerField, symbolTable, 
                                                                                 structTable, classTable, currentClass);
 
                     if (!innerTypeName.empty() && structTable.count(innerTypeName)) {
                         auto &structInfo = structTable.at(innerTypeName);
-                        for (const auto &field : structInfo.fields) {
-                            if (field.name == fieldAccess->fieldName) {
-                                if (field.type == ValueType::STRUCT && !field.structTypeName.empty()) {
-                                    typeName = field.structTypeName;
-                                }
-                                break;
-                            }
+                        const MemberInfo *field = structInfo.findField(fieldAccess->fieldName);
+                        if (field && field->type == ValueType::STRUCT && !field->structTypeName.empty()) {
+                            typeName = field->structTypeName;
                         }
                     }
                 }
@@ -275,15 +299,15 @@ bool StatementValidator::validateFieldAssignment(const FieldAssignment *assign,
     if (classTable.count(typeName)) {
         const auto &classInfo = classTable.at(typeName);
         
-        if (classInfo.fieldInfo.find(assign->fieldName) == classInfo.fieldInfo.end()) {
+        const MemberInfo *field = classInfo.findField(assign->fieldName);
+        if (!field) {
             reporter.reportError("Class '" + typeName + "' has no field named '" + 
                                assign->fieldName + "'", assign->line);
             return false;
         }
         
-        auto fieldInfoPair = classInfo.fieldInfo.at(assign->fieldName);
-        ValueType fieldType = fieldInfoPair.first;
-        Visibility fieldVisibility = fieldInfoPair.second;
+        ValueType fieldType = field->type;
+        Visibility fieldVisibility = field->visibility;
         
         if (fieldVisibility == Visibility::PRIVATE && currentClass != typeName) {
             reporter.reportError("Cannot access private field '" + assign->fieldName + 
@@ -294,6 +318,7 @@ bool StatementValidator::validateFieldAssignment(const FieldAssignment *assign,
         ValueType valueType = exprValidator.validateExpression(assign->value.get(), symbolTable,
                                                               emptyFunctionTable,
                                                               structTable, classTable, currentClass);
+        valueType = TypeUtils::valueTypeFor(fieldType, assign->value.get(), valueType);
         if (!TypeUtils::isCompatible(fieldType, valueType)) {
             reporter.reportError("Type mismatch: cannot assign " + TypeUtils::typeToString(valueType) +
                                 " to field of type " + TypeUtils::typeToString(fieldType), assign->line);
@@ -302,17 +327,18 @@ bool StatementValidator::validateFieldAssignment(const FieldAssignment *assign,
     } else if (structTable.count(typeName)) {
         const auto &structInfo = structTable.at(typeName);
         
-        auto fieldIt = structInfo.fieldTypes.find(assign->fieldName);
-        if (fieldIt == structInfo.fieldTypes.end()) {
+        const MemberInfo *field = structInfo.findField(assign->fieldName);
+        if (!field) {
             reporter.reportError("Struct '" + typeName + "' has no field named '" + 
                                assign->fieldName + "'", assign->line);
             return false;
         }
         
-        ValueType fieldType = fieldIt->second.first;
+        ValueType fieldType = field->type;
         ValueType valueType = exprValidator.validateExpression(assign->value.get(), symbolTable,
                                                               emptyFunctionTable,
                                                               structTable, classTable, currentClass);
+        valueType = TypeUtils::valueTypeFor(fieldType, assign->value.get(), valueType);
         
         if (!TypeUtils::isCompatible(fieldType, valueType)) {
             reporter.reportError("Type mismatch: cannot assign " + TypeUtils::typeToString(valueType) +
@@ -378,7 +404,7 @@ bool StatementValidator::validateIfStmt(const IfStmt *ifStmt,
     std::unordered_set<std::string> savedNonNilVars = nonNilVars;
 
     // check if condition is a simple variable 
-    if (auto *varExpr = dynamic_cast<const VarExpr *>(ifStmt->condition.get())) {
+    if (auto *varExpr = nodeCast<VarExpr>(ifStmt->condition.get())) {
         // this is the syntax sugar for checking non-nil
         if (symbolTable.count(varExpr->name)) {
             auto &varInfo = symbolTable.at(varExpr->name);
@@ -386,17 +412,17 @@ bool StatementValidator::validateIfStmt(const IfStmt *ifStmt,
                 nonNilVars.insert(varExpr->name);
             }
         }
-    } else if (auto *binExpr = dynamic_cast<const BinaryExpr *>(ifStmt->condition.get())) {
+    } else if (auto *binExpr = nodeCast<BinaryExpr>(ifStmt->condition.get())) {
         // handle explicit comparisons like x != nil
         if (binExpr->op == BinaryOp::NOT_EQUAL) {
-            if (auto *varExpr = dynamic_cast<const VarExpr *>(binExpr->left.get())) {
-                if (dynamic_cast<const NilExpr *>(binExpr->right.get())) {
+            if (auto *varExpr = nodeCast<VarExpr>(binExpr->left.get())) {
+                if (nodeCast<NilExpr>(binExpr->right.get())) {
                     nonNilVars.insert(varExpr->name);
                 }
             }
         } else if (binExpr->op == BinaryOp::EQUAL) {
-            if (auto *varExpr = dynamic_cast<const VarExpr *>(binExpr->left.get())) {
-                if (dynamic_cast<const NilExpr *>(binExpr->right.get())) {
+            if (auto *varExpr = nodeCast<VarExpr>(binExpr->left.get())) {
+                if (nodeCast<NilExpr>(binExpr->right.get())) {
                     
                 }
             }
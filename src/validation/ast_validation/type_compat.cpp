@@ -47,7 +47,7 @@ bool TypeCompatibility::checkCompoundAssignment(const std::string &varName,
                                                const TypeInfo &varInfo,
                                                ValueType valueType, int line,
                                                ErrorReporter &reporter) {
-    if (varInfo.type != ValueType::NUMBER || valueType != ValueType::NUMBER) {
+    if (!TypeUtils::isNumeric(varInfo.type) || !TypeUtils::isNumeric(valueType)) {
         reporter.reportError("Compound assignment on variable '" + varName + 
                            "' requires number types, but got " +
                            TypeUtils::typeToString(varInfo.type) + " and " +
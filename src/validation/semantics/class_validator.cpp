@@ -10,35 +10,19 @@ ClassValidator::ClassValidator(ErrorReporter &reporter)
 
 bool ClassValidator::collectClassDeclarations(const Program &program,
                                             std::map<std::string, ClassInfo> &classTable) {
-    for (auto &stmt : program.statements) {
-        if (!stmt)
-            continue;
-
-        if (auto *classDecl = dynamic_cast<ClassDecl *>(stmt.get())) {
-            // check if class is already defined
-            if (classTable.count(classDecl->name)) {
-                reporter.reportError("Class '" + classDecl->name + "' is already defined",
-                                   classDecl->line);
-                return false;
-            }
-
-            // create the ClassInfo object directly in the table using emplace
-            auto &info = classTable[classDecl->name];
-            info.name = classDecl->name;
-            info.fields = classDecl->fields;
-            
-            for (const auto &field : classDecl->fields) {
-                info.fieldInfo[field.name] = {field.type, field.visibility};
-            }
-            
-            for (const auto &method : classDecl->methods) {
-                info.methodInfo[method.name] = {method.returnType, method.visibility};
-            }
-            
-            if (classDecl->constructor) {
-                info.methodInfo["__init"] = {ValueType::INFERRED, Visibility::PUBLIC};
-            }
+    for (const ClassDecl *classDecl : program.declarations.classes) {
+        // check if class is already defined
+        if (classTable.count(classDecl->name)) {
+            reporter.reportError("Class '" + classDecl->name + "' is already defined",
+                               classDecl->line);
+            return false;
         }
+
+        // create the ClassInfo object directly in the table using emplace
+        auto &info = classTable[classDecl->name];
+        info.name = classDecl->name;
+        info.fields = classDecl->fields;
+        info.indexMembers(*classDecl);
     }
 
     return true;
@@ -72,7 +56,7 @@ bool ClassValidator::validateClassDeclaration(const ClassDecl *decl,
             if (!field.structTypeName.empty()) {
                 if (!structTable.count(field.structTypeName) && 
                     !classTable.count(field.structTypeName)) {
-                    reporter.reportError("Unknown type '" + field.structTypeName + "' for field '" + 
+                    reporter.reportError("Unknown type '" + field.structTypeName.str() + "' for field '" + 
                                       field.name + "'", decl->line);
                     return false;
                 }
@@ -89,8 +73,10 @@ bool ClassValidator::validateClassDeclaration(const ClassDecl *decl,
             std::visit(
                 [&](auto &&arg) {
                     using T = std::decay_t<decltype(arg)>;
-                    if constexpr (std::is_same_v<T, int64_t> || 
-                                  std::is_same_v<T, double>) {
+                    if constexpr (std::is_same_v<T, int64_t>) {
+                        defaultType = field.type == ValueType::INT ? ValueType::INT
+                                                                   : ValueType::NUMBER;
+                    } else if constexpr (std::is_same_v<T, double>) {
                         defaultType = ValueType::NUMBER;
                     } else if constexpr (std::is_same_v<T, std::string>) {
                         defaultType = ValueType::STRING;
@@ -122,6 +108,13 @@ bool ClassValidator::validateClassDeclaration(const ClassDecl *decl,
         }
         methodNames.insert(method.name);
         
+        // fields and methods share one member index
+        if (fieldNames.count(method.name)) {
+            reporter.reportError("Method '" + method.name + "' has the same name as a field in class '" + 
+                               decl->name + "'", method.line);
+            return false;
+        }
+        
         if (method.name == "__init") {
             reporter.reportError("Method cannot be named '__init' - this is reserved for constructors", 
                                method.line);
@@ -149,7 +142,7 @@ bool ClassValidator::validateClassMethod(const std::string &className,
                                         bool isConstructor,
                                         std::unordered_map<std::string, TypeInfo> &symbolTable,
                                         const std::map<std::string, StructInfo> &structTable,
-                                        std::map<std::string, ClassInfo> &classTable,
+                                        const std::map<std::string, ClassInfo> &classTable,
                                         std::unordered_set<std::string> &nonNilVars,
                                         std::string &currentClass,
                                         std::string &currentFunction) {
@@ -163,7 +156,8 @@ bool ClassValidator::validateClassMethod(const std::string &className,
     
     // add self parameter for instance methods
     if (!method.isStatic) {
-        symbolTable["self"] = {ValueType::STRUCT, false, true, false, false, true, className};
+        symbolTable["self"] = {ValueType::STRUCT, false, true, false, false, true,
+                               TypeName::find(className)};
     }
     
     // check parameters for duplicates and validate types
@@ -192,7 +186,7 @@ bool ClassValidator::validateClassMethod(const std::string &className,
             }
         }
         
-        std::string structTypeName = "";
+        TypeName structTypeName;
         bool isStruct = false;
         
         // handle struct/class type parameters
@@ -210,7 +204,7 @@ bool ClassValidator::validateClassMethod(const std::string &className,
             }
             
             if (!structTable.count(structTypeName) && !classTable.count(structTypeName)) {
-                reporter.reportError("Unknown type '" + structTypeName + "' for parameter '" + 
+                reporter.reportError("Unknown type '" + structTypeName.str() + "' for parameter '" + 
                                   param.first + "'", method.line);
                 symbolTable = savedSymbolTable;
                 currentFunction = savedFunction;
@@ -235,7 +229,7 @@ bool ClassValidator::validateClassMethod(const std::string &className,
         }
         
         for (const auto &stmt : method.body) {
-            if (auto *ret = dynamic_cast<const ReturnStmt *>(stmt.get())) {
+            if (auto *ret = nodeCast<ReturnStmt>(stmt.get())) {
                 if (ret->value) {
                     reporter.reportError("Constructor cannot return a value", ret->line);
                     symbolTable = savedSymbolTable;
@@ -248,6 +242,7 @@ bool ClassValidator::validateClassMethod(const std::string &className,
     } else if (method.returnType == ValueType::INFERRED) {
         VariableCollector varCollector(reporter);
         varCollector.collectLocalVariables(method.body, symbolTable,
+                                          std::unordered_map<std::string, FunctionInfo>(),
                                           structTable, classTable);
 
         FunctionValidator funcValidator(reporter);
@@ -267,6 +262,7 @@ bool ClassValidator::validateClassMethod(const std::string &className,
     // collect all local variables before checking statements
     VariableCollector varCollector(reporter);
     varCollector.collectLocalVariables(method.body, symbolTable,
+                                      std::unordered_map<std::string, FunctionInfo>(),
                                       structTable, classTable);
     
     // check all statements in the method body
@@ -287,7 +283,7 @@ bool ClassValidator::validateClassMethod(const std::string &className,
     // additional constructor validation
     if (isConstructor) {
         for (const auto &stmt : method.body) {
-            if (auto *ret = dynamic_cast<const ReturnStmt *>(stmt.get())) {
+            if (auto *ret = nodeCast<ReturnStmt>(stmt.get())) {
                 if (ret->value) {
                     reporter.reportError("Constructor cannot return a value", ret->line);
                     hasErrors = true;
@@ -319,8 +315,8 @@ bool ClassValidator::checkClassFieldsInitialized(const ClassDecl *classDecl) {
 
     // check for field assignments in the constructor body
     for (const auto &stmt : constructor->body) {
-        if (auto *fieldAssign = dynamic_cast<const FieldAssignment *>(stmt.get())) {
-            if (dynamic_cast<const SelfExpr *>(fieldAssign->object.get())) {
+        if (auto *fieldAssign = nodeCast<FieldAssignment>(stmt.get())) {
+            if (nodeCast<SelfExpr>(fieldAssign->object.get())) {
                 initializedFields.insert(fieldAssign->fieldName);
             }
         }
@@ -356,14 +352,14 @@ bool ClassValidator::validateMethodCall(const std::string &className,
 
     const auto &classInfo = classTable.at(className);
     
-    if (!classInfo.methodInfo.count(methodName)) {
+    const MemberInfo *method = classInfo.findMethod(methodName);
+    if (!method) {
         reporter.reportError("Method '" + methodName + "' does not exist in class '" + className + "'", line);
         return false;
     }
 
     // get method visibility
-    auto methodInfoPair = classInfo.methodInfo.at(methodName);
-    Visibility methodVisibility = methodInfoPair.second;
+    Visibility methodVisibility = method->visibility;
     
     if (methodName != "__init") {
         if (methodVisibility == Visibility::PRIVATE) {
@@ -397,15 +393,13 @@ bool ClassValidator::validateFieldAccess(const std::string &className,
     const auto &classInfo = classTable.at(className);
     
     // check if field exists
-    for (const auto &field : classInfo.fields) {
-        if (field.name == fieldName) {
-            if (field.visibility == Visibility::PRIVATE && currentClass != className) {
-                reporter.reportError("Cannot access private field '" + fieldName + 
-                                  "' from outside class '" + className + "'", line);
-                return false;
-            }
-            return true;
+    if (const MemberInfo *field = classInfo.findField(fieldName)) {
+        if (field->visibility == Visibility::PRIVATE && currentClass != className) {
+            reporter.reportError("Cannot access private field '" + fieldName + 
+                              "' from outside class '" + className + "'", line);
+            return false;
         }
+        return true;
     }
 
     reporter.reportError("Class '" + className + "' has no field '" + fieldName + "'", line);
@@ -2,6 +2,7 @@
 #include "../../../include/validation/semantics/variable_collector.h"
 #include "../../../include/validation/ast_validation/expr_validator.h"
 #include "../../../include/validation/ast_validation/stmt_validator.h"
+#include <algorithm>
 #include <unordered_set>
 
 namespace HolyLua {
@@ -66,11 +67,11 @@ bool FunctionValidator::inferAndValidateFunction(FunctionDecl *func,
         bool isOptional = func->parameterOptionals[i];
 
         symbolTable[param.first] = {param.second, false, true, isOptional,
-                                    false,        false, ""};
+                                    false,        false, TypeName()};
     }
 
     // collect all local variables before analyzing return types
-    varCollector.collectLocalVariables(func->body, symbolTable, 
+    varCollector.collectLocalVariables(func->body, symbolTable, functionTable,
                                        std::map<std::string, StructInfo>(), 
                                        std::map<std::string, ClassInfo>());
 
@@ -103,8 +104,14 @@ bool FunctionValidator::inferAndValidateFunction(FunctionDecl *func,
             functionTable[func->name].returnType = ValueType::NUMBER;
         }
     } else {
-        // validate explicit return type matches
+        // validate explicit return type matches, a function returning int
+        // may return bare integer constants
+        bool onlyIntegerConstants =
+            std::find(returnAnalysis.returnsIntegerConstant.begin(),
+                      returnAnalysis.returnsIntegerConstant.end(),
+                      false) == returnAnalysis.returnsIntegerConstant.end();
         if (returnAnalysis.inferredType != ValueType::INFERRED &&
+            !(func->returnType == ValueType::INT && onlyIntegerConstants) &&
             !TypeUtils::isCompatible(func->returnType, returnAnalysis.inferredType)) {
             reporter.reportError("Function '" + func->name + "' declared to return " +
                                 TypeUtils::typeToString(func->returnType) + " but actually returns " +
@@ -146,14 +153,14 @@ bool FunctionValidator::validateFunctionBody(FunctionDecl *func,
                           func->parameterOptionals[i] : false;
         
         symbolTable[param.first] = {param.second, false, true, isOptional,
-                                    false, false, ""};
+                                    false, false, TypeName()};
     }
 
     for (const auto &stmt : func->body) {
         if (!stmt)
             continue;
             
-        if (auto *nestedFunc = dynamic_cast<const FunctionDecl *>(stmt.get())) {
+        if (auto *nestedFunc = nodeCast<FunctionDecl>(stmt.get())) {
             if (nestedFunc->isGlobal) {
                 reporter.reportError("Nested function '" + nestedFunc->name + 
                                    "' cannot be marked as global", nestedFunc->line);
@@ -163,7 +170,7 @@ bool FunctionValidator::validateFunctionBody(FunctionDecl *func,
             }
             
             symbolTable[nestedFunc->name] = {ValueType::FUNCTION, false, true, 
-                                           false, true, false, ""};
+                                           false, true, false, TypeName()};
         }
     }
 
@@ -206,15 +213,16 @@ ReturnAnalysis FunctionValidator::analyzeReturnTypes(const std::vector<std::uniq
         if (!stmt)
             continue;
 
-        if (auto *ret = dynamic_cast<const ReturnStmt *>(stmt.get())) {
+        if (auto *ret = nodeCast<ReturnStmt>(stmt.get())) {
             if (ret->value) {
                 ValueType retType = exprValidator.validateExpression(ret->value.get(), symbolTable,
                                                                     functionTable, structTable, 
                                                                     classTable, emptyClass);
                 analysis.returnTypes.push_back(retType);
                 analysis.returnLines.push_back(ret->line);
+                analysis.returnsIntegerConstant.push_back(isIntegerConstant(ret->value.get()));
             }
-        } else if (auto *ifStmt = dynamic_cast<const IfStmt *>(stmt.get())) {
+        } else if (auto *ifStmt = nodeCast<IfStmt>(stmt.get())) {
             // recursively check if/else blocks
             ReturnAnalysis thenAnalysis = analyzeReturnTypes(ifStmt->thenBlock, symbolTable,
                                                             functionTable, structTable, classTable);
@@ -227,6 +235,9 @@ ReturnAnalysis FunctionValidator::analyzeReturnTypes(const std::vector<std::uniq
             analysis.returnLines.insert(analysis.returnLines.end(),
                                         thenAnalysis.returnLines.begin(),
                                         thenAnalysis.returnLines.end());
+            analysis.returnsIntegerConstant.insert(analysis.returnsIntegerConstant.end(),
+                                                   thenAnalysis.returnsIntegerConstant.begin(),
+                                                   thenAnalysis.returnsIntegerConstant.end());
 
             analysis.returnTypes.insert(analysis.returnTypes.end(),
                                         elseAnalysis.returnTypes.begin(),
@@ -234,6 +245,20 @@ ReturnAnalysis FunctionValidator::analyzeReturnTypes(const std::vector<std::uniq
             analysis.returnLines.insert(analysis.returnLines.end(),
                                         elseAnalysis.returnLines.begin(),
                                         elseAnalysis.returnLines.end());
+            analysis.returnsIntegerConstant.insert(analysis.returnsIntegerConstant.end(),
+                                                   elseAnalysis.returnsIntegerConstant.begin(),
+                                                   elseAnalysis.returnsIntegerConstant.end());
+        }
+    }
+
+    // integer constants return an int when another path does
+    for (ValueType type : analysis.returnTypes) {
+        if (type == ValueType::INT) {
+            for (size_t i = 0; i < analysis.returnTypes.size(); i++) {
+                if (analysis.returnsIntegerConstant[i])
+                    analysis.returnTypes[i] = ValueType::INT;
+            }
+            break;
         }
     }
 
@@ -290,19 +315,19 @@ void FunctionValidator::collectUsageConstraints(
     if (!node)
         return;
 
-    if (auto *ret = dynamic_cast<const ReturnStmt *>(node)) {
+    if (auto *ret = nodeCast<ReturnStmt>(node)) {
         if (ret->value) {
             collectExprConstraints(paramName, ret->value.get(), constraints);
         }
-    } else if (auto *assign = dynamic_cast<const Assignment *>(node)) {
+    } else if (auto *assign = nodeCast<Assignment>(node)) {
         collectExprConstraints(paramName, assign->value.get(), constraints);
-    } else if (auto *print = dynamic_cast<const PrintStmt *>(node)) {
+    } else if (auto *print = nodeCast<PrintStmt>(node)) {
         for (const auto &arg : print->arguments) {
             if (arg.expression) {
                 collectExprConstraints(paramName, arg.expression.get(), constraints);
             }
         }
-    } else if (auto *ifStmt = dynamic_cast<const IfStmt *>(node)) {
+    } else if (auto *ifStmt = nodeCast<IfStmt>(node)) {
         collectExprConstraints(paramName, ifStmt->condition.get(), constraints);
         for (const auto &stmt : ifStmt->thenBlock) {
             collectUsageConstraints(paramName, stmt.get(), constraints);
@@ -310,11 +335,11 @@ void FunctionValidator::collectUsageConstraints(
         for (const auto &stmt : ifStmt->elseBlock) {
             collectUsageConstraints(paramName, stmt.get(), constraints);
         }
-    } else if (auto *decl = dynamic_cast<const VarDecl *>(node)) {
+    } else if (auto *decl = nodeCast<VarDecl>(node)) {
         if (decl->hasValue && decl->value) {
             collectExprConstraints(paramName, decl->value.get(), constraints);
         }
-    } else if (auto *func = dynamic_cast<const FunctionDecl *>(node)) {
+    } else if (auto *func = nodeCast<FunctionDecl>(node)) {
         for (const auto &stmt : func->body) {
             collectUsageConstraints(paramName, stmt.get(), constraints);
         }
@@ -326,9 +351,9 @@ bool FunctionValidator::isParameterInExpr(const std::string &paramName,
     if (!expr)
         return false;
 
-    if (auto *var = dynamic_cast<const VarExpr *>(expr)) {
+    if (auto *var = nodeCast<VarExpr>(expr)) {
         return var->name == paramName;
-    } else if (auto *lambda = dynamic_cast<const LambdaExpr *>(expr)) {
+    } else if (auto *lambda = nodeCast<LambdaExpr>(expr)) {
         // check if parameter is used inside the lambda body
         for (const auto &stmt : lambda->body) {
             if (isParameterInNode(paramName, stmt.get())) {
@@ -336,19 +361,23 @@ bool FunctionValidator::isParameterInExpr(const std::string &paramName,
             }
         }
         return false;
-    } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
-        return isParameterInExpr(paramName, bin->left.get()) ||
-               isParameterInExpr(paramName, bin->right.get());
-    } else if (auto *un = dynamic_cast<const UnaryExpr *>(expr)) {
+    } else if (auto *bin = nodeCast<BinaryExpr>(expr)) {
+        auto spine = leftSpine(bin);
+        for (auto *link : spine) {
+            if (isParameterInExpr(paramName, link->right.get()))
+                return true;
+        }
+        return isParameterInExpr(paramName, spine.back()->left.get());
+    } else if (auto *un = nodeCast<UnaryExpr>(expr)) {
         return isParameterInExpr(paramName, un->operand.get());
-    } else if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
+    } else if (auto *call = nodeCast<FunctionCall>(expr)) {
         for (const auto &arg : call->arguments) {
             if (isParameterInExpr(paramName, arg.get()))
                 return true;
         }
-    } else if (auto *unwrap = dynamic_cast<const ForceUnwrapExpr *>(expr)) {
+    } else if (auto *unwrap = nodeCast<ForceUnwrapExpr>(expr)) {
         return isParameterInExpr(paramName, unwrap->operand.get());
-    } else if (auto *structCons = dynamic_cast<const StructConstructor *>(expr)) {
+    } else if (auto *structCons = nodeCast<StructConstructor>(expr)) {
         for (const auto &arg : structCons->positionalArgs) {
             if (isParameterInExpr(paramName, arg.get()))
                 return true;
@@ -357,7 +386,7 @@ bool FunctionValidator::isParameterInExpr(const std::string &paramName,
             if (isParameterInExpr(paramName, namedArg.second.get()))
                 return true;
         }
-    } else if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(expr)) {
+    } else if (auto *fieldAccess = nodeCast<FieldAccessExpr>(expr)) {
         return isParameterInExpr(paramName, fieldAccess->object.get());
     }
 
@@ -369,22 +398,22 @@ bool FunctionValidator::isParameterInNode(const std::string &paramName,
     if (!node)
         return false;
 
-    if (auto *expr = dynamic_cast<const Expr *>(node)) {
+    if (auto *expr = nodeCast<Expr>(node)) {
         return isParameterInExpr(paramName, expr);
-    } else if (auto *ret = dynamic_cast<const ReturnStmt *>(node)) {
+    } else if (auto *ret = nodeCast<ReturnStmt>(node)) {
         if (ret->value) {
             return isParameterInExpr(paramName, ret->value.get());
         }
-    } else if (auto *assign = dynamic_cast<const Assignment *>(node)) {
+    } else if (auto *assign = nodeCast<Assignment>(node)) {
         return isParameterInExpr(paramName, assign->value.get());
-    } else if (auto *print = dynamic_cast<const PrintStmt *>(node)) {
+    } else if (auto *print = nodeCast<PrintStmt>(node)) {
         for (const auto &arg : print->arguments) {
             if (arg.expression &&
                 isParameterInExpr(paramName, arg.expression.get())) {
                 return true;
             }
         }
-    } else if (auto *decl = dynamic_cast<const VarDecl *>(node)) {
+    } else if (auto *decl = nodeCast<VarDecl>(node)) {
         if (decl->hasValue && decl->value) {
             return isParameterInExpr(paramName, decl->value.get());
         }
@@ -400,7 +429,7 @@ void FunctionValidator::collectExprConstraints(
     if (!expr)
         return;
 
-    if (auto *lambda = dynamic_cast<const LambdaExpr *>(expr)) {
+    if (auto *lambda = nodeCast<LambdaExpr>(expr)) {
         // check if parameter is used inside the lambda body
         for (const auto &stmt : lambda->body) {
             if (isParameterInNode(paramName, stmt.get())) {
@@ -410,7 +439,7 @@ void FunctionValidator::collectExprConstraints(
         }
     }
 
-    if (auto *var = dynamic_cast<const VarExpr *>(expr)) {
+    if (auto *var = nodeCast<VarExpr>(expr)) {
         if (var->name == paramName) {
             if (expectedType != ValueType::INFERRED) {
                 constraints.emplace_back(expectedType, expr->line,
@@ -418,40 +447,47 @@ void FunctionValidator::collectExprConstraints(
                                            TypeUtils::typeToString(expectedType));
             }
         }
-    } else if (auto *bin = dynamic_cast<const BinaryExpr *>(expr)) {
-        // check if this is a usage of the parameter in a binary operation
-        collectExprConstraints(paramName, bin->left.get(), constraints);
-        collectExprConstraints(paramName, bin->right.get(), constraints);
-
-        ValueType requiredType;
-        if (TypeUtils::operatorRequiresType(bin->op, requiredType)) {
-            if (isParameterInExpr(paramName, bin->left.get()) ||
-                isParameterInExpr(paramName, bin->right.get())) {
+    } else if (auto *bin = nodeCast<BinaryExpr>(expr)) {
+        // check if this is a usage of the parameter in a binary operation.
+        // a chain is walked from its innermost operator out, remembering
+        // whether the operands so far used the parameter
+        auto spine = leftSpine(bin);
+        const Expr *innermost = spine.back()->left.get();
+        collectExprConstraints(paramName, innermost, constraints);
+        bool used = isParameterInExpr(paramName, innermost);
+
+        for (auto it = spine.rbegin(); it != spine.rend(); ++it) {
+            const BinaryExpr *link = *it;
+            collectExprConstraints(paramName, link->right.get(), constraints);
+            used = used || isParameterInExpr(paramName, link->right.get());
+
+            ValueType requiredType;
+            if (used && TypeUtils::operatorRequiresType(link->op, requiredType)) {
                 constraints.emplace_back(
-                    requiredType, expr->line,
-                    "used with operator '" + TypeUtils::binaryOpToString(bin->op) +
+                    requiredType, link->line,
+                    "used with operator '" + TypeUtils::binaryOpToString(link->op) +
                         "' which requires " + TypeUtils::typeToString(requiredType));
             }
         }
-    } else if (auto *un = dynamic_cast<const UnaryExpr *>(expr)) {
+    } else if (auto *un = nodeCast<UnaryExpr>(expr)) {
         if (un->op == UnaryOp::NEGATE) {
             collectExprConstraints(paramName, un->operand.get(), constraints,
                                  ValueType::NUMBER);
         } else {
             collectExprConstraints(paramName, un->operand.get(), constraints);
         }
-    } else if (auto *call = dynamic_cast<const FunctionCall *>(expr)) {
+    } else if (auto *call = nodeCast<FunctionCall>(expr)) {
         (void)call;
-    } else if (auto *unwrap = dynamic_cast<const ForceUnwrapExpr *>(expr)) {
+    } else if (auto *unwrap = nodeCast<ForceUnwrapExpr>(expr)) {
         collectExprConstraints(paramName, unwrap->operand.get(), constraints);
-    } else if (auto *structCons = dynamic_cast<const StructConstructor *>(expr)) {
+    } else if (auto *structCons = nodeCast<StructConstructor>(expr)) {
         for (const auto &arg : structCons->positionalArgs) {
             collectExprConstraints(paramName, arg.get(), constraints);
         }
         for (const auto &namedArg : structCons->namedArgs) {
             collectExprConstraints(paramName, namedArg.second.get(), constraints);
         }
-    } else if (auto *fieldAccess = dynamic_cast<const FieldAccessExpr *>(expr)) {
+    } else if (auto *fieldAccess = nodeCast<FieldAccessExpr>(expr)) {
         collectExprConstraints(paramName, fieldAccess->object.get(), constraints);
     }
 }
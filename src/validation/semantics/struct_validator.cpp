@@ -7,32 +7,21 @@ StructValidator::StructValidator(ErrorReporter &reporter)
 
 bool StructValidator::collectStructDeclarations(const Program &program,
                                               std::map<std::string, StructInfo> &structTable) {
-    for (size_t i = 0; i < program.statements.size(); i++) {
-        auto &stmt = program.statements[i];
-        if (!stmt) {
-            continue;
+    for (const StructDecl *structDecl : program.declarations.structs) {
+        // check if struct is already defined
+        if (structTable.count(structDecl->name)) {
+            reporter.reportError("Struct '" + structDecl->name + "' is already defined",
+                               structDecl->line);
+            return false;
         }
-        
-        if (auto *structDecl = dynamic_cast<StructDecl *>(stmt.get())) {
-            // check if struct is already defined
-            if (structTable.count(structDecl->name)) {
-                reporter.reportError("Struct '" + structDecl->name + "' is already defined",
-                                   structDecl->line);
-                return false;
-            }
-
-            // add struct to table
-            StructInfo info;
-            info.name = structDecl->name;
-            info.fields = structDecl->fields;
 
-            // build field type map
-            for (const auto &field : structDecl->fields) {
-                info.fieldTypes[field.name] = {field.type, field.isOptional};
-            }
+        // add struct to table
+        StructInfo info;
+        info.name = structDecl->name;
+        info.fields = structDecl->fields;
+        info.indexMembers(*structDecl);
 
-            structTable[structDecl->name] = info;
-        }
+        structTable[structDecl->name] = info;
     }
     
     return true;
@@ -49,10 +38,8 @@ bool StructValidator::validateStructFieldAccess(const std::string &structName,
 
     const auto &structInfo = structTable.at(structName);
     
-    for (const auto &field : structInfo.fields) {
-        if (field.name == fieldName) {
-            return true;
-        }
+    if (structInfo.findField(fieldName)) {
+        return true;
     }
 
     reporter.reportError("Struct '" + structName + "' has no field '" + fieldName + "'", line);
@@ -68,15 +55,15 @@ std::string StructValidator::getFieldStructType(const FieldAccessExpr *field,
         
     std::string objectStructName;
     
-    if (auto *v = dynamic_cast<const VarExpr *>(field->object.get())) {
+    if (auto *v = nodeCast<VarExpr>(field->object.get())) {
         if (symbolTable.count(v->name)) {
             objectStructName = symbolTable.at(v->name).structTypeName;
         }
     }
-    else if (dynamic_cast<const SelfExpr *>(field->object.get())) {
+    else if (nodeCast<SelfExpr>(field->object.get())) {
         objectStructName = currentClass;
     }
-    else if (auto *innerField = dynamic_cast<const FieldAccessExpr *>(field->object.get())) {
+    else if (auto *innerField = nodeCast<FieldAccessExpr>(field->object.get())) {
         objectStructName = getFieldStructType(innerField, symbolTable, structTable, currentClass);
     }
     
@@ -86,13 +73,11 @@ std::string StructValidator::getFieldStructType(const FieldAccessExpr *field,
     
     if (structTable.count(objectStructName)) {
         auto &info = structTable.at(objectStructName);
-        for (const auto &f : info.fields) {
-            if (f.name == field->fieldName) {
-                if (f.type == ValueType::STRUCT && !f.structTypeName.empty()) {
-                    return f.structTypeName;
-                }
-                return objectStructName;
+        if (const MemberInfo *f = info.findField(field->fieldName)) {
+            if (f->type == ValueType::STRUCT && !f->structTypeName.empty()) {
+                return f->structTypeName;
             }
+            return objectStructName;
         }
     }
     
@@ -1,22 +1,55 @@
 #include "../../../include/validation/semantics/variable_collector.h"
+#include "../../../include/validation/ast_validation/expr_validator.h"
+#include <sstream>
 
 namespace HolyLua {
 
 VariableCollector::VariableCollector(ErrorReporter &reporter) 
     : reporter(reporter) {}
 
+// integer constants, int variables and int arithmetic on them. the compiler
+// counts a for loop on an int64_t when its start and step are integral
+static bool isIntegralBound(const Expr *expr,
+                            const std::unordered_map<std::string, TypeInfo> &symbolTable) {
+    if (isIntegerConstant(expr)) {
+        return true;
+    }
+    if (auto *var = nodeCast<VarExpr>(expr)) {
+        auto it = symbolTable.find(var->name);
+        return it != symbolTable.end() && it->second.type == ValueType::INT;
+    }
+    if (auto *un = nodeCast<UnaryExpr>(expr)) {
+        return un->op == UnaryOp::NEGATE && isIntegralBound(un->operand.get(), symbolTable);
+    }
+    if (auto *bin = nodeCast<BinaryExpr>(expr)) {
+        auto spine = leftSpine(bin);
+        for (auto *link : spine) {
+            switch (link->op) {
+            case BinaryOp::ADD:
+            case BinaryOp::SUBTRACT:
+            case BinaryOp::MULTIPLY:
+            case BinaryOp::MODULO:
+            case BinaryOp::FLOOR_DIVIDE:
+                if (!isIntegralBound(link->right.get(), symbolTable)) {
+                    return false;
+                }
+                break;
+            default:
+                return false;
+            }
+        }
+        return isIntegralBound(spine.back()->left.get(), symbolTable);
+    }
+    return false;
+}
+
 bool VariableCollector::collectGlobalVariables(const Program &program,
                                              std::unordered_map<std::string, TypeInfo> &symbolTable,
                                              const std::map<std::string, StructInfo> &structTable,
                                              const std::map<std::string, ClassInfo> &classTable) {
-    for (auto &stmt : program.statements) {
-        if (!stmt)
-            continue;
-
-        if (auto *decl = dynamic_cast<VarDecl *>(stmt.get())) {
-            if (!processVariableDeclaration(decl, symbolTable, structTable, classTable)) {
-                return false;
-            }
+    for (const VarDecl *decl : program.declarations.globals) {
+        if (!processVariableDeclaration(decl, symbolTable, structTable, classTable)) {
+            return false;
         }
     }
 
@@ -25,12 +58,13 @@ bool VariableCollector::collectGlobalVariables(const Program &program,
 
 void VariableCollector::collectLocalVariables(const std::vector<std::unique_ptr<ASTNode>> &stmts,
                                             std::unordered_map<std::string, TypeInfo> &symbolTable,
+                                            const std::unordered_map<std::string, FunctionInfo> &functionTable,
                                             const std::map<std::string, StructInfo> &structTable,
                                             const std::map<std::string, ClassInfo> &classTable) {
     for (const auto &stmt : stmts) {
         if (!stmt) continue;
 
-        if (auto *decl = dynamic_cast<const VarDecl *>(stmt.get())) {
+        if (auto *decl = nodeCast<VarDecl>(stmt.get())) {
             if (decl->isGlobal) {
                 continue;
             }
@@ -38,10 +72,10 @@ void VariableCollector::collectLocalVariables(const std::vector<std::unique_ptr<
             ValueType type = decl->type;
             bool isFunction = false;
             bool isStruct = false;
-            std::string structTypeName = decl->typeName;
+            TypeName structTypeName = decl->typeName;
 
             if (type == ValueType::INFERRED && decl->hasValue) {
-                if (auto *lit = dynamic_cast<const LiteralExpr *>(decl->value.get())) {
+                if (auto *lit = nodeCast<LiteralExpr>(decl->value.get())) {
                     if (std::holds_alternative<int64_t>(lit->value) || 
                         std::holds_alternative<double>(lit->value)) {
                         type = ValueType::NUMBER;
@@ -50,23 +84,31 @@ void VariableCollector::collectLocalVariables(const std::vector<std::unique_ptr<
                     } else if (std::holds_alternative<bool>(lit->value)) {
                         type = ValueType::BOOL;
                     }
-                } else if (dynamic_cast<const LambdaExpr *>(decl->value.get())) {
+                } else if (nodeCast<LambdaExpr>(decl->value.get())) {
                     type = ValueType::FUNCTION;
                     isFunction = true;
-                } else if (auto *structCons = dynamic_cast<const StructConstructor *>(decl->value.get())) {
+                } else if (auto *structCons = nodeCast<StructConstructor>(decl->value.get())) {
                     type = ValueType::STRUCT;
                     isStruct = true;
                     if (structTypeName.empty()) {
-                        structTypeName = structCons->structName;
+                        structTypeName = TypeName::find(structCons->structName);
                     }
-                } else if (auto *classInst = dynamic_cast<const ClassInstantiation *>(decl->value.get())) {
+                } else if (auto *classInst = nodeCast<ClassInstantiation>(decl->value.get())) {
                     type = ValueType::STRUCT;
                     isStruct = true;
                     if (structTypeName.empty()) {
-                        structTypeName = classInst->className;
+                        structTypeName = TypeName::find(classInst->className);
                     }
                 } else {
-                    type = ValueType::NUMBER;
+                    // typed like codegen types it. the statement itself is
+                    // checked later, so its errors are not reported twice
+                    std::ostringstream discarded;
+                    ErrorReporter quiet(reporter.getSources(), discarded);
+                    ValueType valueType = ExpressionValidator(quiet).validateExpression(
+                        decl->value.get(), symbolTable, functionTable, structTable, classTable);
+                    type = valueType == ValueType::INFERRED
+                               ? ValueType::NUMBER
+                               : declarationType(decl->value.get(), valueType);
                 }
             }
 
@@ -74,27 +116,30 @@ void VariableCollector::collectLocalVariables(const std::vector<std::unique_ptr<
                                      isFunction, isStruct, structTypeName};
         }
         // recurse into control structures
-        else if (auto *ifStmt = dynamic_cast<const IfStmt *>(stmt.get())) {
-            collectLocalVariables(ifStmt->thenBlock, symbolTable, structTable, classTable);
+        else if (auto *ifStmt = nodeCast<IfStmt>(stmt.get())) {
+            collectLocalVariables(ifStmt->thenBlock, symbolTable, functionTable, structTable, classTable);
             for (auto &branch : ifStmt->elseifBranches) {
-                collectLocalVariables(branch.second, symbolTable, structTable, classTable);
+                collectLocalVariables(branch.second, symbolTable, functionTable, structTable, classTable);
             }
-            collectLocalVariables(ifStmt->elseBlock, symbolTable, structTable, classTable);
+            collectLocalVariables(ifStmt->elseBlock, symbolTable, functionTable, structTable, classTable);
         }
-        else if (auto *whileStmt = dynamic_cast<const WhileStmt *>(stmt.get())) {
-            collectLocalVariables(whileStmt->body, symbolTable, structTable, classTable);
+        else if (auto *whileStmt = nodeCast<WhileStmt>(stmt.get())) {
+            collectLocalVariables(whileStmt->body, symbolTable, functionTable, structTable, classTable);
         }
-        else if (auto *forStmt = dynamic_cast<const ForStmt *>(stmt.get())) {
+        else if (auto *forStmt = nodeCast<ForStmt>(stmt.get())) {
             // add loop variable if not already present
             if (symbolTable.find(forStmt->varName) == symbolTable.end()) {
-                symbolTable[forStmt->varName] = {ValueType::NUMBER, false, true, false,
-                                               false, false, ""};
+                bool integral = isIntegralBound(forStmt->start.get(), symbolTable) &&
+                                (!forStmt->step ||
+                                 isIntegralBound(forStmt->step.get(), symbolTable));
+                symbolTable[forStmt->varName] = {integral ? ValueType::INT : ValueType::NUMBER,
+                                               false, true, false, false, false, TypeName()};
             }
             
-            collectLocalVariables(forStmt->body, symbolTable, structTable, classTable);
+            collectLocalVariables(forStmt->body, symbolTable, functionTable, structTable, classTable);
         }
-        else if (auto *repeatStmt = dynamic_cast<const RepeatStmt *>(stmt.get())) {
-            collectLocalVariables(repeatStmt->body, symbolTable, structTable, classTable);
+        else if (auto *repeatStmt = nodeCast<RepeatStmt>(stmt.get())) {
+            collectLocalVariables(repeatStmt->body, symbolTable, functionTable, structTable, classTable);
         }
     }
 }
@@ -112,7 +157,7 @@ bool VariableCollector::processVariableDeclaration(const VarDecl *decl,
     bool isOptional = decl->isOptional;
     bool isFunction = false;
     bool isStruct = false;
-    std::string structTypeName = "";
+    TypeName structTypeName;
 
     // check if type is a struct or class from the type annotation
     if (!decl->typeName.empty()) {
@@ -126,9 +171,9 @@ bool VariableCollector::processVariableDeclaration(const VarDecl *decl,
             structTypeName = decl->typeName;
         } else if (decl->type == ValueType::STRUCT || 
                   (!decl->typeName.empty() && decl->typeName != "number" && 
-                   decl->typeName != "string" && decl->typeName != "bool" && 
+                   decl->typeName != "int" && decl->typeName != "string" && decl->typeName != "bool" && 
                    decl->typeName != "function" && decl->typeName != "struct")) {
-            reporter.reportError("Unknown type '" + decl->typeName + "' for variable '" + 
+            reporter.reportError("Unknown type '" + decl->typeName.str() + "' for variable '" + 
                                decl->name + "'", decl->line);
             return false;
         }
@@ -136,7 +181,7 @@ bool VariableCollector::processVariableDeclaration(const VarDecl *decl,
 
     if (decl->hasValue && decl->value) {
         // check if it's a lambda
-        if (dynamic_cast<const LambdaExpr *>(decl->value.get())) {
+        if (nodeCast<LambdaExpr>(decl->value.get())) {
             isFunction = true;
             declaredType = ValueType::FUNCTION;
 
@@ -148,13 +193,13 @@ bool VariableCollector::processVariableDeclaration(const VarDecl *decl,
             }
         }
         // check if it's a struct constructor
-        else if (auto *structCons = dynamic_cast<const StructConstructor *>(
+        else if (auto *structCons = nodeCast<StructConstructor>(
                      decl->value.get())) {
             isStruct = true;
             declaredType = ValueType::STRUCT;
 
             if (structTypeName.empty()) {
-                structTypeName = structCons->structName;
+                structTypeName = TypeName::find(structCons->structName);
             }
 
             if (!structTable.count(structCons->structName) && 
@@ -167,7 +212,7 @@ bool VariableCollector::processVariableDeclaration(const VarDecl *decl,
             // validate that declared type matches
             if (decl->type != ValueType::INFERRED && !decl->typeName.empty()) {
                 if (decl->typeName != structCons->structName) {
-                    reporter.reportError("Type mismatch: variable declared as '" + decl->typeName +
+                    reporter.reportError("Type mismatch: variable declared as '" + decl->typeName.str() +
                                         "' but initialized with '" + structCons->structName +
                                         "'", decl->line);
                     return false;
@@ -175,13 +220,13 @@ bool VariableCollector::processVariableDeclaration(const VarDecl *decl,
             }
         }
         // check if it's a class instantiation
-        else if (auto *classInst = dynamic_cast<const ClassInstantiation *>(
+        else if (auto *classInst = nodeCast<ClassInstantiation>(
                      decl->value.get())) {
             isStruct = true;
             declaredType = ValueType::STRUCT;
 
             if (structTypeName.empty()) {
-                structTypeName = classInst->className;
+                structTypeName = TypeName::find(classInst->className);
             }
 
             if (!classTable.count(classInst->className)) {
@@ -193,7 +238,7 @@ bool VariableCollector::processVariableDeclaration(const VarDecl *decl,
             // validate that declared type matches
             if (decl->type != ValueType::INFERRED && !decl->typeName.empty()) {
                 if (decl->typeName != classInst->className) {
-                    reporter.reportError("Type mismatch: variable declared as '" + decl->typeName +
+                    reporter.reportError("Type mismatch: variable declared as '" + decl->typeName.str() +
                                         "' but initialized with '" + classInst->className +
                                         "'", decl->line);
                     return false;
@@ -1,15 +1,24 @@
 #include "../../include/validation/type_checker.h"
+#include "../../include/utils/parallel.h"
+#include <algorithm>
+#include <memory>
+#include <sstream>
 
 namespace HolyLua {
 
-TypeChecker::TypeChecker(const std::string &source)
-    : reporter(source),
+TypeChecker::TypeChecker(const SourceManager &sources)
+    : sources(sources),
+      reporter(sources),
       functionValidator(reporter),
       structValidator(reporter),
       classValidator(reporter),
       variableCollector(reporter),
       statementValidator(reporter) {}
 
+void TypeChecker::setJobs(unsigned jobs) {
+    this->jobs = std::max(1u, jobs);
+}
+
 void TypeChecker::initBuiltinFunctions() {
     // tostring: converts any value to string
     FunctionInfo tostringInfo;
@@ -55,10 +64,22 @@ void TypeChecker::initBuiltinFunctions() {
 bool TypeChecker::check(const Program &program) {
     initBuiltinFunctions();
     
-    if (!performFirstPass(program)) return false;
-    if (!performSecondPass(program)) return false;
-    if (!performThirdPass(program)) return false;
-    if (!performFourthPass(program)) return false;
+    {
+        PassTimer::Scope scope(timer, "pass 1: declarations");
+        if (!performFirstPass(program)) return false;
+    }
+    {
+        PassTimer::Scope scope(timer, "pass 2: signatures");
+        if (!performSecondPass(program)) return false;
+    }
+    {
+        PassTimer::Scope scope(timer, "pass 3: bodies");
+        if (!performThirdPass(program)) return false;
+    }
+    {
+        PassTimer::Scope scope(timer, "pass 4: statements");
+        if (!performFourthPass(program)) return false;
+    }
     
     return !reporter.hasErrors();
 }
@@ -73,27 +94,21 @@ bool TypeChecker::performFirstPass(const Program &program) {
     }
     
     // validate struct declarations
-    for (auto &stmt : program.statements) {
-        if (!stmt) continue;
-        if (auto *structDecl = dynamic_cast<StructDecl *>(stmt.get())) {
-            std::set<std::string> fieldNames;
-            for (const auto &field : structDecl->fields) {
-                if (fieldNames.count(field.name)) {
-                    reporter.reportError("Duplicate field name '" + field.name + 
-                                       "' in struct '" + structDecl->name + "'", structDecl->line);
-                    return false;
-                }
-                fieldNames.insert(field.name);
+    for (const StructDecl *structDecl : program.declarations.structs) {
+        std::set<std::string> fieldNames;
+        for (const auto &field : structDecl->fields) {
+            if (fieldNames.count(field.name)) {
+                reporter.reportError("Duplicate field name '" + field.name + 
+                                   "' in struct '" + structDecl->name + "'", structDecl->line);
+                return false;
             }
+            fieldNames.insert(field.name);
         }
     }
     
-    for (auto &stmt : program.statements) {
-        if (!stmt) continue;
-        if (auto *classDecl = dynamic_cast<ClassDecl *>(stmt.get())) {
-            if (!classValidator.validateClassDeclaration(classDecl, classTable, structTable)) {
-                return false;
-            }
+    for (const ClassDecl *classDecl : program.declarations.classes) {
+        if (!classValidator.validateClassDeclaration(classDecl, classTable, structTable)) {
+            return false;
         }
     }
     
@@ -103,85 +118,128 @@ bool TypeChecker::performFirstPass(const Program &program) {
 
 bool TypeChecker::performSecondPass(const Program &program) {
     // collect function signatures
-    for (auto &stmt : program.statements) {
-        if (!stmt) continue;
-        if (auto *func = dynamic_cast<FunctionDecl *>(stmt.get())) {
-            if (!functionValidator.collectFunctionSignature(func, functionTable)) {
-                return false;
-            }
+    for (FunctionDecl *func : program.declarations.functions) {
+        if (!functionValidator.collectFunctionSignature(func, functionTable)) {
+            return false;
         }
     }
     return true;
 }
 
 bool TypeChecker::performThirdPass(const Program &program) {
-    // infer types and validate functions
-    for (auto &stmt : program.statements) {
-        if (!stmt) continue;
-        if (auto *func = dynamic_cast<FunctionDecl *>(stmt.get())) {
-            if (!functionValidator.inferAndValidateFunction(func, symbolTable, 
-                                                           functionTable, variableCollector)) {
-                return false;
-            }
+    // every global function, constructor and method body is its own task.
+    // method bodies see neither the function table nor each other's scratch
+    // state, and a function with an explicit return type only reads the
+    // table, so those tasks run in parallel
+    std::vector<BodyCheck> checks;
+    for (FunctionDecl *func : program.declarations.functions) {
+        if (func->isGlobal) {
+            BodyCheck check;
+            check.function = func;
+            checks.push_back(std::move(check));
         }
     }
-    
-    for (auto &stmt : program.statements) {
-        if (!stmt) continue;
-        if (auto *classDecl = dynamic_cast<ClassDecl *>(stmt.get())) {
-            // validate constructor
-            if (classDecl->constructor) {
-                if (!classValidator.validateClassMethod(classDecl->name, 
-                                                       *classDecl->constructor.get(),
-                                                       true,
-                                                       symbolTable,
-                                                       structTable,
-                                                       classTable,
-                                                       nonNilVars,
-                                                       currentClass,
-                                                       currentFunction)) {
-                    return false;
-                }
-            }
-            
-            // validate methods
-            for (const auto &method : classDecl->methods) {
-                if (!classValidator.validateClassMethod(classDecl->name,
-                                                       method,
-                                                       false,
-                                                       symbolTable,
-                                                       structTable,
-                                                       classTable,
-                                                       nonNilVars,
-                                                       currentClass,
-                                                       currentFunction)) {
-                    return false;
-                }
-            }
+    for (const ClassDecl *classDecl : program.declarations.classes) {
+        if (classDecl->constructor) {
+            BodyCheck check;
+            check.classDecl = classDecl;
+            check.method = classDecl->constructor.get();
+            check.isConstructor = true;
+            checks.push_back(std::move(check));
+        }
+        for (const auto &method : classDecl->methods) {
+            BodyCheck check;
+            check.classDecl = classDecl;
+            check.method = &method;
+            checks.push_back(std::move(check));
         }
     }
-    
-    return true;
-}
 
-bool TypeChecker::performFourthPass(const Program &program) {
-    // check all statements
-    for (const auto &stmt : program.statements) {
-        if (!stmt) continue;
+    struct Scratch {
+        std::unordered_map<std::string, TypeInfo> symbolTable;
+        std::unordered_set<std::string> nonNilVars;
+        std::string currentClass;
+        std::string currentFunction;
+    };
 
-        if (dynamic_cast<const VarDecl *>(stmt.get())) {
-            continue;
+    auto runCheck = [&](Scratch &state, BodyCheck &check) {
+        std::ostringstream messages;
+        ErrorReporter taskReporter(sources, messages);
+        if (check.function) {
+            FunctionValidator validator(taskReporter);
+            VariableCollector collector(taskReporter);
+            check.passed = validator.inferAndValidateFunction(check.function,
+                                                              state.symbolTable,
+                                                              functionTable,
+                                                              collector);
+        } else {
+            ClassValidator validator(taskReporter);
+            check.passed = validator.validateClassMethod(check.classDecl->name,
+                                                         *check.method,
+                                                         check.isConstructor,
+                                                         state.symbolTable,
+                                                         structTable,
+                                                         classTable,
+                                                         state.nonNilVars,
+                                                         state.currentClass,
+                                                         state.currentFunction);
         }
+        check.diagnostics = messages.str();
+        check.errorCount = taskReporter.getErrorCount();
+        check.done = true;
+    };
 
-        if (dynamic_cast<const ClassDecl *>(stmt.get())) {
-            continue;
+    // an inferred return type may depend on the ones inferred before it and
+    // is written into the function table, so those functions are checked
+    // one after another before anything reads the table
+    std::vector<size_t> pending;
+    {
+        Scratch state{symbolTable, nonNilVars, currentClass, currentFunction};
+        bool inferring = true;
+        for (size_t i = 0; i < checks.size(); i++) {
+            BodyCheck &check = checks[i];
+            if (!check.function || check.function->returnType != ValueType::INFERRED) {
+                pending.push_back(i);
+            } else if (inferring) {
+                runCheck(state, check);
+                inferring = check.passed;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Scratch>> scratch(jobs);
+    parallelFor(pending.size(), jobs, [&](unsigned worker, size_t index) {
+        if (!scratch[worker]) {
+            scratch[worker] = std::unique_ptr<Scratch>(
+                new Scratch{symbolTable, nonNilVars, currentClass, currentFunction});
         }
+        runCheck(*scratch[worker], checks[pending[index]]);
+    });
 
-        if (dynamic_cast<const StructDecl *>(stmt.get())) {
+    // report in source order, stopping at the first failed body as the
+    // serial pass did. an inferred function left unchecked always follows
+    // one that failed
+    for (const auto &check : checks) {
+        if (!check.done) {
+            break;
+        }
+        reporter.replay(check.diagnostics, check.errorCount);
+        if (!check.passed) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool TypeChecker::performFourthPass(const Program &program) {
+    // check top-level statements, declarations were handled by earlier passes
+    for (const ASTNode *stmt : program.declarations.statements) {
+        if (nodeCast<VarDecl>(stmt)) {
             continue;
         }
         
-        if (!statementValidator.validateStatement(stmt.get(), symbolTable, functionTable,
+        if (!statementValidator.validateStatement(stmt, symbolTable, functionTable,
                                                  structTable, classTable, nonNilVars,
                                                  currentFunction, currentClass)) {
             return false;
@@ -56,7 +56,7 @@ target("holylua")
         add_syslinks("user32")
     else
         add_ldflags("-Wl,--as-needed")
-        add_syslinks("m")
+        add_syslinks("m", "pthread")
     end
 
     after_install(function(target)
@@ -126,6 +126,16 @@ export HOLY_LUA_INCLUDE="%s"
         end
     end)
 
+target("holylua_bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("bench/*.cpp")
+    add_files("src/**.cpp|main.cpp")
+
+    if not is_plat("windows") then
+        add_syslinks("m", "pthread")
+    end
+
 target("holylua_static")
     add_installfiles("lib/(holylua.*)", { prefixdir = "lib" })
     add_installfiles("api/(holylua_api.h)", { prefixdir = "include" })